@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""
+Benchmark comparison
+Compares two result files written by the native benchmark target:
+
+    pio test -e bench                       # appends to bench_output.txt
+    mv bench_output.txt before.txt
+    ... make the change ...
+    pio test -e bench
+    python3 bench_compare.py before.txt bench_output.txt [--threshold 5] [--fail-on-regression]
+
+Each line of a result file is one JSON object. When a file holds several
+runs of the same benchmark, the last one counts.
+"""
+
+import json
+import sys
+
+def load_results(path):
+    """Read a result file into {name: result}."""
+    results = {}
+    with open(path, 'r') as f:
+        for number, line in enumerate(f, 1):
+            line = line.strip()
+            if line.startswith("BENCH "):
+                line = line[len("BENCH "):]
+            if not line:
+                continue
+            try:
+                result = json.loads(line)
+            except json.JSONDecodeError:
+                print(f"⚠️  {path}:{number}: not a benchmark result, skipped")
+                continue
+            results[result["name"]] = result
+    return results
+
+def change(before, after):
+    """Relative change in percent; positive is slower."""
+    if before == 0:
+        return 0.0 if after == 0 else float("inf")
+    return (after - before) * 100.0 / before
+
+def compare(before_path, after_path, threshold):
+    """Print a comparison table; returns the names that got slower than the threshold."""
+    before = load_results(before_path)
+    after = load_results(after_path)
+
+    print(f"{'benchmark':<28} {'median ns':>21} {'change':>8} {'p99 ns':>21} {'allocs/op':>15}")
+
+    regressions = []
+    for name in sorted(set(before) | set(after)):
+        if name not in before or name not in after:
+            print(f"{name:<28} {'only in ' + ('before' if name in before else 'after'):>21}")
+            continue
+
+        b, a = before[name], after[name]
+        median_change = change(b["median_ns"], a["median_ns"])
+        marker = ""
+        if median_change > threshold:
+            marker = " ❌"
+            regressions.append(name)
+        elif median_change < -threshold:
+            marker = " ✅"
+
+        medians = f"{b['median_ns']:.1f} → {a['median_ns']:.1f}"
+        p99s = f"{b['p99_ns']:.1f} → {a['p99_ns']:.1f}"
+        allocs = f"{b['allocs_per_op']:.2f} → {a['allocs_per_op']:.2f}"
+        print(f"{name:<28} {medians:>21} {median_change:>+7.1f}% {p99s:>21} {allocs:>15}{marker}")
+
+    return regressions
+
+def main():
+    args = [arg for arg in sys.argv[1:] if not arg.startswith("--")]
+    threshold = 5.0
+    if "--threshold" in sys.argv:
+        index = sys.argv.index("--threshold")
+        if index + 1 >= len(sys.argv):
+            print("❌ --threshold needs a percentage")
+            sys.exit(2)
+        threshold = float(sys.argv[index + 1])
+        args.remove(sys.argv[index + 1])
+
+    if len(args) != 2:
+        print("Usage: python3 bench_compare.py <before> <after> [--threshold 5] [--fail-on-regression]")
+        sys.exit(2)
+
+    regressions = compare(args[0], args[1], threshold)
+
+    if regressions:
+        print(f"\n{len(regressions)} benchmark(s) slower by more than {threshold:.0f}%: {', '.join(regressions)}")
+        if "--fail-on-regression" in sys.argv:
+            sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -1,54 +1,319 @@
 #!/usr/bin/env python3
 """
 ESP32 Firmware Package Creator
-Creates custom .bin packages with the format: [Magic][MetadataLength][Metadata][Firmware]
+Creates custom .bin packages. Format 2 (default) starts with a fixed header:
+
+    [64 byte header: version, board, offsets, CRC32s][Metadata JSON][Firmware]
+
+Format 1, still read by the device: [Magic][MetadataLength][Metadata][Firmware]
+The header layout is documented in lib/FirmwareFormat/FirmwareFormat.h.
+
+With --compress the firmware is stored as its HEX records packed to binary and
+LZSS compressed (lib/LzssDecoder); the device turns it back into HEX lines as
+it flashes, so packages take about a third of the SPIFFS space.
 """
 
 import json
 import struct
 import sys
 import os
+import zlib
+from datetime import datetime, timezone
+
+MAGIC_HEADER = b"FLFW\0"  # 5 bytes, format 1
+MAGIC_V2 = b"FLFW"
+FORMAT_V2 = 2
+PAYLOAD_INTEL_HEX = 0
+PAYLOAD_HEX_LZSS = 1
+PAYLOAD_NAMES = {PAYLOAD_INTEL_HEX: "Intel HEX", PAYLOAD_HEX_LZSS: "Intel HEX, LZSS"}
+
+# Must match LzssDecoder.h
+LZSS_WINDOW_BITS = 9
+LZSS_LENGTH_BITS = 4
+LZSS_MIN_MATCH = 2
+LZSS_WINDOW = 1 << LZSS_WINDOW_BITS
+LZSS_MAX_MATCH = (1 << LZSS_LENGTH_BITS) - 1 + LZSS_MIN_MATCH
+
+# ATtiny flash pages - keep in step with lib/FlashPages/FlashPages.h
+FLASH_PAGE_SIZE = 64
+FLASH_PAGES = 256
+
+# Board ids in the format 2 header - keep in step with BOARDS in FirmwareFormat.cpp
+BOARD_IDS = {
+    "FL-LC01": 1,
+}
+
+# Everything up to the header CRC, which covers these 60 bytes
+HEADER_V2 = struct.Struct('<4sBBHHBBHHIIIIIIII12s')
+HEADER_V2_SIZE = HEADER_V2.size + 4
+
+def parse_version(version):
+    """'1.0.6' -> (1, 0, 6), range-checked for the header fields."""
+    parts = version.split('.')
+    if len(parts) != 3 or not all(part.isdigit() for part in parts):
+        raise ValueError(f"version '{version}' is not MAJOR.MINOR.PATCH")
+    major, minor, patch = (int(part) for part in parts)
+    if major > 255 or minor > 255 or patch > 65535:
+        raise ValueError(f"version '{version}' does not fit the package header")
+    return major, minor, patch
+
+def build_time(metadata):
+    """build_info.timestamp as Unix seconds, read as UTC so the date matches the JSON; 0 if missing."""
+    timestamp = metadata.get("build_info", {}).get("timestamp")
+    if not timestamp:
+        return 0
+    return int(datetime.fromisoformat(timestamp).replace(tzinfo=timezone.utc).timestamp())
+
+def pack_hex(hex_bytes):
+    """HEX text -> [count][address BE:2][type][data] per record; checksums are checked, then dropped."""
+    packed = bytearray()
+    for number, line in enumerate(hex_bytes.splitlines(), 1):
+        line = line.strip()
+        if not line.startswith(b':'):
+            continue
+        try:
+            record = bytes.fromhex(line[1:].decode('ascii'))
+        except ValueError:
+            raise ValueError(f"HEX line {number} is not hex")
+        if len(record) < 5 or record[0] != len(record) - 5 or sum(record) & 0xFF != 0:
+            raise ValueError(f"HEX line {number} has a bad length or checksum")
+        packed += record[:-1]
+    return bytes(packed)
+
+def unpack_hex(packed):
+    """Packed records back to HEX text, as the device regenerates it."""
+    lines = []
+    position = 0
+    while position < len(packed):
+        length = packed[position]
+        record = packed[position:position + 4 + length]
+        if len(record) != 4 + length:
+            raise ValueError("packed records end mid-record")
+        record += bytes([(-sum(record)) & 0xFF])
+        lines.append(":" + record.hex().upper())
+        position += 4 + length
+    return ("\n".join(lines) + "\n").encode('ascii')
+
+def flash_image_crc(hex_bytes):
+    """(pages, CRC32) of the ATtiny image the way FlashPages computes it: 64-byte
+    pages from address 0 through the last one the HEX sets, unset bytes 0xFF."""
+    image = bytearray(b'\xff' * FLASH_PAGE_SIZE * FLASH_PAGES)
+    packed = pack_hex(hex_bytes)
+    base = 0
+    end = 0
+    position = 0
+    while position < len(packed):
+        length, address, record_type = packed[position], (packed[position + 1] << 8) | packed[position + 2], packed[position + 3]
+        data = packed[position + 4:position + 4 + length]
+        if record_type == 0 and length > 0:
+            start = base + address
+            if start + length > len(image):
+                raise ValueError("HEX data past the end of the ATtiny's flash")
+            image[start:start + length] = data
+            end = max(end, start + length)
+        elif record_type in (2, 4) and length == 2:
+            base = ((data[0] << 8) | data[1]) << (4 if record_type == 2 else 16)
+        position += 4 + length
+    pages = (end + FLASH_PAGE_SIZE - 1) // FLASH_PAGE_SIZE
+    return pages, zlib.crc32(image[:pages * FLASH_PAGE_SIZE])
+
+def lzss_compress(data):
+    """Greedy LZSS in the LzssDecoder bit format: 1+8 bit literals, 1+9+4 bit copies."""
+    bits = []
+    candidates = {}
+    position = 0
+    while position < len(data):
+        best_length = 0
+        best_distance = 0
+        key = data[position:position + LZSS_MIN_MATCH]
+        for start in reversed(candidates.get(key, [])):
+            if position - start > LZSS_WINDOW:
+                break
+            length = 0
+            while (length < LZSS_MAX_MATCH and position + length < len(data)
+                   and data[start + length] == data[position + length]):
+                length += 1
+            if length > best_length:
+                best_length, best_distance = length, position - start
+                if length == LZSS_MAX_MATCH:
+                    break
+        
+        step = best_length if best_length >= LZSS_MIN_MATCH else 1
+        if step > 1:
+            bits.append('0' + format(best_distance - 1, f'0{LZSS_WINDOW_BITS}b')
+                        + format(best_length - LZSS_MIN_MATCH, f'0{LZSS_LENGTH_BITS}b'))
+        else:
+            bits.append('1' + format(data[position], '08b'))
+        for index in range(position, position + step):
+            if index + LZSS_MIN_MATCH <= len(data):
+                chain = candidates.setdefault(data[index:index + LZSS_MIN_MATCH], [])
+                chain.append(index)
+                if len(chain) > 64:
+                    del chain[:32]
+        position += step
+    
+    stream = ''.join(bits)
+    stream += '0' * (-len(stream) % 8)
+    return bytes(int(stream[i:i + 8], 2) for i in range(0, len(stream), 8))
+
+def lzss_decompress(data, length):
+    """Reference decoder, to check a package before it leaves the machine."""
+    stream = ''.join(format(byte, '08b') for byte in data)
+    out = bytearray()
+    position = 0
+    while len(out) < length:
+        if stream[position:position + 1] == '1':
+            out.append(int(stream[position + 1:position + 9], 2))
+            position += 9
+            continue
+        token = stream[position + 1:position + 1 + LZSS_WINDOW_BITS + LZSS_LENGTH_BITS]
+        if len(token) < LZSS_WINDOW_BITS + LZSS_LENGTH_BITS:
+            raise ValueError("compressed payload ends early")
+        distance = int(token[:LZSS_WINDOW_BITS], 2) + 1
+        if distance > len(out):
+            raise ValueError("compressed payload copies from before its start")
+        for _ in range(int(token[LZSS_WINDOW_BITS:], 2) + LZSS_MIN_MATCH):
+            out.append(out[-distance])
+        position += 1 + LZSS_WINDOW_BITS + LZSS_LENGTH_BITS
+    return bytes(out[:length])
 
-MAGIC_HEADER = b"FLFW\0"  # 5 bytes
+def build_package_v1(metadata_bytes, firmware):
+    return MAGIC_HEADER + struct.pack('<I', len(metadata_bytes)) + metadata_bytes + firmware
 
-def create_firmware_package(metadata_file, firmware_file, output_file):
+def build_package_v2(metadata, metadata_bytes, firmware, compress=False):
+    """Header from the metadata's version and board, then the metadata and firmware."""
+    firmware_info = metadata.get("firmware", {})
+    board = firmware_info.get("board")
+    if board not in BOARD_IDS:
+        raise ValueError(f"board '{board}' has no id - set firmware.board or add it to BOARD_IDS and FirmwareFormat.cpp")
+    major, minor, patch = parse_version(firmware_info.get("version", ""))
+    
+    payload_type = PAYLOAD_INTEL_HEX
+    decoded_length = 0
+    if compress:
+        packed = pack_hex(firmware)
+        firmware = lzss_compress(packed)
+        payload_type = PAYLOAD_HEX_LZSS
+        decoded_length = len(packed)
+    
+    metadata_offset = HEADER_V2_SIZE if metadata_bytes else 0
+    payload_offset = HEADER_V2_SIZE + len(metadata_bytes)
+    header = HEADER_V2.pack(MAGIC_V2, FORMAT_V2, payload_type, HEADER_V2_SIZE, BOARD_IDS[board],
+                            major, minor, patch, 0,
+                            payload_offset, len(firmware), zlib.crc32(firmware),
+                            metadata_offset, len(metadata_bytes), zlib.crc32(metadata_bytes),
+                            build_time(metadata), decoded_length, bytes(12))
+    return header + struct.pack('<I', zlib.crc32(header)) + metadata_bytes + firmware
+
+def read_package(data):
+    """Fields of a package in either format, with its checksums checked."""
+    if data[:5] == MAGIC_HEADER:
+        metadata_length = struct.unpack('<I', data[5:9])[0]
+        return {"format": 1, "metadata": data[9:9 + metadata_length], "firmware": data[9 + metadata_length:],
+                "valid": 9 + metadata_length <= len(data)}
+    
+    if data[:4] != MAGIC_V2 or len(data) < HEADER_V2_SIZE or data[4] != FORMAT_V2:
+        raise ValueError("not a firmware package")
+    fields = HEADER_V2.unpack(data[:HEADER_V2.size])
+    (_, _, payload_type, _, board_id, major, minor, patch, _,
+     payload_offset, payload_length, payload_crc,
+     metadata_offset, metadata_length, metadata_crc, timestamp, decoded_length, _) = fields
+    header_crc = struct.unpack('<I', data[HEADER_V2.size:HEADER_V2_SIZE])[0]
+    metadata = data[metadata_offset:metadata_offset + metadata_length] if metadata_length else b""
+    firmware = data[payload_offset:payload_offset + payload_length]
+    boards = {board_id: name for name, board_id in BOARD_IDS.items()}
+    return {
+        "format": 2,
+        "version": f"{major}.{minor}.{patch}",
+        "board": boards.get(board_id, f"board{board_id}"),
+        "payload_type": payload_type,
+        "decoded_length": decoded_length,
+        "build_time": timestamp,
+        "metadata": metadata,
+        "firmware": firmware,
+        "valid": zlib.crc32(data[:HEADER_V2.size]) == header_crc
+                 and len(firmware) == payload_length and zlib.crc32(firmware) == payload_crc
+                 and len(metadata) == metadata_length and zlib.crc32(metadata) == metadata_crc,
+    }
+
+def hex_payload(package):
+    """The firmware of a read package as HEX text, decompressing it if needed."""
+    if package.get("payload_type", PAYLOAD_INTEL_HEX) == PAYLOAD_HEX_LZSS:
+        return unpack_hex(lzss_decompress(package["firmware"], package["decoded_length"]))
+    return package["firmware"]
+
+def create_firmware_package(metadata_file, firmware_file, output_file, package_format=FORMAT_V2, compress=False):
     """Create a firmware package from metadata and firmware files."""
     
     # Read metadata
     with open(metadata_file, 'r') as f:
         metadata_content = f.read()
+    metadata_bytes = metadata_content.encode('utf-8')
     
     # Read firmware
     with open(firmware_file, 'rb') as f:
         firmware_content = f.read()
     
+    if package_format == 1:
+        package = build_package_v1(metadata_bytes, firmware_content)
+    else:
+        package = build_package_v2(json.loads(metadata_content), metadata_bytes, firmware_content, compress)
+    
     # Create package
     with open(output_file, 'wb') as f:
-        # Write magic header
-        f.write(MAGIC_HEADER)
-        
-        # Write metadata length (4 bytes, little-endian)
-        metadata_length = len(metadata_content)
-        f.write(struct.pack('<I', metadata_length))
-        
-        # Write metadata
-        f.write(metadata_content.encode('utf-8'))
-        
-        # Write firmware
-        f.write(firmware_content)
+        f.write(package)
     
     print(f"Created firmware package: {output_file}")
-    print(f"  Magic header: {MAGIC_HEADER}")
-    print(f"  Metadata length: {metadata_length} bytes")
+    print(f"  Format: {package_format}")
+    print(f"  Metadata length: {len(metadata_bytes)} bytes")
     print(f"  Firmware size: {len(firmware_content)} bytes")
-    print(f"  Total package size: {9 + metadata_length + len(firmware_content)} bytes")
+    if compress:
+        stored = read_package(package)
+        if hex_payload(stored) != unpack_hex(pack_hex(firmware_content)):
+            raise ValueError("compressed payload does not decompress to the firmware")
+        print(f"  Compressed firmware: {len(stored['firmware'])} bytes "
+              f"({len(firmware_content) / len(stored['firmware']):.2f}x, {stored['decoded_length']} bytes of records)")
+    print(f"  Total package size: {len(package)} bytes")
+
+def show_package_info(package_file):
+    """Print a package's header fields and check its CRCs."""
+    with open(package_file, 'rb') as f:
+        package = read_package(f.read())
+    
+    print(f"Package: {package_file}")
+    print(f"  Format: {package['format']}")
+    if package["format"] == 2:
+        print(f"  Version: {package['version']}")
+        print(f"  Board: {package['board']}")
+        print(f"  Payload: {PAYLOAD_NAMES.get(package['payload_type'], package['payload_type'])}")
+        if package["build_time"]:
+            print(f"  Build time: {datetime.fromtimestamp(package['build_time'], timezone.utc).isoformat()}")
+    print(f"  Metadata length: {len(package['metadata'])} bytes")
+    print(f"  Firmware size: {len(package['firmware'])} bytes")
+    if package["format"] == 2 and package["payload_type"] == PAYLOAD_HEX_LZSS and package["valid"]:
+        try:
+            hex_size = len(hex_payload(package))
+            print(f"  Decompressed: {hex_size} bytes of HEX ({hex_size / max(len(package['firmware']), 1):.2f}x)")
+        except ValueError as e:
+            print(f"  Decompressed: failed - {e}")
+            package["valid"] = False
+    if package["valid"]:
+        try:
+            pages, crc = flash_image_crc(hex_payload(package))
+            print(f"  ATtiny image: {pages} pages, CRC32 {crc:08x}")
+        except ValueError as e:
+            print(f"  ATtiny image: unknown - {e}")
+    if package["format"] == 2:
+        print(f"  Checksums: {'OK' if package['valid'] else 'MISMATCH'}")
+    return package["valid"]
 
 def create_sample_metadata():
     """Create a sample metadata file for testing."""
     sample_metadata = {
         "firmware": {
             "version": "1.0.1",
-            "description": "I2C Light Controller for ATtiny1616 with WS2812B LED"
+            "description": "I2C Light Controller for ATtiny1616 with WS2812B LED",
+            "board": "FL-LC01"
         },
         "target": {
             "board": "ATtiny1616",
@@ -87,27 +352,51 @@ def main():
     if len(sys.argv) == 1:
         print("ESP32 Firmware Package Creator")
         print("Usage:")
-        print("  python3 create_firmware_package.py create <metadata.json> <firmware.hex> <output.bin>")
+        print("  python3 create_firmware_package.py create <metadata.json> <firmware.hex> <output.bin> [--compress] [--format 1]")
+        print("  python3 create_firmware_package.py info <package.bin>")
         print("  python3 create_firmware_package.py sample")
         print()
         print("Examples:")
         print("  python3 create_firmware_package.py sample")
         print("  python3 create_firmware_package.py create sample_metadata.json firmware.hex firmware-v1.0.1.bin")
+        print("  python3 create_firmware_package.py create sample_metadata.json firmware.hex firmware-v1.0.1.bin --compress")
+        print("  python3 create_firmware_package.py info firmware-v1.0.1.bin")
         return
     
     command = sys.argv[1]
+    args = sys.argv[2:]
+    package_format = FORMAT_V2
+    if "--format" in args:
+        index = args.index("--format")
+        if index + 1 >= len(args) or args[index + 1] not in ("1", "2"):
+            print("Error: --format must be 1 or 2")
+            return
+        package_format = int(args[index + 1])
+        del args[index:index + 2]
+    compress = "--compress" in args
+    if compress:
+        args.remove("--compress")
+        if package_format == 1:
+            print("Error: --compress needs format 2")
+            return
     
     if command == "sample":
         create_sample_metadata()
+    elif command == "info":
+        if len(args) != 1:
+            print("Usage: python3 create_firmware_package.py info <package.bin>")
+            return
+        if not show_package_info(args[0]):
+            sys.exit(1)
     elif command == "create":
-        if len(sys.argv) != 5:
+        if len(args) != 3:
             print("Error: create command requires 3 arguments")
-            print("Usage: python3 create_firmware_package.py create <metadata.json> <firmware.hex> <output.bin>")
+            print("Usage: python3 create_firmware_package.py create <metadata.json> <firmware.hex> <output.bin> [--compress] [--format 1]")
             return
         
-        metadata_file = sys.argv[2]
-        firmware_file = sys.argv[3]
-        output_file = sys.argv[4]
+        metadata_file = args[0]
+        firmware_file = args[1]
+        output_file = args[2]
         
         if not os.path.exists(metadata_file):
             print(f"Error: Metadata file '{metadata_file}' not found")
@@ -117,7 +406,11 @@ def main():
             print(f"Error: Firmware file '{firmware_file}' not found")
             return
         
-        create_firmware_package(metadata_file, firmware_file, output_file)
+        try:
+            create_firmware_package(metadata_file, firmware_file, output_file, package_format, compress)
+        except ValueError as e:
+            print(f"Error: {e}")
+            sys.exit(1)
     else:
         print(f"Unknown command: {command}")
 
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+Fuzzing for the firmware package parsers
+Targets (fuzz/fuzz_<name>.cpp) call the same FirmwareFormat and
+FirmwareMetadata code the ESP32 runs on uploads:
+
+    package   - FLFW header, metadata and embedded HEX, as an upload
+    hex       - Intel HEX record decoding and the version scan
+    metadata  - metadata JSON
+    payload   - HexPayloadReader on plain and LZSS-compressed payloads
+
+Usage:
+    python3 fuzz/fuzz.py corpus                    # seeds from firmware-v1.0.x.bin and test/test_firmware.hex
+    python3 fuzz/fuzz.py run <target> [args...]    # libFuzzer (clang), extra args go to the fuzzer
+    python3 fuzz/fuzz.py replay                    # corpus through every target with gcc + ASan/UBSan
+
+The metadata and package targets need ArduinoJson: set ARDUINOJSON_DIR to
+its src/ directory, or build the firmware once so PlatformIO fetches it.
+"""
+
+import glob
+import hashlib
+import json
+import os
+import shutil
+import struct
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+FUZZ_DIR = os.path.join(ROOT, "fuzz")
+CORPUS_DIR = os.path.join(FUZZ_DIR, "corpus")
+BUILD_DIR = os.path.join(FUZZ_DIR, "build")
+
+sys.path.insert(0, ROOT)
+import create_firmware_package
+
+TARGETS = ["package", "hex", "metadata", "payload"]
+SOURCES = {
+    "package": ["lib/FirmwareFormat/FirmwareFormat.cpp", "lib/Crc32/Crc32.cpp", "lib/FirmwareMetadata/FirmwareMetadata.cpp"],
+    "hex": ["lib/FirmwareFormat/FirmwareFormat.cpp", "lib/Crc32/Crc32.cpp"],
+    "metadata": ["lib/FirmwareMetadata/FirmwareMetadata.cpp"],
+    "payload": ["lib/HexPayloadReader/HexPayloadReader.cpp", "lib/LzssDecoder/LzssDecoder.cpp",
+                "lib/FirmwareFormat/FirmwareFormat.cpp", "lib/Crc32/Crc32.cpp"],
+}
+
+def find_arduinojson():
+    """ArduinoJson's src/ directory, or None."""
+    configured = os.environ.get("ARDUINOJSON_DIR")
+    if configured:
+        return configured
+    matches = glob.glob(os.path.join(ROOT, ".pio", "libdeps", "*", "ArduinoJson", "src"))
+    return matches[0] if matches else None
+
+def split_package(data):
+    """(metadata, firmware) of a package, or None if the header is invalid."""
+    try:
+        package = create_firmware_package.read_package(data)
+    except (ValueError, struct.error):
+        return None
+    if not package["valid"]:
+        return None
+    return package["metadata"], package["firmware"]
+
+def make_packages(metadata, firmware):
+    """The same contents in both package formats, compressed too when the HEX packs."""
+    packages = [create_firmware_package.build_package_v1(metadata, firmware)]
+    for compress in (False, True):
+        try:
+            packages.append(create_firmware_package.build_package_v2(json.loads(metadata), metadata, firmware, compress))
+        except ValueError:
+            pass
+    return packages
+
+def payload_seed(payload_type, decoded_length, payload):
+    """fuzz_payload input: type, decoded length, then the payload."""
+    return struct.pack('<BI', payload_type, decoded_length) + payload
+
+def write_seed(target, data):
+    """Store a seed under its SHA-1, the way libFuzzer names corpus files."""
+    directory = os.path.join(CORPUS_DIR, target)
+    os.makedirs(directory, exist_ok=True)
+    with open(os.path.join(directory, hashlib.sha1(data).hexdigest()), 'wb') as f:
+        f.write(data)
+
+def build_corpus():
+    """Seed corpus from the packages and HEX file in the repository."""
+    if os.path.isdir(CORPUS_DIR):
+        shutil.rmtree(CORPUS_DIR)
+
+    with open(os.path.join(ROOT, "test", "test_firmware.hex"), 'rb') as f:
+        test_hex = f.read()
+    write_seed("hex", test_hex)
+    write_seed("payload", payload_seed(create_firmware_package.PAYLOAD_INTEL_HEX, 0, test_hex))
+    for line in test_hex.splitlines():
+        write_seed("hex", line)
+
+    for path in sorted(glob.glob(os.path.join(ROOT, "firmware-v1.0.*.bin"))):
+        with open(path, 'rb') as f:
+            package = f.read()
+        write_seed("package", package)
+
+        parts = split_package(package)
+        if parts is None:
+            print(f"⚠️  {os.path.basename(path)}: not a valid package, used as a package seed only")
+            continue
+        metadata, firmware = parts
+        write_seed("metadata", metadata)
+        write_seed("hex", firmware)
+        write_seed("payload", payload_seed(create_firmware_package.PAYLOAD_INTEL_HEX, 0, firmware))
+        packed = create_firmware_package.pack_hex(firmware)
+        write_seed("payload", payload_seed(create_firmware_package.PAYLOAD_HEX_LZSS, len(packed),
+                                           create_firmware_package.lzss_compress(packed)))
+
+        # Both formats around the same firmware, the small HEX file and no firmware
+        for firmware_seed in (firmware, test_hex, b""):
+            for seed in make_packages(metadata, firmware_seed):
+                write_seed("package", seed)
+
+    with open(os.path.join(ROOT, "sample_metadata.json"), 'rb') as f:
+        sample = f.read()
+    write_seed("metadata", sample)
+    write_seed("metadata", json.dumps(json.loads(sample), separators=(',', ':')).encode('utf-8'))
+
+    for target in TARGETS:
+        count = len(os.listdir(os.path.join(CORPUS_DIR, target)))
+        print(f"✅ {target}: {count} seeds in {os.path.relpath(os.path.join(CORPUS_DIR, target), ROOT)}")
+
+def build_target(target, replay):
+    """Compile one target; returns the binary path or None."""
+    includes = ["-I" + os.path.join(ROOT, "lib", "FirmwareFormat"),
+                "-I" + os.path.join(ROOT, "lib", "Crc32"),
+                "-I" + os.path.join(ROOT, "lib", "FirmwareMetadata"),
+                "-I" + os.path.join(ROOT, "lib", "LzssDecoder"),
+                "-I" + os.path.join(ROOT, "lib", "HexPayloadReader")]
+    if "lib/FirmwareMetadata/FirmwareMetadata.cpp" in SOURCES[target]:
+        arduinojson = find_arduinojson()
+        if arduinojson is None:
+            print(f"⚠️  {target}: ArduinoJson not found, set ARDUINOJSON_DIR - skipped")
+            return None
+        includes.append("-I" + arduinojson)
+
+    os.makedirs(BUILD_DIR, exist_ok=True)
+    sources = [os.path.join(FUZZ_DIR, f"fuzz_{target}.cpp")] + [os.path.join(ROOT, s) for s in SOURCES[target]]
+    if replay:
+        compiler = os.environ.get("CXX", "g++")
+        flags = ["-fsanitize=address,undefined", "-fno-sanitize-recover=all"]
+        sources.append(os.path.join(FUZZ_DIR, "replay_main.cpp"))
+        output = os.path.join(BUILD_DIR, f"fuzz_{target}_replay")
+    else:
+        compiler = os.environ.get("CXX", "clang++")
+        flags = ["-fsanitize=fuzzer,address,undefined"]
+        output = os.path.join(BUILD_DIR, f"fuzz_{target}")
+
+    command = [compiler, "-std=gnu++11", "-g", "-O1"] + flags + includes + sources + ["-o", output]
+    if subprocess.call(command) != 0:
+        print(f"❌ {target}: build failed")
+        sys.exit(1)
+    return output
+
+def main():
+    if len(sys.argv) < 2 or sys.argv[1] not in ("corpus", "run", "replay"):
+        print(__doc__)
+        sys.exit(2)
+
+    command = sys.argv[1]
+    if command == "corpus":
+        build_corpus()
+        return
+
+    if not os.path.isdir(CORPUS_DIR):
+        build_corpus()
+
+    if command == "run":
+        if len(sys.argv) < 3 or sys.argv[2] not in TARGETS:
+            print(f"Usage: python3 fuzz/fuzz.py run <{'|'.join(TARGETS)}> [libFuzzer args...]")
+            sys.exit(2)
+        target = sys.argv[2]
+        binary = build_target(target, replay=False)
+        if binary is None:
+            sys.exit(1)
+        sys.exit(subprocess.call([binary, os.path.join(CORPUS_DIR, target)] + sys.argv[3:]))
+
+    built = 0
+    for target in TARGETS:
+        binary = build_target(target, replay=True)
+        if binary is None:
+            continue
+        if subprocess.call([binary, os.path.join(CORPUS_DIR, target)]) != 0:
+            print(f"❌ {target}: replay failed")
+            sys.exit(1)
+        built += 1
+    if built == 0:
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,43 @@
+// libFuzzer target: the input as an Intel HEX file, every line through the
+// record decoders and the whole file through the version scan
+#include "FirmwareFormat.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const char* hex = (const char*)data;
+    size_t position = 0;
+    
+    while (position < size) {
+        const char* line = hex + position;
+        const char* newline = (const char*)memchr(line, '\n', size - position);
+        size_t length = newline != nullptr ? (size_t)(newline - line) : size - position;
+        position += length + 1;
+        
+        HexRecord record;
+        bool decoded = FirmwareFormat::decodeRecord(line, length, record);
+        bool checksum = FirmwareFormat::verifyChecksum(line, length);
+        bool valid = FirmwareFormat::isValidHexLine(line, length);
+        
+        // Each check is stricter than the next
+        if ((decoded && !checksum) || (checksum && !valid)) {
+            abort();
+        }
+        if (decoded && length != FirmwareFormat::MIN_HEX_LINE + 2 * (size_t)record.length) {
+            abort();
+        }
+        
+        char text[FirmwareFormat::MAX_HEX_DATA + 1];
+        size_t textLength = FirmwareFormat::extractText(line, length, text, sizeof(text));
+        if (textLength != strlen(text) || (!valid && textLength != 0)) {
+            abort();
+        }
+    }
+    
+    char version[16];
+    char buildDate[16];
+    FirmwareFormat::extractVersion(hex, size, version, sizeof(version), buildDate, sizeof(buildDate));
+    return 0;
+}
@@ -0,0 +1,21 @@
+// libFuzzer target: the metadata JSON of a package
+#include "FirmwareMetadata.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    FirmwareMetadata metadata;
+    FirmwareMetadata::parse((const char*)data, size, metadata);
+    
+    // Every field terminated inside its buffer, parsed or not
+    if (strlen(metadata.version) >= sizeof(metadata.version) ||
+        strlen(metadata.description) >= sizeof(metadata.description) ||
+        strlen(metadata.board) >= sizeof(metadata.board) ||
+        strlen(metadata.buildDate) >= sizeof(metadata.buildDate) ||
+        strlen(metadata.features) >= sizeof(metadata.features)) {
+        abort();
+    }
+    return 0;
+}
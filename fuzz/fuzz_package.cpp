@@ -0,0 +1,39 @@
+// libFuzzer target: a whole uploaded package, through the same steps
+// uploadFirmwarePackage and extractFirmwarePackage take
+#include "FirmwareFormat.h"
+#include "FirmwareMetadata.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    FirmwarePackageLayout layout;
+    if (FirmwareFormat::parsePackageHeader(data, size, size, layout) != PACKAGE_OK) {
+        return 0;
+    }
+    
+    // The layout must stay inside the input; format 1 firmware runs to the end
+    if (layout.metadataOffset + layout.metadataLength > size ||
+        layout.firmwareOffset + layout.firmwareLength > size ||
+        (layout.formatVersion == FirmwareFormat::PACKAGE_FORMAT_V1 && layout.firmwareOffset + layout.firmwareLength != size)) {
+        abort();
+    }
+    if (FirmwareFormat::verifyPackage(data, size, layout) != PACKAGE_OK) {
+        return 0;
+    }
+    
+    FirmwareMetadata metadata;
+    if (layout.metadataLength > 0) {
+        FirmwareMetadata::parse((const char*)data + layout.metadataOffset, layout.metadataLength, metadata);
+    }
+    
+    char version[16];
+    char buildDate[16];
+    FirmwareFormat::extractVersion((const char*)data + layout.firmwareOffset, layout.firmwareLength,
+                                   version, sizeof(version), buildDate, sizeof(buildDate));
+    if (strlen(version) >= sizeof(version) || strlen(buildDate) >= sizeof(buildDate)) {
+        abort();
+    }
+    return 0;
+}
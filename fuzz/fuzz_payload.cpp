@@ -0,0 +1,64 @@
+// libFuzzer target: the input as a firmware payload through HexPayloadReader,
+// the way the flasher streams it. Byte 0 is the payload type, bytes 1-4 the
+// decoded length (LE), the rest the payload, read in uneven chunks.
+#include "HexPayloadReader.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+struct FuzzSource {
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+};
+
+static size_t readSource(void* context, uint8_t* buffer, size_t capacity) {
+    FuzzSource* source = (FuzzSource*)context;
+    size_t count = source->size - source->position;
+    // Short reads, like a File near a SPIFFS page boundary
+    if (count > capacity) {
+        count = capacity;
+    }
+    if (count > 1 + source->position % 37) {
+        count = 1 + source->position % 37;
+    }
+    memcpy(buffer, source->data + source->position, count);
+    source->position += count;
+    return count;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 5) {
+        return 0;
+    }
+    uint8_t payloadType = data[0] & 1;
+    uint32_t decodedLength = data[1] | (data[2] << 8) | (data[3] << 16) | ((uint32_t)data[4] << 24);
+    FuzzSource source = { data + 5, size - 5, 0 };
+    
+    HexPayloadReader reader(payloadType, source.size, decodedLength, readSource, &source);
+    char line[FirmwareFormat::MIN_HEX_LINE + 2 * FirmwareFormat::MAX_HEX_DATA + 1];
+    size_t length = 0;
+    HexRecord record;
+    uint32_t lines = 0;
+    
+    while (reader.nextLine(line, sizeof(line), length)) {
+        if (length >= sizeof(line) || line[length] != '\0' || line[0] != ':') {
+            abort();
+        }
+        // Packed records come out as well-formed lines with their checksums rebuilt
+        if (payloadType == PAYLOAD_HEX_LZSS && !FirmwareFormat::decodeRecord(line, length, record)) {
+            abort();
+        }
+        lines++;
+    }
+    
+    HexPayloadStatus status = reader.getStatus();
+    if (status == HEX_PAYLOAD_OK || reader.getLineNumber() < lines) {
+        abort();
+    }
+    if (source.position > source.size) {
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Runs inputs through a fuzz target without libFuzzer, for compilers that
+// don't ship it (gcc) and for replaying the corpus or a crash in CI:
+//
+//   fuzz_hex_replay fuzz/corpus/hex crash-1234...
+//
+// Directories are read one level deep.
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static bool runFile(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + count);
+    }
+    fclose(file);
+    
+    // Exact-size copy so ASan catches reads past the end
+    uint8_t* input = (uint8_t*)malloc(data.size() > 0 ? data.size() : 1);
+    if (!data.empty()) {
+        memcpy(input, &data[0], data.size());
+    }
+    LLVMFuzzerTestOneInput(input, data.size());
+    free(input);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int inputs = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        struct stat info;
+        if (stat(argv[i], &info) != 0) {
+            fprintf(stderr, "Cannot stat %s\n", argv[i]);
+            return 1;
+        }
+        
+        if (!S_ISDIR(info.st_mode)) {
+            inputs += runFile(argv[i]) ? 1 : 0;
+            continue;
+        }
+        
+        DIR* dir = opendir(argv[i]);
+        struct dirent* entry;
+        while (dir != nullptr && (entry = readdir(dir)) != nullptr) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            inputs += runFile(std::string(argv[i]) + "/" + entry->d_name) ? 1 : 0;
+        }
+        if (dir != nullptr) {
+            closedir(dir);
+        }
+    }
+    
+    printf("Replayed %d input(s)\n", inputs);
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include "Backoff.h"
+
+Backoff::Backoff(unsigned long initialDelay, unsigned long maxDelay, uint8_t jitterPercent)
+    : initialDelay(initialDelay), maxDelay(maxDelay), jitterPercent(jitterPercent > 100 ? 100 : jitterPercent),
+      baseDelay(initialDelay), attempts(0) {
+}
+
+unsigned long Backoff::next(uint32_t random) {
+    unsigned long delay = baseDelay;
+    
+    unsigned long spread = delay * jitterPercent / 100;
+    if (spread > 0) {
+        delay -= random % (spread + 1);
+    }
+    
+    if (baseDelay < maxDelay) {
+        baseDelay = baseDelay > maxDelay / 2 ? maxDelay : baseDelay * 2;
+    }
+    
+    if (attempts < UINT16_MAX) {
+        attempts++;
+    }
+    
+    return delay;
+}
+
+void Backoff::reset() {
+    baseDelay = initialDelay;
+    attempts = 0;
+}
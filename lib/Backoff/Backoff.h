@@ -0,0 +1,31 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdint.h>
+
+// Exponential backoff with jitter. Each delay is drawn from
+// [base * (100 - jitter%) / 100, base], then base doubles up to the cap, so
+// devices knocked offline by the same broker restart don't retry in lockstep.
+// The random value is passed in to keep this free of Arduino dependencies.
+class Backoff {
+public:
+    Backoff(unsigned long initialDelay, unsigned long maxDelay, uint8_t jitterPercent);
+    
+    // Delay before the next attempt, then grow the base
+    unsigned long next(uint32_t random);
+    
+    // Back to the initial delay, e.g. after a successful connect
+    void reset();
+    
+    unsigned long getBaseDelay() const { return baseDelay; }
+    uint16_t getAttempts() const { return attempts; }
+
+private:
+    unsigned long initialDelay;
+    unsigned long maxDelay;
+    uint8_t jitterPercent;
+    unsigned long baseDelay;
+    uint16_t attempts;
+};
+
+#endif
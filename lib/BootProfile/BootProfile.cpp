@@ -0,0 +1,231 @@
+#include "BootProfile.h"
+#include "Crc32.h"
+#include <string.h>
+
+static void putLE16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+}
+
+static void putLE32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+static uint16_t getLE16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t getLE32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Copies at most length - 1 characters and always terminates
+static void copyName(char* out, const char* in, size_t length) {
+    size_t i = 0;
+    for (; in != nullptr && in[i] != '\0' && i < length - 1; i++) {
+        out[i] = in[i];
+    }
+    memset(out + i, 0, length - i);
+}
+
+// BootProfile
+
+BootProfile::BootProfile() {
+    clear();
+}
+
+void BootProfile::clear() {
+    memset(firmware, 0, sizeof(firmware));
+    resetReason = 0;
+    bootCount = 0;
+    completedAt = 0;
+    freeHeap = 0;
+    minFreeHeap = 0;
+    phaseCount = 0;
+}
+
+void BootProfile::setFirmware(const char* version) {
+    copyName(firmware, version, sizeof(firmware));
+}
+
+bool BootProfile::add(const char* name, uint32_t startedAt, uint32_t finishedAt, int32_t heapDelta, BootPhaseStatus status) {
+    if (phaseCount >= MAX_PHASES) {
+        return false;
+    }
+    
+    BootPhaseRecord& record = phases[phaseCount++];
+    copyName(record.name, name, sizeof(record.name));
+    record.startedAt = startedAt;
+    record.finishedAt = finishedAt;
+    record.heapDelta = heapDelta;
+    record.status = status;
+    return true;
+}
+
+void BootProfile::capture(const BootSequencer& sequencer) {
+    for (int i = 0; i < sequencer.getPhaseCount(); i++) {
+        if (!sequencer.isFinished(i)) {
+            continue;
+        }
+        add(sequencer.getName(i), sequencer.getStartedAt(i), sequencer.getFinishedAt(i),
+            sequencer.getHeapDelta(i), sequencer.getStatus(i));
+    }
+}
+
+void BootProfile::finish(uint32_t completedAt, uint32_t freeHeap, uint32_t minFreeHeap) {
+    this->completedAt = completedAt;
+    this->freeHeap = freeHeap;
+    this->minFreeHeap = minFreeHeap;
+}
+
+int BootProfile::findPhase(const char* name) const {
+    for (int i = 0; i < phaseCount; i++) {
+        if (strncmp(phases[i].name, name, BootPhaseRecord::NAME_LENGTH - 1) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int BootProfile::getLongestPhase() const {
+    int longest = -1;
+    for (int i = 0; i < phaseCount; i++) {
+        if (longest == -1 || phases[i].duration() > phases[longest].duration()) {
+            longest = i;
+        }
+    }
+    return longest;
+}
+
+// BootHistory
+
+BootHistory::BootHistory() : newest(0), count(0) {
+}
+
+void BootHistory::clear() {
+    newest = 0;
+    count = 0;
+}
+
+void BootHistory::push(const BootProfile& profile) {
+    newest = (newest + MAX_BOOTS - 1) % MAX_BOOTS;
+    boots[newest] = profile;
+    if (count < MAX_BOOTS) {
+        count++;
+    }
+}
+
+const BootProfile& BootHistory::get(int index) const {
+    return boots[(newest + index) % MAX_BOOTS];
+}
+
+size_t BootHistory::serialize(uint8_t* buffer, size_t capacity) const {
+    if (capacity < HEADER_SIZE) {
+        return 0;
+    }
+    
+    size_t position = HEADER_SIZE;
+    
+    for (int b = 0; b < count; b++) {
+        const BootProfile& boot = get(b);
+        size_t bootSize = BOOT_HEADER_SIZE + boot.getPhaseCount() * PHASE_SIZE;
+        if (position + bootSize > capacity) {
+            return 0;
+        }
+        
+        uint8_t* out = buffer + position;
+        memcpy(out, boot.getFirmware(), BootProfile::VERSION_LENGTH);
+        out += BootProfile::VERSION_LENGTH;
+        *out++ = boot.getResetReason();
+        putLE32(out, boot.getBootCount()); out += 4;
+        putLE32(out, boot.getCompletedAt()); out += 4;
+        putLE32(out, boot.getFreeHeap()); out += 4;
+        putLE32(out, boot.getMinFreeHeap()); out += 4;
+        *out++ = boot.getPhaseCount();
+        
+        for (int p = 0; p < boot.getPhaseCount(); p++) {
+            const BootPhaseRecord& phase = boot.getPhase(p);
+            memcpy(out, phase.name, BootPhaseRecord::NAME_LENGTH);
+            out += BootPhaseRecord::NAME_LENGTH;
+            putLE32(out, phase.startedAt); out += 4;
+            putLE32(out, phase.finishedAt); out += 4;
+            putLE32(out, (uint32_t)phase.heapDelta); out += 4;
+            *out++ = phase.status;
+        }
+        
+        position += bootSize;
+    }
+    
+    uint32_t payloadLength = position - HEADER_SIZE;
+    putLE32(buffer, MAGIC);
+    putLE16(buffer + 4, FORMAT_VERSION);
+    putLE16(buffer + 6, count);
+    putLE32(buffer + 8, payloadLength);
+    putLE32(buffer + 12, Crc32::compute(buffer + HEADER_SIZE, payloadLength));
+    return position;
+}
+
+bool BootHistory::deserialize(const uint8_t* data, size_t length) {
+    clear();
+    
+    if (length < HEADER_SIZE || getLE32(data) != MAGIC || getLE16(data + 4) != FORMAT_VERSION) {
+        return false;
+    }
+    
+    uint16_t bootCount = getLE16(data + 6);
+    uint32_t payloadLength = getLE32(data + 8);
+    if (bootCount > MAX_BOOTS || payloadLength > length - HEADER_SIZE ||
+        Crc32::compute(data + HEADER_SIZE, payloadLength) != getLE32(data + 12)) {
+        return false;
+    }
+    
+    // Stored newest first, the same order get() uses with newest at 0
+    const uint8_t* in = data + HEADER_SIZE;
+    const uint8_t* end = in + payloadLength;
+    
+    for (int b = 0; b < bootCount; b++) {
+        if (end - in < (ptrdiff_t)BOOT_HEADER_SIZE) {
+            clear();
+            return false;
+        }
+        
+        BootProfile& boot = boots[b];
+        boot.clear();
+        char firmware[BootProfile::VERSION_LENGTH];
+        memcpy(firmware, in, sizeof(firmware));
+        firmware[sizeof(firmware) - 1] = '\0';
+        boot.setFirmware(firmware);
+        in += BootProfile::VERSION_LENGTH;
+        boot.setResetReason(*in++);
+        boot.setBootCount(getLE32(in)); in += 4;
+        uint32_t completedAt = getLE32(in); in += 4;
+        uint32_t freeHeap = getLE32(in); in += 4;
+        uint32_t minFreeHeap = getLE32(in); in += 4;
+        boot.finish(completedAt, freeHeap, minFreeHeap);
+        uint8_t phaseCount = *in++;
+        
+        if (phaseCount > BootProfile::MAX_PHASES || end - in < (ptrdiff_t)(phaseCount * PHASE_SIZE)) {
+            clear();
+            return false;
+        }
+        
+        for (int p = 0; p < phaseCount; p++) {
+            char name[BootPhaseRecord::NAME_LENGTH];
+            memcpy(name, in, sizeof(name));
+            name[sizeof(name) - 1] = '\0';
+            in += BootPhaseRecord::NAME_LENGTH;
+            uint32_t startedAt = getLE32(in); in += 4;
+            uint32_t finishedAt = getLE32(in); in += 4;
+            int32_t heapDelta = (int32_t)getLE32(in); in += 4;
+            BootPhaseStatus status = (BootPhaseStatus)*in++;
+            boot.add(name, startedAt, finishedAt, heapDelta, status);
+        }
+        
+        count = b + 1;
+    }
+    
+    return true;
+}
@@ -0,0 +1,102 @@
+#ifndef BOOTPROFILE_H
+#define BOOTPROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "BootSequencer.h"
+
+// Where one boot spent its time and heap, one row per phase, in a fixed
+// table so it can be filled before anything else is up.
+struct BootPhaseRecord {
+    static const size_t NAME_LENGTH = 16; // Including terminator
+    
+    char name[NAME_LENGTH];
+    uint32_t startedAt;    // ms since power-on
+    uint32_t finishedAt;
+    int32_t heapDelta;     // Negative when the phase used heap
+    uint8_t status;        // BootPhaseStatus
+    
+    uint32_t duration() const { return finishedAt - startedAt; }
+};
+
+class BootProfile {
+public:
+    static const int MAX_PHASES = BootSequencer::MAX_PHASES + 1; // + time before setup()
+    static const size_t VERSION_LENGTH = 16; // Including terminator
+    
+    BootProfile();
+    void clear();
+    
+    void setFirmware(const char* version);
+    void setResetReason(uint8_t reason) { resetReason = reason; }
+    void setBootCount(uint32_t count) { bootCount = count; }
+    
+    // Returns false when the table is full
+    bool add(const char* name, uint32_t startedAt, uint32_t finishedAt, int32_t heapDelta, BootPhaseStatus status);
+    // Appends every finished phase of the sequencer in the order they were added
+    void capture(const BootSequencer& sequencer);
+    void finish(uint32_t completedAt, uint32_t freeHeap, uint32_t minFreeHeap);
+    
+    const char* getFirmware() const { return firmware; }
+    uint8_t getResetReason() const { return resetReason; }
+    uint32_t getBootCount() const { return bootCount; }
+    uint32_t getCompletedAt() const { return completedAt; }
+    uint32_t getFreeHeap() const { return freeHeap; }
+    uint32_t getMinFreeHeap() const { return minFreeHeap; }
+    int getPhaseCount() const { return phaseCount; }
+    const BootPhaseRecord& getPhase(int index) const { return phases[index]; }
+    int findPhase(const char* name) const;
+    // -1 when empty
+    int getLongestPhase() const;
+
+private:
+    char firmware[VERSION_LENGTH];
+    uint8_t resetReason;
+    uint32_t bootCount;
+    uint32_t completedAt;
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;
+    BootPhaseRecord phases[MAX_PHASES];
+    int phaseCount;
+};
+
+// The last few boots, newest first, so a regression shows up next to the
+// boots of the previous firmware. Stored as:
+//
+//   [magic "FLBP"][format u16][boot count u16][payload length u32][payload crc32 u32]
+//   [boot]...
+//
+// Each boot is [firmware 16][reset reason u8][boot count u32][completed u32]
+// [free heap u32][min free heap u32][phase count u8] followed by phase
+// count x [name 16][started u32][finished u32][heap delta i32][status u8],
+// all little-endian.
+class BootHistory {
+public:
+    static const int MAX_BOOTS = 4;
+    static const uint32_t MAGIC = 0x50424C46; // "FLBP" on disk
+    static const uint16_t FORMAT_VERSION = 1;
+    static const size_t HEADER_SIZE = 16;
+    static const size_t BOOT_HEADER_SIZE = BootProfile::VERSION_LENGTH + 18;
+    static const size_t PHASE_SIZE = BootPhaseRecord::NAME_LENGTH + 13;
+    static const size_t MAX_SIZE = HEADER_SIZE + MAX_BOOTS * (BOOT_HEADER_SIZE + BootProfile::MAX_PHASES * PHASE_SIZE);
+    
+    BootHistory();
+    void clear();
+    
+    // Newest first; the oldest boot drops off when full
+    void push(const BootProfile& profile);
+    int getCount() const { return count; }
+    const BootProfile& get(int index) const;
+    
+    // Returns the image size, or 0 if it doesn't fit
+    size_t serialize(uint8_t* buffer, size_t capacity) const;
+    // Leaves the history empty if the image is damaged or from another format
+    bool deserialize(const uint8_t* data, size_t length);
+
+private:
+    BootProfile boots[MAX_BOOTS];
+    int newest;
+    int count;
+};
+
+#endif
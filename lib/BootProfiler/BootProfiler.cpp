@@ -0,0 +1,140 @@
+#include "BootProfiler.h"
+#include "Logger.h"
+#include <esp_system.h>
+
+const char* BootProfiler::HISTORY_FILE = "/boot_history.bin";
+
+BootProfile BootProfiler::current;
+BootHistory BootProfiler::history;
+bool BootProfiler::finished = false;
+uint32_t BootProfiler::setupStartedAt = 0;
+int32_t BootProfiler::coreHeapDelta = 0;
+
+void BootProfiler::begin(const char* firmwareVersion) {
+    setupStartedAt = millis();
+    // What the ROM, bootloader and Arduino core had taken by the time setup() ran
+    coreHeapDelta = (int32_t)(ESP.getFreeHeap() - ESP.getHeapSize());
+    
+    current.clear();
+    current.setFirmware(firmwareVersion);
+    current.setResetReason(esp_reset_reason());
+}
+
+uint32_t BootProfiler::sampleHeap() {
+    return ESP.getFreeHeap();
+}
+
+void BootProfiler::finish(const BootSequencer& sequencer) {
+    if (finished) {
+        return;
+    }
+    
+    current.add("core", 0, setupStartedAt, coreHeapDelta, BOOT_DONE);
+    current.capture(sequencer);
+    current.finish(sequencer.getCompletedAt(), ESP.getFreeHeap(), ESP.getMinFreeHeap());
+    
+    // Boot numbers carry on from the stored history
+    loadHistory();
+    current.setBootCount(history.getCount() > 0 ? history.get(0).getBootCount() + 1 : 1);
+    
+    printReport();
+    
+    history.push(current);
+    if (!saveHistory()) {
+        Logger::addEntry("Failed to save boot history");
+    }
+    finished = true;
+}
+
+bool BootProfiler::isFinished() {
+    return finished;
+}
+
+const BootHistory& BootProfiler::getHistory() {
+    return history;
+}
+
+const char* BootProfiler::resetReasonToString(uint8_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON: return "power_on";
+        case ESP_RST_EXT: return "external";
+        case ESP_RST_SW: return "software";
+        case ESP_RST_PANIC: return "panic";
+        case ESP_RST_INT_WDT:
+        case ESP_RST_TASK_WDT:
+        case ESP_RST_WDT: return "watchdog";
+        case ESP_RST_DEEPSLEEP: return "deep_sleep";
+        case ESP_RST_BROWNOUT: return "brownout";
+        default: return "unknown";
+    }
+}
+
+bool BootProfiler::loadHistory() {
+    if (!SPIFFS.exists(HISTORY_FILE)) {
+        return false;
+    }
+    
+    File file = SPIFFS.open(HISTORY_FILE, "r");
+    if (!file) {
+        return false;
+    }
+    
+    static uint8_t buffer[BootHistory::MAX_SIZE];
+    size_t size = file.size();
+    size_t bytesRead = size <= sizeof(buffer) ? file.read(buffer, size) : 0;
+    file.close();
+    
+    // A damaged or older-format history is dropped, not worth a migration
+    if (!history.deserialize(buffer, bytesRead)) {
+        Logger::addEntry("Discarding unreadable boot history");
+        return false;
+    }
+    return true;
+}
+
+bool BootProfiler::saveHistory() {
+    static uint8_t buffer[BootHistory::MAX_SIZE];
+    size_t size = history.serialize(buffer, sizeof(buffer));
+    if (size == 0) {
+        return false;
+    }
+    
+    File file = SPIFFS.open(HISTORY_FILE, "w");
+    if (!file) {
+        return false;
+    }
+    
+    size_t bytesWritten = file.write(buffer, size);
+    file.close();
+    return bytesWritten == size;
+}
+
+void BootProfiler::printReport() {
+    char line[80];
+    
+    Logger::addEntry("Boot #" + String(current.getBootCount()) + " (" + current.getFirmware() + ", " +
+                     resetReasonToString(current.getResetReason()) + ") complete in " +
+                     String(current.getCompletedAt()) + " ms, heap " + String(current.getFreeHeap()) +
+                     " free, " + String(current.getMinFreeHeap()) + " min");
+    
+    snprintf(line, sizeof(line), "  %-15s %7s %7s %7s %8s", "phase", "start", "end", "ms", "heap");
+    Logger::addEntry(line);
+    
+    for (int i = 0; i < current.getPhaseCount(); i++) {
+        const BootPhaseRecord& phase = current.getPhase(i);
+        snprintf(line, sizeof(line), "  %-15s %7lu %7lu %7lu %8ld%s", phase.name,
+                 (unsigned long)phase.startedAt, (unsigned long)phase.finishedAt,
+                 (unsigned long)phase.duration(), (long)phase.heapDelta,
+                 phase.status == BOOT_FAILED ? " FAILED" : "");
+        Logger::addEntry(line);
+    }
+    
+    // Compare with the previous boot, a firmware change shows up here first
+    if (history.getCount() > 0) {
+        const BootProfile& previous = history.get(0);
+        long change = (long)current.getCompletedAt() - (long)previous.getCompletedAt();
+        Logger::addEntry("Previous boot #" + String(previous.getBootCount()) + " (" + previous.getFirmware() +
+                         ") took " + String(previous.getCompletedAt()) + " ms (" + (change >= 0 ? "+" : "") +
+                         String(change) + " ms)");
+    }
+}
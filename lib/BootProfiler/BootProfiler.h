@@ -0,0 +1,43 @@
+#ifndef BOOTPROFILER_H
+#define BOOTPROFILER_H
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include "BootSequencer.h"
+#include "BootProfile.h"
+
+// Cold-start report: when each boot phase ran and what it cost in heap,
+// printed once the sequencer completes and kept in flash for the last few
+// boots so a slower firmware shows up next to the one before it.
+class BootProfiler {
+public:
+    // First thing in setup(); everything before it is reported as "core"
+    static void begin(const char* firmwareVersion);
+    
+    // Free heap, for BootSequencer::setHeapProbe()
+    static uint32_t sampleHeap();
+    
+    // Once the sequencer has completed: builds the table, prints it and
+    // adds it to the stored history (needs SPIFFS mounted)
+    static void finish(const BootSequencer& sequencer);
+    static bool isFinished();
+    
+    // Newest first; this boot is entry 0 once finish() ran
+    static const BootHistory& getHistory();
+    static const char* resetReasonToString(uint8_t reason);
+    
+private:
+    static const char* HISTORY_FILE;
+    
+    static BootProfile current;
+    static BootHistory history;
+    static bool finished;
+    static uint32_t setupStartedAt;
+    static int32_t coreHeapDelta;
+    
+    static bool loadHistory();
+    static bool saveHistory();
+    static void printReport();
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "BootSequencer.h"
+
+BootSequencer::BootSequencer(BootClock clock)
+    : clock(clock), listener(nullptr), heapProbe(nullptr), phaseCount(0), finishedMask(0), complete(false), completedAt(0) {
+}
+
+int BootSequencer::add(const char* name, BootStart start, BootPoll poll, uint32_t after) {
+    if (phaseCount >= MAX_PHASES) {
+        return -1;
+    }
+    
+    Phase& phase = phases[phaseCount];
+    phase.name = name;
+    phase.start = start;
+    phase.poll = poll;
+    phase.after = after;
+    phase.status = BOOT_WAITING;
+    phase.startedAt = 0;
+    phase.finishedAt = 0;
+    phase.heapAtStart = 0;
+    phase.heapAtFinish = 0;
+    return phaseCount++;
+}
+
+void BootSequencer::setListener(BootListener listener) {
+    this->listener = listener;
+}
+
+void BootSequencer::setHeapProbe(BootProbe probe) {
+    heapProbe = probe;
+}
+
+bool BootSequencer::run() {
+    // Running phases get one poll per call
+    for (int i = 0; i < phaseCount; i++) {
+        Phase& phase = phases[i];
+        if (phase.status != BOOT_RUNNING) {
+            continue;
+        }
+        
+        BootPhaseStatus status = phase.poll(clock() - phase.startedAt);
+        if (status == BOOT_DONE || status == BOOT_FAILED) {
+            finish(i, status);
+        }
+    }
+    
+    // Starting a phase can finish it, which can make later phases ready
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int i = 0; i < phaseCount; i++) {
+            Phase& phase = phases[i];
+            if (phase.status != BOOT_WAITING || (phase.after & finishedMask) != phase.after) {
+                continue;
+            }
+            
+            phase.startedAt = clock();
+            phase.heapAtStart = heapProbe != nullptr ? heapProbe() : 0;
+            phase.status = BOOT_RUNNING;
+            progress = true;
+            
+            bool ok = phase.start == nullptr || phase.start();
+            if (!ok) {
+                finish(i, BOOT_FAILED);
+            } else if (phase.poll == nullptr) {
+                finish(i, BOOT_DONE);
+            }
+        }
+    }
+    
+    if (!complete && isComplete()) {
+        complete = true;
+        completedAt = clock();
+    }
+    return complete;
+}
+
+bool BootSequencer::isComplete() const {
+    return finishedMask == (1UL << phaseCount) - 1;
+}
+
+bool BootSequencer::isFinished(int phase) const {
+    return phase >= 0 && phase < phaseCount && (finishedMask & bit(phase)) != 0;
+}
+
+void BootSequencer::finish(int phase, BootPhaseStatus status) {
+    phases[phase].status = status;
+    phases[phase].finishedAt = clock();
+    phases[phase].heapAtFinish = heapProbe != nullptr ? heapProbe() : 0;
+    finishedMask |= bit(phase);
+    
+    if (listener != nullptr) {
+        listener(*this, phase);
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef BOOTSEQUENCER_H
+#define BOOTSEQUENCER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum BootPhaseStatus : uint8_t {
+    BOOT_WAITING = 0,   // Dependencies still running
+    BOOT_RUNNING,       // Started, being polled
+    BOOT_DONE,
+    BOOT_FAILED
+};
+
+typedef bool (*BootStart)();                             // false = failed
+typedef BootPhaseStatus (*BootPoll)(unsigned long elapsed); // RUNNING until finished
+typedef unsigned long (*BootClock)();
+typedef uint32_t (*BootProbe)();                         // e.g. free heap
+
+class BootSequencer;
+typedef void (*BootListener)(const BootSequencer& sequencer, int phase);
+
+// Startup as a set of phases with explicit dependencies instead of a fixed
+// order with sleeps in between. A phase starts as soon as everything it
+// depends on has finished (done or failed, the phase decides whether it
+// can do without). Phases without a poll function finish when start()
+// returns; the others keep running, e.g. WiFi association, while
+// independent phases go ahead. No Arduino dependency; the clock is passed in.
+class BootSequencer {
+public:
+    static const int MAX_PHASES = 16;
+    
+    explicit BootSequencer(BootClock clock);
+    
+    // Returns the phase id, or -1 if the table is full. Names must outlive the sequencer.
+    int add(const char* name, BootStart start, BootPoll poll = nullptr, uint32_t after = 0);
+    static uint32_t bit(int phase) { return phase < 0 ? 0 : 1UL << phase; }
+    
+    // Called whenever a phase finishes
+    void setListener(BootListener listener);
+    
+    // Sampled as each phase starts and finishes. Phases that overlap (a
+    // polled phase and the ones started meanwhile) share their deltas.
+    void setHeapProbe(BootProbe probe);
+    
+    // Polls running phases once and starts every phase that became ready.
+    // True once every phase has finished.
+    bool run();
+    
+    bool isComplete() const;
+    bool isFinished(int phase) const;
+    unsigned long getCompletedAt() const { return completedAt; }
+    
+    int getPhaseCount() const { return phaseCount; }
+    const char* getName(int phase) const { return phases[phase].name; }
+    BootPhaseStatus getStatus(int phase) const { return phases[phase].status; }
+    unsigned long getStartedAt(int phase) const { return phases[phase].startedAt; }
+    unsigned long getFinishedAt(int phase) const { return phases[phase].finishedAt; }
+    unsigned long getDuration(int phase) const { return phases[phase].finishedAt - phases[phase].startedAt; }
+    // Negative when the phase left less free heap than it started with
+    int32_t getHeapDelta(int phase) const { return (int32_t)(phases[phase].heapAtFinish - phases[phase].heapAtStart); }
+
+private:
+    struct Phase {
+        const char* name;
+        BootStart start;
+        BootPoll poll;
+        uint32_t after;
+        BootPhaseStatus status;
+        unsigned long startedAt;
+        unsigned long finishedAt;
+        uint32_t heapAtStart;
+        uint32_t heapAtFinish;
+    };
+    
+    BootClock clock;
+    BootListener listener;
+    BootProbe heapProbe;
+    Phase phases[MAX_PHASES];
+    int phaseCount;
+    uint32_t finishedMask;
+    bool complete;
+    unsigned long completedAt;
+    
+    void finish(int phase, BootPhaseStatus status);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "ConfigImage.h"
+#include <string.h>
+
+// Field ids in the binary config image. Never renumber or reuse an id;
+// retire it and pick a new one instead.
+enum ConfigFieldId : uint8_t {
+    FIELD_MQTT_BROKER_IP = 1,
+    FIELD_MQTT_BROKER_PORT = 2,
+    FIELD_MQTT_USERNAME = 3,
+    FIELD_MQTT_PASSWORD = 4,
+    FIELD_MQTT_DEVICE_NAME = 5,
+    FIELD_MQTT_DEVICE_ID = 6,
+    FIELD_MQTT_PREFIX = 7,
+    
+    FIELD_WIFI_SSID = 16,
+    FIELD_WIFI_PASSWORD = 17,
+    FIELD_WIFI_BSSID = 18,
+    FIELD_WIFI_CHANNEL = 19,
+    FIELD_WIFI_STATIC_IP = 20,
+    FIELD_WIFI_IP = 21,
+    FIELD_WIFI_GATEWAY = 22,
+    FIELD_WIFI_SUBNET = 23,
+    FIELD_WIFI_DNS = 24
+};
+
+static void writeString(ConfigWriter& writer, uint8_t id, const String& value) {
+    writer.writeString(id, value.c_str(), value.length());
+}
+
+static void assignString(String& target, const ConfigField& field) {
+    target = "";
+    target.concat((const char*)field.value, field.length);
+}
+
+size_t ConfigImage::encode(const MQTTConfig& mqtt, const WiFiConfig& wifi, uint16_t schemaVersion,
+                           uint8_t* buffer, size_t capacity) {
+    ConfigWriter writer(buffer, capacity);
+    
+    writeString(writer, FIELD_MQTT_BROKER_IP, mqtt.brokerIP);
+    writer.writeU16(FIELD_MQTT_BROKER_PORT, mqtt.brokerPort);
+    writeString(writer, FIELD_MQTT_USERNAME, mqtt.username);
+    writeString(writer, FIELD_MQTT_PASSWORD, mqtt.password);
+    writeString(writer, FIELD_MQTT_DEVICE_NAME, mqtt.deviceName);
+    writeString(writer, FIELD_MQTT_DEVICE_ID, mqtt.deviceId);
+    writeString(writer, FIELD_MQTT_PREFIX, mqtt.mqttPrefix);
+    
+    writeString(writer, FIELD_WIFI_SSID, wifi.ssid);
+    writeString(writer, FIELD_WIFI_PASSWORD, wifi.password);
+    if (wifi.hasLink()) {
+        writer.writeBlob(FIELD_WIFI_BSSID, wifi.bssid, sizeof(wifi.bssid));
+        writer.writeU8(FIELD_WIFI_CHANNEL, wifi.channel);
+    }
+    writer.writeBool(FIELD_WIFI_STATIC_IP, wifi.staticIp);
+    if (wifi.staticIp && wifi.hasAddress()) {
+        writer.writeU32(FIELD_WIFI_IP, wifi.ip);
+        writer.writeU32(FIELD_WIFI_GATEWAY, wifi.gateway);
+        writer.writeU32(FIELD_WIFI_SUBNET, wifi.subnet);
+        writer.writeU32(FIELD_WIFI_DNS, wifi.dns);
+    }
+    
+    return writer.finish(schemaVersion);
+}
+
+ConfigReader::Status ConfigImage::decode(const uint8_t* data, size_t length, MQTTConfig& mqtt,
+                                         WiFiConfig& wifi, uint16_t& schemaVersion) {
+    ConfigReader reader;
+    ConfigReader::Status status = reader.open(data, length);
+    if (status != ConfigReader::OK) {
+        return status;
+    }
+    schemaVersion = reader.getSchemaVersion();
+    
+    ConfigField field;
+    while (reader.next(field)) {
+        switch (field.id) {
+            case FIELD_MQTT_BROKER_IP: assignString(mqtt.brokerIP, field); break;
+            case FIELD_MQTT_BROKER_PORT: mqtt.brokerPort = field.asU32(); break;
+            case FIELD_MQTT_USERNAME: assignString(mqtt.username, field); break;
+            case FIELD_MQTT_PASSWORD: assignString(mqtt.password, field); break;
+            case FIELD_MQTT_DEVICE_NAME: assignString(mqtt.deviceName, field); break;
+            case FIELD_MQTT_DEVICE_ID: assignString(mqtt.deviceId, field); break;
+            case FIELD_MQTT_PREFIX: assignString(mqtt.mqttPrefix, field); break;
+            case FIELD_WIFI_SSID: assignString(wifi.ssid, field); break;
+            case FIELD_WIFI_PASSWORD: assignString(wifi.password, field); break;
+            case FIELD_WIFI_BSSID:
+                if (field.length == sizeof(wifi.bssid)) {
+                    memcpy(wifi.bssid, field.value, field.length);
+                }
+                break;
+            case FIELD_WIFI_CHANNEL: wifi.channel = field.asU32(); break;
+            case FIELD_WIFI_STATIC_IP: wifi.staticIp = field.asBool(); break;
+            case FIELD_WIFI_IP: wifi.ip = field.asU32(); break;
+            case FIELD_WIFI_GATEWAY: wifi.gateway = field.asU32(); break;
+            case FIELD_WIFI_SUBNET: wifi.subnet = field.asU32(); break;
+            case FIELD_WIFI_DNS: wifi.dns = field.asU32(); break;
+            default: break; // Field from a newer schema
+        }
+    }
+    
+    return ConfigReader::OK;
+}
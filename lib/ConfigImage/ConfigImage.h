@@ -0,0 +1,50 @@
+#ifndef CONFIGIMAGE_H
+#define CONFIGIMAGE_H
+
+#include <Arduino.h>
+#include "ConfigStore.h"
+
+struct MQTTConfig {
+    String brokerIP;
+    int brokerPort;
+    String username;
+    String password;
+    String deviceName;
+    String deviceId;
+    String mqttPrefix;
+};
+
+struct WiFiConfig {
+    String ssid;
+    String password;
+    
+    // Last good association, lets the next boot skip the channel scan
+    uint8_t bssid[6];
+    uint8_t channel;       // 0 when unknown
+    
+    // Fixed address, only used when staticIp is set
+    bool staticIp;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    
+    bool hasLink() const { return channel != 0; }
+    bool hasAddress() const { return ip != 0 && subnet != 0; }
+};
+
+// The settings ConfigManager persists, as a ConfigStore image in memory.
+// No file access, so the native tests and benchmarks run the real layout.
+class ConfigImage {
+public:
+    // Returns the image size, or 0 if it doesn't fit in capacity
+    static size_t encode(const MQTTConfig& mqtt, const WiFiConfig& wifi, uint16_t schemaVersion,
+                         uint8_t* buffer, size_t capacity);
+    
+    // Applies every known field over mqtt and wifi; missing ones keep their
+    // values. Nothing is touched unless the image is valid.
+    static ConfigReader::Status decode(const uint8_t* data, size_t length, MQTTConfig& mqtt,
+                                       WiFiConfig& wifi, uint16_t& schemaVersion);
+};
+
+#endif
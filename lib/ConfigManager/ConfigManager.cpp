@@ -1,9 +1,54 @@
 #include "ConfigManager.h"
+#include "Logger.h"
 
 // Static member initialization
 MQTTConfig ConfigManager::mqttConfig;
 WiFiConfig ConfigManager::wifiConfig;
-const char* ConfigManager::CONFIG_FILE = "/config.json";
+const char* ConfigManager::CONFIG_FILE = "/config.bin";
+const char* ConfigManager::CONFIG_TEMP_FILE = "/config.bin.tmp";
+const char* ConfigManager::LEGACY_JSON_FILE = "/config.json";
+
+uint32_t ConfigManager::configVersion = 1;
+bool ConfigManager::dirty = false;
+unsigned long ConfigManager::dirtySince = 0;
+unsigned long ConfigManager::flashWrites = 0;
+unsigned long ConfigManager::writesSkipped = 0;
+unsigned long ConfigManager::writesCoalesced = 0;
+size_t ConfigManager::storedSize = 0;
+
+// Schema migrations: MIGRATIONS[n] upgrades the in-RAM config from
+// schema n to n + 1, after the stored fields have been applied. New
+// fields don't need an entry (missing ids keep their defaults), only
+// changes in the meaning of existing fields do. Schema 0 is the old
+// /config.json, which is handled by importLegacyJson().
+typedef bool (*ConfigMigration)();
+
+static const ConfigMigration MIGRATIONS[] = {
+    nullptr // 0 -> 1: legacy JSON import
+};
+
+static_assert(sizeof(MIGRATIONS) / sizeof(MIGRATIONS[0]) == ConfigManager::SCHEMA_VERSION,
+              "Every schema version needs a migration entry");
+
+static bool parseStaticAddress(JsonObject wifi, WiFiConfig& target) {
+    IPAddress ip, gateway, subnet, dns;
+    if (!ip.fromString((const char*)(wifi["ip"] | "")) ||
+        !gateway.fromString((const char*)(wifi["gateway"] | "")) ||
+        !subnet.fromString((const char*)(wifi["subnet"] | "255.255.255.0"))) {
+        return false;
+    }
+    
+    // DNS defaults to the gateway, which is what most routers serve
+    if (!dns.fromString((const char*)(wifi["dns"] | ""))) {
+        dns = gateway;
+    }
+    
+    target.ip = ip;
+    target.gateway = gateway;
+    target.subnet = subnet;
+    target.dns = dns;
+    return target.hasAddress();
+}
 
 bool ConfigManager::init() {
     // SPIFFS is initialized in main.cpp, so we don't need to initialize it here
@@ -12,15 +57,40 @@ bool ConfigManager::init() {
     return true;
 }
 
+void ConfigManager::loop() {
+    // Deferred commit once the burst of changes has settled
+    if (dirty && millis() - dirtySince >= COMMIT_DELAY) {
+        saveConfig();
+    }
+}
+
 bool ConfigManager::loadConfig() {
+    configVersion++;
+    dirty = false;
     return parseConfigFile();
 }
 
 bool ConfigManager::saveConfig() {
-    return writeConfigFile();
+    if (!dirty) {
+        return true;
+    }
+    
+    if (!writeConfigFile()) {
+        Logger::addEntry("Failed to commit configuration");
+        return false;
+    }
+    
+    dirty = false;
+    flashWrites++;
+    Logger::addEntry("Configuration committed (writes: " + String(flashWrites) + ", skipped: " + String(writesSkipped) + ", coalesced: " + String(writesCoalesced) + ")");
+    return true;
 }
 
-MQTTConfig ConfigManager::getMQTTConfig() {
+uint32_t ConfigManager::getConfigVersion() {
+    return configVersion;
+}
+
+const MQTTConfig& ConfigManager::getMQTTConfig() {
     return mqttConfig;
 }
 
@@ -28,6 +98,14 @@ bool ConfigManager::updateMQTTConfig(const String& brokerIP, int brokerPort,
                                    const String& username, const String& password,
                                    const String& deviceName, const String& deviceId,
                                    const String& mqttPrefix) {
+    if (mqttConfig.brokerIP == brokerIP && mqttConfig.brokerPort == brokerPort &&
+        mqttConfig.username == username && mqttConfig.password == password &&
+        mqttConfig.deviceName == deviceName && mqttConfig.deviceId == deviceId &&
+        mqttConfig.mqttPrefix == mqttPrefix) {
+        writesSkipped++;
+        return true;
+    }
+    
     mqttConfig.brokerIP = brokerIP;
     mqttConfig.brokerPort = brokerPort;
     mqttConfig.username = username;
@@ -36,68 +114,80 @@ bool ConfigManager::updateMQTTConfig(const String& brokerIP, int brokerPort,
     mqttConfig.deviceId = deviceId;
     mqttConfig.mqttPrefix = mqttPrefix;
     
+    // User-initiated change, commit now so the result can be reported
+    markDirty();
     return saveConfig();
 }
 
-WiFiConfig ConfigManager::getWiFiConfig() {
+const WiFiConfig& ConfigManager::getWiFiConfig() {
     return wifiConfig;
 }
 
 void ConfigManager::setWiFiConfig(const String& ssid, const String& password) {
+    if (wifiConfig.ssid == ssid && wifiConfig.password == password) {
+        writesSkipped++;
+        return;
+    }
+    
+    // The cached access point belongs to the old network
+    if (wifiConfig.ssid != ssid) {
+        clearWiFiCache();
+    }
+    
     wifiConfig.ssid = ssid;
     wifiConfig.password = password;
-    saveConfig();
+    markDirty();
 }
 
-bool ConfigManager::parseConfigFile() {
-    if (!SPIFFS.exists(CONFIG_FILE)) {
-        return false;
+void ConfigManager::setWiFiLink(const uint8_t* bssid, uint8_t channel) {
+    if (!bssid || channel == 0) {
+        return;
     }
     
-    File file = SPIFFS.open(CONFIG_FILE, "r");
-    if (!file) {
-        return false;
+    // Roaming between the same access points shouldn't wear the flash
+    if (wifiConfig.channel == channel && memcmp(wifiConfig.bssid, bssid, sizeof(wifiConfig.bssid)) == 0) {
+        writesSkipped++;
+        return;
     }
     
-    DynamicJsonDocument doc(1024);
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
-    
-    if (error) {
-        return false;
+    memcpy(wifiConfig.bssid, bssid, sizeof(wifiConfig.bssid));
+    wifiConfig.channel = channel;
+    scheduleCommit();
+}
+
+void ConfigManager::clearWiFiLink() {
+    if (!wifiConfig.hasLink() && (wifiConfig.staticIp || !wifiConfig.hasAddress())) {
+        return;
     }
     
-    // Parse MQTT config
-    if (doc.containsKey("mqtt")) {
-        JsonObject mqtt = doc["mqtt"];
-        mqttConfig.brokerIP = mqtt["brokerIP"] | "192.168.1.100";
-        mqttConfig.brokerPort = mqtt["brokerPort"] | 1883;
-        mqttConfig.username = mqtt["username"] | "";
-        mqttConfig.password = mqtt["password"] | "";
-        mqttConfig.deviceName = mqtt["deviceName"] | "ESP32_C3_Mini";
-        mqttConfig.deviceId = mqtt["deviceId"] | "esp32_c3_mini_1";
-        mqttConfig.mqttPrefix = mqtt["mqttPrefix"] | "homeassistant";
-    }
+    clearWiFiCache();
+    scheduleCommit();
+}
+
+void ConfigManager::clearWiFiCache() {
+    memset(wifiConfig.bssid, 0, sizeof(wifiConfig.bssid));
+    wifiConfig.channel = 0;
     
-    // Parse WiFi config
-    if (doc.containsKey("wifi")) {
-        JsonObject wifi = doc["wifi"];
-        wifiConfig.ssid = wifi["ssid"] | "";
-        wifiConfig.password = wifi["password"] | "";
+    if (!wifiConfig.staticIp) {
+        wifiConfig.ip = 0;
+        wifiConfig.gateway = 0;
+        wifiConfig.subnet = 0;
+        wifiConfig.dns = 0;
     }
-    
-    return true;
 }
 
-bool ConfigManager::writeConfigFile() {
+String ConfigManager::exportJson(bool includeSecrets) {
     DynamicJsonDocument doc(1024);
+    doc["schema"] = (int)SCHEMA_VERSION;
     
     // MQTT config
     JsonObject mqtt = doc.createNestedObject("mqtt");
     mqtt["brokerIP"] = mqttConfig.brokerIP;
     mqtt["brokerPort"] = mqttConfig.brokerPort;
     mqtt["username"] = mqttConfig.username;
-    mqtt["password"] = mqttConfig.password;
+    if (includeSecrets) {
+        mqtt["password"] = mqttConfig.password;
+    }
     mqtt["deviceName"] = mqttConfig.deviceName;
     mqtt["deviceId"] = mqttConfig.deviceId;
     mqtt["mqttPrefix"] = mqttConfig.mqttPrefix;
@@ -105,17 +195,253 @@ bool ConfigManager::writeConfigFile() {
     // WiFi config
     JsonObject wifi = doc.createNestedObject("wifi");
     wifi["ssid"] = wifiConfig.ssid;
-    wifi["password"] = wifiConfig.password;
+    if (includeSecrets) {
+        wifi["password"] = wifiConfig.password;
+    }
+    // The cached access point isn't a setting, only a fixed address is
+    wifi["staticIp"] = wifiConfig.staticIp;
+    if (wifiConfig.staticIp) {
+        wifi["ip"] = IPAddress(wifiConfig.ip).toString();
+        wifi["gateway"] = IPAddress(wifiConfig.gateway).toString();
+        wifi["subnet"] = IPAddress(wifiConfig.subnet).toString();
+        wifi["dns"] = IPAddress(wifiConfig.dns).toString();
+    }
+    
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
+
+bool ConfigManager::importJson(const String& json) {
+    DynamicJsonDocument doc(1024);
+    DeserializationError error = deserializeJson(doc, json);
+    
+    if (error) {
+        Logger::addEntry("Config import failed: " + String(error.c_str()));
+        return false;
+    }
     
-    File file = SPIFFS.open(CONFIG_FILE, "w");
+    // Check a fixed address before anything is applied
+    WiFiConfig staticAddress;
+    staticAddress.staticIp = doc["wifi"]["staticIp"] | false;
+    if (staticAddress.staticIp && !parseStaticAddress(doc["wifi"].as<JsonObject>(), staticAddress)) {
+        Logger::addEntry("Config import failed: invalid static IP settings");
+        return false;
+    }
+    
+    // Keys that are absent (e.g. secrets left out of an export) keep their current value
+    if (doc.containsKey("mqtt")) {
+        JsonObject mqtt = doc["mqtt"];
+        mqttConfig.brokerIP = mqtt["brokerIP"] | mqttConfig.brokerIP.c_str();
+        mqttConfig.brokerPort = mqtt["brokerPort"] | mqttConfig.brokerPort;
+        mqttConfig.username = mqtt["username"] | mqttConfig.username.c_str();
+        mqttConfig.password = mqtt["password"] | mqttConfig.password.c_str();
+        mqttConfig.deviceName = mqtt["deviceName"] | mqttConfig.deviceName.c_str();
+        mqttConfig.deviceId = mqtt["deviceId"] | mqttConfig.deviceId.c_str();
+        mqttConfig.mqttPrefix = mqtt["mqttPrefix"] | mqttConfig.mqttPrefix.c_str();
+    }
+    
+    if (doc.containsKey("wifi")) {
+        JsonObject wifi = doc["wifi"];
+        String ssid = wifi["ssid"] | wifiConfig.ssid.c_str();
+        if (ssid != wifiConfig.ssid) {
+            clearWiFiCache();
+        }
+        wifiConfig.ssid = ssid;
+        wifiConfig.password = wifi["password"] | wifiConfig.password.c_str();
+        
+        if (wifi.containsKey("staticIp")) {
+            wifiConfig.staticIp = staticAddress.staticIp;
+            if (wifiConfig.staticIp) {
+                wifiConfig.ip = staticAddress.ip;
+                wifiConfig.gateway = staticAddress.gateway;
+                wifiConfig.subnet = staticAddress.subnet;
+                wifiConfig.dns = staticAddress.dns;
+            } else {
+                // Back to DHCP, the old fixed address is no longer used
+                clearWiFiCache();
+            }
+        }
+    }
+    
+    markDirty();
+    return saveConfig();
+}
+
+bool ConfigManager::isDirty() {
+    return dirty;
+}
+
+unsigned long ConfigManager::getFlashWrites() {
+    return flashWrites;
+}
+
+unsigned long ConfigManager::getWritesSkipped() {
+    return writesSkipped;
+}
+
+unsigned long ConfigManager::getWritesCoalesced() {
+    return writesCoalesced;
+}
+
+size_t ConfigManager::getStoredSize() {
+    return storedSize;
+}
+
+void ConfigManager::markDirty() {
+    configVersion++;
+    scheduleCommit();
+}
+
+void ConfigManager::scheduleCommit() {
+    if (dirty) {
+        // Already waiting on a commit, this change rides along with it
+        writesCoalesced++;
+        return;
+    }
+    
+    dirty = true;
+    dirtySince = millis();
+}
+
+bool ConfigManager::parseConfigFile() {
+    if (readConfigImage(CONFIG_FILE)) {
+        return true;
+    }
+    
+    // A power cut between remove and rename leaves only the temp file
+    if (readConfigImage(CONFIG_TEMP_FILE)) {
+        Logger::addEntry("Recovered configuration from " + String(CONFIG_TEMP_FILE));
+        if (SPIFFS.exists(CONFIG_FILE)) {
+            SPIFFS.remove(CONFIG_FILE);
+        }
+        SPIFFS.rename(CONFIG_TEMP_FILE, CONFIG_FILE);
+        return true;
+    }
+    
+    return importLegacyJson();
+}
+
+bool ConfigManager::readConfigImage(const char* path) {
+    if (!SPIFFS.exists(path)) {
+        return false;
+    }
+    
+    File file = SPIFFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    
+    size_t size = file.size();
+    if (size > MAX_CONFIG_SIZE) {
+        file.close();
+        Logger::addEntry("Config image too large: " + String(size) + " bytes");
+        return false;
+    }
+    
+    uint8_t buffer[MAX_CONFIG_SIZE];
+    size_t bytesRead = file.read(buffer, size);
+    file.close();
+    
+    uint16_t schema = 0;
+    ConfigReader::Status status = ConfigImage::decode(buffer, bytesRead, mqttConfig, wifiConfig, schema);
+    if (status != ConfigReader::OK) {
+        Logger::addEntry("Invalid config image " + String(path) + ": " + ConfigStore::statusToString(status));
+        return false;
+    }
+    
+    if (schema > SCHEMA_VERSION) {
+        // Written by newer firmware - unknown fields were skipped, known ones still apply
+        Logger::addEntry("Config schema " + String(schema) + " is newer than " + String(SCHEMA_VERSION) + ", loaded known fields");
+    }
+    
+    storedSize = bytesRead;
+    
+    if (schema < SCHEMA_VERSION) {
+        return migrate(schema);
+    }
+    
+    return true;
+}
+
+bool ConfigManager::migrate(uint16_t fromVersion) {
+    for (uint16_t version = fromVersion; version < SCHEMA_VERSION; version++) {
+        ConfigMigration migration = MIGRATIONS[version];
+        if (migration && !migration()) {
+            Logger::addEntry("Config migration from schema " + String(version) + " failed");
+            return false;
+        }
+    }
+    
+    Logger::addEntry("Config migrated from schema " + String(fromVersion) + " to " + String(SCHEMA_VERSION));
+    
+    // Persist in the current layout
+    markDirty();
+    return true;
+}
+
+bool ConfigManager::importLegacyJson() {
+    if (!SPIFFS.exists(LEGACY_JSON_FILE)) {
+        return false;
+    }
+    
+    File file = SPIFFS.open(LEGACY_JSON_FILE, "r");
     if (!file) {
         return false;
     }
     
-    size_t bytesWritten = serializeJson(doc, file);
+    String content = file.readString();
     file.close();
     
-    return bytesWritten > 0;
+    // Files written by the previous release end with "\n<crc32>"
+    int separator = content.lastIndexOf('\n');
+    if (separator != -1 && content.length() - separator - 1 == 8) {
+        content = content.substring(0, separator);
+    }
+    
+    Logger::addEntry("Migrating " + String(LEGACY_JSON_FILE) + " to binary config");
+    
+    if (!importJson(content)) {
+        return false;
+    }
+    
+    SPIFFS.remove(LEGACY_JSON_FILE);
+    return true;
+}
+
+bool ConfigManager::writeConfigFile() {
+    uint8_t buffer[MAX_CONFIG_SIZE];
+    size_t imageSize = ConfigImage::encode(mqttConfig, wifiConfig, SCHEMA_VERSION, buffer, sizeof(buffer));
+    if (imageSize == 0) {
+        Logger::addEntry("Config image exceeds " + String(MAX_CONFIG_SIZE) + " bytes");
+        return false;
+    }
+    
+    // Write the new image next to the old one, then swap it in
+    File file = SPIFFS.open(CONFIG_TEMP_FILE, "w");
+    if (!file) {
+        return false;
+    }
+    
+    size_t bytesWritten = file.write(buffer, imageSize);
+    file.close();
+    
+    if (bytesWritten != imageSize) {
+        SPIFFS.remove(CONFIG_TEMP_FILE);
+        return false;
+    }
+    
+    // SPIFFS won't rename over an existing file
+    if (SPIFFS.exists(CONFIG_FILE)) {
+        SPIFFS.remove(CONFIG_FILE);
+    }
+    
+    if (!SPIFFS.rename(CONFIG_TEMP_FILE, CONFIG_FILE)) {
+        return false;
+    }
+    
+    storedSize = imageSize;
+    return true;
 }
 
 void ConfigManager::setDefaults() {
@@ -129,4 +455,6 @@ void ConfigManager::setDefaults() {
     
     wifiConfig.ssid = "";
     wifiConfig.password = "";
+    wifiConfig.staticIp = false;
+    clearWiFiCache();
 }
@@ -4,47 +4,72 @@
 #include <Arduino.h>
 #include <SPIFFS.h>
 #include <ArduinoJson.h>
-
-struct MQTTConfig {
-    String brokerIP;
-    int brokerPort;
-    String username;
-    String password;
-    String deviceName;
-    String deviceId;
-    String mqttPrefix;
-};
-
-struct WiFiConfig {
-    String ssid;
-    String password;
-};
+#include "ConfigImage.h"
 
 class ConfigManager {
 public:
+    static const unsigned long COMMIT_DELAY = 2000; // Coalesce bursts of changes into one flash write
+    static const uint16_t SCHEMA_VERSION = 1;
+    static const size_t MAX_CONFIG_SIZE = 1024;
+    
     static bool init();
+    static void loop();
     static bool loadConfig();
     static bool saveConfig();
     
+    // Bumped on every settings change so dependants can cache derived values;
+    // the cached WiFi link isn't a setting and leaves it alone
+    static uint32_t getConfigVersion();
+    
     // MQTT Configuration
-    static MQTTConfig getMQTTConfig();
+    static const MQTTConfig& getMQTTConfig();
     static bool updateMQTTConfig(const String& brokerIP, int brokerPort, 
                                 const String& username, const String& password,
                                 const String& deviceName, const String& deviceId,
                                 const String& mqttPrefix);
     
     // WiFi Configuration
-    static WiFiConfig getWiFiConfig();
+    static const WiFiConfig& getWiFiConfig();
     static void setWiFiConfig(const String& ssid, const String& password);
+    // Cached after every successful connect; a changed SSID drops it
+    static void setWiFiLink(const uint8_t* bssid, uint8_t channel);
+    static void clearWiFiLink();
+    
+    // JSON is only used for import/export through the web API
+    static String exportJson(bool includeSecrets);
+    static bool importJson(const String& json);
+    
+    // Flash write statistics
+    static bool isDirty();
+    static unsigned long getFlashWrites();
+    static unsigned long getWritesSkipped();
+    static unsigned long getWritesCoalesced();
+    static size_t getStoredSize();
 
 private:
     static MQTTConfig mqttConfig;
     static WiFiConfig wifiConfig;
     static const char* CONFIG_FILE;
+    static const char* CONFIG_TEMP_FILE;
+    static const char* LEGACY_JSON_FILE;
+    
+    static uint32_t configVersion;
+    static bool dirty;
+    static unsigned long dirtySince;
+    static unsigned long flashWrites;
+    static unsigned long writesSkipped;
+    static unsigned long writesCoalesced;
+    static size_t storedSize;
     
     static bool parseConfigFile();
+    static bool readConfigImage(const char* path);
     static bool writeConfigFile();
+    static bool importLegacyJson();
+    static bool migrate(uint16_t fromVersion);
+    static void markDirty();
+    static void scheduleCommit();
     static void setDefaults();
+    static void clearWiFiCache();
 };
 
 #endif
@@ -0,0 +1,186 @@
+#include "ConfigStore.h"
+#include "Crc32.h"
+#include <string.h>
+
+static void putLE16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+}
+
+static void putLE32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+static uint16_t getLE16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t getLE32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// ConfigField
+
+uint32_t ConfigField::asU32() const {
+    switch (length) {
+        case 1: return value[0];
+        case 2: return getLE16(value);
+        case 4: return getLE32(value);
+        default: return 0;
+    }
+}
+
+int32_t ConfigField::asI32() const {
+    return (int32_t)asU32();
+}
+
+bool ConfigField::asBool() const {
+    return length > 0 && value[0] != 0;
+}
+
+// ConfigWriter
+
+ConfigWriter::ConfigWriter(uint8_t* buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), position(ConfigStore::HEADER_SIZE), fieldCount(0), overflow(capacity < ConfigStore::HEADER_SIZE) {
+}
+
+bool ConfigWriter::writeU8(uint8_t id, uint8_t value) {
+    return writeField(id, CONFIG_TYPE_U8, &value, 1);
+}
+
+bool ConfigWriter::writeU16(uint8_t id, uint16_t value) {
+    uint8_t raw[2];
+    putLE16(raw, value);
+    return writeField(id, CONFIG_TYPE_U16, raw, 2);
+}
+
+bool ConfigWriter::writeU32(uint8_t id, uint32_t value) {
+    uint8_t raw[4];
+    putLE32(raw, value);
+    return writeField(id, CONFIG_TYPE_U32, raw, 4);
+}
+
+bool ConfigWriter::writeI32(uint8_t id, int32_t value) {
+    uint8_t raw[4];
+    putLE32(raw, (uint32_t)value);
+    return writeField(id, CONFIG_TYPE_I32, raw, 4);
+}
+
+bool ConfigWriter::writeBool(uint8_t id, bool value) {
+    uint8_t raw = value ? 1 : 0;
+    return writeField(id, CONFIG_TYPE_BOOL, &raw, 1);
+}
+
+bool ConfigWriter::writeString(uint8_t id, const char* value, size_t length) {
+    return writeField(id, CONFIG_TYPE_STRING, (const uint8_t*)value, length);
+}
+
+bool ConfigWriter::writeBlob(uint8_t id, const uint8_t* value, size_t length) {
+    return writeField(id, CONFIG_TYPE_BLOB, value, length);
+}
+
+bool ConfigWriter::writeField(uint8_t id, uint8_t type, const uint8_t* value, size_t length) {
+    if (overflow || length > 0xFFFF || position + ConfigStore::FIELD_HEADER_SIZE + length > capacity) {
+        overflow = true;
+        return false;
+    }
+    
+    uint8_t* out = buffer + position;
+    out[0] = id;
+    out[1] = type;
+    putLE16(out + 2, (uint16_t)length);
+    if (length > 0) {
+        memcpy(out + ConfigStore::FIELD_HEADER_SIZE, value, length);
+    }
+    
+    position += ConfigStore::FIELD_HEADER_SIZE + length;
+    fieldCount++;
+    return true;
+}
+
+size_t ConfigWriter::finish(uint16_t schemaVersion) {
+    if (overflow) {
+        return 0;
+    }
+    
+    size_t payloadLength = position - ConfigStore::HEADER_SIZE;
+    
+    putLE32(buffer, ConfigStore::MAGIC);
+    putLE16(buffer + 4, schemaVersion);
+    putLE16(buffer + 6, fieldCount);
+    putLE32(buffer + 8, (uint32_t)payloadLength);
+    putLE32(buffer + 12, Crc32::compute(buffer + ConfigStore::HEADER_SIZE, payloadLength));
+    
+    return position;
+}
+
+// ConfigReader
+
+ConfigReader::ConfigReader()
+    : payload(nullptr), payloadLength(0), position(0), schemaVersion(0), fieldCount(0) {
+}
+
+ConfigReader::Status ConfigReader::open(const uint8_t* data, size_t length) {
+    payload = nullptr;
+    payloadLength = 0;
+    position = 0;
+    
+    if (length < ConfigStore::HEADER_SIZE) {
+        return TOO_SHORT;
+    }
+    
+    if (getLE32(data) != ConfigStore::MAGIC) {
+        return BAD_MAGIC;
+    }
+    
+    uint32_t declaredLength = getLE32(data + 8);
+    if (declaredLength != length - ConfigStore::HEADER_SIZE) {
+        return BAD_LENGTH;
+    }
+    
+    if (Crc32::compute(data + ConfigStore::HEADER_SIZE, declaredLength) != getLE32(data + 12)) {
+        return BAD_CRC;
+    }
+    
+    schemaVersion = getLE16(data + 4);
+    fieldCount = getLE16(data + 6);
+    payload = data + ConfigStore::HEADER_SIZE;
+    payloadLength = declaredLength;
+    return OK;
+}
+
+bool ConfigReader::next(ConfigField& field) {
+    if (payload == nullptr || position + ConfigStore::FIELD_HEADER_SIZE > payloadLength) {
+        return false;
+    }
+    
+    const uint8_t* in = payload + position;
+    uint16_t length = getLE16(in + 2);
+    if (position + ConfigStore::FIELD_HEADER_SIZE + length > payloadLength) {
+        return false;
+    }
+    
+    field.id = in[0];
+    field.type = in[1];
+    field.length = length;
+    field.value = in + ConfigStore::FIELD_HEADER_SIZE;
+    
+    position += ConfigStore::FIELD_HEADER_SIZE + length;
+    return true;
+}
+
+// ConfigStore
+
+const char* ConfigStore::statusToString(ConfigReader::Status status) {
+    switch (status) {
+        case ConfigReader::OK: return "OK";
+        case ConfigReader::TOO_SHORT: return "too short";
+        case ConfigReader::BAD_MAGIC: return "bad magic";
+        case ConfigReader::BAD_LENGTH: return "bad length";
+        case ConfigReader::BAD_CRC: return "CRC mismatch";
+        default: return "unknown";
+    }
+}
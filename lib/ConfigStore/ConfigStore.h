@@ -0,0 +1,101 @@
+#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Binary config image:
+//
+//   [magic "FLCF"][schema u16][field count u16][payload length u32][payload crc32 u32]
+//   [field]...
+//
+// Each field is [id u8][type u8][length u16][value], all little-endian.
+// Readers skip ids they don't know and keep defaults for ids that are
+// missing, so adding a setting never needs a migration - only changing
+// the meaning of an existing one does.
+
+enum ConfigFieldType : uint8_t {
+    CONFIG_TYPE_U8 = 1,
+    CONFIG_TYPE_U16 = 2,
+    CONFIG_TYPE_U32 = 3,
+    CONFIG_TYPE_I32 = 4,
+    CONFIG_TYPE_BOOL = 5,
+    CONFIG_TYPE_STRING = 6,
+    CONFIG_TYPE_BLOB = 7
+};
+
+struct ConfigField {
+    uint8_t id;
+    uint8_t type;
+    uint16_t length;
+    const uint8_t* value; // Points into the source buffer, not null terminated
+    
+    uint32_t asU32() const;
+    int32_t asI32() const;
+    bool asBool() const;
+};
+
+class ConfigWriter {
+public:
+    ConfigWriter(uint8_t* buffer, size_t capacity);
+    
+    bool writeU8(uint8_t id, uint8_t value);
+    bool writeU16(uint8_t id, uint16_t value);
+    bool writeU32(uint8_t id, uint32_t value);
+    bool writeI32(uint8_t id, int32_t value);
+    bool writeBool(uint8_t id, bool value);
+    bool writeString(uint8_t id, const char* value, size_t length);
+    bool writeBlob(uint8_t id, const uint8_t* value, size_t length);
+    
+    // Fills in the header; returns the total image size, or 0 if anything overflowed
+    size_t finish(uint16_t schemaVersion);
+    bool overflowed() const { return overflow; }
+
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t position;
+    uint16_t fieldCount;
+    bool overflow;
+    
+    bool writeField(uint8_t id, uint8_t type, const uint8_t* value, size_t length);
+};
+
+class ConfigReader {
+public:
+    enum Status {
+        OK = 0,
+        TOO_SHORT,
+        BAD_MAGIC,
+        BAD_LENGTH,
+        BAD_CRC
+    };
+    
+    ConfigReader();
+    
+    // Validates the header and CRC; no copies are made
+    Status open(const uint8_t* data, size_t length);
+    uint16_t getSchemaVersion() const { return schemaVersion; }
+    uint16_t getFieldCount() const { return fieldCount; }
+    
+    // Returns false at the end of the image or on a malformed field
+    bool next(ConfigField& field);
+
+private:
+    const uint8_t* payload;
+    size_t payloadLength;
+    size_t position;
+    uint16_t schemaVersion;
+    uint16_t fieldCount;
+};
+
+class ConfigStore {
+public:
+    static const uint32_t MAGIC = 0x46434C46; // "FLCF" on disk
+    static const size_t HEADER_SIZE = 16;
+    static const size_t FIELD_HEADER_SIZE = 4;
+    
+    static const char* statusToString(ConfigReader::Status status);
+};
+
+#endif
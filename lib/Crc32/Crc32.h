@@ -0,0 +1,19 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320).
+// Results match Python's zlib.crc32 so the packaging scripts and the
+// device agree on checksums. No Arduino dependency so it also builds
+// in the native test environment.
+class Crc32 {
+public:
+    static uint32_t compute(const uint8_t* data, size_t length);
+    
+    // Continue a running CRC, e.g. update(update(0, a, n), b, m)
+    static uint32_t update(uint32_t crc, const uint8_t* data, size_t length);
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "DiscoveryCache.h"
+#include <string.h>
+
+DiscoveryCache::DiscoveryCache(unsigned long paceInterval)
+    : paceInterval(paceInterval), currentGeneration(0), rendered(false), used(0), count(0),
+      replaying(false), replayIndex(0), sentAny(false), lastSent(0), renderCount(0), replayCount(0), overflowCount(0) {
+}
+
+void DiscoveryCache::begin(uint32_t generation) {
+    used = 0;
+    count = 0;
+    replaying = false;
+    currentGeneration = generation;
+    rendered = true;
+    renderCount++;
+}
+
+bool DiscoveryCache::add(const char* topic, const char* payload, size_t length, bool retain) {
+    size_t topicLength = strlen(topic) + 1;
+    
+    // Payloads are NUL terminated too, AsyncMqttClient takes C strings
+    if (count >= MAX_ENTRIES || used + topicLength + length + 1 > ARENA_SIZE) {
+        overflowCount++;
+        return false;
+    }
+    
+    Entry& entry = entries[count];
+    entry.topicOffset = used;
+    memcpy(arena + used, topic, topicLength);
+    used += topicLength;
+    
+    entry.payloadOffset = used;
+    entry.payloadLength = length;
+    memcpy(arena + used, payload, length);
+    arena[used + length] = '\0';
+    used += length + 1;
+    
+    entry.retain = retain;
+    count++;
+    return true;
+}
+
+const char* DiscoveryCache::getTopic(int index) const {
+    return arena + entries[index].topicOffset;
+}
+
+const char* DiscoveryCache::getPayload(int index) const {
+    return arena + entries[index].payloadOffset;
+}
+
+size_t DiscoveryCache::getPayloadLength(int index) const {
+    return entries[index].payloadLength;
+}
+
+bool DiscoveryCache::getRetain(int index) const {
+    return entries[index].retain;
+}
+
+void DiscoveryCache::startReplay() {
+    replaying = true;
+    replayIndex = 0;
+    sentAny = false;
+    replayCount++;
+}
+
+int DiscoveryCache::nextDue(unsigned long now) const {
+    if (!isReplaying()) {
+        return -1;
+    }
+    
+    if (sentAny && now - lastSent < paceInterval) {
+        return -1;
+    }
+    
+    return replayIndex;
+}
+
+void DiscoveryCache::markSent(unsigned long now) {
+    if (isReplaying()) {
+        replayIndex++;
+    }
+    sentAny = true;
+    lastSent = now;
+}
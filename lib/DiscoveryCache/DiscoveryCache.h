@@ -0,0 +1,68 @@
+#ifndef DISCOVERYCACHE_H
+#define DISCOVERYCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Discovery documents rendered once per config generation into a fixed
+// arena, then replayed on every connect without touching ArduinoJson.
+// Replay is paced, one publish per interval, so a burst of large retained
+// documents can't overrun the AsyncTCP send buffer. No Arduino dependency.
+class DiscoveryCache {
+public:
+    static const int MAX_ENTRIES = 16;
+    static const size_t ARENA_SIZE = 8192;
+    
+    struct Entry {
+        uint16_t topicOffset;
+        uint16_t payloadOffset;
+        uint16_t payloadLength;
+        bool retain;
+    };
+    
+    explicit DiscoveryCache(unsigned long paceInterval);
+    
+    // Start rendering a new generation, dropping the old entries
+    void begin(uint32_t generation);
+    bool add(const char* topic, const char* payload, size_t length, bool retain);
+    bool isCurrent(uint32_t generation) const { return rendered && generation == currentGeneration; }
+    
+    int size() const { return count; }
+    const char* getTopic(int index) const;
+    const char* getPayload(int index) const;
+    size_t getPayloadLength(int index) const;
+    bool getRetain(int index) const;
+    
+    // Replay: startReplay(), then each loop publish nextDue() if it isn't -1
+    // and call markSent() once the client accepted it
+    void startReplay();
+    int nextDue(unsigned long now) const;
+    void markSent(unsigned long now);
+    bool isReplaying() const { return replaying && replayIndex < count; }
+    
+    size_t getBytesUsed() const { return used; }
+    unsigned long getRenderCount() const { return renderCount; }
+    unsigned long getReplayCount() const { return replayCount; }
+    unsigned long getOverflowCount() const { return overflowCount; }
+
+private:
+    unsigned long paceInterval;
+    uint32_t currentGeneration;
+    bool rendered;
+    
+    char arena[ARENA_SIZE];
+    size_t used;
+    Entry entries[MAX_ENTRIES];
+    int count;
+    
+    bool replaying;
+    int replayIndex;
+    bool sentAny;
+    unsigned long lastSent;
+    
+    unsigned long renderCount;
+    unsigned long replayCount;
+    unsigned long overflowCount;
+};
+
+#endif
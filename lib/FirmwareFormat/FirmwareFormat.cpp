@@ -0,0 +1,428 @@
+#include "FirmwareFormat.h"
+#include "Crc32.h"
+#include <string.h>
+
+static const uint8_t PACKAGE_MAGIC[FirmwareFormat::PACKAGE_MAGIC_SIZE] = { 'F', 'L', 'F', 'W', '\0' };
+static const size_t V2_HEADER_CRC_OFFSET = 60;
+
+struct BoardEntry {
+    uint16_t id;
+    const char* name;
+};
+
+// Keep in step with BOARD_IDS in create_firmware_package.py and post_build.py
+static const BoardEntry BOARDS[] = {
+    { 1, "FL-LC01" }
+};
+
+// Version strings the ATtiny builds embed
+static const char* const KNOWN_VERSIONS[] = { "1.0.0", "1.0.1", "1.0.2", "1.1.0" };
+static const char* const UNKNOWN = "Unknown";
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Caller has already checked both characters are hex digits
+static uint8_t hexByte(const char* in) {
+    return (hexDigit(in[0]) << 4) | hexDigit(in[1]);
+}
+
+static uint16_t getLE16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t getLE32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// After the format 2 header and inside the package, without overflowing
+static bool sectionFits(uint32_t offset, uint32_t length, size_t packageSize) {
+    return offset >= FirmwareFormat::PACKAGE_V2_HEADER_SIZE && offset <= packageSize && length <= packageSize - offset;
+}
+
+static bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static const char* findText(const char* haystack, size_t length, const char* needle) {
+    size_t needleLength = strlen(needle);
+    for (size_t i = 0; i + needleLength <= length; i++) {
+        if (memcmp(haystack + i, needle, needleLength) == 0) {
+            return haystack + i;
+        }
+    }
+    return nullptr;
+}
+
+// Copies at most capacity - 1 characters and always terminates
+static void copyText(char* out, size_t capacity, const char* in, size_t length) {
+    if (capacity == 0) {
+        return;
+    }
+    if (length > capacity - 1) {
+        length = capacity - 1;
+    }
+    memcpy(out, in, length);
+    out[length] = '\0';
+}
+
+bool FirmwareFormat::isValidHexLine(const char* line, size_t length) {
+    if (line == nullptr || length < MIN_HEX_LINE || line[0] != ':') {
+        return false;
+    }
+    
+    for (size_t i = 1; i < length; i++) {
+        if (hexDigit(line[i]) < 0) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool FirmwareFormat::verifyChecksum(const char* line, size_t length) {
+    // Whole bytes after the ':' only
+    if (!isValidHexLine(line, length) || (length - 1) % 2 != 0) {
+        return false;
+    }
+    
+    uint8_t sum = 0;
+    for (size_t i = 1; i < length - 2; i += 2) {
+        sum += hexByte(line + i);
+    }
+    
+    return (uint8_t)(0x100 - sum) == hexByte(line + length - 2);
+}
+
+bool FirmwareFormat::decodeRecord(const char* line, size_t length, HexRecord& record) {
+    if (!verifyChecksum(line, length)) {
+        return false;
+    }
+    
+    uint8_t count = hexByte(line + 1);
+    if (length != MIN_HEX_LINE + 2 * (size_t)count) {
+        return false;
+    }
+    
+    uint8_t type = hexByte(line + 7);
+    if (type > HEX_RECORD_START_LINEAR) {
+        return false;
+    }
+    
+    record.length = count;
+    record.address = (hexByte(line + 3) << 8) | hexByte(line + 5);
+    record.type = type;
+    for (size_t i = 0; i < count; i++) {
+        record.data[i] = hexByte(line + 9 + 2 * i);
+    }
+    return true;
+}
+
+size_t FirmwareFormat::formatRecord(const HexRecord& record, char* out, size_t capacity) {
+    static const char DIGITS[] = "0123456789ABCDEF";
+    size_t length = MIN_HEX_LINE + 2 * (size_t)record.length;
+    if (capacity < length + 1) {
+        return 0;
+    }
+    
+    uint8_t header[PACKED_RECORD_HEADER] = { record.length, (uint8_t)(record.address >> 8), (uint8_t)record.address, record.type };
+    uint8_t sum = 0;
+    char* position = out;
+    *position++ = ':';
+    for (size_t i = 0; i < PACKED_RECORD_HEADER + record.length; i++) {
+        uint8_t value = i < PACKED_RECORD_HEADER ? header[i] : record.data[i - PACKED_RECORD_HEADER];
+        sum += value;
+        *position++ = DIGITS[value >> 4];
+        *position++ = DIGITS[value & 0x0F];
+    }
+    uint8_t checksum = (uint8_t)(0x100 - sum);
+    *position++ = DIGITS[checksum >> 4];
+    *position++ = DIGITS[checksum & 0x0F];
+    *position = '\0';
+    return length;
+}
+
+size_t FirmwareFormat::extractText(const char* line, size_t length, char* out, size_t capacity) {
+    if (capacity == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+    
+    if (!isValidHexLine(line, length)) {
+        return 0;
+    }
+    
+    // Data sits between :LLAAAATT and the checksum
+    const size_t dataStart = 9;
+    const size_t dataEnd = length - 2;
+    
+    size_t written = 0;
+    for (size_t i = dataStart; i + 2 <= dataEnd && written < capacity - 1; i += 2) {
+        uint8_t value = hexByte(line + i);
+        if (value >= 32 && value <= 126) {
+            out[written++] = (char)value;
+        }
+    }
+    
+    out[written] = '\0';
+    return written;
+}
+
+bool FirmwareFormat::isValidDate(const char* date, size_t length, char separator) {
+    if (date == nullptr || length != 10 || date[4] != separator || date[7] != separator) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < length; i++) {
+        if (i != 4 && i != 7 && (date[i] < '0' || date[i] > '9')) {
+            return false;
+        }
+    }
+    
+    int year = (date[0] - '0') * 1000 + (date[1] - '0') * 100 + (date[2] - '0') * 10 + (date[3] - '0');
+    int month = (date[5] - '0') * 10 + (date[6] - '0');
+    int day = (date[8] - '0') * 10 + (date[9] - '0');
+    
+    return year >= 2000 && year <= 2030 && month >= 1 && month <= 12 && day >= 1 && day <= 31;
+}
+
+bool FirmwareFormat::extractVersion(const char* hex, size_t length, char* version, size_t versionCapacity,
+                                    char* buildDate, size_t buildDateCapacity) {
+    copyText(version, versionCapacity, UNKNOWN, strlen(UNKNOWN));
+    copyText(buildDate, buildDateCapacity, UNKNOWN, strlen(UNKNOWN));
+    
+    bool foundVersion = false;
+    bool foundDate = false;
+    char text[MAX_HEX_DATA + 1];
+    size_t position = 0;
+    
+    while (position < length) {
+        const char* lineStart = hex + position;
+        const char* newline = (const char*)memchr(lineStart, '\n', length - position);
+        size_t lineLength = newline != nullptr ? (size_t)(newline - lineStart) : length - position;
+        position += lineLength + 1;
+        
+        // Trim
+        while (lineLength > 0 && isWhitespace(lineStart[0])) {
+            lineStart++;
+            lineLength--;
+        }
+        while (lineLength > 0 && isWhitespace(lineStart[lineLength - 1])) {
+            lineLength--;
+        }
+        
+        size_t textLength = extractText(lineStart, lineLength, text, sizeof(text));
+        if (textLength == 0) {
+            continue;
+        }
+        
+        // A later line wins, like a later match in the same line
+        for (size_t v = 0; v < sizeof(KNOWN_VERSIONS) / sizeof(KNOWN_VERSIONS[0]); v++) {
+            if (findText(text, textLength, KNOWN_VERSIONS[v]) != nullptr) {
+                copyText(version, versionCapacity, KNOWN_VERSIONS[v], strlen(KNOWN_VERSIONS[v]));
+                foundVersion = true;
+                break;
+            }
+        }
+        
+        // YYYY-MM-DD, then YYYY/MM/DD
+        const char* dash = findText(text, textLength, "2024-");
+        if (dash != nullptr && dash + 10 <= text + textLength && isValidDate(dash, 10, '-')) {
+            copyText(buildDate, buildDateCapacity, dash, 10);
+            foundDate = true;
+        }
+        const char* slash = findText(text, textLength, "2024/");
+        if (slash != nullptr && slash + 10 <= text + textLength && isValidDate(slash, 10, '/')) {
+            copyText(buildDate, buildDateCapacity, slash, 10);
+            foundDate = true;
+        }
+    }
+    
+    return foundVersion || foundDate;
+}
+
+static FirmwarePackageStatus parseV1Header(const uint8_t* header, size_t packageSize, FirmwarePackageLayout& layout) {
+    uint32_t metadataLength = getLE32(header + FirmwareFormat::PACKAGE_MAGIC_SIZE);
+    layout.formatVersion = FirmwareFormat::PACKAGE_FORMAT_V1;
+    layout.metadataLength = metadataLength;
+    
+    if (metadataLength == 0 || metadataLength > FirmwareFormat::MAX_METADATA) {
+        return PACKAGE_BAD_METADATA_LENGTH;
+    }
+    
+    layout.metadataOffset = FirmwareFormat::PACKAGE_HEADER_SIZE;
+    layout.firmwareOffset = FirmwareFormat::PACKAGE_HEADER_SIZE + metadataLength;
+    
+    if (layout.firmwareOffset > packageSize) {
+        return PACKAGE_TRUNCATED;
+    }
+    
+    layout.firmwareLength = packageSize - layout.firmwareOffset;
+    return PACKAGE_OK;
+}
+
+static FirmwarePackageStatus parseV2Header(const uint8_t* header, size_t headerLength, size_t packageSize,
+                                           FirmwarePackageLayout& layout) {
+    if (headerLength < FirmwareFormat::PACKAGE_V2_HEADER_SIZE || packageSize < FirmwareFormat::PACKAGE_V2_HEADER_SIZE) {
+        return PACKAGE_TOO_SHORT;
+    }
+    
+    if (Crc32::compute(header, V2_HEADER_CRC_OFFSET) != getLE32(header + V2_HEADER_CRC_OFFSET)) {
+        return PACKAGE_BAD_HEADER_CRC;
+    }
+    
+    // A larger header would mean fields this firmware doesn't know about
+    if (getLE16(header + 6) != FirmwareFormat::PACKAGE_V2_HEADER_SIZE) {
+        return PACKAGE_UNSUPPORTED_FORMAT;
+    }
+    
+    layout.formatVersion = FirmwareFormat::PACKAGE_FORMAT_V2;
+    layout.payloadType = header[5];
+    layout.boardId = getLE16(header + 8);
+    layout.versionMajor = header[10];
+    layout.versionMinor = header[11];
+    layout.versionPatch = getLE16(header + 12);
+    layout.firmwareCrc32 = getLE32(header + 24);
+    layout.metadataCrc32 = getLE32(header + 36);
+    layout.buildTime = getLE32(header + 40);
+    layout.decodedLength = getLE32(header + 44);
+    
+    uint32_t payloadOffset = getLE32(header + 16);
+    uint32_t payloadLength = getLE32(header + 20);
+    uint32_t metadataOffset = getLE32(header + 28);
+    uint32_t metadataLength = getLE32(header + 32);
+    layout.metadataLength = metadataLength;
+    
+    if (metadataLength > FirmwareFormat::MAX_METADATA) {
+        return PACKAGE_BAD_METADATA_LENGTH;
+    }
+    if (metadataLength > 0 && !sectionFits(metadataOffset, metadataLength, packageSize)) {
+        return PACKAGE_TRUNCATED;
+    }
+    if (!sectionFits(payloadOffset, payloadLength, packageSize)) {
+        return PACKAGE_TRUNCATED;
+    }
+    
+    layout.metadataOffset = metadataLength > 0 ? metadataOffset : 0;
+    layout.firmwareOffset = payloadOffset;
+    layout.firmwareLength = payloadLength;
+    return PACKAGE_OK;
+}
+
+FirmwarePackageStatus FirmwareFormat::parsePackageHeader(const uint8_t* header, size_t headerLength, size_t packageSize,
+                                                         FirmwarePackageLayout& layout) {
+    memset(&layout, 0, sizeof(layout));
+    
+    if (header == nullptr || headerLength < PACKAGE_HEADER_SIZE || packageSize < MIN_PACKAGE_SIZE) {
+        return PACKAGE_TOO_SHORT;
+    }
+    
+    if (packageSize > MAX_PACKAGE_SIZE) {
+        return PACKAGE_TOO_LARGE;
+    }
+    
+    // "FLFW", then the format: the NUL ending the format 1 magic, or a number
+    if (memcmp(header, PACKAGE_MAGIC, PACKAGE_MAGIC_SIZE - 1) != 0) {
+        return PACKAGE_BAD_MAGIC;
+    }
+    
+    if (header[PACKAGE_MAGIC_SIZE - 1] == '\0') {
+        return parseV1Header(header, packageSize, layout);
+    }
+    if (header[PACKAGE_MAGIC_SIZE - 1] == PACKAGE_FORMAT_V2) {
+        return parseV2Header(header, headerLength, packageSize, layout);
+    }
+    return PACKAGE_UNSUPPORTED_FORMAT;
+}
+
+FirmwarePackageStatus FirmwareFormat::verifyPackage(const uint8_t* package, size_t packageSize,
+                                                    const FirmwarePackageLayout& layout) {
+    if (layout.formatVersion != PACKAGE_FORMAT_V2) {
+        return PACKAGE_OK;
+    }
+    
+    if (package == nullptr || layout.metadataOffset + layout.metadataLength > packageSize ||
+        layout.firmwareOffset + layout.firmwareLength > packageSize) {
+        return PACKAGE_TRUNCATED;
+    }
+    
+    if (layout.metadataLength > 0 &&
+        Crc32::compute(package + layout.metadataOffset, layout.metadataLength) != layout.metadataCrc32) {
+        return PACKAGE_BAD_CHECKSUM;
+    }
+    if (Crc32::compute(package + layout.firmwareOffset, layout.firmwareLength) != layout.firmwareCrc32) {
+        return PACKAGE_BAD_CHECKSUM;
+    }
+    return PACKAGE_OK;
+}
+
+const char* FirmwareFormat::packageStatusToString(FirmwarePackageStatus status) {
+    switch (status) {
+        case PACKAGE_OK: return "OK";
+        case PACKAGE_TOO_SHORT: return "Package too small to be valid";
+        case PACKAGE_BAD_MAGIC: return "Invalid package magic header";
+        case PACKAGE_BAD_METADATA_LENGTH: return "Invalid metadata length";
+        case PACKAGE_TRUNCATED: return "Package truncated - metadata incomplete";
+        case PACKAGE_TOO_LARGE: return "Package too large";
+        case PACKAGE_UNSUPPORTED_FORMAT: return "Unsupported package format";
+        case PACKAGE_BAD_HEADER_CRC: return "Package header checksum mismatch";
+        case PACKAGE_BAD_CHECKSUM: return "Package checksum mismatch - file is corrupt";
+        default: return "Unknown";
+    }
+}
+
+uint16_t FirmwareFormat::boardId(const char* name) {
+    if (name == nullptr) {
+        return BOARD_UNKNOWN;
+    }
+    for (size_t i = 0; i < sizeof(BOARDS) / sizeof(BOARDS[0]); i++) {
+        if (strcmp(BOARDS[i].name, name) == 0) {
+            return BOARDS[i].id;
+        }
+    }
+    return BOARD_UNKNOWN;
+}
+
+const char* FirmwareFormat::boardName(uint16_t id) {
+    for (size_t i = 0; i < sizeof(BOARDS) / sizeof(BOARDS[0]); i++) {
+        if (BOARDS[i].id == id) {
+            return BOARDS[i].name;
+        }
+    }
+    return nullptr;
+}
+
+bool FirmwareFormat::formatBuildDate(uint32_t buildTime, char* out, size_t capacity) {
+    if (buildTime == 0 || capacity < 11) {
+        copyText(out, capacity, UNKNOWN, strlen(UNKNOWN));
+        return false;
+    }
+    
+    // Civil date from days since 1970-01-01, valid for any uint32_t time
+    uint32_t z = buildTime / 86400 + 719468;
+    uint32_t era = z / 146097;
+    uint32_t dayOfEra = z - era * 146097;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t mp = (5 * dayOfYear + 2) / 153;
+    uint32_t day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    uint32_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    
+    out[0] = '0' + (year / 1000) % 10;
+    out[1] = '0' + (year / 100) % 10;
+    out[2] = '0' + (year / 10) % 10;
+    out[3] = '0' + year % 10;
+    out[4] = '-';
+    out[5] = '0' + month / 10;
+    out[6] = '0' + month % 10;
+    out[7] = '-';
+    out[8] = '0' + day / 10;
+    out[9] = '0' + day % 10;
+    out[10] = '\0';
+    return true;
+}
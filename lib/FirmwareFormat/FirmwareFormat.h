@@ -0,0 +1,143 @@
+#ifndef FIRMWAREFORMAT_H
+#define FIRMWAREFORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum HexRecordType : uint8_t {
+    HEX_RECORD_DATA = 0,
+    HEX_RECORD_EOF = 1,
+    HEX_RECORD_EXTENDED_SEGMENT = 2,
+    HEX_RECORD_START_SEGMENT = 3,
+    HEX_RECORD_EXTENDED_LINEAR = 4,
+    HEX_RECORD_START_LINEAR = 5
+};
+
+struct HexRecord {
+    uint8_t length;
+    uint16_t address;
+    uint8_t type;
+    uint8_t data[255];
+};
+
+// Firmware packages (.bin) as written by create_firmware_package.py.
+//
+// Format 1, still accepted:
+//
+//   [magic "FLFW\0"][metadata length u32 LE][metadata JSON][Intel HEX]
+//
+// Format 2 starts with a fixed 64 byte little-endian header, so version,
+// board and checksums are readable without parsing JSON. Byte 4 is the NUL
+// of the format 1 magic, so it doubles as the format number:
+//
+//    0  4  "FLFW"              28  4  metadata offset (0 = no metadata)
+//    4  1  format (2)          32  4  metadata length
+//    5  1  payload type        36  4  metadata CRC32
+//    6  2  header size (64)    40  4  build time, Unix seconds (0 = unknown)
+//    8  2  board id            44  4  payload length once decoded (0 = stored as is)
+//   10  1  version major       48 12  reserved, zero
+//                              60  4  CRC32 of bytes 0-59
+//   11  1  version minor
+//   12  2  version patch
+//   14  2  flags, zero
+//   16  4  payload offset
+//   20  4  payload length
+//   24  4  payload CRC32
+//
+// CRCs are Crc32 (zlib.crc32 in the packaging scripts).
+enum FirmwarePackageStatus : uint8_t {
+    PACKAGE_OK = 0,
+    PACKAGE_TOO_SHORT,
+    PACKAGE_BAD_MAGIC,
+    PACKAGE_BAD_METADATA_LENGTH,
+    PACKAGE_TRUNCATED,         // A section runs past the end of the package
+    PACKAGE_TOO_LARGE,
+    PACKAGE_UNSUPPORTED_FORMAT,
+    PACKAGE_BAD_HEADER_CRC,
+    PACKAGE_BAD_CHECKSUM       // Metadata or payload doesn't match its CRC
+};
+
+// HEX_LZSS is the HEX file's records packed as [count][address BE:2][type]
+// [data], checksums dropped, then LZSS compressed (see LzssDecoder.h).
+// HexPayloadReader turns either back into HEX lines.
+enum FirmwarePayloadType : uint8_t {
+    PAYLOAD_INTEL_HEX = 0,
+    PAYLOAD_HEX_LZSS = 1
+};
+
+struct FirmwarePackageLayout {
+    uint8_t formatVersion;     // 1 or 2; the fields down to buildTime are format 2 only
+    uint8_t payloadType;
+    uint16_t boardId;          // See boardName()
+    uint8_t versionMajor;
+    uint8_t versionMinor;
+    uint16_t versionPatch;
+    uint32_t buildTime;
+    uint32_t metadataCrc32;
+    uint32_t firmwareCrc32;
+    size_t metadataOffset;
+    size_t metadataLength;     // 0 when a format 2 package has no metadata
+    size_t firmwareOffset;
+    size_t firmwareLength;     // 0 when the package ends after the metadata
+    size_t decodedLength;      // Packed record bytes for PAYLOAD_HEX_LZSS
+};
+
+// Intel HEX lines and the package container on plain buffers, so the
+// device, the tests and the benchmarks all run the same parsing code.
+// No Arduino dependency, no allocation.
+class FirmwareFormat {
+public:
+    static const size_t MIN_HEX_LINE = 11;          // ":LLAAAATTCC"
+    static const size_t PACKED_RECORD_HEADER = 4;   // Count, address, type
+    static const size_t MAX_HEX_DATA = 255;
+    static const size_t PACKAGE_MAGIC_SIZE = 5;
+    static const size_t PACKAGE_HEADER_SIZE = 9;    // Magic + metadata length
+    static const size_t MIN_PACKAGE_SIZE = 10;      // Header + one metadata byte
+    static const size_t MAX_METADATA = 2048;
+    static const size_t MAX_PACKAGE_SIZE = 128 * 1024;  // ATtiny1616 HEX is ~46 KB
+    static const uint8_t PACKAGE_FORMAT_V1 = 1;
+    static const uint8_t PACKAGE_FORMAT_V2 = 2;
+    static const size_t PACKAGE_V2_HEADER_SIZE = 64;
+    // Enough for either format; callers reading a stored package read this much
+    static const size_t PACKAGE_MAX_HEADER_SIZE = PACKAGE_V2_HEADER_SIZE;
+    static const uint16_t BOARD_UNKNOWN = 0;
+    
+    // ':' followed by at least MIN_HEX_LINE - 1 hex digits
+    static bool isValidHexLine(const char* line, size_t length);
+    // The two's complement checksum at the end of the line matches its bytes
+    static bool verifyChecksum(const char* line, size_t length);
+    // Strict decode: byte count matches the line, checksum holds, known type
+    static bool decodeRecord(const char* line, size_t length, HexRecord& record);
+    // The line for a record, checksum included, terminated. Returns its
+    // length, or 0 if it doesn't fit in capacity.
+    static size_t formatRecord(const HexRecord& record, char* out, size_t capacity);
+    // Printable ASCII from the data field, for spotting version strings.
+    // Returns the characters written; out is always terminated.
+    static size_t extractText(const char* line, size_t length, char* out, size_t capacity);
+    // YYYY<sep>MM<sep>DD between 2000 and 2030
+    static bool isValidDate(const char* date, size_t length, char separator);
+    // Scans every line of a HEX file for a known version and a build date.
+    // Both are set to "Unknown" when missing; true if either was found.
+    static bool extractVersion(const char* hex, size_t length, char* version, size_t versionCapacity,
+                               char* buildDate, size_t buildDateCapacity);
+    
+    // header needs PACKAGE_HEADER_SIZE bytes for format 1 and
+    // PACKAGE_V2_HEADER_SIZE for format 2; packageSize is the whole package.
+    // Checks the format 2 header CRC but not the sections.
+    static FirmwarePackageStatus parsePackageHeader(const uint8_t* header, size_t headerLength, size_t packageSize,
+                                                    FirmwarePackageLayout& layout);
+    // Section CRCs of a whole package in memory; format 1 has none and passes
+    static FirmwarePackageStatus verifyPackage(const uint8_t* package, size_t packageSize,
+                                               const FirmwarePackageLayout& layout);
+    static const char* packageStatusToString(FirmwarePackageStatus status);
+    
+    // Board ids in the format 2 header, matching BOARD_IDS in the packaging
+    // scripts. boardName() returns nullptr for an id it doesn't know.
+    static uint16_t boardId(const char* name);
+    static const char* boardName(uint16_t id);
+    // YYYY-MM-DD (UTC) of a format 2 build time, the same form the metadata
+    // JSON gives; "Unknown" for 0. Needs 11 bytes.
+    static bool formatBuildDate(uint32_t buildTime, char* out, size_t capacity);
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "FirmwareMetadata.h"
+#include <ArduinoJson.h>
+#include <string.h>
+
+// Replaces a 2 KB DynamicJsonDocument allocated per parse; uploads and the
+// package listings run one at a time from the web handler
+static StaticJsonDocument<FirmwareMetadata::DOCUMENT_SIZE> document;
+
+const char* FirmwareMetadata::lastError = "";
+
+static const char* const UNKNOWN = "Unknown";
+
+// Copies at most capacity - 1 characters and always terminates
+static void copyText(char* out, size_t capacity, const char* in, size_t length) {
+    if (length > capacity - 1) {
+        length = capacity - 1;
+    }
+    memcpy(out, in, length);
+    out[length] = '\0';
+}
+
+static void copyField(char* out, size_t capacity, JsonVariantConst value) {
+    const char* text = value.as<const char*>();
+    if (text == nullptr) {
+        text = UNKNOWN;
+    }
+    copyText(out, capacity, text, strlen(text));
+}
+
+FirmwareMetadata::FirmwareMetadata() {
+    clear();
+}
+
+void FirmwareMetadata::clear() {
+    copyText(version, sizeof(version), UNKNOWN, strlen(UNKNOWN));
+    copyText(description, sizeof(description), UNKNOWN, strlen(UNKNOWN));
+    copyText(board, sizeof(board), UNKNOWN, strlen(UNKNOWN));
+    copyText(buildDate, sizeof(buildDate), UNKNOWN, strlen(UNKNOWN));
+    features[0] = '\0';
+}
+
+bool FirmwareMetadata::parse(const char* json, size_t length, FirmwareMetadata& metadata) {
+    metadata.clear();
+    
+    if (json == nullptr || length == 0 || length > MAX_JSON) {
+        lastError = "InvalidInput";
+        return false;
+    }
+    
+    // Only the fields below are kept, the rest of the document costs no pool space
+    StaticJsonDocument<256> filter;
+    filter["firmware"]["version"] = true;
+    filter["firmware"]["description"] = true;
+    filter["firmware"]["board"] = true;
+    filter["build_info"]["timestamp"] = true;
+    filter["features"][0] = true;
+    
+    DeserializationError error = deserializeJson(document, json, length,
+                                                 DeserializationOption::Filter(filter),
+                                                 DeserializationOption::NestingLimit(NESTING_LIMIT));
+    if (error) {
+        lastError = error.c_str();
+        document.clear();
+        return false;
+    }
+    lastError = "";
+    
+    // Read through the const interface: a missing key must not add one
+    const JsonDocument& parsed = document;
+    JsonVariantConst firmware = parsed["firmware"];
+    copyField(metadata.version, sizeof(metadata.version), firmware["version"]);
+    copyField(metadata.description, sizeof(metadata.description), firmware["description"]);
+    copyField(metadata.board, sizeof(metadata.board), firmware["board"]);
+    
+    // ISO timestamp, YYYY-MM-DDTHH:MM:SS...
+    const char* timestamp = parsed["build_info"]["timestamp"].as<const char*>();
+    if (timestamp != nullptr) {
+        const char* dateEnd = strchr(timestamp, 'T');
+        copyText(metadata.buildDate, sizeof(metadata.buildDate), timestamp,
+                 dateEnd != nullptr ? (size_t)(dateEnd - timestamp) : strlen(timestamp));
+    }
+    
+    size_t used = 0;
+    for (JsonVariantConst feature : parsed["features"].as<JsonArrayConst>()) {
+        const char* name = feature.as<const char*>();
+        if (name == nullptr) {
+            continue;
+        }
+        
+        size_t nameLength = strlen(name);
+        size_t needed = nameLength + (used > 0 ? 1 : 0);
+        if (used + needed >= sizeof(metadata.features)) {
+            break;
+        }
+        if (used > 0) {
+            metadata.features[used++] = ',';
+        }
+        memcpy(metadata.features + used, name, nameLength);
+        used += nameLength;
+    }
+    metadata.features[used] = '\0';
+    
+    document.clear();
+    return true;
+}
+
+const char* FirmwareMetadata::getLastError() {
+    return lastError;
+}
@@ -0,0 +1,38 @@
+#ifndef FIRMWAREMETADATA_H
+#define FIRMWAREMETADATA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// The metadata JSON inside a firmware package, as written by
+// create_firmware_package.py. Parsing uses a static ArduinoJson document
+// and fixed buffers, so it never touches the heap; not reentrant. Fields
+// that are missing read "Unknown", long values are truncated.
+struct FirmwareMetadata {
+    static const size_t VERSION_LENGTH = 24;
+    static const size_t DESCRIPTION_LENGTH = 96;
+    static const size_t BOARD_LENGTH = 32;
+    static const size_t BUILD_DATE_LENGTH = 32;
+    static const size_t FEATURES_LENGTH = 256;   // Comma separated
+    static const size_t MAX_JSON = 2048;         // FirmwareFormat::MAX_METADATA
+    static const size_t DOCUMENT_SIZE = 2048;
+    static const uint8_t NESTING_LIMIT = 4;
+    
+    char version[VERSION_LENGTH];
+    char description[DESCRIPTION_LENGTH];
+    char board[BOARD_LENGTH];
+    char buildDate[BUILD_DATE_LENGTH];          // Date part of build_info.timestamp
+    char features[FEATURES_LENGTH];
+    
+    FirmwareMetadata();
+    void clear();
+    
+    // False on malformed JSON or a document that doesn't fit; see getLastError()
+    static bool parse(const char* json, size_t length, FirmwareMetadata& metadata);
+    static const char* getLastError();
+
+private:
+    static const char* lastError;
+};
+
+#endif
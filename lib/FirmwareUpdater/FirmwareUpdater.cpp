@@ -1,9 +1,28 @@
 #include "FirmwareUpdater.h"
 #include "Logger.h"
-#include <ArduinoJson.h>
+#include "HeapTracker.h"
+#include "Crc32.h"
+#include "HexPayloadReader.h"
+#include "FlashPages.h"
+#include <new>
 
 // Static member initialization
 const char* FirmwareUpdater::FIRMWARE_DIR = "/";
+const char* FirmwareUpdater::FLASHED_PAGES_FILE = "/attiny_pages.bin";
+
+// Page hashes of the image being flashed and of the one the ATtiny has
+struct FlashImages {
+    FlashPages image;
+    FlashPages flashed;
+};
+
+// What sendChangedPage needs to know while the payload is read again
+struct DeltaUpdate {
+    const FlashPages* flashed;
+    int pageCount;
+    int lineCount;
+    int successCount;
+};
 
 void FirmwareUpdater::init() {
     Logger::addEntry("FirmwareUpdater initialized");
@@ -23,6 +42,7 @@ String FirmwareUpdater::getFirmwarePath(const String& filename) {
 }
 
 bool FirmwareUpdater::uploadFirmwareToSPIFFS(const uint8_t* firmwareData, size_t firmwareSize, const String& filename) {
+    HeapScope heapScope(HEAP_MODULE_FIRMWARE);
     String filepath = getFirmwarePath(filename);
     
     Logger::addEntry("Attempting to create firmware file: " + filepath);
@@ -55,34 +75,7 @@ bool FirmwareUpdater::uploadFirmwareToSPIFFS(const uint8_t* firmwareData, size_t
 }
 
 bool FirmwareUpdater::isValidDateFormat(const String& dateStr, char separator) {
-    if (dateStr.length() != 10) {
-        return false;
-    }
-    
-    // Check separator positions
-    if (dateStr.charAt(4) != separator || dateStr.charAt(7) != separator) {
-        return false;
-    }
-    
-    // Check if all other characters are digits
-    for (int i = 0; i < dateStr.length(); i++) {
-        if (i != 4 && i != 7) { // Skip separator positions
-            if (dateStr.charAt(i) < '0' || dateStr.charAt(i) > '9') {
-                return false;
-            }
-        }
-    }
-    
-    // Basic validation: year should be reasonable, month 1-12, day 1-31
-    int year = dateStr.substring(0, 4).toInt();
-    int month = dateStr.substring(5, 7).toInt();
-    int day = dateStr.substring(8, 10).toInt();
-    
-    if (year < 2000 || year > 2030) return false;
-    if (month < 1 || month > 12) return false;
-    if (day < 1 || day > 31) return false;
-    
-    return true;
+    return FirmwareFormat::isValidDate(dateStr.c_str(), dateStr.length(), separator);
 }
 
 bool FirmwareUpdater::updateATtinyFirmware() {
@@ -91,6 +84,7 @@ bool FirmwareUpdater::updateATtinyFirmware() {
 }
 
 bool FirmwareUpdater::updateATtinyFirmwareFromSPIFFS(const String& filename) {
+    HeapScope heapScope(HEAP_MODULE_FIRMWARE);
     if (!firmwareExists(filename)) {
         Logger::addEntry("No firmware file found: " + filename);
         return false;
@@ -103,78 +97,68 @@ bool FirmwareUpdater::updateATtinyFirmwareFromSPIFFS(const String& filename) {
         return false;
     }
     
-    Logger::addEntry("Starting ATtiny firmware update from SPIFFS: " + filename);
+    // A plain .hex file is one HEX payload from start to end
+    FirmwarePackageLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.payloadType = PAYLOAD_INTEL_HEX;
+    layout.firmwareLength = file.size();
     
-    // Initialize I2C communication
-    Wire.beginTransmission(ATTINY_ADDRESS);
-    if (Wire.endTransmission() != 0) {
-        Logger::addEntry("ATtiny not responding on I2C address 0x" + String(ATTINY_ADDRESS, HEX));
-        file.close();
+    bool success = updateFromPayload(file, layout, filename);
+    file.close();
+    return success;
+}
+
+bool FirmwareUpdater::updateATtinyFirmwareFromPackage(const String& filename) {
+    HeapScope heapScope(HEAP_MODULE_FIRMWARE);
+    String filepath = getFirmwarePath(filename);
+    File file = SPIFFS.open(filepath, "r");
+    if (!file) {
+        Logger::addEntry("Failed to open firmware package: " + filepath);
         return false;
     }
     
-    // Send firmware update command
-    Wire.beginTransmission(ATTINY_ADDRESS);
-    Wire.write(0xFE); // Firmware update command
-    if (Wire.endTransmission() != 0) {
-        Logger::addEntry("Failed to send firmware update command");
+    uint8_t header[FirmwareFormat::PACKAGE_MAX_HEADER_SIZE];
+    size_t headerLength = file.read(header, sizeof(header));
+    FirmwarePackageLayout layout;
+    FirmwarePackageStatus status = FirmwareFormat::parsePackageHeader(header, headerLength, file.size(), layout);
+    if (status == PACKAGE_OK) {
+        status = verifyStoredPackage(file, layout);
+    }
+    if (status != PACKAGE_OK) {
+        Logger::addEntry(filename + ": " + FirmwareFormat::packageStatusToString(status));
         file.close();
         return false;
     }
     
-    delay(100); // Give ATtiny time to prepare
-    
-    int lineCount = 0;
-    int successCount = 0;
-    
-    while (file.available()) {
-        String line = file.readStringUntil('\n');
-        line.trim();
-        
-        if (line.length() > 0 && line.startsWith(":")) {
-            if (sendFirmwareLine(line)) {
-                successCount++;
-            }
-            lineCount++;
-            
-            // Progress indicator every 100 lines
-            if (lineCount % 100 == 0) {
-                Logger::addEntry("Firmware update progress: " + String(lineCount) + " lines processed");
-            }
-            
-            delay(1); // Small delay to prevent overwhelming the ATtiny
-        }
+    if (layout.payloadType == PAYLOAD_HEX_LZSS) {
+        Logger::addEntry("Compressed payload: " + String(layout.firmwareLength) + " bytes, " +
+                         String(layout.decodedLength) + " bytes of HEX records");
     }
     
+    bool success = updateFromPayload(file, layout, filename);
     file.close();
-    
-    // Send update complete command
-    Wire.beginTransmission(ATTINY_ADDRESS);
-    Wire.write(0xFF); // Update complete command
-    Wire.endTransmission();
-    
-    delay(500); // Give ATtiny time to finalize
-    
-    Logger::addEntry("Firmware update completed. Lines: " + String(lineCount) + ", Success: " + String(successCount));
-    
-    return successCount == lineCount;
+    return success;
 }
 
 bool FirmwareUpdater::checkATtinyVersion() {
-    Wire.beginTransmission(ATTINY_ADDRESS);
-    Wire.write(0xFD); // Version check command
-    if (Wire.endTransmission() != 0) {
+    const uint8_t versionCommand = 0xFD; // Version check command
+    if (I2CBus::write(ATTINY_ADDRESS, &versionCommand, 1, I2C_PRIORITY_LOW) != 0) {
         Logger::addEntry("Failed to send version check command");
         return false;
     }
     
     delay(100);
     
-    Wire.requestFrom(ATTINY_ADDRESS, 32);
-    if (Wire.available()) {
+    // A short reply still carries the version, only nothing at all is a failure
+    uint8_t response[32];
+    I2CTransaction transaction(ATTINY_ADDRESS);
+    transaction.readData = response;
+    transaction.readLength = sizeof(response);
+    I2CBus::transfer(transaction, I2C_PRIORITY_LOW);
+    if (transaction.bytesRead > 0) {
         String version = "";
-        while (Wire.available()) {
-            char c = Wire.read();
+        for (size_t i = 0; i < transaction.bytesRead; i++) {
+            char c = response[i];
             if (c == '\0') break;
             version += c;
         }
@@ -288,222 +272,421 @@ size_t FirmwareUpdater::getFirmwareSize(const String& filename) {
     return size;
 }
 
-bool FirmwareUpdater::sendFirmwareLine(const String& line) {
-    Wire.beginTransmission(ATTINY_ADDRESS);
-    
-    // Send line length first
-    Wire.write(line.length());
-    
-    // Send the actual line data
-    for (int i = 0; i < line.length(); i++) {
-        Wire.write(line.charAt(i));
+// HexPayloadReader input, from wherever the payload's File is positioned
+static size_t readPayloadFile(void* context, uint8_t* buffer, size_t capacity) {
+    return ((File*)context)->read(buffer, capacity);
+}
+
+bool FirmwareUpdater::sendFirmwareLine(const char* line, size_t length) {
+    // Line length first, then the line itself, in one write
+    uint8_t buffer[MAX_LINE_LENGTH + 1];
+    if (length > MAX_LINE_LENGTH) {
+        return false;
     }
+    buffer[0] = length;
+    memcpy(buffer + 1, line, length);
     
-    if (Wire.endTransmission() != 0) {
+    if (I2CBus::write(ATTINY_ADDRESS, buffer, length + 1, I2C_PRIORITY_LOW) != 0) {
         return false;
     }
     
-    // Wait for acknowledgment
+    // Wait for acknowledgment, off the bus so other users can get in
     delay(1);
-    Wire.requestFrom(ATTINY_ADDRESS, 1);
-    if (Wire.available()) {
-        uint8_t ack = Wire.read();
+    uint8_t ack = 0;
+    if (I2CBus::read(ATTINY_ADDRESS, &ack, 1, I2C_PRIORITY_LOW) == 0) {
         return (ack == 0x06); // ACK character
     }
     
     return false;
 }
 
-bool FirmwareUpdater::verifyFirmwareChecksum(const String& line) {
-    if (line.length() < 11) return false; // Minimum HEX line length
+bool FirmwareUpdater::updateFromPayload(File& file, const FirmwarePackageLayout& layout, const String& name) {
+    // Without the page hashes this is still a full update, just neither a delta nor a verified one
+    FlashImages* images = new (std::nothrow) FlashImages;
+    if (!checkPayload(file, layout, images != nullptr ? &images->image : nullptr)) {
+        delete images;
+        return false;
+    }
     
-    // Extract checksum from end of line
-    String checksumStr = line.substring(line.length() - 2);
-    uint8_t expectedChecksum = strtol(checksumStr.c_str(), NULL, 16);
+    // An image with no data would match any ATtiny on a CRC of zero pages
+    bool known = images != nullptr && !images->image.failed() && images->image.getPageCount() > 0;
+    uint32_t attinyCrc = 0;
     
-    // Calculate checksum from data
-    uint8_t calculatedChecksum = 0;
-    for (int i = 1; i < line.length() - 2; i += 2) {
-        String byteStr = line.substring(i, i + 2);
-        uint8_t byte = strtol(byteStr.c_str(), NULL, 16);
-        calculatedChecksum += byte;
+    // Already running this image: nothing to flash
+    if (known && readATtinyCrc(images->image.getPageCount(), attinyCrc) && attinyCrc == images->image.getImageCrc()) {
+        Logger::addEntry("ATtiny already runs " + name + " (CRC32 " + String(attinyCrc, HEX) + "), update skipped");
+        
+        // Routine checks shouldn't rewrite the page hashes when they already match
+        bool stored = loadFlashedPages(images->flashed) &&
+                      images->flashed.getImageCrc() == images->image.getImageCrc() &&
+                      images->flashed.getPageCount() == images->image.getPageCount();
+        if (!stored) {
+            saveFlashedPages(images->image);
+        }
+        delete images;
+        return true;
     }
-    calculatedChecksum = (0x100 - calculatedChecksum) & 0xFF;
     
-    return calculatedChecksum == expectedChecksum;
-}
-
-int FirmwareUpdater::countHexLines(const String& filepath) {
-    File file = SPIFFS.open(filepath, "r");
-    if (!file) {
-        return 0;
+    // The stored hashes are only used once the ATtiny has confirmed, by CRC,
+    // that it still has the image they describe. An ATtiny that can't report
+    // a CRC doesn't know the delta command either.
+    bool delta = false;
+    if (known && loadFlashedPages(images->flashed)) {
+        if (!readATtinyCrc(images->flashed.getPageCount(), attinyCrc)) {
+            Logger::addEntry("ATtiny can't report a CRC, full update");
+        } else if (attinyCrc != images->flashed.getImageCrc()) {
+            Logger::addEntry("ATtiny image doesn't match the stored page hashes, full update");
+        } else {
+            delta = true;
+        }
     }
     
-    int lineCount = 0;
-    while (file.available()) {
-        String line = file.readStringUntil('\n');
-        if (line.length() > 0 && line.startsWith(":")) {
-            lineCount++;
+    bool success = false;
+    if (delta) {
+        uint16_t changed = images->image.countChanged(images->flashed);
+        Logger::addEntry("Delta update: " + String(changed) + " of " + String(FlashPages::MAX_PAGES) + " pages changed");
+        success = flashChangedPages(file, layout, name, images->image, images->flashed);
+        if (!success) {
+            Logger::addEntry("Delta update failed, falling back to a full update");
         }
     }
+    if (!success) {
+        success = flashPayload(file, layout, name);
+    }
     
-    file.close();
-    return lineCount;
+    // Line ACKs only say each line arrived; the CRC says what ended up in flash
+    bool verified = false;
+    if (success && known) {
+        if (!readATtinyCrc(images->image.getPageCount(), attinyCrc)) {
+            Logger::addEntry("ATtiny can't report a CRC, update not verified");
+        } else if (attinyCrc != images->image.getImageCrc()) {
+            Logger::addEntry("Verify failed: ATtiny CRC32 " + String(attinyCrc, HEX) + ", expected " +
+                             String(images->image.getImageCrc(), HEX));
+            success = false;
+        } else {
+            Logger::addEntry("Verified: ATtiny CRC32 " + String(attinyCrc, HEX) + " over " +
+                             String(images->image.getPageCount()) + " pages");
+            verified = true;
+        }
+    }
+    
+    // Only a verified image is a baseline for the next delta; after anything
+    // else nobody knows what the ATtiny has, so the next update is a full one
+    if (verified) {
+        saveFlashedPages(images->image);
+    } else {
+        forgetFlashedImage();
+    }
+    delete images;
+    return success;
 }
 
-bool FirmwareUpdater::extractVersionFromHex(const String& hexContent, String& version, String& buildDate) {
-    // Initialize with default values
-    version = "Unknown";
-    buildDate = "Unknown";
+bool FirmwareUpdater::checkPayload(File& file, const FirmwarePackageLayout& layout, FlashPages* pages) {
+    if (!file.seek(layout.firmwareOffset)) {
+        Logger::addEntry("Failed to seek to the firmware payload");
+        return false;
+    }
     
-    // Split content into lines
-    int startPos = 0;
-    int endPos = hexContent.indexOf('\n');
+    // One line longer than the ATtiny accepts still fits, so it can be rejected
+    HexPayloadReader reader(layout.payloadType, layout.firmwareLength, layout.decodedLength, readPayloadFile, &file);
+    char line[MAX_LINE_LENGTH + 2];
+    size_t length = 0;
+    HexRecord record;
+    if (pages != nullptr) {
+        pages->reset();
+    }
     
-    while (endPos != -1) {
-        String line = hexContent.substring(startPos, endPos);
-        line.trim();
-        
-        if (isValidHexLine(line)) {
-            String data = parseHexLine(line);
-            if (data.length() > 0) {
-                // Search for version string patterns
-                if (data.indexOf("1.0.0") != -1) {
-                    version = "1.0.0";
-                } else if (data.indexOf("1.0.1") != -1) {
-                    version = "1.0.1";
-                } else if (data.indexOf("1.0.2") != -1) {
-                    version = "1.0.2";
-                } else if (data.indexOf("1.1.0") != -1) {
-                    version = "1.1.0";
-                }
-                
-                // Search for build date patterns (YYYY-MM-DD or YYYY/MM/DD)
-                int datePos = data.indexOf("2024-");
-                if (datePos != -1 && datePos + 10 <= data.length()) {
-                    String potentialDate = data.substring(datePos, datePos + 10);
-                    if (isValidDateFormat(potentialDate, '-')) {
-                        buildDate = potentialDate;
-                    }
-                }
-                
-                // Alternative date format
-                datePos = data.indexOf("2024/");
-                if (datePos != -1 && datePos + 10 <= data.length()) {
-                    String potentialDate = data.substring(datePos, datePos + 10);
-                    if (isValidDateFormat(potentialDate, '/')) {
-                        buildDate = potentialDate;
-                    }
-                }
-            }
+    while (reader.nextLine(line, sizeof(line), length)) {
+        if (length > MAX_LINE_LENGTH || !FirmwareFormat::decodeRecord(line, length, record)) {
+            Logger::addEntry("Malformed HEX record on line " + String(reader.getLineNumber()) + ", update not started");
+            return false;
+        }
+        if (pages != nullptr) {
+            pages->addRecord(record);
         }
-        
-        startPos = endPos + 1;
-        endPos = hexContent.indexOf('\n', startPos);
     }
     
-    // If we found at least one valid piece of info, return true
-    return (version != "Unknown" || buildDate != "Unknown");
+    if (reader.getStatus() != HEX_PAYLOAD_END) {
+        Logger::addEntry(String(HexPayloadReader::statusToString(reader.getStatus())) + " at line " +
+                         String(reader.getLineNumber()) + ", update not started");
+        return false;
+    }
+    
+    if (pages != nullptr && !pages->finish()) {
+        Logger::addEntry("HEX records out of address order, delta update not possible");
+    }
+    return true;
 }
 
-String FirmwareUpdater::parseHexLine(const String& hexLine) {
-    if (!isValidHexLine(hexLine)) {
-        return "";
+bool FirmwareUpdater::beginUpdate(File& file, const FirmwarePackageLayout& layout, uint8_t command) {
+    // Flashing runs at low priority, each line is its own bus grant so
+    // display updates interleave with it
+    if (I2CBus::probe(ATTINY_ADDRESS) != I2C_PROBE_ACK) {
+        Logger::addEntry("ATtiny not responding on I2C address 0x" + String(ATTINY_ADDRESS, HEX));
+        return false;
     }
     
-    // Extract data portion (skip :, length, address, keep data, skip checksum)
-    if (hexLine.length() < 11) {
-        return "";
+    if (!file.seek(layout.firmwareOffset)) {
+        Logger::addEntry("Failed to seek to the firmware payload");
+        return false;
     }
     
-    // Data starts after :[length][address] and ends before [checksum]
-    int dataStart = 9; // After :[2][4]
-    int dataEnd = hexLine.length() - 2; // Before [2] checksum
+    if (I2CBus::write(ATTINY_ADDRESS, &command, 1, I2C_PRIORITY_LOW) != 0) {
+        Logger::addEntry("Failed to send firmware update command");
+        return false;
+    }
     
-    if (dataEnd <= dataStart) {
-        return "";
+    delay(100); // Give ATtiny time to prepare
+    return true;
+}
+
+void FirmwareUpdater::endUpdate() {
+    // Send update complete command
+    const uint8_t completeCommand = 0xFF; // Update complete command
+    I2CBus::write(ATTINY_ADDRESS, &completeCommand, 1, I2C_PRIORITY_LOW);
+    
+    delay(500); // Give ATtiny time to finalize
+}
+
+bool FirmwareUpdater::flashPayload(File& file, const FirmwarePackageLayout& layout, const String& name) {
+    Logger::addEntry("Starting ATtiny firmware update from SPIFFS: " + name);
+    
+    // Firmware update command: the ATtiny erases the application, then programs every line
+    if (!beginUpdate(file, layout, 0xFE)) {
+        return false;
     }
     
-    String dataHex = hexLine.substring(dataStart, dataEnd);
-    String asciiData = "";
+    // Lines come straight out of the payload, decompressed on the way if need be
+    HexPayloadReader reader(layout.payloadType, layout.firmwareLength, layout.decodedLength, readPayloadFile, &file);
+    char line[MAX_LINE_LENGTH + 2];
+    size_t length = 0;
+    int lineCount = 0;
+    int successCount = 0;
+    unsigned long startTime = millis();
     
-    // Convert hex pairs to ASCII
-    for (int i = 0; i < dataHex.length(); i += 2) {
-        if (i + 1 < dataHex.length()) {
-            String hexPair = dataHex.substring(i, i + 2);
-            int asciiValue = strtol(hexPair.c_str(), NULL, 16);
-            
-            // Only include printable ASCII characters
-            if (asciiValue >= 32 && asciiValue <= 126) {
-                asciiData += (char)asciiValue;
-            }
+    while (reader.nextLine(line, sizeof(line), length)) {
+        if (sendFirmwareLine(line, length)) {
+            successCount++;
+        }
+        lineCount++;
+        
+        // Progress indicator every 100 lines
+        if (lineCount % 100 == 0) {
+            Logger::addEntry("Firmware update progress: " + String(lineCount) + " lines processed");
         }
+        
+        delay(1); // Small delay to prevent overwhelming the ATtiny
     }
     
-    return asciiData;
+    endUpdate();
+    
+    Logger::addEntry("Firmware update completed. Lines: " + String(lineCount) + ", Success: " + String(successCount) +
+                     ", " + String(millis() - startTime) + " ms");
+    
+    // The payload was checked before the update started, so a reader error here means the file changed under us
+    return successCount == lineCount && reader.getStatus() == HEX_PAYLOAD_END;
 }
 
-bool FirmwareUpdater::isValidHexLine(const String& hexLine) {
-    // Check if line starts with : and has minimum length
-    if (!hexLine.startsWith(":") || hexLine.length() < 11) {
+bool FirmwareUpdater::flashChangedPages(File& file, const FirmwarePackageLayout& layout, const String& name,
+                                        FlashPages& image, const FlashPages& flashed) {
+    Logger::addEntry("Starting ATtiny delta update from SPIFFS: " + name);
+    
+    // Delta update command: nothing is erased, only the pages that follow are reprogrammed
+    if (!beginUpdate(file, layout, 0xFC)) {
         return false;
     }
     
-    // Check if all characters are valid hex
-    for (int i = 1; i < hexLine.length(); i++) {
-        char c = hexLine.charAt(i);
-        if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))) {
-            return false;
+    // The payload is read a second time and rebuilt into the same pages;
+    // each one that differs from the ATtiny's goes out as it completes
+    DeltaUpdate delta = { &flashed, 0, 0, 0 };
+    image.reset(sendChangedPage, &delta);
+    HexPayloadReader reader(layout.payloadType, layout.firmwareLength, layout.decodedLength, readPayloadFile, &file);
+    char line[MAX_LINE_LENGTH + 2];
+    size_t length = 0;
+    HexRecord record;
+    unsigned long startTime = millis();
+    
+    while (reader.nextLine(line, sizeof(line), length)) {
+        if (FirmwareFormat::decodeRecord(line, length, record)) {
+            image.addRecord(record);
         }
     }
+    // Pages past the end of the new image are erased if the old one used them
+    bool complete = image.finish() && reader.getStatus() == HEX_PAYLOAD_END;
     
-    return true;
+    endUpdate();
+    
+    Logger::addEntry("Delta update completed. Pages: " + String(delta.pageCount) + ", Lines: " + String(delta.lineCount) +
+                     ", Success: " + String(delta.successCount) + ", " + String(millis() - startTime) + " ms");
+    return complete && delta.successCount == delta.lineCount;
 }
 
-// New methods for .bin package handling
-bool FirmwareUpdater::uploadFirmwarePackage(const uint8_t* packageData, size_t packageSize, const String& filename) {
-    // Parse metadata directly from package data to get version and board info
-    if (packageSize < 10) {
-        Logger::addEntry("Package too small to be valid");
+void FirmwareUpdater::sendChangedPage(void* context, uint16_t page, const uint8_t* data, uint32_t hash) {
+    DeltaUpdate* delta = (DeltaUpdate*)context;
+    if (hash == delta->flashed->getPageHash(page)) {
+        return;
+    }
+    
+    // A page is RECORDS_PER_PAGE data records, written whole so erased bytes
+    // in it are programmed back to 0xFF
+    HexRecord record;
+    record.type = HEX_RECORD_DATA;
+    record.length = FlashPages::RECORD_SIZE;
+    char line[MAX_LINE_LENGTH + 1];
+    
+    for (size_t i = 0; i < FlashPages::RECORDS_PER_PAGE; i++) {
+        record.address = page * FlashPages::PAGE_SIZE + i * FlashPages::RECORD_SIZE;
+        memcpy(record.data, data + i * FlashPages::RECORD_SIZE, FlashPages::RECORD_SIZE);
+        size_t length = FirmwareFormat::formatRecord(record, line, sizeof(line));
+        if (length > 0 && sendFirmwareLine(line, length)) {
+            delta->successCount++;
+        }
+        delta->lineCount++;
+        delay(1); // Small delay to prevent overwhelming the ATtiny
+    }
+    delta->pageCount++;
+}
+
+bool FirmwareUpdater::readATtinyCrc(uint16_t pageCount, uint32_t& crc) {
+    // CRC command: [0xFB][page count LE], answered with [ACK][CRC32 LE] once
+    // the ATtiny has run the CRC over that many pages of its application
+    const uint8_t command[3] = { 0xFB, (uint8_t)(pageCount & 0xFF), (uint8_t)(pageCount >> 8) };
+    if (I2CBus::write(ATTINY_ADDRESS, command, sizeof(command), I2C_PRIORITY_LOW) != 0) {
         return false;
     }
     
-    // Check magic header "FLFW\0" (5 bytes)
-    const char* expectedMagic = "FLFW\0";
-    if (memcmp(packageData, expectedMagic, 5) != 0) {
-        Logger::addEntry("Invalid package magic header");
+    delay(10 + pageCount); // About 0.3 ms a page on the ATtiny, with margin
+    
+    // Firmware without the command answers something else, or nothing
+    uint8_t response[5];
+    if (I2CBus::read(ATTINY_ADDRESS, response, sizeof(response), I2C_PRIORITY_LOW) != 0 || response[0] != 0x06) {
+        return false;
+    }
+    crc = response[1] | (response[2] << 8) | (response[3] << 16) | ((uint32_t)response[4] << 24);
+    return true;
+}
+
+bool FirmwareUpdater::loadFlashedPages(FlashPages& pages) {
+    if (!SPIFFS.exists(FLASHED_PAGES_FILE)) {
         return false;
     }
     
-    // Read metadata length (4 bytes, little-endian)
-    uint32_t metadataLength = packageData[5] | (packageData[6] << 8) | 
-                              (packageData[7] << 16) | (packageData[8] << 24);
+    File file = SPIFFS.open(FLASHED_PAGES_FILE, "r");
+    if (!file) {
+        return false;
+    }
     
-    Logger::addEntry("Metadata length: " + String(metadataLength) + " bytes");
+    static uint8_t buffer[FlashPages::SERIALIZED_SIZE];
+    size_t size = file.size();
+    size_t bytesRead = size <= sizeof(buffer) ? file.read(buffer, size) : 0;
+    file.close();
     
-    if (metadataLength > 2048 || metadataLength == 0) {
-        Logger::addEntry("Invalid metadata length: " + String(metadataLength));
+    if (!pages.deserialize(buffer, bytesRead)) {
+        Logger::addEntry("Discarding unreadable ATtiny page hashes, full update");
+        return false;
+    }
+    return true;
+}
+
+bool FirmwareUpdater::saveFlashedPages(const FlashPages& pages) {
+    static uint8_t buffer[FlashPages::SERIALIZED_SIZE];
+    size_t size = pages.serialize(buffer, sizeof(buffer));
+    if (size == 0) {
         return false;
     }
     
-    // Calculate metadata position
-    size_t metadataStart = 9;  // After 5 magic + 4 length
-    if (metadataStart + metadataLength > packageSize) {
-        Logger::addEntry("Package truncated - metadata incomplete");
+    File file = SPIFFS.open(FLASHED_PAGES_FILE, "w");
+    if (!file) {
         return false;
     }
     
-    // Extract metadata JSON string
-    String metadataJson = String((char*)&packageData[metadataStart], metadataLength);
+    size_t bytesWritten = file.write(buffer, size);
+    file.close();
+    return bytesWritten == size;
+}
+
+void FirmwareUpdater::forgetFlashedImage() {
+    if (SPIFFS.exists(FLASHED_PAGES_FILE)) {
+        SPIFFS.remove(FLASHED_PAGES_FILE);
+    }
+}
+
+bool FirmwareUpdater::verifyFirmwareChecksum(const String& line) {
+    return FirmwareFormat::verifyChecksum(line.c_str(), line.length());
+}
+
+int FirmwareUpdater::countHexLines(const String& filepath) {
+    File file = SPIFFS.open(filepath, "r");
+    if (!file) {
+        return 0;
+    }
+    
+    int lineCount = 0;
+    while (file.available()) {
+        String line = file.readStringUntil('\n');
+        if (line.length() > 0 && line.startsWith(":")) {
+            lineCount++;
+        }
+    }
     
-    // Parse metadata to get version and board
-    String version, description, buildDate, board;
-    String features;
-    if (!parseFirmwareMetadataFromString(metadataJson, version, description, buildDate, board, features)) {
-        Logger::addEntry("Failed to parse metadata from package");
+    file.close();
+    return lineCount;
+}
+
+bool FirmwareUpdater::extractVersionFromHex(const String& hexContent, String& version, String& buildDate) {
+    char versionBuffer[16];
+    char buildDateBuffer[16];
+    bool found = FirmwareFormat::extractVersion(hexContent.c_str(), hexContent.length(),
+                                                versionBuffer, sizeof(versionBuffer),
+                                                buildDateBuffer, sizeof(buildDateBuffer));
+    version = versionBuffer;
+    buildDate = buildDateBuffer;
+    return found;
+}
+
+String FirmwareUpdater::parseHexLine(const String& hexLine) {
+    char text[FirmwareFormat::MAX_HEX_DATA + 1];
+    FirmwareFormat::extractText(hexLine.c_str(), hexLine.length(), text, sizeof(text));
+    return String(text);
+}
+
+bool FirmwareUpdater::isValidHexLine(const String& hexLine) {
+    return FirmwareFormat::isValidHexLine(hexLine.c_str(), hexLine.length());
+}
+
+// New methods for .bin package handling
+bool FirmwareUpdater::uploadFirmwarePackage(const uint8_t* packageData, size_t packageSize, const String& filename) {
+    HeapScope heapScope(HEAP_MODULE_FIRMWARE);
+    // Parse metadata directly from package data to get version and board info
+    FirmwarePackageLayout layout;
+    FirmwarePackageStatus status = FirmwareFormat::parsePackageHeader(packageData, packageSize, packageSize, layout);
+    if (status == PACKAGE_OK || status == PACKAGE_TRUNCATED) {
+        Logger::addEntry("Metadata length: " + String(layout.metadataLength) + " bytes");
+    }
+    if (status == PACKAGE_OK) {
+        status = FirmwareFormat::verifyPackage(packageData, packageSize, layout);
+    }
+    if (status != PACKAGE_OK) {
+        Logger::addEntry(FirmwareFormat::packageStatusToString(status));
         return false;
     }
     
+    // Format 2 carries version and board in its header; format 1 only in the JSON
+    String version;
+    String board;
+    if (layout.formatVersion == FirmwareFormat::PACKAGE_FORMAT_V2) {
+        version = packageVersion(layout);
+        board = packageBoard(layout);
+    } else {
+        FirmwareMetadata metadata;
+        if (!FirmwareMetadata::parse((const char*)&packageData[layout.metadataOffset], layout.metadataLength, metadata)) {
+            Logger::addEntry("Failed to parse metadata from package: " + String(FirmwareMetadata::getLastError()));
+            return false;
+        }
+        version = metadata.version;
+        board = metadata.board;
+    }
+    
     // Generate proper filename
     String properFilename = generateFirmwareFilename(version, board);
     String filepath = getFirmwarePath(properFilename);
@@ -547,6 +730,7 @@ bool FirmwareUpdater::uploadFirmwarePackage(const uint8_t* packageData, size_t p
 }
 
 bool FirmwareUpdater::extractFirmwarePackage(const String& packagePath) {
+    HeapScope heapScope(HEAP_MODULE_FIRMWARE);
     if (!SPIFFS.exists(packagePath)) {
         Logger::addEntry("Firmware package not found: " + packagePath);
         return false;
@@ -558,76 +742,96 @@ bool FirmwareUpdater::extractFirmwarePackage(const String& packagePath) {
         return false;
     }
     
-    // Read the entire package into memory
+    // Bound the size before it decides an allocation and every read after it
     size_t packageSize = packageFile.size();
-    uint8_t* packageData = new uint8_t[packageSize];
-    packageFile.read(packageData, packageSize);
+    if (packageSize < FirmwareFormat::MIN_PACKAGE_SIZE || packageSize > FirmwareFormat::MAX_PACKAGE_SIZE) {
+        Logger::addEntry("Invalid package size: " + String(packageSize) + " bytes");
+        packageFile.close();
+        return false;
+    }
+    
+    // Read the entire package into memory
+    uint8_t* packageData = new (std::nothrow) uint8_t[packageSize];
+    if (packageData == nullptr) {
+        Logger::addEntry("Not enough memory to extract a " + String(packageSize) + " byte package");
+        packageFile.close();
+        return false;
+    }
+    size_t bytesRead = packageFile.read(packageData, packageSize);
     packageFile.close();
     
-    // Parse custom .bin format: [Magic][MetadataLength][Metadata][Firmware]
-    if (packageSize < 10) { // Minimum: 5 magic + 4 length + 1 metadata
-        Logger::addEntry("Package too small to be valid");
+    if (bytesRead != packageSize) {
+        Logger::addEntry("Short read on firmware package: " + String(bytesRead) + " of " + String(packageSize) + " bytes");
         delete[] packageData;
         return false;
     }
     
-    // Check magic header "FLFW\0" (5 bytes)
-    const char* expectedMagic = "FLFW\0";
+    // Parse custom .bin format, either version; see FirmwareFormat.h
+    FirmwarePackageLayout layout;
+    FirmwarePackageStatus status = FirmwareFormat::parsePackageHeader(packageData, packageSize, packageSize, layout);
+    if (status == PACKAGE_OK || status == PACKAGE_TRUNCATED) {
+        Logger::addEntry("Metadata length: " + String(layout.metadataLength) + " bytes");
+    }
+    if (status == PACKAGE_OK) {
+        status = FirmwareFormat::verifyPackage(packageData, packageSize, layout);
+    }
+    if (status != PACKAGE_OK) {
+        Logger::addEntry(FirmwareFormat::packageStatusToString(status));
+        delete[] packageData;
+        return false;
+    }
     
-    // Debug: Log the first 8 bytes
+    // Debug: Log the first 8 bytes, all inside the header just validated
     String debugBytes = "First 8 bytes: ";
     for (int i = 0; i < 8; i++) {
         debugBytes += String(packageData[i], HEX) + " ";
     }
     Logger::addEntry(debugBytes);
     
-    if (memcmp(packageData, expectedMagic, 5) != 0) {
-        Logger::addEntry("Invalid package magic header");
+    if (layout.firmwareLength == 0) {
+        Logger::addEntry("Package truncated - no firmware data");
         delete[] packageData;
         return false;
     }
     
-    // Read metadata length (4 bytes, little-endian)
-    uint32_t metadataLength = packageData[5] | (packageData[6] << 8) | 
-                              (packageData[7] << 16) | (packageData[8] << 24);
-    
-    Logger::addEntry("Metadata length: " + String(metadataLength) + " bytes");
-    
-    if (metadataLength > 2048 || metadataLength == 0) {
-        Logger::addEntry("Invalid metadata length: " + String(metadataLength));
+    if (layout.payloadType != PAYLOAD_INTEL_HEX && layout.payloadType != PAYLOAD_HEX_LZSS) {
+        Logger::addEntry("Unsupported firmware payload type: " + String(layout.payloadType));
         delete[] packageData;
         return false;
     }
     
-    // Calculate positions
-    size_t metadataStart = 9;  // After 5 magic + 4 length
-    size_t metadataEnd = metadataStart + metadataLength;
-    size_t firmwareStart = metadataEnd;
-    
-    if (firmwareStart >= packageSize) {
-        Logger::addEntry("Package truncated - no firmware data");
-        delete[] packageData;
-        return false;
+    // Extract metadata; optional in format 2
+    if (layout.metadataLength > 0) {
+        File metaFile = SPIFFS.open("/firmware.meta", "w");
+        if (metaFile) {
+            metaFile.write(&packageData[layout.metadataOffset], layout.metadataLength);
+            metaFile.close();
+            Logger::addEntry("Metadata extracted successfully");
+        } else {
+            Logger::addEntry("Failed to write metadata file");
+            delete[] packageData;
+            return false;
+        }
+    } else if (SPIFFS.exists("/firmware.meta")) {
+        SPIFFS.remove("/firmware.meta");
     }
     
-    // Extract metadata
-    String metadataJson = String((char*)&packageData[metadataStart], metadataLength);
-    File metaFile = SPIFFS.open("/firmware.meta", "w");
-    if (metaFile) {
-        metaFile.print(metadataJson);
-        metaFile.close();
-        Logger::addEntry("Metadata extracted successfully");
-    } else {
-        Logger::addEntry("Failed to write metadata file");
+    // A compressed payload is flashed straight from the package; expanding
+    // it into SPIFFS would give back the space it saves
+    if (layout.payloadType == PAYLOAD_HEX_LZSS) {
+        if (SPIFFS.exists("/firmware.hex")) {
+            SPIFFS.remove("/firmware.hex");
+        }
         delete[] packageData;
-        return false;
+        Logger::addEntry("Compressed firmware (" + String(layout.firmwareLength) + " bytes) stays in the package");
+        return true;
     }
     
     // Extract firmware hex
-    size_t firmwareSize = packageSize - firmwareStart;
+    size_t firmwareSize = layout.firmwareLength;
     File hexFile = SPIFFS.open("/firmware.hex", "w");
     if (hexFile) {
-        hexFile.write(&packageData[firmwareStart], firmwareSize);
+        hexFile.write(&packageData[layout.firmwareOffset], firmwareSize);
         hexFile.close();
         Logger::addEntry("Firmware extracted successfully: " + String(firmwareSize) + " bytes");
     } else {
@@ -657,102 +861,31 @@ bool FirmwareUpdater::parseFirmwareMetadata(const String& metadataPath, String&
     String jsonContent = metaFile.readString();
     metaFile.close();
     
-    DynamicJsonDocument doc(2048);
-    DeserializationError error = deserializeJson(doc, jsonContent);
-    
-    if (error) {
-        Logger::addEntry("Failed to parse metadata JSON: " + String(error.c_str()));
+    FirmwareMetadata metadata;
+    if (!FirmwareMetadata::parse(jsonContent.c_str(), jsonContent.length(), metadata)) {
+        Logger::addEntry("Failed to parse metadata JSON: " + String(FirmwareMetadata::getLastError()));
         return false;
     }
     
-    // Extract version info
-    if (doc.containsKey("firmware") && doc["firmware"].containsKey("version")) {
-        version = doc["firmware"]["version"].as<String>();
-    } else {
-        version = "Unknown";
-    }
-    
-    if (doc.containsKey("firmware") && doc["firmware"].containsKey("description")) {
-        description = doc["firmware"]["description"].as<String>();
-    } else {
-        description = "Unknown";
-    }
-    
-    if (doc.containsKey("firmware") && doc["firmware"].containsKey("board")) {
-        board = doc["firmware"]["board"].as<String>();
-    } else {
-        board = "Unknown";
-    }
-    
-    if (doc.containsKey("build_info") && doc["build_info"].containsKey("timestamp")) {
-        String timestamp = doc["build_info"]["timestamp"].as<String>();
-        // Extract date part from ISO timestamp (YYYY-MM-DDTHH:MM:SS...)
-        int dateEnd = timestamp.indexOf('T');
-        if (dateEnd != -1) {
-            buildDate = timestamp.substring(0, dateEnd);
-        } else {
-            buildDate = timestamp;
-        }
-    } else {
-        buildDate = "Unknown";
-    }
-    
+    version = metadata.version;
+    description = metadata.description;
+    buildDate = metadata.buildDate;
+    board = metadata.board;
     return true;
 }
 
 bool FirmwareUpdater::parseFirmwareMetadataFromString(const String& metadataJson, String& version, String& description, String& buildDate, String& board, String& features) {
-    DynamicJsonDocument doc(2048);
-    DeserializationError error = deserializeJson(doc, metadataJson);
-    
-    if (error) {
-        Logger::addEntry("Failed to parse metadata JSON string: " + String(error.c_str()));
+    FirmwareMetadata metadata;
+    if (!FirmwareMetadata::parse(metadataJson.c_str(), metadataJson.length(), metadata)) {
+        Logger::addEntry("Failed to parse metadata JSON string: " + String(FirmwareMetadata::getLastError()));
         return false;
     }
     
-    // Extract version info
-    if (doc.containsKey("firmware") && doc["firmware"].containsKey("version")) {
-        version = doc["firmware"]["version"].as<String>();
-    } else {
-        version = "Unknown";
-    }
-    
-    if (doc.containsKey("firmware") && doc["firmware"].containsKey("description")) {
-        description = doc["firmware"]["description"].as<String>();
-    } else {
-        description = "Unknown";
-    }
-    
-    if (doc.containsKey("firmware") && doc["firmware"].containsKey("board")) {
-        board = doc["firmware"]["board"].as<String>();
-    } else {
-        board = "Unknown";
-    }
-    
-    if (doc.containsKey("build_info") && doc["build_info"].containsKey("timestamp")) {
-        String timestamp = doc["build_info"]["timestamp"].as<String>();
-        // Extract date part from ISO timestamp (YYYY-MM-DDTHH:MM:SS...)
-        int dateEnd = timestamp.indexOf('T');
-        if (dateEnd != -1) {
-            buildDate = timestamp.substring(0, dateEnd);
-        } else {
-            buildDate = timestamp;
-        }
-    } else {
-        buildDate = "Unknown";
-    }
-    
-    // Extract features array
-    features = "";
-    if (doc.containsKey("features") && doc["features"].is<JsonArray>()) {
-        JsonArray featuresArray = doc["features"];
-        for (JsonVariant feature : featuresArray) {
-            if (features.length() > 0) {
-                features += ",";
-            }
-            features += feature.as<String>();
-        }
-    }
-    
+    version = metadata.version;
+    description = metadata.description;
+    buildDate = metadata.buildDate;
+    board = metadata.board;
+    features = metadata.features;
     return true;
 }
 
@@ -776,50 +909,122 @@ String FirmwareUpdater::getFirmwarePackageInfo(const String& filename) {
     info += "Modified: " + String(lastModified) + "\n";
     info += "Type: Firmware Package (.bin)\n";
     
-    // Parse metadata directly from the .bin package
-    if (size >= 10) {
-        File packageFile = SPIFFS.open(filepath, "r");
-        if (packageFile) {
-            // Read the package header to get metadata
-            uint8_t header[10];
-            packageFile.read(header, 10);
-            packageFile.close();
-            
-            // Check magic header "FLFW\0" (5 bytes)
-            const char* expectedMagic = "FLFW\0";
-            if (memcmp(header, expectedMagic, 5) == 0) {
-                // Read metadata length (4 bytes, little-endian)
-                uint32_t metadataLength = header[5] | (header[6] << 8) | 
-                                          (header[7] << 16) | (header[8] << 24);
-                
-                if (metadataLength > 0 && metadataLength <= 2048) {
-                    // Read metadata
-                    packageFile = SPIFFS.open(filepath, "r");
-                    packageFile.seek(9); // Skip magic + length
-                    char* metadataBuffer = new char[metadataLength + 1];
-                    size_t bytesRead = packageFile.readBytes(metadataBuffer, metadataLength);
-                    metadataBuffer[bytesRead] = '\0'; // Null terminate
-                    String metadataJson = String(metadataBuffer);
-                    delete[] metadataBuffer;
-                    packageFile.close();
-                    
-                    // Parse metadata
-                    String version, description, buildDate, board, features;
-                    if (parseFirmwareMetadataFromString(metadataJson, version, description, buildDate, board, features)) {
-                        info += "Version: " + version + "\n";
-                        info += "Description: " + description + "\n";
-                        info += "Build Date: " + buildDate + "\n";
-                        info += "Board: " + board + "\n";
-                        if (features.length() > 0) {
-                            info += "Features: " + features + "\n";
-                        }
-                    }
-                }
+    appendPackageInfo(filepath, size, true, info);
+    
+    return info;
+}
+
+String FirmwareUpdater::packageVersion(const FirmwarePackageLayout& layout) {
+    return String(layout.versionMajor) + "." + String(layout.versionMinor) + "." + String(layout.versionPatch);
+}
+
+String FirmwareUpdater::packageBoard(const FirmwarePackageLayout& layout) {
+    const char* name = FirmwareFormat::boardName(layout.boardId);
+    if (name == nullptr) {
+        return "board" + String(layout.boardId);
+    }
+    return name;
+}
+
+FirmwarePackageStatus FirmwareUpdater::verifyStoredPackage(File& packageFile, const FirmwarePackageLayout& layout) {
+    if (layout.formatVersion != FirmwareFormat::PACKAGE_FORMAT_V2) {
+        return PACKAGE_OK;
+    }
+    
+    // Streamed, so checking a package doesn't need it in RAM
+    uint8_t chunk[256];
+    const size_t offsets[2] = { layout.metadataOffset, layout.firmwareOffset };
+    const size_t lengths[2] = { layout.metadataLength, layout.firmwareLength };
+    const uint32_t expected[2] = { layout.metadataCrc32, layout.firmwareCrc32 };
+    
+    for (int section = 0; section < 2; section++) {
+        if (section == 0 && lengths[section] == 0) {
+            continue;   // No metadata
+        }
+        if (!packageFile.seek(offsets[section])) {
+            return PACKAGE_TRUNCATED;
+        }
+        
+        uint32_t crc = 0;
+        size_t remaining = lengths[section];
+        while (remaining > 0) {
+            size_t count = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+            if (packageFile.read(chunk, count) != count) {
+                return PACKAGE_TRUNCATED;
             }
+            crc = Crc32::update(crc, chunk, count);
+            remaining -= count;
+        }
+        if (crc != expected[section]) {
+            return PACKAGE_BAD_CHECKSUM;
         }
     }
+    return PACKAGE_OK;
+}
+
+bool FirmwareUpdater::readPackageMetadata(File& packageFile, const FirmwarePackageLayout& layout, FirmwareMetadata& metadata) {
+    if (layout.metadataLength == 0 || !packageFile.seek(layout.metadataOffset)) {
+        return false;
+    }
     
-    return info;
+    char* metadataBuffer = new (std::nothrow) char[layout.metadataLength];
+    if (metadataBuffer == nullptr) {
+        return false;
+    }
+    size_t bytesRead = packageFile.readBytes(metadataBuffer, layout.metadataLength);
+    bool parsed = bytesRead == layout.metadataLength &&
+                  FirmwareMetadata::parse(metadataBuffer, bytesRead, metadata);
+    delete[] metadataBuffer;
+    return parsed;
+}
+
+void FirmwareUpdater::appendPackageInfo(const String& filepath, size_t size, bool withDetails, String& info) {
+    File packageFile = SPIFFS.open(filepath, "r");
+    if (!packageFile) {
+        return;
+    }
+    
+    uint8_t header[FirmwareFormat::PACKAGE_MAX_HEADER_SIZE];
+    size_t headerLength = packageFile.read(header, sizeof(header));
+    FirmwarePackageLayout layout;
+    FirmwarePackageStatus status = FirmwareFormat::parsePackageHeader(header, headerLength, size, layout);
+    if (status != PACKAGE_OK) {
+        packageFile.close();
+        info += "Status: " + String(FirmwareFormat::packageStatusToString(status)) + "\n";
+        return;
+    }
+    
+    // Format 1 keeps everything in the JSON; format 2 needs it only for the details
+    FirmwareMetadata metadata;
+    bool hasMetadata = false;
+    if (layout.formatVersion != FirmwareFormat::PACKAGE_FORMAT_V2 || withDetails) {
+        hasMetadata = readPackageMetadata(packageFile, layout, metadata);
+    }
+    
+    if (layout.formatVersion == FirmwareFormat::PACKAGE_FORMAT_V2) {
+        char buildDate[11];
+        FirmwareFormat::formatBuildDate(layout.buildTime, buildDate, sizeof(buildDate));
+        
+        info += "Format: 2\n";
+        info += "Version: " + packageVersion(layout) + "\n";
+        if (hasMetadata) {
+            info += "Description: " + String(metadata.description) + "\n";
+        }
+        info += "Build Date: " + String(buildDate) + "\n";
+        info += "Board: " + packageBoard(layout) + "\n";
+        
+        status = verifyStoredPackage(packageFile, layout);
+        info += "Checksum: " + String(status == PACKAGE_OK ? "OK" : FirmwareFormat::packageStatusToString(status)) + "\n";
+    } else if (hasMetadata) {
+        info += "Version: " + String(metadata.version) + "\n";
+        info += "Description: " + String(metadata.description) + "\n";
+        info += "Build Date: " + String(metadata.buildDate) + "\n";
+        info += "Board: " + String(metadata.board) + "\n";
+    }
+    if (hasMetadata && metadata.features[0] != '\0') {
+        info += "Features: " + String(metadata.features) + "\n";
+    }
+    packageFile.close();
 }
 
 bool FirmwareUpdater::deleteFirmwarePackage(const String& filename) {
@@ -940,51 +1145,8 @@ String FirmwareUpdater::getAllFirmwareInfo() {
             info += "Size: " + String(size) + " bytes\n";
             info += "Modified: " + String(lastModified) + "\n";
             
-            // Try to get metadata info by parsing the .bin package directly
-            String filepath = getFirmwarePath(filename);
-            File packageFile = SPIFFS.open(filepath, "r");
-            if (packageFile) {
-                // Read the package header to get metadata
-                if (packageFile.size() >= 10) {
-                    uint8_t header[10];
-                    packageFile.read(header, 10);
-                    packageFile.close();
-                    
-                    // Check magic header "FLFW\0" (5 bytes)
-                    const char* expectedMagic = "FLFW\0";
-                    if (memcmp(header, expectedMagic, 5) == 0) {
-                        // Read metadata length (4 bytes, little-endian)
-                        uint32_t metadataLength = header[5] | (header[6] << 8) | 
-                                                  (header[7] << 16) | (header[8] << 24);
-                        
-                        if (metadataLength > 0 && metadataLength <= 2048) {
-                            // Read metadata
-                            packageFile = SPIFFS.open(filepath, "r");
-                            packageFile.seek(9); // Skip magic + length
-                            char* metadataBuffer = new char[metadataLength + 1];
-                            size_t bytesRead = packageFile.readBytes(metadataBuffer, metadataLength);
-                            metadataBuffer[bytesRead] = '\0'; // Null terminate
-                            String metadataJson = String(metadataBuffer);
-                            delete[] metadataBuffer;
-                            packageFile.close();
-                            
-                            // Parse metadata
-                            String version, description, buildDate, board, features;
-                            if (parseFirmwareMetadataFromString(metadataJson, version, description, buildDate, board, features)) {
-                                info += "Version: " + version + "\n";
-                                info += "Description: " + description + "\n";
-                                info += "Build Date: " + buildDate + "\n";
-                                info += "Board: " + board + "\n";
-                                if (features.length() > 0) {
-                                    info += "Features: " + features + "\n";
-                                }
-                            }
-                        }
-                    }
-                } else {
-                    packageFile.close();
-                }
-            }
+            // Format 2 packages list from their header alone, without the JSON
+            appendPackageInfo(getFirmwarePath(filename), size, false, info);
             
             foundFiles = true;
         }
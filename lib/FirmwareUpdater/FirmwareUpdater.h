@@ -4,6 +4,10 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <SPIFFS.h>
+#include "I2CBus.h"
+#include "FirmwareFormat.h"
+#include "FirmwareMetadata.h"
+#include "FlashPages.h"
 
 class FirmwareUpdater {
 public:
@@ -11,6 +15,10 @@ public:
     static bool uploadFirmwareToSPIFFS(const uint8_t* firmwareData, size_t firmwareSize, const String& filename);
     static bool updateATtinyFirmware();
     static bool updateATtinyFirmwareFromSPIFFS(const String& filename = "attiny_firmware.hex");
+    // Flashes the firmware inside a stored package, compressed or not
+    static bool updateATtinyFirmwareFromPackage(const String& filename);
+    // Drops the stored page hashes of the ATtiny's image, so the next update rewrites every page
+    static void forgetFlashedImage();
     static bool checkATtinyVersion();
     static String getStoredFirmwareInfo(const String& filename = "attiny_firmware.hex");
     static bool deleteStoredFirmware(const String& filename = "attiny_firmware.hex");
@@ -35,10 +43,28 @@ public:
 
 private:
     static const int ATTINY_ADDRESS = 0x50;
+    static const size_t MAX_LINE_LENGTH = 127;  // Length byte + line must fit the 128 byte Wire buffer
     static const char* FIRMWARE_DIR;
+    static const char* FLASHED_PAGES_FILE;
     
-    static bool sendFirmwareLine(const String& line);
+    static bool sendFirmwareLine(const char* line, size_t length);
     static bool verifyFirmwareChecksum(const String& line);
+    // Every record has to decode before the ATtiny is put into update mode;
+    // pages, if given, gets the page hashes of the image on the way
+    static bool checkPayload(File& file, const FirmwarePackageLayout& layout, FlashPages* pages);
+    // Skipped when the ATtiny already has the image, only the changed pages
+    // when its image is known, every line otherwise; verified by CRC after
+    static bool updateFromPayload(File& file, const FirmwarePackageLayout& layout, const String& name);
+    static bool beginUpdate(File& file, const FirmwarePackageLayout& layout, uint8_t command);
+    static void endUpdate();
+    static bool flashPayload(File& file, const FirmwarePackageLayout& layout, const String& name);
+    static bool flashChangedPages(File& file, const FirmwarePackageLayout& layout, const String& name,
+                                  FlashPages& image, const FlashPages& flashed);
+    static void sendChangedPage(void* context, uint16_t page, const uint8_t* data, uint32_t hash);
+    // CRC32 of the first pageCount pages the ATtiny has; false if it can't tell
+    static bool readATtinyCrc(uint16_t pageCount, uint32_t& crc);
+    static bool loadFlashedPages(FlashPages& pages);
+    static bool saveFlashedPages(const FlashPages& pages);
     static void createFirmwareDirectory();
     static String getFirmwarePath(const String& filename);
     static int countHexLines(const String& filepath);
@@ -46,6 +72,13 @@ private:
     static String parseHexLine(const String& hexLine);
     static bool isValidHexLine(const String& hexLine);
     static bool isValidDateFormat(const String& dateStr, char separator);
+    
+    // Package headers and stored packages, either format
+    static String packageVersion(const FirmwarePackageLayout& layout);
+    static String packageBoard(const FirmwarePackageLayout& layout);
+    static FirmwarePackageStatus verifyStoredPackage(File& packageFile, const FirmwarePackageLayout& layout);
+    static bool readPackageMetadata(File& packageFile, const FirmwarePackageLayout& layout, FirmwareMetadata& metadata);
+    static void appendPackageInfo(const String& filepath, size_t size, bool withDetails, String& info);
 };
 
 #endif
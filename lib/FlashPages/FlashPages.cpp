@@ -0,0 +1,174 @@
+#include "FlashPages.h"
+#include "Crc32.h"
+#include <string.h>
+
+static void putLE16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+}
+
+static void putLE32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+static uint16_t getLE16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t getLE32(const uint8_t* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+FlashPages::FlashPages() {
+    reset();
+}
+
+void FlashPages::reset(PageFunction onPage, void* context) {
+    this->onPage = onPage;
+    this->context = context;
+    
+    memset(page, 0xFF, sizeof(page));
+    uint32_t erasedHash = Crc32::compute(page, sizeof(page));
+    for (size_t i = 0; i < MAX_PAGES; i++) {
+        hashes[i] = erasedHash;
+    }
+    
+    currentPage = -1;
+    nextPage = 0;
+    nextAddress = 0;
+    baseAddress = 0;
+    pageCount = 0;
+    runningCrc = 0;
+    imageCrc = 0;
+    finished = false;
+    error = false;
+}
+
+bool FlashPages::addRecord(const HexRecord& record) {
+    if (error || finished) {
+        return false;
+    }
+    
+    switch (record.type) {
+        case HEX_RECORD_DATA:
+            break;
+        case HEX_RECORD_EXTENDED_SEGMENT:
+        case HEX_RECORD_EXTENDED_LINEAR:
+            if (record.length != 2) {
+                error = true;
+                return false;
+            }
+            baseAddress = (record.data[0] << 8) | record.data[1];
+            baseAddress <<= record.type == HEX_RECORD_EXTENDED_SEGMENT ? 4 : 16;
+            return true;
+        default:
+            // End of file and start addresses don't put anything in flash
+            return true;
+    }
+    
+    uint32_t address = baseAddress + record.address;
+    if (address < nextAddress || address + record.length > MAX_PAGES * PAGE_SIZE) {
+        error = true;
+        return false;
+    }
+    
+    for (size_t i = 0; i < record.length; i++, address++) {
+        int32_t index = address / PAGE_SIZE;
+        if (index != currentPage) {
+            flushPage();
+            // Pages the image skips over are erased
+            while (nextPage < index) {
+                emitPage(nextPage, false);
+            }
+            currentPage = index;
+        }
+        page[address % PAGE_SIZE] = record.data[i];
+    }
+    
+    if (record.length > 0) {
+        nextAddress = address;
+        pageCount = currentPage + 1;
+    }
+    return true;
+}
+
+bool FlashPages::finish() {
+    if (error || finished) {
+        return !error;
+    }
+    
+    flushPage();
+    while (nextPage < MAX_PAGES) {
+        emitPage(nextPage, false);
+    }
+    finished = true;
+    return true;
+}
+
+void FlashPages::flushPage() {
+    if (currentPage < 0) {
+        return;
+    }
+    emitPage(currentPage, true);
+    currentPage = -1;
+}
+
+void FlashPages::emitPage(uint16_t index, bool hasData) {
+    // page holds the page being filled, or is erased between pages
+    hashes[index] = Crc32::compute(page, sizeof(page));
+    runningCrc = Crc32::update(runningCrc, page, sizeof(page));
+    if (hasData) {
+        imageCrc = runningCrc;
+    }
+    nextPage = index + 1;
+    if (onPage != nullptr) {
+        onPage(context, index, page, hashes[index]);
+    }
+    memset(page, 0xFF, sizeof(page));
+}
+
+uint16_t FlashPages::countChanged(const FlashPages& other) const {
+    uint16_t changed = 0;
+    for (size_t i = 0; i < MAX_PAGES; i++) {
+        if (hashes[i] != other.hashes[i]) {
+            changed++;
+        }
+    }
+    return changed;
+}
+
+size_t FlashPages::serialize(uint8_t* buffer, size_t capacity) const {
+    if (capacity < SERIALIZED_SIZE) {
+        return 0;
+    }
+    
+    for (size_t i = 0; i < MAX_PAGES; i++) {
+        putLE32(buffer + HEADER_SIZE + i * 4, hashes[i]);
+    }
+    putLE32(buffer, MAGIC);
+    putLE16(buffer + 4, FORMAT_VERSION);
+    putLE16(buffer + 6, pageCount);
+    putLE32(buffer + 8, imageCrc);
+    putLE32(buffer + 12, Crc32::compute(buffer + HEADER_SIZE, MAX_PAGES * 4));
+    return SERIALIZED_SIZE;
+}
+
+bool FlashPages::deserialize(const uint8_t* data, size_t length) {
+    reset();
+    
+    if (length != SERIALIZED_SIZE || getLE32(data) != MAGIC || getLE16(data + 4) != FORMAT_VERSION ||
+        getLE16(data + 6) > MAX_PAGES || Crc32::compute(data + HEADER_SIZE, MAX_PAGES * 4) != getLE32(data + 12)) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < MAX_PAGES; i++) {
+        hashes[i] = getLE32(data + HEADER_SIZE + i * 4);
+    }
+    pageCount = getLE16(data + 6);
+    imageCrc = getLE32(data + 8);
+    finished = true;
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef FLASHPAGES_H
+#define FLASHPAGES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FirmwareFormat.h"
+
+// The ATtiny image as 64-byte flash pages, built from HEX records as they
+// stream past. Every page of the application region is handed out in
+// order, bytes the image doesn't set read as erased (0xFF), and each gets
+// a CRC32 so two images can be compared page by page without keeping
+// either. Records have to come in ascending address order, which is how
+// avr-objcopy writes them; anything else fails and the caller falls back
+// to a full update.
+//
+// The image CRC is a CRC32 of pages 0 to getPageCount() - 1 in one run,
+// what the ATtiny reports for its application region. The hashes and CRC
+// of the image on the ATtiny are stored as:
+//
+//   [magic "FLPG"][format u16][page count u16][image crc32 u32][hashes crc32 u32]
+//   [page hash u32] x MAX_PAGES
+//
+// all little-endian.
+class FlashPages {
+public:
+    static const size_t PAGE_SIZE = 64;
+    static const size_t MAX_PAGES = 256;    // ATtiny1616: 16 KB
+    static const size_t RECORDS_PER_PAGE = 4;
+    static const size_t RECORD_SIZE = PAGE_SIZE / RECORDS_PER_PAGE;
+    
+    static const uint32_t MAGIC = 0x47504C46; // "FLPG" on disk
+    static const uint16_t FORMAT_VERSION = 1;
+    static const size_t HEADER_SIZE = 16;
+    static const size_t SERIALIZED_SIZE = HEADER_SIZE + MAX_PAGES * 4;
+    
+    // Called once per page, 0 to MAX_PAGES - 1, as soon as it is complete
+    typedef void (*PageFunction)(void* context, uint16_t page, const uint8_t* data, uint32_t hash);
+    
+    FlashPages();
+    void reset(PageFunction onPage = nullptr, void* context = nullptr);
+    
+    // False once a record is out of order, outside the region or malformed
+    bool addRecord(const HexRecord& record);
+    // Hands out the last page and the erased ones after it
+    bool finish();
+    bool failed() const { return error; }
+    
+    // Pages up to and including the last one the image sets
+    uint16_t getPageCount() const { return pageCount; }
+    uint32_t getPageHash(uint16_t page) const { return hashes[page]; }
+    // Complete once finish() has run
+    uint32_t getImageCrc() const { return imageCrc; }
+    // Pages whose hash differs from the same page of another image
+    uint16_t countChanged(const FlashPages& other) const;
+    
+    // Returns the image size, or 0 if it doesn't fit
+    size_t serialize(uint8_t* buffer, size_t capacity) const;
+    // Leaves the pages reset if the image is damaged or from another format
+    bool deserialize(const uint8_t* data, size_t length);
+
+private:
+    void flushPage();
+    void emitPage(uint16_t index, bool hasData);
+    
+    uint32_t hashes[MAX_PAGES];
+    uint8_t page[PAGE_SIZE];
+    int32_t currentPage;        // -1 while no page is being filled
+    uint16_t nextPage;          // First page not handed out yet
+    uint32_t nextAddress;
+    uint32_t baseAddress;       // From extended address records
+    uint16_t pageCount;
+    uint32_t runningCrc;        // Every page handed out so far
+    uint32_t imageCrc;          // Up to the last page the image sets
+    PageFunction onPage;
+    void* context;
+    bool finished;
+    bool error;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "FrameDiff.h"
+
+int FrameDiff::diff(const uint8_t* frame, const uint8_t* shadow, int width, int pages,
+                    FrameSpan* spans, int maxSpans) {
+    int count = 0;
+    
+    for (int page = 0; page < pages; page++) {
+        const uint8_t* row = frame + page * width;
+        const uint8_t* shadowRow = shadow + page * width;
+        int first = -1;
+        int last = -1;
+        
+        for (int column = 0; column <= width; column++) {
+            bool changed = column < width && row[column] != shadowRow[column];
+            
+            // Close the open span at the end of the page or when the gap
+            // to the next change is too wide to bridge
+            if (first >= 0 && (column == width || (changed && (size_t)(column - last - 1) > SPAN_OVERHEAD))) {
+                if (count >= maxSpans) {
+                    return -1;
+                }
+                spans[count].page = page;
+                spans[count].firstColumn = first;
+                spans[count].lastColumn = last;
+                count++;
+                first = -1;
+            }
+            
+            if (changed) {
+                if (first < 0) {
+                    first = column;
+                }
+                last = column;
+            }
+        }
+    }
+    
+    return count;
+}
+
+size_t FrameDiff::transferSize(const FrameSpan* spans, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += SPAN_OVERHEAD + spans[i].lastColumn - spans[i].firstColumn + 1;
+    }
+    return total;
+}
+
+size_t FrameDiff::fullTransferSize(int width, int pages) {
+    return SPAN_OVERHEAD + (size_t)width * pages;
+}
@@ -0,0 +1,35 @@
+#ifndef FRAMEDIFF_H
+#define FRAMEDIFF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// A run of changed columns within one display page
+struct FrameSpan {
+    uint8_t page;
+    uint8_t firstColumn;
+    uint8_t lastColumn;
+};
+
+// Compares a framebuffer against the copy last sent to the panel. Both use
+// the SSD1306 layout: page-major, one byte per column holding 8 vertical
+// pixels. Changes closer together than SPAN_OVERHEAD columns are merged,
+// since re-addressing would cost more than sending the unchanged bytes.
+// No Arduino dependency.
+class FrameDiff {
+public:
+    static const int MAX_SPANS = 32;
+    // Column/page address commands plus the data control byte
+    static const size_t SPAN_OVERHEAD = 8;
+    
+    // Returns the span count, 0 if nothing changed, -1 if more than
+    // maxSpans are needed (send the whole frame instead)
+    static int diff(const uint8_t* frame, const uint8_t* shadow, int width, int pages,
+                    FrameSpan* spans, int maxSpans);
+    
+    // Bytes on the wire to send the spans, excluding I2C addressing
+    static size_t transferSize(const FrameSpan* spans, int count);
+    static size_t fullTransferSize(int width, int pages);
+};
+
+#endif
@@ -0,0 +1,25 @@
+#include "HeapReport.h"
+#include "HeapTracker.h"
+
+String HeapReport::toJson(uint32_t freeHeap, uint32_t largestBlock, uint32_t minFreeHeap) {
+    String json = "{\"freeHeap\":" + String((unsigned long)freeHeap);
+    json += ",\"largestBlock\":" + String((unsigned long)largestBlock);
+    json += ",\"minFreeHeap\":" + String((unsigned long)minFreeHeap);
+    json += ",\"fragmentation\":" + String(HeapTracker::fragmentation(freeHeap, largestBlock), 1);
+    json += ",\"hooked\":" + String(HeapTracker::isHooked() ? "true" : "false");
+    json += ",\"allocations\":" + String((unsigned long)HeapTracker::getAllocations());
+    json += ",\"frees\":" + String((unsigned long)HeapTracker::getFrees());
+    json += ",\"largestFailure\":" + String((unsigned long)HeapTracker::getLargestFailure());
+    json += ",\"modules\":[";
+    for (int m = 0; m < HEAP_MODULE_COUNT; m++) {
+        const HeapTracker::Counters& counters = HeapTracker::getCounters((HeapModule)m);
+        if (m > 0) json += ",";
+        json += "{\"name\":\"" + String(HeapTracker::moduleName((HeapModule)m)) + "\"";
+        json += ",\"allocations\":" + String((unsigned long)counters.allocations);
+        json += ",\"frees\":" + String((unsigned long)counters.frees);
+        json += ",\"failures\":" + String((unsigned long)counters.failures);
+        json += ",\"kilobytes\":" + String((unsigned long)(counters.bytesAllocated / 1024)) + "}";
+    }
+    json += "]}";
+    return json;
+}
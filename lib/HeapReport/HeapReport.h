@@ -0,0 +1,13 @@
+#ifndef HEAPREPORT_H
+#define HEAPREPORT_H
+
+#include <Arduino.h>
+
+// The /api/heap response. The readings are taken by the caller, before
+// building the report allocates.
+class HeapReport {
+public:
+    static String toJson(uint32_t freeHeap, uint32_t largestBlock, uint32_t minFreeHeap);
+};
+
+#endif
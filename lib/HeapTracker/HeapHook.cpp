@@ -0,0 +1,127 @@
+#include "HeapTracker.h"
+
+#ifdef HEAP_TRACKER_HOOK
+
+#include <stdlib.h>
+
+#if defined(ESP_PLATFORM)
+
+// Device: the firmware links with -Wl,--wrap=malloc,--wrap=calloc,
+// --wrap=realloc,--wrap=free (see platformio.ini), so every call into the
+// allocator from the core, String and the libraries lands here first.
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+void* __wrap_malloc(size_t size) {
+    void* ptr = __real_malloc(size);
+    if (ptr != nullptr) {
+        HeapTracker::recordAlloc(size);
+    } else if (size > 0) {
+        HeapTracker::recordFailure(size);
+    }
+    return ptr;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    void* ptr = __real_calloc(count, size);
+    if (ptr != nullptr) {
+        HeapTracker::recordAlloc(count * size);
+    } else if (count * size > 0) {
+        HeapTracker::recordFailure(count * size);
+    }
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    void* resized = __real_realloc(ptr, size);
+    if (size == 0) {
+        // realloc(ptr, 0) frees
+        if (ptr != nullptr) {
+            HeapTracker::recordFree();
+        }
+        return resized;
+    }
+    
+    if (resized == nullptr) {
+        HeapTracker::recordFailure(size);
+        return resized;
+    }
+    
+    // Growing a String is the churn worth counting: a new block replacing the old one
+    HeapTracker::recordAlloc(size);
+    if (ptr != nullptr) {
+        HeapTracker::recordFree();
+    }
+    return resized;
+}
+
+void __wrap_free(void* ptr) {
+    if (ptr != nullptr) {
+        HeapTracker::recordFree();
+    }
+    __real_free(ptr);
+}
+}
+
+#else
+
+// Native tests: the mocked String is a std::string, so replacing the global
+// operator new/delete sees its allocations without linker tricks that the
+// host toolchain may not support
+
+#include <new>
+
+void* operator new(size_t size) {
+    void* ptr = malloc(size > 0 ? size : 1);
+    if (ptr == nullptr) {
+        HeapTracker::recordFailure(size);
+        throw std::bad_alloc();
+    }
+    HeapTracker::recordAlloc(size);
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    void* ptr = malloc(size > 0 ? size : 1);
+    if (ptr == nullptr) {
+        HeapTracker::recordFailure(size);
+        return nullptr;
+    }
+    HeapTracker::recordAlloc(size);
+    return ptr;
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr != nullptr) {
+        HeapTracker::recordFree();
+        free(ptr);
+    }
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    operator delete(ptr);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,113 @@
+#include "HeapTracker.h"
+#include <string.h>
+
+HeapTracker::Counters HeapTracker::counters[HEAP_MODULE_COUNT];
+HeapModule HeapTracker::currentModule = HEAP_MODULE_OTHER;
+const void* HeapTracker::currentThread = nullptr;
+HeapThreadId HeapTracker::threadId = nullptr;
+size_t HeapTracker::largestFailure = 0;
+
+static const char* const MODULE_NAMES[HEAP_MODULE_COUNT] = {
+    "other", "logger", "web", "mqtt", "firmware", "display", "i2c", "config", "wifi", "telemetry"
+};
+
+void HeapTracker::setThreadId(HeapThreadId threadId) {
+    HeapTracker::threadId = threadId;
+}
+
+HeapTracker::Scope HeapTracker::enter(HeapModule module) {
+    Scope previous;
+    previous.module = currentModule;
+    previous.thread = currentThread;
+    
+    currentModule = module;
+    currentThread = threadId != nullptr ? threadId() : nullptr;
+    return previous;
+}
+
+void HeapTracker::leave(const Scope& previous) {
+    currentModule = previous.module;
+    currentThread = previous.thread;
+}
+
+HeapModule HeapTracker::getCurrentModule() {
+    return currentModule;
+}
+
+HeapModule HeapTracker::attribute() {
+    if (currentModule != HEAP_MODULE_OTHER && threadId != nullptr && threadId() != currentThread) {
+        return HEAP_MODULE_OTHER;
+    }
+    return currentModule;
+}
+
+void HeapTracker::recordAlloc(size_t size) {
+    Counters& counter = counters[attribute()];
+    counter.allocations++;
+    counter.bytesAllocated += size;
+}
+
+void HeapTracker::recordFree() {
+    counters[attribute()].frees++;
+}
+
+void HeapTracker::recordFailure(size_t size) {
+    counters[attribute()].failures++;
+    if (size > largestFailure) {
+        largestFailure = size;
+    }
+}
+
+const HeapTracker::Counters& HeapTracker::getCounters(HeapModule module) {
+    return counters[module < HEAP_MODULE_COUNT ? module : HEAP_MODULE_OTHER];
+}
+
+uint32_t HeapTracker::getAllocations() {
+    uint32_t total = 0;
+    for (int i = 0; i < HEAP_MODULE_COUNT; i++) {
+        total += counters[i].allocations;
+    }
+    return total;
+}
+
+uint32_t HeapTracker::getFrees() {
+    uint32_t total = 0;
+    for (int i = 0; i < HEAP_MODULE_COUNT; i++) {
+        total += counters[i].frees;
+    }
+    return total;
+}
+
+uint32_t HeapTracker::getLiveAllocations() {
+    // Blocks freed by a module other than the one that allocated them still
+    // balance out in the totals
+    return getAllocations() - getFrees();
+}
+
+size_t HeapTracker::getLargestFailure() {
+    return largestFailure;
+}
+
+void HeapTracker::reset() {
+    memset(counters, 0, sizeof(counters));
+    largestFailure = 0;
+}
+
+bool HeapTracker::isHooked() {
+#ifdef HEAP_TRACKER_HOOK
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* HeapTracker::moduleName(HeapModule module) {
+    return module < HEAP_MODULE_COUNT ? MODULE_NAMES[module] : "unknown";
+}
+
+float HeapTracker::fragmentation(uint32_t freeBytes, uint32_t largestBlock) {
+    if (freeBytes == 0 || largestBlock >= freeBytes) {
+        return 0;
+    }
+    return (freeBytes - largestBlock) * 100.0f / freeBytes;
+}
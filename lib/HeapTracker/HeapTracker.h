@@ -0,0 +1,94 @@
+#ifndef HEAPTRACKER_H
+#define HEAPTRACKER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Who allocates. Code marks itself with a HeapScope; anything outside a
+// scope, or on another task, counts as HEAP_MODULE_OTHER.
+enum HeapModule : uint8_t {
+    HEAP_MODULE_OTHER = 0,
+    HEAP_MODULE_LOGGER,
+    HEAP_MODULE_WEB,
+    HEAP_MODULE_MQTT,
+    HEAP_MODULE_FIRMWARE,
+    HEAP_MODULE_DISPLAY,
+    HEAP_MODULE_I2C,
+    HEAP_MODULE_CONFIG,
+    HEAP_MODULE_WIFI,
+    HEAP_MODULE_TELEMETRY,
+    HEAP_MODULE_COUNT
+};
+
+typedef const void* (*HeapThreadId)();
+
+// Allocation accounting. The counters are fed by the allocator hook in
+// HeapHook.cpp, built when HEAP_TRACKER_HOOK is defined: a linker wrap of
+// malloc and friends on the device, operator new/delete in the native
+// tests. Without the hook every count stays at zero. Recording never
+// allocates and takes no lock, so counts from concurrent tasks are
+// approximate.
+class HeapTracker {
+public:
+    struct Counters {
+        uint32_t allocations;
+        uint32_t frees;
+        uint32_t failures;
+        uint64_t bytesAllocated;
+    };
+    
+    struct Scope {
+        HeapModule module;
+        const void* thread;
+    };
+    
+    // Scopes only count on the thread that opened them; without a thread
+    // id function (native tests) there is a single thread
+    static void setThreadId(HeapThreadId threadId);
+    
+    static Scope enter(HeapModule module);
+    static void leave(const Scope& previous);
+    static HeapModule getCurrentModule();
+    
+    // Called from the allocator hook
+    static void recordAlloc(size_t size);
+    static void recordFree();
+    static void recordFailure(size_t size);
+    
+    static const Counters& getCounters(HeapModule module);
+    static uint32_t getAllocations();   // All modules
+    static uint32_t getFrees();
+    static uint32_t getLiveAllocations();
+    static size_t getLargestFailure();
+    static void reset();
+    
+    static bool isHooked();
+    static const char* moduleName(HeapModule module);
+    
+    // Share of free heap that can't be handed out in one piece, 0-100 %
+    static float fragmentation(uint32_t freeBytes, uint32_t largestBlock);
+
+private:
+    static Counters counters[HEAP_MODULE_COUNT];
+    static HeapModule currentModule;
+    static const void* currentThread;
+    static HeapThreadId threadId;
+    static size_t largestFailure;
+    
+    static HeapModule attribute();
+};
+
+// Attributes allocations to a module until it goes out of scope; nests
+class HeapScope {
+public:
+    explicit HeapScope(HeapModule module) : previous(HeapTracker::enter(module)) {}
+    ~HeapScope() { HeapTracker::leave(previous); }
+
+private:
+    HeapTracker::Scope previous;
+    
+    HeapScope(const HeapScope&);
+    HeapScope& operator=(const HeapScope&);
+};
+
+#endif
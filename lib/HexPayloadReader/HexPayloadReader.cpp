@@ -0,0 +1,183 @@
+#include "HexPayloadReader.h"
+#include <string.h>
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+HexPayloadReader::HexPayloadReader(uint8_t payloadType, uint32_t payloadLength, uint32_t decodedLength,
+                                   PayloadReadFunction read, void* context)
+    : payloadType(payloadType), inputRemaining(payloadLength), decodedRemaining(decodedLength),
+      read(read), context(context), status(HEX_PAYLOAD_OK), lineNumber(0),
+      inputPosition(0), inputCount(0), decodedPosition(0), decodedCount(0) {
+    if (payloadType != PAYLOAD_INTEL_HEX && payloadType != PAYLOAD_HEX_LZSS) {
+        status = HEX_PAYLOAD_UNSUPPORTED;
+    }
+}
+
+bool HexPayloadReader::nextLine(char* line, size_t capacity, size_t& length) {
+    length = 0;
+    if (status != HEX_PAYLOAD_OK) {
+        return false;
+    }
+    if (capacity < FirmwareFormat::MIN_HEX_LINE + 1) {
+        status = HEX_PAYLOAD_LINE_TOO_LONG;
+        return false;
+    }
+    
+    if (payloadType == PAYLOAD_HEX_LZSS) {
+        return nextPackedLine(line, capacity, length);
+    }
+    return nextTextLine(line, capacity, length);
+}
+
+bool HexPayloadReader::fillInput() {
+    if (inputPosition < inputCount) {
+        return true;
+    }
+    if (inputRemaining == 0) {
+        return false;
+    }
+    
+    size_t wanted = inputRemaining < INPUT_CHUNK ? inputRemaining : INPUT_CHUNK;
+    size_t count = read(context, input, wanted);
+    if (count == 0 || count > wanted) {
+        inputRemaining = 0;
+        return false;
+    }
+    inputRemaining -= count;
+    inputPosition = 0;
+    inputCount = count;
+    return true;
+}
+
+bool HexPayloadReader::nextInputByte(uint8_t& value) {
+    if (!fillInput()) {
+        return false;
+    }
+    value = input[inputPosition++];
+    return true;
+}
+
+bool HexPayloadReader::nextDecodedByte(uint8_t& value) {
+    while (decodedPosition == decodedCount) {
+        if (decodedRemaining == 0 || decoder.failed()) {
+            return false;
+        }
+        
+        // Hand the decoder whatever input is buffered, refilling once it's used up.
+        // With none left it can still hold tokens or a copy from the last call.
+        const uint8_t* in = nullptr;
+        size_t available = 0;
+        if (fillInput()) {
+            in = input + inputPosition;
+            available = inputCount - inputPosition;
+        }
+        
+        size_t wanted = decodedRemaining < DECODE_CHUNK ? decodedRemaining : DECODE_CHUNK;
+        size_t consumed = 0;
+        decodedCount = decoder.decode(in, available, consumed, decoded, wanted);
+        decodedPosition = 0;
+        inputPosition += consumed;
+        decodedRemaining -= decodedCount;
+        
+        if (decodedCount == 0 && available == 0) {
+            return false;
+        }
+    }
+    
+    value = decoded[decodedPosition++];
+    return true;
+}
+
+bool HexPayloadReader::nextTextLine(char* line, size_t capacity, size_t& length) {
+    while (true) {
+        size_t count = 0;
+        bool sawByte = false;
+        bool overflow = false;
+        uint8_t value;
+        
+        while (nextInputByte(value)) {
+            sawByte = true;
+            if (value == '\n') {
+                break;
+            }
+            if (count < capacity - 1) {
+                line[count++] = value;
+            } else {
+                overflow = true;
+            }
+        }
+        
+        if (!sawByte) {
+            status = HEX_PAYLOAD_END;
+            return false;
+        }
+        lineNumber++;
+        if (overflow) {
+            status = HEX_PAYLOAD_LINE_TOO_LONG;
+            return false;
+        }
+        
+        size_t start = 0;
+        while (start < count && isBlank(line[start])) {
+            start++;
+        }
+        while (count > start && isBlank(line[count - 1])) {
+            count--;
+        }
+        if (count == start || line[start] != ':') {
+            continue;
+        }
+        
+        length = count - start;
+        memmove(line, line + start, length);
+        line[length] = '\0';
+        return true;
+    }
+}
+
+bool HexPayloadReader::nextPackedLine(char* line, size_t capacity, size_t& length) {
+    uint8_t header[FirmwareFormat::PACKED_RECORD_HEADER];
+    for (size_t i = 0; i < sizeof(header); i++) {
+        if (!nextDecodedByte(header[i])) {
+            // Only a clean end between records, with every decoded byte accounted for
+            bool finished = i == 0 && decodedRemaining == 0 && !decoder.failed();
+            status = finished ? HEX_PAYLOAD_END : HEX_PAYLOAD_CORRUPT;
+            return false;
+        }
+    }
+    
+    record.length = header[0];
+    record.address = (header[1] << 8) | header[2];
+    record.type = header[3];
+    if (record.type > HEX_RECORD_START_LINEAR) {
+        status = HEX_PAYLOAD_CORRUPT;
+        return false;
+    }
+    for (size_t i = 0; i < record.length; i++) {
+        if (!nextDecodedByte(record.data[i])) {
+            status = HEX_PAYLOAD_CORRUPT;
+            return false;
+        }
+    }
+    lineNumber++;
+    
+    length = FirmwareFormat::formatRecord(record, line, capacity);
+    if (length == 0) {
+        status = HEX_PAYLOAD_LINE_TOO_LONG;
+        return false;
+    }
+    return true;
+}
+
+const char* HexPayloadReader::statusToString(HexPayloadStatus status) {
+    switch (status) {
+        case HEX_PAYLOAD_OK: return "OK";
+        case HEX_PAYLOAD_END: return "End of payload";
+        case HEX_PAYLOAD_LINE_TOO_LONG: return "HEX line too long";
+        case HEX_PAYLOAD_CORRUPT: return "Compressed payload is corrupt";
+        case HEX_PAYLOAD_UNSUPPORTED: return "Unsupported payload type";
+        default: return "Unknown";
+    }
+}
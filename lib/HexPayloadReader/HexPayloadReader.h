@@ -0,0 +1,69 @@
+#ifndef HEXPAYLOADREADER_H
+#define HEXPAYLOADREADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FirmwareFormat.h"
+#include "LzssDecoder.h"
+
+enum HexPayloadStatus : uint8_t {
+    HEX_PAYLOAD_OK = 0,
+    HEX_PAYLOAD_END,
+    HEX_PAYLOAD_LINE_TOO_LONG,
+    HEX_PAYLOAD_CORRUPT,        // Bad LZSS stream, a cut-off or unknown record, or the wrong decoded length
+    HEX_PAYLOAD_UNSUPPORTED     // Unknown payload type
+};
+
+// Fills buffer with up to capacity bytes of payload; 0 means no more
+typedef size_t (*PayloadReadFunction)(void* context, uint8_t* buffer, size_t capacity);
+
+// Intel HEX lines from a firmware payload, one at a time, whether it is
+// stored as HEX text or LZSS-packed records, so the flasher streams a
+// compressed package straight to the ATtiny. Reads through a callback in
+// INPUT_CHUNK pieces; everything lives in the object (about 1 KB), no heap.
+class HexPayloadReader {
+public:
+    static const size_t INPUT_CHUNK = 64;
+    static const size_t DECODE_CHUNK = 64;
+    
+    // payloadLength is the stored size; decodedLength the packed record
+    // bytes of a PAYLOAD_HEX_LZSS payload and ignored for PAYLOAD_INTEL_HEX
+    HexPayloadReader(uint8_t payloadType, uint32_t payloadLength, uint32_t decodedLength,
+                     PayloadReadFunction read, void* context);
+    
+    // The next record line, trimmed and terminated. Plain HEX skips lines
+    // that don't start with ':', like the flasher always has. False at the
+    // end of the payload or on an error; see getStatus().
+    bool nextLine(char* line, size_t capacity, size_t& length);
+    
+    HexPayloadStatus getStatus() const { return status; }
+    // Source line for plain HEX, record number for packed payloads
+    uint32_t getLineNumber() const { return lineNumber; }
+    static const char* statusToString(HexPayloadStatus status);
+
+private:
+    bool fillInput();
+    bool nextInputByte(uint8_t& value);
+    bool nextDecodedByte(uint8_t& value);
+    bool nextTextLine(char* line, size_t capacity, size_t& length);
+    bool nextPackedLine(char* line, size_t capacity, size_t& length);
+    
+    uint8_t payloadType;
+    uint32_t inputRemaining;
+    uint32_t decodedRemaining;
+    PayloadReadFunction read;
+    void* context;
+    HexPayloadStatus status;
+    uint32_t lineNumber;
+    
+    uint8_t input[INPUT_CHUNK];
+    size_t inputPosition;
+    size_t inputCount;
+    uint8_t decoded[DECODE_CHUNK];
+    size_t decodedPosition;
+    size_t decodedCount;
+    LzssDecoder decoder;
+    HexRecord record;
+};
+
+#endif
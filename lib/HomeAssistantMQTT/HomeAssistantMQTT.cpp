@@ -2,142 +2,646 @@
 
 // Static member initialization
 AsyncMqttClient HomeAssistantMQTT::mqttClient;
-bool HomeAssistantMQTT::connected = false;
-unsigned long HomeAssistantMQTT::lastReconnectAttempt = 0;
+volatile bool HomeAssistantMQTT::connected = false;
+volatile bool HomeAssistantMQTT::connectFailed = false;
+volatile int HomeAssistantMQTT::lastDisconnectReason = -1;
+MQTTConnectionState HomeAssistantMQTT::connectionState = MQTT_IDLE;
+Backoff HomeAssistantMQTT::backoff(RECONNECT_MIN_DELAY, RECONNECT_MAX_DELAY, RECONNECT_JITTER);
+unsigned long HomeAssistantMQTT::nextAttempt = 0;
+unsigned long HomeAssistantMQTT::attemptStarted = 0;
+unsigned long HomeAssistantMQTT::connectedSince = 0;
+unsigned long HomeAssistantMQTT::connectAttempts = 0;
+unsigned long HomeAssistantMQTT::connectCount = 0;
+unsigned long HomeAssistantMQTT::disconnectCount = 0;
+MQTTOfflineQueue HomeAssistantMQTT::offlineQueue;
+uint32_t HomeAssistantMQTT::topicVersion = 0;
+String HomeAssistantMQTT::discoveryTopic;
+String HomeAssistantMQTT::stateTopic;
+String HomeAssistantMQTT::commandTopic;
+String HomeAssistantMQTT::availabilityTopic;
+String HomeAssistantMQTT::deviceInfoTopic;
+String HomeAssistantMQTT::ledStateTopic;
+String HomeAssistantMQTT::i2cStateTopic;
+String HomeAssistantMQTT::systemStateTopic;
+String HomeAssistantMQTT::lightConfigTopic;
+String HomeAssistantMQTT::lightStateTopic;
+String HomeAssistantMQTT::lightCommandTopic;
+const char* const HomeAssistantMQTT::LIGHT_COMMAND_ROUTE = "light/set";
+LightStatePublisher HomeAssistantMQTT::lightPublisher(LIGHT_STATE_INTERVAL);
+volatile bool HomeAssistantMQTT::lightResync = false;
+DiscoveryCache HomeAssistantMQTT::discoveryCache(DISCOVERY_PACE);
+volatile bool HomeAssistantMQTT::discoveryResync = false;
+volatile bool HomeAssistantMQTT::sessionResync = false;
+
+HomeAssistantMQTT::Route HomeAssistantMQTT::routes[MAX_ROUTES];
+int HomeAssistantMQTT::routeCount = 0;
+SemaphoreHandle_t HomeAssistantMQTT::topicMutex = nullptr;
+QueueHandle_t HomeAssistantMQTT::inboundQueue = nullptr;
+unsigned long HomeAssistantMQTT::droppedMessages = 0;
+HomeAssistantMQTT::InboundMessage HomeAssistantMQTT::assembly;
+int HomeAssistantMQTT::assemblyRoute = -1;
+size_t HomeAssistantMQTT::assemblyTotal = 0;
+size_t HomeAssistantMQTT::assemblyReceived = 0;
 
 bool HomeAssistantMQTT::init() {
-    MQTTConfig config = ConfigManager::getMQTTConfig();
-    
-    mqttClient.setServer(config.brokerIP.c_str(), config.brokerPort);
-    
-    if (config.username.length() > 0) {
-        mqttClient.setCredentials(config.username.c_str(), config.password.c_str());
-    }
+    applyServerConfig();
     
     mqttClient.onConnect(onMqttConnect);
     mqttClient.onDisconnect(onMqttDisconnect);
     mqttClient.onMessage(onMqttMessage);
     
+    topicMutex = xSemaphoreCreateMutex();
+    inboundQueue = xQueueCreate(INBOUND_QUEUE_LENGTH, sizeof(InboundMessage));
+    
     return true;
 }
 
-bool HomeAssistantMQTT::connect() {
-    if (mqttClient.connected()) {
-        return true;
+void HomeAssistantMQTT::loop() {
+    if (!inboundQueue) return;
+    
+    updateConnection();
+    
+    // Static, the message is too big for comfort on the loop task stack
+    static InboundMessage message;
+    while (xQueueReceive(inboundQueue, &message, 0) == pdTRUE) {
+        if (message.route >= routeCount) continue;
+        
+        String topic = getDiscoveryTopic() + "/" + routes[message.route].suffix;
+        String payload(message.payload, message.length);
+        routes[message.route].handler(topic, payload);
     }
     
-    unsigned long now = millis();
-    if (now - lastReconnectAttempt > 5000) {
-        lastReconnectAttempt = now;
-        mqttClient.connect();
+    if (connectionState != MQTT_CONNECTED) {
+        return;
+    }
+    
+    // Availability and subscriptions for a new session, with topics built here
+    if (sessionResync) {
+        sessionResync = false;
+        refreshTopics();
+        // Queued if the TCP buffer is full, or Home Assistant shows us offline
+        publish(availabilityTopic, "online", true);
+        subscribeRoutes();
+    }
+    
+    flushOfflineQueue();
+    replayDiscovery();
+    
+    // Retained state must be resent after a reconnect even if nothing changed
+    if (lightResync) {
+        lightResync = false;
+        lightPublisher.invalidate();
+    }
+    
+    LightState state;
+    if (lightPublisher.poll(millis(), state)) {
+        char payload[192];
+        // A full TCP buffer queues it, so the final value still goes out
+        if (state.toJson(payload, sizeof(payload)) > 0) {
+            refreshTopics();
+            publish(lightStateTopic, payload, true);
+        }
+    }
+}
+
+bool HomeAssistantMQTT::connect() {
+    if (connectionState == MQTT_IDLE) {
+        connectionState = MQTT_WAITING;
+        nextAttempt = millis();
     }
     
-    return false;
+    return connectionState == MQTT_CONNECTED;
 }
 
 void HomeAssistantMQTT::disconnect() {
+    connectionState = MQTT_IDLE;
     mqttClient.disconnect();
 }
 
+void HomeAssistantMQTT::reconnect() {
+    backoff.reset();
+    
+    if (connectionState == MQTT_CONNECTED || connectionState == MQTT_CONNECTING) {
+        // updateConnection() notices the drop and schedules the next attempt
+        mqttClient.disconnect(true);
+    } else if (connectionState == MQTT_WAITING) {
+        nextAttempt = millis();
+    }
+}
+
 bool HomeAssistantMQTT::isConnected() {
     return mqttClient.connected();
 }
 
-void HomeAssistantMQTT::publishDeviceInfo() {
-    MQTTConfig config = ConfigManager::getMQTTConfig();
+void HomeAssistantMQTT::updateConnection() {
+    unsigned long now = millis();
     
-    DynamicJsonDocument doc(1024);
+    switch (connectionState) {
+        case MQTT_IDLE:
+            break;
+            
+        case MQTT_WAITING:
+            // Signed difference so millis() wraparound doesn't stall the retry
+            if ((long)(now - nextAttempt) < 0 || WiFi.status() != WL_CONNECTED) {
+                break;
+            }
+            
+            // Settings may have changed since the last attempt
+            applyServerConfig();
+            connectFailed = false;
+            connectAttempts++;
+            attemptStarted = now;
+            connectionState = MQTT_CONNECTING;
+            mqttClient.connect();
+            break;
+            
+        case MQTT_CONNECTING:
+            if (connected) {
+                connectionState = MQTT_CONNECTED;
+                connectedSince = now;
+                connectCount++;
+                backoff.reset();
+                Logger::addEntry("MQTT connected after " + String(connectAttempts) + " attempt(s)");
+            } else if (connectFailed || now - attemptStarted > CONNECT_TIMEOUT) {
+                mqttClient.disconnect(true);
+                scheduleReconnect(now);
+            }
+            break;
+            
+        case MQTT_CONNECTED:
+            if (!connected) {
+                disconnectCount++;
+                Logger::addEntry("MQTT disconnected (reason " + String(lastDisconnectReason) + ")");
+                scheduleReconnect(now);
+            }
+            break;
+    }
+}
+
+void HomeAssistantMQTT::scheduleReconnect(unsigned long now) {
+    unsigned long delay = backoff.next(esp_random());
+    nextAttempt = now + delay;
+    connectionState = MQTT_WAITING;
+}
+
+void HomeAssistantMQTT::applyServerConfig() {
+    // AsyncMqttClient keeps these pointers, so they must reference ConfigManager's storage
+    const MQTTConfig& config = ConfigManager::getMQTTConfig();
+    
+    mqttClient.setServer(config.brokerIP.c_str(), config.brokerPort);
+    
+    if (config.username.length() > 0) {
+        mqttClient.setCredentials(config.username.c_str(), config.password.c_str());
+    } else {
+        mqttClient.setCredentials(nullptr, nullptr);
+    }
+    
+    // Lets Home Assistant mark the entities unavailable when we drop off
+    refreshTopics();
+    mqttClient.setWill(availabilityTopic.c_str(), 0, true, "offline");
+}
+
+void HomeAssistantMQTT::flushOfflineQueue() {
+    for (int i = 0; i < FLUSH_PER_LOOP && !offlineQueue.isEmpty(); i++) {
+        const MQTTOfflineQueue::Entry* entry = offlineQueue.peek();
+        
+        // 0 means the TCP buffer is full, try again next loop
+        if (mqttClient.publish(entry->topic, entry->qos, entry->retain, entry->payload, entry->length) == 0) {
+            break;
+        }
+        offlineQueue.pop();
+    }
+}
+
+void HomeAssistantMQTT::publish(const String& topic, const char* payload, bool retain) {
+    // Anything still queued must go first or a stale value could land last
+    if (connectionState == MQTT_CONNECTED && offlineQueue.isEmpty()) {
+        if (mqttClient.publish(topic.c_str(), 0, retain, payload) != 0) {
+            return;
+        }
+    }
+    
+    offlineQueue.push(topic.c_str(), payload, strlen(payload), 0, retain);
+}
+
+MQTTConnectionState HomeAssistantMQTT::getConnectionState() {
+    return connectionState;
+}
+
+const char* HomeAssistantMQTT::getConnectionStateName() {
+    switch (connectionState) {
+        case MQTT_WAITING: return "waiting";
+        case MQTT_CONNECTING: return "connecting";
+        case MQTT_CONNECTED: return "connected";
+        default: return "idle";
+    }
+}
+
+unsigned long HomeAssistantMQTT::getConnectAttempts() {
+    return connectAttempts;
+}
+
+unsigned long HomeAssistantMQTT::getConnectCount() {
+    return connectCount;
+}
+
+unsigned long HomeAssistantMQTT::getDisconnectCount() {
+    return disconnectCount;
+}
+
+int HomeAssistantMQTT::getLastDisconnectReason() {
+    return lastDisconnectReason;
+}
+
+unsigned long HomeAssistantMQTT::getNextAttemptIn() {
+    if (connectionState != MQTT_WAITING) {
+        return 0;
+    }
+    
+    long remaining = (long)(nextAttempt - millis());
+    return remaining > 0 ? remaining : 0;
+}
+
+unsigned long HomeAssistantMQTT::getConnectedDuration() {
+    return connectionState == MQTT_CONNECTED ? millis() - connectedSince : 0;
+}
+
+const MQTTOfflineQueue& HomeAssistantMQTT::getOfflineQueue() {
+    return offlineQueue;
+}
+
+void HomeAssistantMQTT::republishDiscovery() {
+    discoveryResync = true;
+}
+
+const DiscoveryCache& HomeAssistantMQTT::getDiscoveryCache() {
+    return discoveryCache;
+}
+
+void HomeAssistantMQTT::replayDiscovery() {
+    uint32_t version = ConfigManager::getConfigVersion();
+    
+    // New settings mean new topics and names, announce them straight away
+    if (!discoveryCache.isCurrent(version)) {
+        renderDiscovery();
+        discoveryResync = true;
+    }
+    
+    if (discoveryResync) {
+        discoveryResync = false;
+        discoveryCache.startReplay();
+    }
+    
+    // One document per pace interval; a refused publish is retried next loop
+    int index = discoveryCache.nextDue(millis());
+    if (index < 0) {
+        return;
+    }
+    
+    if (mqttClient.publish(discoveryCache.getTopic(index), 0, discoveryCache.getRetain(index),
+                           discoveryCache.getPayload(index), discoveryCache.getPayloadLength(index)) != 0) {
+        discoveryCache.markSent(millis());
+    }
+}
+
+void HomeAssistantMQTT::renderDiscovery() {
+    refreshTopics();
+    unsigned long overflows = discoveryCache.getOverflowCount();
+    discoveryCache.begin(topicVersion);
+    
+    renderDeviceInfo();
+    renderLightDiscovery();
+    renderSensorDiscovery("uptime", "Uptime", "duration", "total_increasing", "s", "{{ value_json.uptime }}");
+    
+    // Telemetry batches are [min, avg, max] and leave out unchanged sensors,
+    // so keep the previous state when a key is missing
+    for (int i = 0; i < Telemetry::getSensorCount(); i++) {
+        String key = Telemetry::getSensorKey(i);
+        String valueTemplate = "{{ value_json." + key + "[1] if '" + key + "' in value_json else this.state }}";
+        renderSensorDiscovery(key.c_str(), Telemetry::getSensorName(i), "", "measurement",
+                              Telemetry::getSensorUnit(i), valueTemplate.c_str());
+    }
+    
+    if (discoveryCache.getOverflowCount() != overflows) {
+        Logger::addEntry("Discovery cache full, some entities were not announced");
+    }
+}
+
+void HomeAssistantMQTT::renderDeviceInfo() {
+    const MQTTConfig& config = ConfigManager::getMQTTConfig();
+    
+    DynamicJsonDocument doc(256);
     doc["identifiers"] = config.deviceId;
     doc["name"] = config.deviceName;
     doc["manufacturer"] = "FireLabs";
     doc["model"] = "FL-LEDController01";
     
-    String deviceInfo;
-    serializeJson(doc, deviceInfo);
-    
-    String topic = getDiscoveryTopic() + "/device";
-    mqttClient.publish(topic.c_str(), 0, false, deviceInfo.c_str());
+    cacheDocument(deviceInfoTopic, doc, false);
 }
 
 void HomeAssistantMQTT::publishLEDState(const String& state) {
-    String topic = getStateTopic() + "/led";
-    mqttClient.publish(topic.c_str(), 0, false, state.c_str());
+    refreshTopics();
+    publish(ledStateTopic, state.c_str(), false);
 }
 
 void HomeAssistantMQTT::publishI2CDevices(const String& status) {
-    String topic = getStateTopic() + "/i2c";
-    mqttClient.publish(topic.c_str(), 0, false, status.c_str());
+    refreshTopics();
+    publish(i2cStateTopic, status.c_str(), false);
+}
+
+void HomeAssistantMQTT::publishTelemetry(const char* payload) {
+    refreshTopics();
+    publish(systemStateTopic, payload, false);
+}
+
+void HomeAssistantMQTT::renderLightDiscovery() {
+    const MQTTConfig& config = ConfigManager::getMQTTConfig();
+    
+    DynamicJsonDocument doc(1024);
+    doc["name"] = config.deviceName;
+    doc["unique_id"] = config.deviceId + "_light";
+    doc["schema"] = "json";
+    doc["command_topic"] = lightCommandTopic;
+    doc["state_topic"] = lightStateTopic;
+    doc["availability_topic"] = availabilityTopic;
+    doc["brightness"] = true;
+    doc["brightness_scale"] = 255;
+    
+    JsonArray colorModes = doc.createNestedArray("supported_color_modes");
+    colorModes.add("rgb");
+    colorModes.add("color_temp");
+    doc["min_mireds"] = (int)LightState::MIN_MIREDS;
+    doc["max_mireds"] = (int)LightState::MAX_MIREDS;
+    
+    doc["effect"] = true;
+    JsonArray effects = doc.createNestedArray("effect_list");
+    for (int i = 0; i < LIGHT_EFFECT_COUNT; i++) {
+        effects.add(LightState::effectName(i));
+    }
+    
+    JsonObject device = doc.createNestedObject("device");
+    device["identifiers"] = config.deviceId;
+    device["name"] = config.deviceName;
+    device["manufacturer"] = "FireLabs";
+    device["model"] = "FL-LEDController01";
+    
+    cacheDocument(lightConfigTopic, doc, true);
+}
+
+void HomeAssistantMQTT::renderSensorDiscovery(const char* entityId, const char* name, const char* deviceClass,
+                                              const char* stateClass, const char* unit, const char* valueTemplate) {
+    const MQTTConfig& config = ConfigManager::getMQTTConfig();
+    
+    DynamicJsonDocument doc(768);
+    doc["name"] = name;
+    doc["unique_id"] = config.deviceId + "_" + entityId;
+    doc["state_topic"] = systemStateTopic;
+    doc["value_template"] = valueTemplate;
+    doc["availability_topic"] = availabilityTopic;
+    if (deviceClass[0] != '\0') {
+        doc["device_class"] = deviceClass;
+    }
+    doc["state_class"] = stateClass;
+    doc["unit_of_measurement"] = unit;
+    // Controller health, not shelf state: keep it off the default dashboard
+    doc["entity_category"] = "diagnostic";
+    
+    // The light's discovery document carries the full device block
+    doc["device"]["identifiers"] = config.deviceId;
+    
+    cacheDocument(discoveryTopic + "/" + entityId + "/config", doc, true);
 }
 
-void HomeAssistantMQTT::publishSystemStatus(const String& uptime, int rssi) {
-    DynamicJsonDocument doc(512);
-    doc["uptime"] = uptime;
-    doc["rssi"] = rssi;
-    doc["free_heap"] = ESP.getFreeHeap();
+void HomeAssistantMQTT::cacheDocument(const String& topic, JsonDocument& doc, bool retain) {
+    String payload;
+    serializeJson(doc, payload);
+    discoveryCache.add(topic.c_str(), payload.c_str(), payload.length(), retain);
+}
+
+void HomeAssistantMQTT::publishLightState(const LightState& state) {
+    lightPublisher.update(state);
+}
+
+bool HomeAssistantMQTT::parseLightCommand(const String& payload, LightState& state) {
+    StaticJsonDocument<256> doc;
+    DeserializationError error = deserializeJson(doc, payload);
+    if (error) {
+        return false;
+    }
     
-    String statusPayload;
-    serializeJson(doc, statusPayload);
+    // Every key is optional, HA only sends what the user touched
+    if (doc.containsKey("state")) {
+        const char* power = doc["state"] | "";
+        state.on = strcmp(power, "ON") == 0;
+    }
+    
+    if (doc.containsKey("brightness")) {
+        int brightness = doc["brightness"] | 0;
+        state.brightness = constrain(brightness, 0, 255);
+    }
     
-    String topic = getStateTopic() + "/system";
-    mqttClient.publish(topic.c_str(), 0, false, statusPayload.c_str());
+    if (doc.containsKey("color")) {
+        JsonObject color = doc["color"];
+        state.red = constrain(color["r"] | 0, 0, 255);
+        state.green = constrain(color["g"] | 0, 0, 255);
+        state.blue = constrain(color["b"] | 0, 0, 255);
+        state.colorMode = LIGHT_MODE_RGB;
+    }
+    
+    if (doc.containsKey("color_temp")) {
+        int mireds = doc["color_temp"] | 0;
+        if (mireds < LightState::MIN_MIREDS) mireds = LightState::MIN_MIREDS;
+        if (mireds > LightState::MAX_MIREDS) mireds = LightState::MAX_MIREDS;
+        state.colorTemp = mireds;
+        state.colorMode = LIGHT_MODE_COLOR_TEMP;
+    }
+    
+    if (doc.containsKey("effect")) {
+        int effect = LightState::effectFromName(doc["effect"] | "");
+        if (effect >= 0) {
+            state.effect = effect;
+        }
+    }
+    
+    return true;
+}
+
+bool HomeAssistantMQTT::addRoute(const char* suffix, MQTTMessageHandler handler) {
+    if (routeCount >= MAX_ROUTES || !handler) {
+        return false;
+    }
+    
+    routes[routeCount].suffix = suffix;
+    routes[routeCount].handler = handler;
+    routeCount++;
+    
+    if (mqttClient.connected()) {
+        refreshTopics();
+        String topic = discoveryTopic + "/" + suffix;
+        mqttClient.subscribe(topic.c_str(), 0);
+    }
+    
+    return true;
 }
 
 void HomeAssistantMQTT::setMessageCallback(std::function<void(const String&, const String&)> callback) {
-    // Store the callback for use in onMqttMessage
-    // This is a simplified implementation
+    // Generic commands arrive on <discovery topic>/command
+    addRoute("command", callback);
+}
+
+unsigned long HomeAssistantMQTT::getDroppedMessages() {
+    return droppedMessages;
+}
+
+const String& HomeAssistantMQTT::getDiscoveryTopic() {
+    refreshTopics();
+    return discoveryTopic;
+}
+
+const String& HomeAssistantMQTT::getStateTopic() {
+    refreshTopics();
+    return stateTopic;
 }
 
-String HomeAssistantMQTT::getDiscoveryTopic() {
-    MQTTConfig config = ConfigManager::getMQTTConfig();
-    return config.mqttPrefix + "/sensor/" + config.deviceId;
+const String& HomeAssistantMQTT::getCommandTopic() {
+    refreshTopics();
+    return commandTopic;
 }
 
-String HomeAssistantMQTT::getStateTopic() {
-    MQTTConfig config = ConfigManager::getMQTTConfig();
-    return config.mqttPrefix + "/sensor/" + config.deviceId + "/state";
+const String& HomeAssistantMQTT::getAvailabilityTopic() {
+    refreshTopics();
+    return availabilityTopic;
 }
 
-String HomeAssistantMQTT::getCommandTopic() {
-    MQTTConfig config = ConfigManager::getMQTTConfig();
-    return config.mqttPrefix + "/sensor/" + config.deviceId + "/command";
+const String& HomeAssistantMQTT::getLightStateTopic() {
+    refreshTopics();
+    return lightStateTopic;
 }
 
-String HomeAssistantMQTT::getAvailabilityTopic() {
-    MQTTConfig config = ConfigManager::getMQTTConfig();
-    return config.mqttPrefix + "/sensor/" + config.deviceId + "/availability";
+const String& HomeAssistantMQTT::getLightCommandTopic() {
+    refreshTopics();
+    return lightCommandTopic;
+}
+
+void HomeAssistantMQTT::refreshTopics() {
+    uint32_t version = ConfigManager::getConfigVersion();
+    if (version == topicVersion) {
+        return;
+    }
+    
+    const MQTTConfig& config = ConfigManager::getMQTTConfig();
+    
+    // onMqttMessage matches against discoveryTopic from the AsyncTCP task
+    if (topicMutex) xSemaphoreTake(topicMutex, portMAX_DELAY);
+    
+    discoveryTopic = config.mqttPrefix;
+    discoveryTopic += "/sensor/";
+    discoveryTopic += config.deviceId;
+    
+    stateTopic = discoveryTopic + "/state";
+    commandTopic = discoveryTopic + "/command";
+    availabilityTopic = discoveryTopic + "/availability";
+    deviceInfoTopic = discoveryTopic + "/device";
+    ledStateTopic = stateTopic + "/led";
+    i2cStateTopic = stateTopic + "/i2c";
+    systemStateTopic = stateTopic + "/system";
+    
+    // HA expects entity configs under <prefix>/<component>/<object id>/config
+    lightConfigTopic = config.mqttPrefix;
+    lightConfigTopic += "/light/";
+    lightConfigTopic += config.deviceId;
+    lightConfigTopic += "/config";
+    lightStateTopic = stateTopic + "/light";
+    lightCommandTopic = discoveryTopic + "/" + LIGHT_COMMAND_ROUTE;
+    
+    topicVersion = version;
+    
+    if (topicMutex) xSemaphoreGive(topicMutex);
 }
 
 void HomeAssistantMQTT::onMqttConnect(bool sessionPresent) {
     connected = true;
     
-    // Publish availability
-    String availabilityTopic = getAvailabilityTopic();
-    mqttClient.publish(availabilityTopic.c_str(), 0, true, "online");
-    
-    // Publish device info
-    publishDeviceInfo();
+    // Runs on the AsyncTCP task, which mustn't touch the topic Strings the
+    // loop rebuilds: loop() publishes availability, subscribes, replays
+    // discovery from the cache and republishes the light state
+    sessionResync = true;
+    discoveryResync = true;
+    lightResync = true;
 }
 
 void HomeAssistantMQTT::onMqttDisconnect(AsyncMqttClientDisconnectReason reason) {
+    // Also called when a connect attempt fails
+    lastDisconnectReason = (int)reason;
     connected = false;
+    connectFailed = true;
 }
 
 void HomeAssistantMQTT::onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total) {
-    // Handle incoming MQTT messages if needed
+    // Runs on the AsyncTCP task: match, reassemble and hand off, nothing else
+    if (index == 0) {
+        assemblyRoute = findRoute(topic);
+        assemblyTotal = total;
+        assemblyReceived = 0;
+        
+        if (assemblyRoute < 0) return;
+        
+        if (total > MAX_PAYLOAD) {
+            droppedMessages++;
+            assemblyRoute = -1;
+            return;
+        }
+    }
+    
+    // Fragment of a message we're not collecting, or out of sequence
+    if (assemblyRoute < 0 || index != assemblyReceived || index + len > assemblyTotal) {
+        assemblyRoute = -1;
+        return;
+    }
+    
+    memcpy(assembly.payload + index, payload, len);
+    assemblyReceived += len;
+    
+    if (assemblyReceived < assemblyTotal) {
+        return;
+    }
+    
+    assembly.route = assemblyRoute;
+    assembly.length = assemblyTotal;
+    assembly.payload[assemblyTotal] = '\0';
+    assemblyRoute = -1;
+    
+    if (xQueueSend(inboundQueue, &assembly, 0) != pdTRUE) {
+        droppedMessages++;
+    }
 }
 
-void HomeAssistantMQTT::publishDiscoveryMessage(const String& entityId, const String& name, const String& deviceClass, const String& stateClass) {
-    MQTTConfig config = ConfigManager::getMQTTConfig();
+int HomeAssistantMQTT::findRoute(const char* topic) {
+    int match = -1;
     
-    DynamicJsonDocument doc(1024);
-    doc["name"] = name;
-    doc["device_class"] = deviceClass;
-    doc["state_class"] = stateClass;
-    doc["device"]["identifiers"] = config.deviceId;
+    if (xSemaphoreTake(topicMutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return match;
+    }
     
-    String discoveryPayload;
-    serializeJson(doc, discoveryPayload);
+    // Every route shares the base topic, so check it once and then only the suffixes
+    size_t baseLength = discoveryTopic.length();
+    if (topicVersion != 0 && strncmp(topic, discoveryTopic.c_str(), baseLength) == 0 && topic[baseLength] == '/') {
+        const char* suffix = topic + baseLength + 1;
+        for (int i = 0; i < routeCount; i++) {
+            if (strcmp(suffix, routes[i].suffix) == 0) {
+                match = i;
+                break;
+            }
+        }
+    }
     
-    String topic = getDiscoveryTopic() + "/" + entityId + "/config";
-    mqttClient.publish(topic.c_str(), 0, true, discoveryPayload.c_str());
+    xSemaphoreGive(topicMutex);
+    return match;
+}
+
+void HomeAssistantMQTT::subscribeRoutes() {
+    for (int i = 0; i < routeCount; i++) {
+        String topic = discoveryTopic + "/" + routes[i].suffix;
+        mqttClient.subscribe(topic.c_str(), 0);
+    }
 }
@@ -2,42 +2,179 @@
 #define HOMEASSISTANTMQTT_H
 
 #include <Arduino.h>
+#include <WiFi.h>
 #include <AsyncMqttClient.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include "ConfigManager.h"
+#include "Logger.h"
+#include "LightState.h"
+#include "Backoff.h"
+#include "MQTTOfflineQueue.h"
+#include "DiscoveryCache.h"
+#include "Telemetry.h"
+
+typedef std::function<void(const String&, const String&)> MQTTMessageHandler;
+
+enum MQTTConnectionState {
+    MQTT_IDLE,          // connect() not called yet, or disconnect() requested
+    MQTT_WAITING,       // Backing off before the next attempt
+    MQTT_CONNECTING,
+    MQTT_CONNECTED
+};
 
 class HomeAssistantMQTT {
 public:
+    static const int MAX_ROUTES = 8;
+    static const size_t MAX_PAYLOAD = 512;    // Larger inbound messages are dropped
+    static const int INBOUND_QUEUE_LENGTH = 4;
+    static const unsigned long LIGHT_STATE_INTERVAL = 250; // Min ms between light state publishes
+    static const char* const LIGHT_COMMAND_ROUTE;
+    static const unsigned long RECONNECT_MIN_DELAY = 1000;
+    static const unsigned long RECONNECT_MAX_DELAY = 60000;
+    static const uint8_t RECONNECT_JITTER = 50;           // Percent
+    static const unsigned long CONNECT_TIMEOUT = 10000;
+    static const int FLUSH_PER_LOOP = 4;
+    static const unsigned long DISCOVERY_PACE = 50;      // Min ms between discovery publishes
+    
     static bool init();
+    static void loop();
+    
+    // Starts the reconnect state machine; loop() keeps the session up from then on
     static bool connect();
     static void disconnect();
+    // Drop the session and reconnect promptly, e.g. after the broker settings change
+    static void reconnect();
     static bool isConnected();
     
-    // Device discovery
-    static void publishDeviceInfo();
+    // Connection and offline queue statistics
+    static MQTTConnectionState getConnectionState();
+    static const char* getConnectionStateName();
+    static unsigned long getConnectAttempts();
+    static unsigned long getConnectCount();
+    static unsigned long getDisconnectCount();
+    static int getLastDisconnectReason();
+    static unsigned long getNextAttemptIn();
+    static unsigned long getConnectedDuration();
+    static const MQTTOfflineQueue& getOfflineQueue();
+    
+    // Device discovery - documents are rendered once per config version and
+    // replayed from the cache by loop() after every connect
+    static void republishDiscovery();
+    static const DiscoveryCache& getDiscoveryCache();
+    
     static void publishLEDState(const String& state);
     static void publishI2CDevices(const String& status);
-    static void publishSystemStatus(const String& uptime, int rssi);
+    // Batched Telemetry payload; every registered sensor is announced as an HA sensor
+    static void publishTelemetry(const char* payload);
+    
+    // Home Assistant light entity (JSON schema). publishLightState only records
+    // the state; loop() sends it when it changed, at most every LIGHT_STATE_INTERVAL.
+    static void publishLightState(const LightState& state);
+    static bool parseLightCommand(const String& payload, LightState& state);
     
-    // Message handling
+    // Message handling - handlers run on the main loop, not the AsyncTCP task.
+    // Each route subscribes to <discovery topic>/<suffix> on every connect.
+    static bool addRoute(const char* suffix, MQTTMessageHandler handler);
     static void setMessageCallback(std::function<void(const String&, const String&)> callback);
+    static unsigned long getDroppedMessages();
     
-    // Topic helpers
-    static String getDiscoveryTopic();
-    static String getStateTopic();
-    static String getCommandTopic();
-    static String getAvailabilityTopic();
+    // Topic helpers - interned per config version, no allocation once built
+    static const String& getDiscoveryTopic();
+    static const String& getStateTopic();
+    static const String& getCommandTopic();
+    static const String& getAvailabilityTopic();
+    static const String& getLightStateTopic();
+    static const String& getLightCommandTopic();
 
 private:
     static AsyncMqttClient mqttClient;
-    static bool connected;
-    static unsigned long lastReconnectAttempt;
+    static volatile bool connected;      // Written by the AsyncTCP callbacks
+    static volatile bool connectFailed;
+    static volatile int lastDisconnectReason;
+    
+    // Reconnect state machine, main loop only
+    static MQTTConnectionState connectionState;
+    static Backoff backoff;
+    static unsigned long nextAttempt;
+    static unsigned long attemptStarted;
+    static unsigned long connectedSince;
+    static unsigned long connectAttempts;
+    static unsigned long connectCount;
+    static unsigned long disconnectCount;
+    
+    static MQTTOfflineQueue offlineQueue;
+    
+    static void updateConnection();
+    static void scheduleReconnect(unsigned long now);
+    static void applyServerConfig();
+    static void flushOfflineQueue();
+    static void publish(const String& topic, const char* payload, bool retain);
+    
+    // Interned topics, rebuilt when ConfigManager's version moves on
+    static uint32_t topicVersion;
+    static String discoveryTopic;
+    static String stateTopic;
+    static String commandTopic;
+    static String availabilityTopic;
+    static String deviceInfoTopic;
+    static String ledStateTopic;
+    static String i2cStateTopic;
+    static String systemStateTopic;
+    static String lightConfigTopic;
+    static String lightStateTopic;
+    static String lightCommandTopic;
+    
+    static void refreshTopics();
+    
+    static LightStatePublisher lightPublisher;
+    static volatile bool lightResync;
+    
+    // Inbound routing: suffixes are fixed at registration, only the shared
+    // base topic changes with the config
+    struct Route {
+        const char* suffix;
+        MQTTMessageHandler handler;
+    };
+    
+    struct InboundMessage {
+        uint8_t route;
+        uint16_t length;
+        char payload[MAX_PAYLOAD + 1];
+    };
+    
+    static Route routes[MAX_ROUTES];
+    static int routeCount;
+    static SemaphoreHandle_t topicMutex;
+    static QueueHandle_t inboundQueue;
+    static unsigned long droppedMessages;
+    
+    // Reassembly of fragmented payloads (AsyncTCP task only)
+    static InboundMessage assembly;
+    static int assemblyRoute;
+    static size_t assemblyTotal;
+    static size_t assemblyReceived;
+    
+    static int findRoute(const char* topic);
+    static void subscribeRoutes();
     
     static void onMqttConnect(bool sessionPresent);
     static void onMqttDisconnect(AsyncMqttClientDisconnectReason reason);
     static void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total);
     
-    static void publishDiscoveryMessage(const String& entityId, const String& name, const String& deviceClass, const String& stateClass);
+    static DiscoveryCache discoveryCache;
+    static volatile bool discoveryResync;
+    static volatile bool sessionResync;
+    
+    static void renderDiscovery();
+    static void renderDeviceInfo();
+    static void renderLightDiscovery();
+    static void renderSensorDiscovery(const char* entityId, const char* name, const char* deviceClass,
+                                      const char* stateClass, const char* unit, const char* valueTemplate);
+    static void cacheDocument(const String& topic, JsonDocument& doc, bool retain);
+    static void replayDiscovery();
 };
 
 #endif
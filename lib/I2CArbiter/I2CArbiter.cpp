@@ -0,0 +1,53 @@
+#include "I2CArbiter.h"
+
+I2CArbiter::I2CArbiter() : count(0), nextSequence(0) {
+    for (int i = 0; i < MAX_WAITERS; i++) {
+        waiters[i].used = false;
+    }
+}
+
+int I2CArbiter::enqueue(uint8_t priority, void* owner, unsigned long now) {
+    for (int i = 0; i < MAX_WAITERS; i++) {
+        if (!waiters[i].used) {
+            waiters[i].used = true;
+            waiters[i].priority = priority;
+            waiters[i].sequence = nextSequence++;
+            waiters[i].enqueuedAt = now;
+            waiters[i].owner = owner;
+            count++;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void I2CArbiter::remove(int slot) {
+    if (slot < 0 || slot >= MAX_WAITERS || !waiters[slot].used) {
+        return;
+    }
+    waiters[slot].used = false;
+    count--;
+}
+
+int I2CArbiter::pickNext(unsigned long now) const {
+    int best = -1;
+    unsigned long bestScore = 0;
+    
+    for (int i = 0; i < MAX_WAITERS; i++) {
+        const Waiter& waiter = waiters[i];
+        if (!waiter.used) {
+            continue;
+        }
+        
+        unsigned long score = waiter.priority + (now - waiter.enqueuedAt) / AGING_INTERVAL;
+        
+        // Ties go to whoever arrived first
+        if (best < 0 || score > bestScore ||
+            (score == bestScore && (int32_t)(waiter.sequence - waiters[best].sequence) < 0)) {
+            best = i;
+            bestScore = score;
+        }
+    }
+    
+    return best;
+}
@@ -0,0 +1,45 @@
+#ifndef I2CARBITER_H
+#define I2CARBITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Waiters for the I2C bus. The next grant goes to the highest effective
+// priority, where every AGING_INTERVAL spent waiting counts as one extra
+// level, so a steady stream of high priority work can't starve a low
+// priority one. Equal priorities are served in arrival order. Holds only
+// an opaque owner pointer, no Arduino or FreeRTOS dependency.
+class I2CArbiter {
+public:
+    static const int MAX_WAITERS = 8;
+    static const unsigned long AGING_INTERVAL = 50; // ms per priority level
+    
+    I2CArbiter();
+    
+    // Returns the waiter slot, or -1 if every slot is taken
+    int enqueue(uint8_t priority, void* owner, unsigned long now);
+    void remove(int slot);
+    
+    // Slot to grant next, or -1 if nobody is waiting
+    int pickNext(unsigned long now) const;
+    
+    void* getOwner(int slot) const { return waiters[slot].owner; }
+    unsigned long getEnqueuedAt(int slot) const { return waiters[slot].enqueuedAt; }
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+
+private:
+    struct Waiter {
+        bool used;
+        uint8_t priority;
+        uint32_t sequence;
+        unsigned long enqueuedAt;
+        void* owner;
+    };
+    
+    Waiter waiters[MAX_WAITERS];
+    int count;
+    uint32_t nextSequence;
+};
+
+#endif
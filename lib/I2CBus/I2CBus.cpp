@@ -0,0 +1,335 @@
+#include "I2CBus.h"
+#include "Logger.h"
+
+int I2CBus::sdaPin = 6;
+int I2CBus::sclPin = 7;
+uint32_t I2CBus::currentClock = 0;
+uint16_t I2CBus::currentTimeout = 0;
+
+SemaphoreHandle_t I2CBus::stateMutex = nullptr;
+I2CArbiter I2CBus::arbiter;
+TaskHandle_t I2CBus::owner = nullptr;
+int I2CBus::ownerDepth = 0;
+uint8_t I2CBus::lockAddress = 0;
+unsigned long I2CBus::lockStarted = 0;
+
+I2CBusStats I2CBus::stats;
+unsigned long I2CBus::contendedCount = 0;
+unsigned long I2CBus::maxWaitMicros = 0;
+
+bool I2CBus::init(int sda, int scl) {
+    if (stateMutex == nullptr) {
+        stateMutex = xSemaphoreCreateMutex();
+        if (stateMutex == nullptr) {
+            Logger::addEntry("I2C bus mutex allocation failed");
+            return false;
+        }
+    }
+    
+    // Reinitialising under someone's transaction would corrupt it
+    if (!acquireBus(I2C_PRIORITY_HIGH, ACQUIRE_TIMEOUT)) {
+        Logger::addEntry("I2C bus busy, reinitialisation skipped");
+        return false;
+    }
+    
+    Wire.end();
+    sdaPin = sda;
+    sclPin = scl;
+    Wire.begin(sdaPin, sclPin);
+    currentClock = 0;
+    applySettings(DEFAULT_CLOCK, DEFAULT_TIMEOUT);
+    
+    releaseBus();
+    return true;
+}
+
+uint8_t I2CBus::transfer(I2CTransaction& transaction, I2CPriority priority) {
+    return transferBatch(&transaction, 1, priority);
+}
+
+uint8_t I2CBus::transferBatch(I2CTransaction* transactions, int count, I2CPriority priority) {
+    if (count <= 0 || count > MAX_BATCH) {
+        return 4;
+    }
+    
+    if (!acquireBus(priority, ACQUIRE_TIMEOUT)) {
+        for (int i = 0; i < count; i++) {
+            transactions[i].error = 4;
+            transactions[i].bytesRead = 0;
+        }
+        return 4;
+    }
+    
+    uint8_t error = 0;
+    for (int i = 0; i < count; i++) {
+        execute(transactions[i]);
+        if (transactions[i].error != 0) {
+            error = transactions[i].error;
+            break;
+        }
+    }
+    
+    releaseBus();
+    return error;
+}
+
+I2CProbeResult I2CBus::probe(uint8_t address, uint32_t clockHz, uint16_t timeoutMs, I2CPriority priority) {
+    I2CTransaction transaction(address);
+    transaction.clockHz = clockHz;
+    transaction.timeoutMs = timeoutMs;
+    
+    if (!acquireBus(priority, ACQUIRE_TIMEOUT)) {
+        return I2C_PROBE_BUS_ERROR;
+    }
+    execute(transaction);
+    I2CProbeResult result = I2CProbe::classify(transaction.error, readSda());
+    releaseBus();
+    
+    return result;
+}
+
+uint8_t I2CBus::write(uint8_t address, const uint8_t* data, size_t length, I2CPriority priority) {
+    I2CTransaction transaction(address);
+    transaction.writeData = data;
+    transaction.writeLength = length;
+    return transfer(transaction, priority);
+}
+
+uint8_t I2CBus::read(uint8_t address, uint8_t* data, size_t length, I2CPriority priority) {
+    I2CTransaction transaction(address);
+    transaction.readData = data;
+    transaction.readLength = length;
+    return transfer(transaction, priority);
+}
+
+uint8_t I2CBus::writeRead(uint8_t address, const uint8_t* writeData, size_t writeLength,
+                          uint8_t* readData, size_t readLength, I2CPriority priority) {
+    I2CTransaction transaction(address);
+    transaction.writeData = writeData;
+    transaction.writeLength = writeLength;
+    transaction.readData = readData;
+    transaction.readLength = readLength;
+    return transfer(transaction, priority);
+}
+
+bool I2CBus::acquire(uint8_t address, I2CPriority priority, TickType_t timeout) {
+    if (!acquireBus(priority, timeout)) {
+        return false;
+    }
+    
+    // Only the outermost lock is accounted
+    if (ownerDepth == 1) {
+        lockAddress = address;
+        lockStarted = micros();
+    }
+    return true;
+}
+
+void I2CBus::release(size_t bytesWritten) {
+    if (owner != xTaskGetCurrentTaskHandle()) {
+        return;
+    }
+    
+    if (ownerDepth == 1) {
+        stats.record(lockAddress, I2C_PROBE_ACK, bytesWritten, 0, micros() - lockStarted);
+        // The driver may have changed the clock or timeout behind our back
+        currentClock = 0;
+        currentTimeout = 0;
+    }
+    releaseBus();
+}
+
+bool I2CBus::acquireBus(I2CPriority priority, TickType_t timeout) {
+    if (stateMutex == nullptr) {
+        return false;
+    }
+    
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    xSemaphoreTake(stateMutex, portMAX_DELAY);
+    
+    if (owner == self) {
+        ownerDepth++;
+        xSemaphoreGive(stateMutex);
+        return true;
+    }
+    
+    if (owner == nullptr && arbiter.isEmpty()) {
+        owner = self;
+        ownerDepth = 1;
+        xSemaphoreGive(stateMutex);
+        return true;
+    }
+    
+    int slot = arbiter.enqueue(priority, self, millis());
+    if (slot < 0) {
+        xSemaphoreGive(stateMutex);
+        Logger::addEntry("I2C bus wait queue full");
+        return false;
+    }
+    contendedCount++;
+    unsigned long waitStarted = micros();
+    xSemaphoreGive(stateMutex);
+    
+    // releaseBus() hands the bus over and wakes us
+    bool granted = ulTaskNotifyTake(pdTRUE, timeout) > 0;
+    
+    xSemaphoreTake(stateMutex, portMAX_DELAY);
+    if (!granted) {
+        if (owner == self) {
+            // Handed over just as we gave up, swallow the late notification
+            ulTaskNotifyTake(pdTRUE, 0);
+            granted = true;
+        } else {
+            arbiter.remove(slot);
+        }
+    }
+    
+    if (granted) {
+        unsigned long waited = micros() - waitStarted;
+        if (waited > maxWaitMicros) {
+            maxWaitMicros = waited;
+        }
+    }
+    xSemaphoreGive(stateMutex);
+    
+    return granted;
+}
+
+void I2CBus::releaseBus() {
+    xSemaphoreTake(stateMutex, portMAX_DELAY);
+    
+    if (owner != xTaskGetCurrentTaskHandle() || --ownerDepth > 0) {
+        xSemaphoreGive(stateMutex);
+        return;
+    }
+    
+    int next = arbiter.pickNext(millis());
+    if (next < 0) {
+        owner = nullptr;
+    } else {
+        owner = (TaskHandle_t)arbiter.getOwner(next);
+        ownerDepth = 1;
+        arbiter.remove(next);
+        xTaskNotifyGive(owner);
+    }
+    
+    xSemaphoreGive(stateMutex);
+}
+
+void I2CBus::execute(I2CTransaction& transaction) {
+    uint32_t clockHz = transaction.clockHz;
+    if (clockHz == 0) {
+        clockHz = getDeviceClock(transaction.address);
+    }
+    uint16_t timeoutMs = transaction.timeoutMs;
+    if (timeoutMs == 0) {
+        timeoutMs = DEFAULT_TIMEOUT;
+    }
+    applySettings(clockHz, timeoutMs);
+    
+    unsigned long started = micros();
+    transaction.error = 0;
+    transaction.bytesRead = 0;
+    
+    // A bare address phase is a probe; a write before a read ends in a repeated start
+    if (transaction.writeLength > 0 || transaction.readLength == 0) {
+        Wire.beginTransmission(transaction.address);
+        if (transaction.writeLength > 0) {
+            Wire.write(transaction.writeData, transaction.writeLength);
+        }
+        transaction.error = Wire.endTransmission(transaction.readLength == 0);
+    }
+    
+    if (transaction.error == 0 && transaction.readLength > 0) {
+        Wire.requestFrom((int)transaction.address, (int)transaction.readLength);
+        while (Wire.available() && transaction.bytesRead < transaction.readLength) {
+            transaction.readData[transaction.bytesRead++] = Wire.read();
+        }
+        if (transaction.bytesRead < transaction.readLength) {
+            transaction.error = 4;
+        }
+    }
+    
+    stats.record(transaction.address, I2CProbe::classify(transaction.error),
+                 transaction.error == 0 ? transaction.writeLength : 0, transaction.bytesRead,
+                 micros() - started);
+}
+
+void I2CBus::applySettings(uint32_t clockHz, uint16_t timeoutMs) {
+    if (clockHz != currentClock) {
+        Wire.setClock(clockHz);
+        currentClock = clockHz;
+    }
+    if (timeoutMs != currentTimeout) {
+        Wire.setTimeOut(timeoutMs);
+        currentTimeout = timeoutMs;
+    }
+}
+
+void I2CBus::setDeviceClock(uint8_t address, uint32_t clockHz) {
+    stats.setClock(address, clockHz);
+}
+
+uint32_t I2CBus::getDeviceClock(uint8_t address) {
+    uint32_t clockHz = stats.getClock(address);
+    if (clockHz == 0) {
+        return DEFAULT_CLOCK;
+    }
+    return clockHz;
+}
+
+bool I2CBus::recover() {
+    static const I2CLines lines = { setScl, setSda, readSda, delayMicros };
+    
+    if (!acquireBus(I2C_PRIORITY_HIGH, ACQUIRE_TIMEOUT)) {
+        return false;
+    }
+    
+    // Take the pins back from the I2C peripheral while we bit-bang
+    Wire.end();
+    bool recovered = I2CProbe::recoverBus(lines);
+    Wire.begin(sdaPin, sclPin);
+    currentClock = 0;
+    currentTimeout = 0;
+    
+    releaseBus();
+    return recovered;
+}
+
+const I2CBusStats& I2CBus::getStats() {
+    return stats;
+}
+
+unsigned long I2CBus::getContendedCount() {
+    return contendedCount;
+}
+
+unsigned long I2CBus::getMaxWaitMicros() {
+    return maxWaitMicros;
+}
+
+void I2CBus::setScl(bool high) {
+    if (high) {
+        pinMode(sclPin, INPUT_PULLUP);
+    } else {
+        pinMode(sclPin, OUTPUT_OPEN_DRAIN);
+        digitalWrite(sclPin, LOW);
+    }
+}
+
+void I2CBus::setSda(bool high) {
+    if (high) {
+        pinMode(sdaPin, INPUT_PULLUP);
+    } else {
+        pinMode(sdaPin, OUTPUT_OPEN_DRAIN);
+        digitalWrite(sdaPin, LOW);
+    }
+}
+
+bool I2CBus::readSda() {
+    return digitalRead(sdaPin) == HIGH;
+}
+
+void I2CBus::delayMicros(uint32_t micros) {
+    delayMicroseconds(micros);
+}
@@ -0,0 +1,126 @@
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "I2CArbiter.h"
+#include "I2CProbe.h"
+#include "I2CBusStats.h"
+
+enum I2CPriority : uint8_t {
+    I2C_PRIORITY_LOW = 0,      // Scans, firmware flashing
+    I2C_PRIORITY_NORMAL = 1,   // Display updates
+    I2C_PRIORITY_HIGH = 2      // Bus reinitialisation
+};
+
+// One write, one read or a write followed by a repeated-start read
+struct I2CTransaction {
+    uint8_t address;
+    const uint8_t* writeData;
+    size_t writeLength;
+    uint8_t* readData;
+    size_t readLength;
+    uint32_t clockHz;      // 0 = the device's clock
+    uint16_t timeoutMs;    // 0 = the bus default
+    
+    // Results
+    uint8_t error;         // Wire endTransmission() code, 4 for a short read
+    size_t bytesRead;
+    
+    explicit I2CTransaction(uint8_t address)
+        : address(address), writeData(nullptr), writeLength(0), readData(nullptr), readLength(0),
+          clockHz(0), timeoutMs(0), error(0), bytesRead(0) {}
+};
+
+// Sole owner of Wire. Every user goes through here, either with
+// transactions or, for drivers that talk to Wire themselves, by holding an
+// I2CBusLock. The bus is granted one transaction (or lock) at a time by
+// priority with aging, so a long firmware flash interleaves with display
+// updates instead of blocking them. Ownership is recursive per task.
+class I2CBus {
+public:
+    static const uint32_t DEFAULT_CLOCK = I2CProbe::NORMAL_CLOCK;
+    static const uint16_t DEFAULT_TIMEOUT = I2CProbe::NORMAL_TIMEOUT;
+    static const int MAX_BATCH = 8;
+    static const TickType_t ACQUIRE_TIMEOUT = pdMS_TO_TICKS(1000);
+    
+    static bool init(int sdaPin, int sclPin);
+    
+    static uint8_t transfer(I2CTransaction& transaction, I2CPriority priority = I2C_PRIORITY_NORMAL);
+    // Runs up to MAX_BATCH transactions under one grant; stops at the first error
+    static uint8_t transferBatch(I2CTransaction* transactions, int count, I2CPriority priority = I2C_PRIORITY_NORMAL);
+    
+    // Address phase only. SDA is sampled before the bus is released, so a
+    // stuck slave reads as I2C_PROBE_BUS_STUCK and another user's transfer can't.
+    static I2CProbeResult probe(uint8_t address, uint32_t clockHz = 0, uint16_t timeoutMs = 0,
+                                I2CPriority priority = I2C_PRIORITY_LOW);
+    static uint8_t write(uint8_t address, const uint8_t* data, size_t length, I2CPriority priority = I2C_PRIORITY_NORMAL);
+    static uint8_t read(uint8_t address, uint8_t* data, size_t length, I2CPriority priority = I2C_PRIORITY_NORMAL);
+    static uint8_t writeRead(uint8_t address, const uint8_t* writeData, size_t writeLength,
+                             uint8_t* readData, size_t readLength, I2CPriority priority = I2C_PRIORITY_NORMAL);
+    
+    // Exclusive use of Wire for drivers that can't go through transfer().
+    // The hold is accounted as one transaction to the lock's address.
+    static bool acquire(uint8_t address, I2CPriority priority, TickType_t timeout = ACQUIRE_TIMEOUT);
+    static void release(size_t bytesWritten = 0);
+    
+    static void setDeviceClock(uint8_t address, uint32_t clockHz);
+    static uint32_t getDeviceClock(uint8_t address);
+    
+    // Clock a stuck slave off SDA and reinitialise Wire
+    static bool recover();
+    
+    // Per-address transactions, errors by type, bytes and latency
+    static const I2CBusStats& getStats();
+    static unsigned long getContendedCount();
+    static unsigned long getMaxWaitMicros();
+
+private:
+    static int sdaPin;
+    static int sclPin;
+    static uint32_t currentClock;      // 0 = unknown, e.g. after a driver changed it
+    static uint16_t currentTimeout;
+    
+    static SemaphoreHandle_t stateMutex;
+    static I2CArbiter arbiter;
+    static TaskHandle_t owner;
+    static int ownerDepth;
+    static uint8_t lockAddress;
+    static unsigned long lockStarted;
+    
+    static I2CBusStats stats;
+    static unsigned long contendedCount;
+    static unsigned long maxWaitMicros;
+    
+    static bool acquireBus(I2CPriority priority, TickType_t timeout);
+    static void releaseBus();
+    static void execute(I2CTransaction& transaction);
+    static void applySettings(uint32_t clockHz, uint16_t timeoutMs);
+    
+    static void setScl(bool high);
+    static void setSda(bool high);
+    static bool readSda();
+    static void delayMicros(uint32_t micros);
+};
+
+// Holds the bus for a scope, e.g. around Adafruit_SSD1306::display()
+class I2CBusLock {
+public:
+    I2CBusLock(uint8_t address, I2CPriority priority = I2C_PRIORITY_NORMAL)
+        : locked(I2CBus::acquire(address, priority)), bytesWritten(0) {}
+    ~I2CBusLock() { if (locked) I2CBus::release(bytesWritten); }
+    bool isLocked() const { return locked; }
+    // For the statistics, the driver doesn't report what it sent
+    void addBytesWritten(size_t bytes) { bytesWritten += bytes; }
+
+private:
+    bool locked;
+    size_t bytesWritten;
+    I2CBusLock(const I2CBusLock&);
+    I2CBusLock& operator=(const I2CBusLock&);
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "I2CBusStats.h"
+#include <string.h>
+
+// A probe at 400 kHz is ~25 us, a full 128x64 frame at 400 kHz ~25 ms
+static const unsigned long BUCKET_LIMITS[I2CBusStats::LATENCY_BUCKETS - 1] = {
+    50, 100, 250, 500, 1000, 2500, 10000, 25000
+};
+
+I2CBusStats::I2CBusStats() {
+    clear();
+}
+
+void I2CBusStats::clear() {
+    deviceCount = 0;
+    reset(other, 0);
+}
+
+void I2CBusStats::reset(Entry& entry, uint8_t address) {
+    memset(&entry, 0, sizeof(entry));
+    entry.address = address;
+}
+
+int I2CBusStats::find(uint8_t address) const {
+    for (int i = 0; i < deviceCount; i++) {
+        if (devices[i].address == address) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+I2CBusStats::Entry* I2CBusStats::create(uint8_t address) {
+    int index = find(address);
+    if (index >= 0) {
+        return &devices[index];
+    }
+    if (deviceCount >= MAX_DEVICES) {
+        return nullptr;
+    }
+    
+    Entry& entry = devices[deviceCount++];
+    reset(entry, address);
+    return &entry;
+}
+
+void I2CBusStats::record(uint8_t address, I2CProbeResult result, size_t bytesWritten, size_t bytesRead,
+                         unsigned long micros) {
+    Entry* entry;
+    if (result == I2C_PROBE_ACK) {
+        entry = create(address);
+    } else {
+        int index = find(address);
+        entry = index >= 0 ? &devices[index] : nullptr;
+    }
+    if (entry == nullptr) {
+        entry = &other;
+    }
+    
+    entry->transactions++;
+    entry->results[result]++;
+    entry->bytesWritten += bytesWritten;
+    entry->bytesRead += bytesRead;
+    entry->busTimeMicros += micros;
+    if (micros > entry->maxMicros) {
+        entry->maxMicros = micros;
+    }
+    entry->latency[bucketFor(micros)]++;
+}
+
+void I2CBusStats::setClock(uint8_t address, uint32_t clockHz) {
+    Entry* entry = create(address);
+    if (entry != nullptr) {
+        entry->clockHz = clockHz;
+    }
+}
+
+uint32_t I2CBusStats::getClock(uint8_t address) const {
+    int index = find(address);
+    return index >= 0 ? devices[index].clockHz : 0;
+}
+
+unsigned long I2CBusStats::getTransactions() const {
+    unsigned long total = 0;
+    for (int i = 0; i < deviceCount; i++) {
+        total += devices[i].transactions;
+    }
+    return total;
+}
+
+unsigned long I2CBusStats::getErrors() const {
+    unsigned long total = 0;
+    for (int i = 0; i < deviceCount; i++) {
+        total += devices[i].errors();
+    }
+    return total;
+}
+
+uint64_t I2CBusStats::getBusTimeMicros() const {
+    uint64_t total = 0;
+    for (int i = 0; i < deviceCount; i++) {
+        total += devices[i].busTimeMicros;
+    }
+    return total;
+}
+
+unsigned long I2CBusStats::bucketLimit(int bucket) {
+    if (bucket < 0 || bucket >= LATENCY_BUCKETS - 1) {
+        return 0;
+    }
+    return BUCKET_LIMITS[bucket];
+}
+
+int I2CBusStats::bucketFor(unsigned long micros) {
+    for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+        if (micros < BUCKET_LIMITS[i]) {
+            return i;
+        }
+    }
+    return LATENCY_BUCKETS - 1;
+}
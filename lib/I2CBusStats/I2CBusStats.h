@@ -0,0 +1,64 @@
+#ifndef I2CBUSSTATS_H
+#define I2CBUSSTATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "I2CProbe.h"
+
+// Per-address counters for every transaction on the bus: outcome by type,
+// bytes moved, bus time and a latency histogram. Addresses get an entry the
+// first time they answer (or have a clock set), so a sweep of empty
+// addresses lands in one shared "other" entry instead of filling the table.
+// No Arduino dependency; durations are passed in.
+class I2CBusStats {
+public:
+    static const int MAX_DEVICES = 16;
+    static const int LATENCY_BUCKETS = 9;   // Last bucket has no upper bound
+    
+    struct Entry {
+        uint8_t address;
+        uint32_t clockHz;                   // 0 = bus default
+        unsigned long transactions;
+        unsigned long results[I2C_PROBE_RESULT_COUNT];
+        unsigned long bytesWritten;
+        unsigned long bytesRead;
+        uint64_t busTimeMicros;
+        unsigned long maxMicros;
+        unsigned long latency[LATENCY_BUCKETS];
+        
+        unsigned long errors() const { return transactions - results[I2C_PROBE_ACK]; }
+    };
+    
+    I2CBusStats();
+    void clear();
+    
+    void record(uint8_t address, I2CProbeResult result, size_t bytesWritten, size_t bytesRead,
+                unsigned long micros);
+    
+    void setClock(uint8_t address, uint32_t clockHz);
+    uint32_t getClock(uint8_t address) const;
+    
+    int getDeviceCount() const { return deviceCount; }
+    const Entry& getDevice(int index) const { return devices[index]; }
+    const Entry& getOther() const { return other; }
+    
+    // Totals over known devices; the "other" entry is mostly scan NACKs
+    unsigned long getTransactions() const;
+    unsigned long getErrors() const;
+    uint64_t getBusTimeMicros() const;
+    
+    // Upper bound of a latency bucket in microseconds, 0 for the last one
+    static unsigned long bucketLimit(int bucket);
+    static int bucketFor(unsigned long micros);
+
+private:
+    Entry devices[MAX_DEVICES];
+    int deviceCount;
+    Entry other;
+    
+    int find(uint8_t address) const;
+    Entry* create(uint8_t address);
+    static void reset(Entry& entry, uint8_t address);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "I2CProbe.h"
+
+I2CProbeResult I2CProbe::classify(uint8_t wireError) {
+    switch (wireError) {
+        case 0: return I2C_PROBE_ACK;
+        case 2:                          // NACK on address
+        case 3: return I2C_PROBE_NACK;   // NACK on data
+        case 5: return I2C_PROBE_TIMEOUT;
+        default: return I2C_PROBE_BUS_ERROR;
+    }
+}
+
+I2CProbeResult I2CProbe::classify(uint8_t wireError, bool sdaHigh) {
+    I2CProbeResult result = classify(wireError);
+    if ((result == I2C_PROBE_TIMEOUT || result == I2C_PROBE_BUS_ERROR) && !sdaHigh) {
+        return I2C_PROBE_BUS_STUCK;
+    }
+    return result;
+}
+
+const char* I2CProbe::resultToString(I2CProbeResult result) {
+    switch (result) {
+        case I2C_PROBE_ACK: return "ack";
+        case I2C_PROBE_NACK: return "nack";
+        case I2C_PROBE_TIMEOUT: return "timeout";
+        case I2C_PROBE_BUS_ERROR: return "bus_error";
+        case I2C_PROBE_BUS_STUCK: return "bus_stuck";
+        default: return "unknown";
+    }
+}
+
+bool I2CProbe::recoverBus(const I2CLines& lines, uint32_t clockHz) {
+    uint32_t halfPeriod = 500000 / clockHz;
+    if (halfPeriod == 0) halfPeriod = 1;
+    
+    lines.setSda(true);
+    lines.setScl(true);
+    lines.delayMicros(halfPeriod);
+    
+    for (uint8_t pulse = 0; pulse < RECOVERY_PULSES && !lines.readSda(); pulse++) {
+        lines.setScl(false);
+        lines.delayMicros(halfPeriod);
+        lines.setScl(true);
+        lines.delayMicros(halfPeriod);
+    }
+    
+    // STOP: SDA rises while SCL is high, resetting every slave's state machine
+    lines.setScl(false);
+    lines.delayMicros(halfPeriod);
+    lines.setSda(false);
+    lines.delayMicros(halfPeriod);
+    lines.setScl(true);
+    lines.delayMicros(halfPeriod);
+    lines.setSda(true);
+    lines.delayMicros(halfPeriod);
+    
+    return lines.readSda();
+}
+
+void I2CProbeStats::reset() {
+    for (int i = 0; i < I2C_PROBE_RESULT_COUNT; i++) {
+        counts[i] = 0;
+    }
+    recoveries = 0;
+    failedRecoveries = 0;
+}
+
+unsigned long I2CProbeStats::errors() const {
+    return counts[I2C_PROBE_TIMEOUT] + counts[I2C_PROBE_BUS_ERROR] + counts[I2C_PROBE_BUS_STUCK];
+}
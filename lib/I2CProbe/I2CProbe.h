@@ -0,0 +1,56 @@
+#ifndef I2CPROBE_H
+#define I2CPROBE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Outcome of addressing a device, from the ESP32 Wire endTransmission() code
+enum I2CProbeResult : uint8_t {
+    I2C_PROBE_ACK = 0,
+    I2C_PROBE_NACK,        // Nothing at this address (codes 2, 3)
+    I2C_PROBE_TIMEOUT,     // A device stretched SCL past the timeout (code 5)
+    I2C_PROBE_BUS_ERROR,   // Arbitration loss or driver error (codes 1, 4)
+    I2C_PROBE_BUS_STUCK,   // SDA held low, needs recovery
+    I2C_PROBE_RESULT_COUNT
+};
+
+// Raw line access for bus recovery, so the sequence can run against a simulated bus
+struct I2CLines {
+    void (*setScl)(bool high);
+    void (*setSda)(bool high);
+    bool (*readSda)();
+    void (*delayMicros)(uint32_t micros);
+};
+
+class I2CProbe {
+public:
+    static const uint32_t NORMAL_CLOCK = 100000;
+    static const uint16_t NORMAL_TIMEOUT = 50;  // ms, the Wire default
+    static const uint32_t SCAN_CLOCK = 400000;  // Fast mode, the OLED and ATtiny both support it
+    static const uint16_t SCAN_TIMEOUT = 5;     // ms
+    static const uint8_t RECOVERY_PULSES = 9;   // Enough for a slave to finish any byte
+    
+    static I2CProbeResult classify(uint8_t wireError);
+    // As above; a timeout or bus error with SDA still low is a slave stuck
+    // mid-byte. Only meaningful while nobody else can be using the bus.
+    static I2CProbeResult classify(uint8_t wireError, bool sdaHigh);
+    static const char* resultToString(I2CProbeResult result);
+    
+    // Clock SCL until the slave holding SDA lets go, then send a STOP.
+    // True if SDA is high afterwards.
+    static bool recoverBus(const I2CLines& lines, uint32_t clockHz = NORMAL_CLOCK);
+};
+
+// Running counts per probe outcome
+struct I2CProbeStats {
+    unsigned long counts[I2C_PROBE_RESULT_COUNT];
+    unsigned long recoveries;
+    unsigned long failedRecoveries;
+    
+    I2CProbeStats() { reset(); }
+    void reset();
+    void record(I2CProbeResult result) { counts[result]++; }
+    unsigned long errors() const;
+};
+
+#endif
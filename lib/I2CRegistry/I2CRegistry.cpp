@@ -0,0 +1,87 @@
+#include "I2CRegistry.h"
+
+I2CRegistry::I2CRegistry() {
+    clear();
+}
+
+void I2CRegistry::clear() {
+    for (int i = 0; i < 4; i++) {
+        present[i] = 0;
+    }
+    for (int i = 0; i <= LAST_ADDRESS; i++) {
+        lastSeen[i] = 0;
+        lastChange[i] = 0;
+    }
+    deviceCount = 0;
+    changeCount = 0;
+    cursor = FIRST_ADDRESS;
+    sweepCount = 0;
+}
+
+I2CRegistry::Change I2CRegistry::record(uint8_t address, bool found, unsigned long now) {
+    if (address < FIRST_ADDRESS || address > LAST_ADDRESS) {
+        return UNCHANGED;
+    }
+    
+    uint32_t mask = 1UL << (address & 31);
+    bool wasPresent = (present[address >> 5] & mask) != 0;
+    
+    if (found) {
+        lastSeen[address] = now;
+    }
+    
+    if (found == wasPresent) {
+        return UNCHANGED;
+    }
+    
+    if (found) {
+        present[address >> 5] |= mask;
+        deviceCount++;
+    } else {
+        present[address >> 5] &= ~mask;
+        deviceCount--;
+    }
+    
+    lastChange[address] = now;
+    changeCount++;
+    return found ? APPEARED : DISAPPEARED;
+}
+
+bool I2CRegistry::isPresent(uint8_t address) const {
+    if (address > LAST_ADDRESS) {
+        return false;
+    }
+    return (present[address >> 5] & (1UL << (address & 31))) != 0;
+}
+
+unsigned long I2CRegistry::getLastSeen(uint8_t address) const {
+    return address <= LAST_ADDRESS ? lastSeen[address] : 0;
+}
+
+unsigned long I2CRegistry::getLastChange(uint8_t address) const {
+    return address <= LAST_ADDRESS ? lastChange[address] : 0;
+}
+
+int I2CRegistry::nextPresent(int address) const {
+    for (int next = address + 1; next <= LAST_ADDRESS; next++) {
+        // Skip empty words in one step
+        if ((next & 31) == 0 && present[next >> 5] == 0) {
+            next += 31;
+            continue;
+        }
+        if (isPresent(next)) {
+            return next;
+        }
+    }
+    return -1;
+}
+
+bool I2CRegistry::advance() {
+    if (cursor >= LAST_ADDRESS) {
+        cursor = FIRST_ADDRESS;
+        sweepCount++;
+        return true;
+    }
+    cursor++;
+    return false;
+}
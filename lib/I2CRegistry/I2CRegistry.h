@@ -0,0 +1,53 @@
+#ifndef I2CREGISTRY_H
+#define I2CREGISTRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// What the last probe of each 7-bit address found. Lookups are a bitmap
+// test so web handlers and the display never need to touch the bus. The
+// sweep cursor lets the scanner probe a few addresses per loop tick.
+// No Arduino dependency; time is passed in.
+class I2CRegistry {
+public:
+    static const uint8_t FIRST_ADDRESS = 1;
+    static const uint8_t LAST_ADDRESS = 127;
+    
+    enum Change {
+        UNCHANGED,
+        APPEARED,
+        DISAPPEARED
+    };
+    
+    I2CRegistry();
+    
+    Change record(uint8_t address, bool present, unsigned long now);
+    void clear();
+    
+    bool isPresent(uint8_t address) const;
+    // 0 if the address has never answered
+    unsigned long getLastSeen(uint8_t address) const;
+    unsigned long getLastChange(uint8_t address) const;
+    int getDeviceCount() const { return deviceCount; }
+    unsigned long getChangeCount() const { return changeCount; }
+    
+    // Next present address after `address`, or -1. Start with 0.
+    int nextPresent(int address) const;
+    
+    // Incremental sweep: probe getCursor(), then advance(); true when the
+    // sweep wrapped around
+    uint8_t getCursor() const { return cursor; }
+    bool advance();
+    unsigned long getSweepCount() const { return sweepCount; }
+
+private:
+    uint32_t present[4];
+    unsigned long lastSeen[LAST_ADDRESS + 1];
+    unsigned long lastChange[LAST_ADDRESS + 1];
+    int deviceCount;
+    unsigned long changeCount;
+    uint8_t cursor;
+    unsigned long sweepCount;
+};
+
+#endif
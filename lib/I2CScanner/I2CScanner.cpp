@@ -4,6 +4,11 @@
 // Initialize with correct I2C pins
 int I2CScanner::SDA_PIN = 6;  // SDA pin
 int I2CScanner::SCL_PIN = 7;  // SCL pin
+I2CRegistry I2CScanner::registry;
+unsigned long I2CScanner::lastSweepEnd = 0;
+bool I2CScanner::sweeping = true;
+bool I2CScanner::fastProbe = true;
+I2CProbeStats I2CScanner::probeStats;
 
 void I2CScanner::init() {
     init(SDA_PIN, SCL_PIN);
@@ -13,18 +18,43 @@ void I2CScanner::init(int sdaPin, int sclPin) {
     SDA_PIN = sdaPin;
     SCL_PIN = sclPin;
     
-    Wire.begin(SDA_PIN, SCL_PIN);
+    I2CBus::init(SDA_PIN, SCL_PIN);
+    
+    // Different pins, different bus: start the registry over
+    registry.clear();
+    sweeping = true;
     
     Logger::addEntry("I2C initialized on SDA:GPIO" + String(SDA_PIN) + ", SCL:GPIO" + String(SCL_PIN));
 }
 
+void I2CScanner::loop() {
+    unsigned long now = millis();
+    
+    if (!sweeping) {
+        if (now - lastSweepEnd < SWEEP_INTERVAL) {
+            return;
+        }
+        sweeping = true;
+    }
+    
+    for (int i = 0; i < PROBES_PER_TICK; i++) {
+        probe(registry.getCursor());
+        if (registry.advance()) {
+            sweeping = false;
+            lastSweepEnd = now;
+            break;
+        }
+    }
+}
+
 String I2CScanner::scan() {
     Logger::addEntry("Starting I2C bus scan...");
     int deviceCount = 0;
     String result = "I2C Scan Results:\n";
+    unsigned long started = micros();
     
     for (byte address = SCAN_START; address < SCAN_END; address++) {
-        if (testAddress(address)) {
+        if (probe(address)) {
             deviceCount++;
             String deviceInfo = getDeviceInfo(address);
             Logger::addEntry(deviceInfo);
@@ -32,6 +62,8 @@ String I2CScanner::scan() {
         }
     }
     
+    Logger::addEntry("I2C sweep took " + String((micros() - started) / 1000.0, 1) + " ms");
+    
     if (deviceCount == 0) {
         Logger::addEntry("No I2C devices found");
         result = "No I2C devices found";
@@ -52,8 +84,10 @@ String I2CScanner::scanWithDetails() {
     byte commonAddresses[] = {0x3C, 0x3D, 0x27, 0x20, 0x48, 0x68, 0x76, 0x77};
     result += "Testing common addresses first:\n";
     
+    bool tested[SCAN_END] = {false};
     for (byte addr : commonAddresses) {
-        if (testAddress(addr)) {
+        tested[addr] = true;
+        if (probe(addr)) {
             deviceCount++;
             String deviceInfo = getDeviceInfo(addr);
             Logger::addEntry("Common device found: " + deviceInfo);
@@ -61,10 +95,11 @@ String I2CScanner::scanWithDetails() {
         }
     }
     
-    // Full scan
+    // Everything else, each address probed once
     result += "\nFull address scan:\n";
     for (byte address = SCAN_START; address < SCAN_END; address++) {
-        if (testAddress(address)) {
+        if (tested[address]) continue;
+        if (probe(address)) {
             deviceCount++;
             String deviceInfo = getDeviceInfo(address);
             Logger::addEntry(deviceInfo);
@@ -72,6 +107,13 @@ String I2CScanner::scanWithDetails() {
         }
     }
     
+    // Anything other than ACK/NACK points at wiring or a misbehaving device
+    if (probeStats.errors() > 0) {
+        result += "\nProbe errors so far: " + String(probeStats.counts[I2C_PROBE_TIMEOUT]) + " timeout, ";
+        result += String(probeStats.counts[I2C_PROBE_BUS_ERROR]) + " bus error, ";
+        result += String(probeStats.counts[I2C_PROBE_BUS_STUCK]) + " bus stuck\n";
+    }
+    
     if (deviceCount == 0) {
         Logger::addEntry("No I2C devices found");
         result = "No I2C devices found\n\nTroubleshooting tips:\n";
@@ -88,10 +130,100 @@ String I2CScanner::scanWithDetails() {
     return result;
 }
 
-bool I2CScanner::testAddress(byte address) {
-    Wire.beginTransmission(address);
-    byte error = Wire.endTransmission();
-    return (error == 0);
+I2CProbeResult I2CScanner::testAddress(byte address) {
+    // A timeout with SDA still low comes back as BUS_STUCK
+    I2CProbeResult result;
+    if (fastProbe) {
+        result = I2CBus::probe(address, I2CProbe::SCAN_CLOCK, I2CProbe::SCAN_TIMEOUT, I2C_PRIORITY_LOW);
+    } else {
+        result = I2CBus::probe(address, I2CProbe::NORMAL_CLOCK, I2CProbe::NORMAL_TIMEOUT, I2C_PRIORITY_LOW);
+    }
+    
+    probeStats.record(result);
+    
+    if (result == I2C_PROBE_BUS_STUCK) {
+        Logger::addEntry("I2C bus stuck at 0x" + String(address, HEX) + ", recovering");
+        recoverBus();
+    }
+    
+    return result;
+}
+
+bool I2CScanner::probe(byte address) {
+    I2CProbeResult result = testAddress(address);
+    
+    // Errors say nothing about whether the device is there, keep the old entry
+    if (result != I2C_PROBE_ACK && result != I2C_PROBE_NACK) {
+        return registry.isPresent(address);
+    }
+    bool found = (result == I2C_PROBE_ACK);
+    
+    I2CRegistry::Change change = registry.record(address, found, millis());
+    if (change == I2CRegistry::APPEARED) {
+        Logger::addEntry("I2C device appeared at 0x" + String(address, HEX));
+    } else if (change == I2CRegistry::DISAPPEARED) {
+        Logger::addEntry("I2C device disappeared from 0x" + String(address, HEX));
+    }
+    
+    return found;
+}
+
+String I2CScanner::getDeviceList() {
+    if (registry.getDeviceCount() == 0) {
+        return "No I2C devices found";
+    }
+    
+    unsigned long now = millis();
+    String result = "I2C Devices:\n";
+    for (int address = registry.nextPresent(0); address >= 0; address = registry.nextPresent(address)) {
+        result += getDeviceInfo(address);
+        result += ", seen " + String((now - registry.getLastSeen(address)) / 1000) + "s ago\n";
+    }
+    result += "\nTotal devices found: " + String(registry.getDeviceCount());
+    
+    return result;
+}
+
+bool I2CScanner::isPresent(byte address) {
+    return registry.isPresent(address);
+}
+
+unsigned long I2CScanner::getLastSeen(byte address) {
+    return registry.getLastSeen(address);
+}
+
+int I2CScanner::getDeviceCount() {
+    return registry.getDeviceCount();
+}
+
+const I2CRegistry& I2CScanner::getRegistry() {
+    return registry;
+}
+
+void I2CScanner::setFastProbe(bool enabled) {
+    fastProbe = enabled;
+}
+
+bool I2CScanner::isFastProbe() {
+    return fastProbe;
+}
+
+const I2CProbeStats& I2CScanner::getProbeStats() {
+    return probeStats;
+}
+
+bool I2CScanner::recoverBus() {
+    bool recovered = I2CBus::recover();
+    
+    if (recovered) {
+        probeStats.recoveries++;
+        Logger::addEntry("I2C bus recovered");
+    } else {
+        probeStats.failedRecoveries++;
+        Logger::addEntry("I2C bus recovery failed, SDA still held low");
+    }
+    
+    return recovered;
 }
 
 void I2CScanner::sendCommand(byte command) {
@@ -102,26 +234,35 @@ void I2CScanner::sendCommand(byte command) {
 String I2CScanner::getDeviceInfo(byte address) {
     String deviceInfo = "I2C device found at address 0x" + String(address, HEX) + " (0x" + String(address, HEX) + ")";
     
+    String type = getDeviceType(address);
+    if (type.length() > 0) {
+        deviceInfo += " - Likely " + type;
+    }
+    
+    return deviceInfo;
+}
+
+String I2CScanner::getDeviceType(byte address) {
     // Try to identify common devices
     if (address == 0x3C || address == 0x3D) {
-        deviceInfo += " - Likely OLED Display";
+        return "OLED Display";
     } else if (address == 0x48) {
-        deviceInfo += " - Likely ADS1115 ADC";
+        return "ADS1115 ADC";
     } else if (address == 0x68) {
-        deviceInfo += " - Likely RTC (DS3231/DS1307)";
+        return "RTC (DS3231/DS1307)";
     } else if (address == 0x76 || address == 0x77) {
-        deviceInfo += " - Likely BME280/BMP280";
+        return "BME280/BMP280";
     } else if (address == 0x39 || address == 0x29) {
-        deviceInfo += " - Likely TCS3200/TCS230";
+        return "TCS3200/TCS230";
     } else if (address == 0x23 || address == 0x5C) {
-        deviceInfo += " - Likely BH1750 Light Sensor";
+        return "BH1750 Light Sensor";
     } else if (address == 0x27) {
-        deviceInfo += " - Likely LCD Display (PCF8574)";
+        return "LCD Display (PCF8574)";
     } else if (address == 0x20) {
-        deviceInfo += " - Likely I/O Expander (MCP23008)";
+        return "I/O Expander (MCP23008)";
     } else if (address == 0x50) {
-        deviceInfo += " - Likely EEPROM (24C32/24C64)";
+        return "EEPROM (24C32/24C64)";
     }
     
-    return deviceInfo;
+    return "";
 }
@@ -3,13 +3,42 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "I2CRegistry.h"
+#include "I2CProbe.h"
+#include "I2CBus.h"
 
 class I2CScanner {
 public:
+    static const int PROBES_PER_TICK = 4;
+    static const unsigned long SWEEP_INTERVAL = 10000; // Pause between background sweeps
+    
     static void init();
     static void init(int sdaPin, int sclPin);
+    
+    // Background sweep, a few addresses per call
+    static void loop();
+    
+    // Explicit full rescans, these block for the whole sweep
     static String scan();
     static String scanWithDetails();
+    
+    // Registry reads, no bus traffic
+    static String getDeviceList();
+    static bool isPresent(byte address);
+    static unsigned long getLastSeen(byte address);
+    static int getDeviceCount();
+    static const I2CRegistry& getRegistry();
+    static String getDeviceType(byte address);
+    
+    // Scan probes run at a raised clock and short timeout, at low priority,
+    // so a sweep holds the shared bus for as little time as possible
+    static void setFastProbe(bool enabled);
+    static bool isFastProbe();
+    static const I2CProbeStats& getProbeStats();
+    
+    // Clock SCL until a stuck slave releases SDA, then reinitialise Wire
+    static bool recoverBus();
+    
     static void sendCommand(byte command);
     
 private:
@@ -17,8 +46,16 @@ private:
     static int SCL_PIN;
     static const int SCAN_START = 1;
     static const int SCAN_END = 128;
+    static I2CRegistry registry;
+    static unsigned long lastSweepEnd;
+    static bool sweeping;
+    
+    static bool fastProbe;
+    static I2CProbeStats probeStats;
+    
     static String getDeviceInfo(byte address);
-    static bool testAddress(byte address);
+    static I2CProbeResult testAddress(byte address);
+    static bool probe(byte address);
 };
 
 #endif
@@ -1,50 +1,185 @@
 #include "LEDController.h"
 
 CRGB LEDController::leds[NUM_LEDS];
+LightState LEDController::lightState;
+unsigned long LEDController::lastEffectFrame = 0;
+uint8_t LEDController::effectHue = 0;
+unsigned long LEDController::frameCount = 0;
+CRGB LEDController::indicatorColors[MAX_INDICATOR_STEPS];
+uint8_t LEDController::indicatorSteps = 0;
+int LEDController::indicatorShown = -1;
+unsigned long LEDController::indicatorStepTime = 0;
+unsigned long LEDController::indicatorStarted = 0;
+bool LEDController::indicatorActive = false;
 
 void LEDController::init() {
     FastLED.addLeds<WS2812B, LED_PIN, GRB>(leds, NUM_LEDS);
     FastLED.setBrightness(BRIGHTNESS);
 }
 
+void LEDController::loop() {
+    unsigned long now = millis();
+    
+    if (indicatorActive) {
+        updateIndicator(now);
+        return;
+    }
+    
+    if (!lightState.on || lightState.effect == LIGHT_EFFECT_NONE) {
+        return;
+    }
+    
+    if (now - lastEffectFrame < EFFECT_INTERVAL) {
+        return;
+    }
+    lastEffectFrame = now;
+    
+    effectHue++;
+    render();
+}
+
 void LEDController::setColor(CRGB color) {
+    indicatorActive = false;
     leds[0] = color;
-    FastLED.show();
+    show();
 }
 
 void LEDController::setColorByName(String colorName) {
-    if (colorName == "red") setColor(CRGB::Red);
-    else if (colorName == "green") setColor(CRGB::Green);
-    else if (colorName == "blue") setColor(CRGB::Blue);
-    else if (colorName == "yellow") setColor(CRGB::Yellow);
-    else if (colorName == "purple") setColor(CRGB::Purple);
-    else if (colorName == "cyan") setColor(CRGB::Cyan);
-    else if (colorName == "white") setColor(CRGB::White);
-    else if (colorName == "off") setColor(CRGB::Black);
+    CRGB color;
+    if (colorName == "red") color = CRGB::Red;
+    else if (colorName == "green") color = CRGB::Green;
+    else if (colorName == "blue") color = CRGB::Blue;
+    else if (colorName == "yellow") color = CRGB::Yellow;
+    else if (colorName == "purple") color = CRGB::Purple;
+    else if (colorName == "cyan") color = CRGB::Cyan;
+    else if (colorName == "white") color = CRGB::White;
+    else if (colorName == "off") color = CRGB::Black;
+    else return;
+    
+    // Keep the Home Assistant light in step with local changes
+    LightState state = lightState;
+    state.on = (colorName != "off");
+    if (state.on) {
+        state.colorMode = LIGHT_MODE_RGB;
+        state.red = color.r;
+        state.green = color.g;
+        state.blue = color.b;
+        state.effect = LIGHT_EFFECT_NONE;
+    }
+    applyLightState(state);
+}
+
+void LEDController::setBrightness(uint8_t brightness) {
+    FastLED.setBrightness(brightness);
+    show();
+}
+
+void LEDController::applyLightState(const LightState& state) {
+    lightState = state;
+    render();
+}
+
+const LightState& LEDController::getLightState() {
+    return lightState;
+}
+
+void LEDController::render() {
+    // The state is applied once the indication is over
+    if (indicatorActive) {
+        return;
+    }
+    
+    CRGB color = CRGB::Black;
+    
+    if (lightState.on) {
+        switch (lightState.effect) {
+            case LIGHT_EFFECT_RAINBOW:
+                color = CHSV(effectHue, 255, 255);
+                break;
+            case LIGHT_EFFECT_PULSE:
+                color = lightState.colorMode == LIGHT_MODE_COLOR_TEMP ? colorTempToRGB(lightState.colorTemp)
+                                                                      : CRGB(lightState.red, lightState.green, lightState.blue);
+                color.nscale8_video(sin8(effectHue));
+                break;
+            default:
+                color = lightState.colorMode == LIGHT_MODE_COLOR_TEMP ? colorTempToRGB(lightState.colorTemp)
+                                                                      : CRGB(lightState.red, lightState.green, lightState.blue);
+                break;
+        }
+        color.nscale8_video(lightState.brightness);
+    }
+    
+    leds[0] = color;
+    show();
+}
+
+CRGB LEDController::colorTempToRGB(uint16_t mireds) {
+    // Linear blend between the warm and cool ends of the supported range,
+    // close enough for a single status pixel
+    if (mireds < LightState::MIN_MIREDS) mireds = LightState::MIN_MIREDS;
+    if (mireds > LightState::MAX_MIREDS) mireds = LightState::MAX_MIREDS;
+    uint8_t warmth = (uint32_t)(mireds - LightState::MIN_MIREDS) * 255 / (LightState::MAX_MIREDS - LightState::MIN_MIREDS);
+    
+    CRGB cool(201, 226, 255);
+    CRGB warm(255, 147, 41);
+    return blend(cool, warm, warmth);
+}
+
+unsigned long LEDController::getFrameCount() {
+    return frameCount;
+}
+
+void LEDController::show() {
+    FastLED.show();
+    frameCount++;
 }
 
 void LEDController::startupSequence() {
-    setColor(CRGB::Red);
-    delay(500);
-    setColor(CRGB::Green);
-    delay(500);
-    setColor(CRGB::Blue);
-    delay(500);
-    setColor(CRGB::Black);
+    const CRGB colors[] = { CRGB::Red, CRGB::Green, CRGB::Blue };
+    startIndicator(colors, 3, STARTUP_STEP);
 }
 
 void LEDController::wifiConfigMode() {
+    // Stays blue while the config portal runs
     setColor(CRGB::Blue);
 }
 
 void LEDController::wifiConnected() {
-    setColor(CRGB::Green);
-    delay(1000);
-    setColor(CRGB::Black);
+    const CRGB colors[] = { CRGB::Green };
+    startIndicator(colors, 1, STATUS_FLASH);
 }
 
 void LEDController::wifiFailed() {
-    setColor(CRGB::Red);
-    delay(1000);
-    setColor(CRGB::Black);
+    const CRGB colors[] = { CRGB::Red };
+    startIndicator(colors, 1, STATUS_FLASH);
+}
+
+void LEDController::startIndicator(const CRGB* colors, uint8_t steps, unsigned long stepTime) {
+    if (steps > MAX_INDICATOR_STEPS) {
+        steps = MAX_INDICATOR_STEPS;
+    }
+    for (uint8_t i = 0; i < steps; i++) {
+        indicatorColors[i] = colors[i];
+    }
+    indicatorSteps = steps;
+    indicatorStepTime = stepTime;
+    indicatorStarted = millis();
+    indicatorShown = -1;
+    indicatorActive = true;
+    updateIndicator(indicatorStarted);
+}
+
+void LEDController::updateIndicator(unsigned long now) {
+    unsigned long step = (now - indicatorStarted) / indicatorStepTime;
+    if (step >= indicatorSteps) {
+        indicatorActive = false;
+        render();
+        return;
+    }
+    
+    if ((int)step != indicatorShown) {
+        indicatorShown = step;
+        leds[0] = indicatorColors[step];
+        show();
+    }
 }
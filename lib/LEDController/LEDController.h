@@ -3,24 +3,53 @@
 
 #include <Arduino.h>
 #include <FastLED.h>
+#include "LightState.h"
 
 class LEDController {
 public:
     static const int NUM_LEDS = 1;
     static const int LED_PIN = 8;
     static const int BRIGHTNESS = 128;
+    static const unsigned long EFFECT_INTERVAL = 20; // ms between effect frames
+    static const unsigned long STARTUP_STEP = 150;    // ms per colour of the startup sequence
+    static const unsigned long STATUS_FLASH = 1000;   // ms for WiFi status flashes
     
     static void init();
+    static void loop();
     static void setColor(CRGB colour);
     static void setColorByName(String colourName);
     static void setBrightness(uint8_t brightness);
+    // Status indications play from loop() and never block; the light
+    // state is restored when they finish
     static void startupSequence();
     static void wifiConfigMode();
     static void wifiConnected();
     static void wifiFailed();
     
+    // Home Assistant light entity
+    static void applyLightState(const LightState& state);
+    static const LightState& getLightState();
+    static unsigned long getFrameCount();
+    
 private:
     static CRGB leds[NUM_LEDS];
+    static LightState lightState;
+    static unsigned long lastEffectFrame;
+    static uint8_t effectHue;
+    static unsigned long frameCount;
+    
+    static const int MAX_INDICATOR_STEPS = 3;
+    static CRGB indicatorColors[MAX_INDICATOR_STEPS];
+    static uint8_t indicatorSteps;
+    static int indicatorShown;
+    static unsigned long indicatorStepTime;
+    static unsigned long indicatorStarted;
+    static bool indicatorActive;
+    
+    static void startIndicator(const CRGB* colors, uint8_t steps, unsigned long stepTime);
+    static void updateIndicator(unsigned long now);
+    static void render();
+    static CRGB colorTempToRGB(uint16_t mireds);
     static void show();
 };
 
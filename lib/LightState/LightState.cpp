@@ -0,0 +1,89 @@
+#include "LightState.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* const EFFECT_NAMES[LIGHT_EFFECT_COUNT] = {
+    "none",
+    "rainbow",
+    "pulse"
+};
+
+LightState::LightState()
+    : on(false), brightness(255), colorMode(LIGHT_MODE_RGB), red(255), green(255), blue(255),
+      colorTemp(370), effect(LIGHT_EFFECT_NONE) {
+}
+
+bool LightState::operator==(const LightState& other) const {
+    return on == other.on && brightness == other.brightness && colorMode == other.colorMode &&
+           red == other.red && green == other.green && blue == other.blue &&
+           colorTemp == other.colorTemp && effect == other.effect;
+}
+
+size_t LightState::toJson(char* out, size_t capacity) const {
+    int written;
+    
+    if (colorMode == LIGHT_MODE_COLOR_TEMP) {
+        written = snprintf(out, capacity,
+                           "{\"state\":\"%s\",\"brightness\":%u,\"color_mode\":\"color_temp\",\"color_temp\":%u,\"effect\":\"%s\"}",
+                           on ? "ON" : "OFF", brightness, colorTemp, effectName(effect));
+    } else {
+        written = snprintf(out, capacity,
+                           "{\"state\":\"%s\",\"brightness\":%u,\"color_mode\":\"rgb\",\"color\":{\"r\":%u,\"g\":%u,\"b\":%u},\"effect\":\"%s\"}",
+                           on ? "ON" : "OFF", brightness, red, green, blue, effectName(effect));
+    }
+    
+    if (written < 0 || (size_t)written >= capacity) {
+        return 0;
+    }
+    return written;
+}
+
+const char* LightState::effectName(uint8_t effect) {
+    if (effect >= LIGHT_EFFECT_COUNT) {
+        return EFFECT_NAMES[LIGHT_EFFECT_NONE];
+    }
+    return EFFECT_NAMES[effect];
+}
+
+int LightState::effectFromName(const char* name) {
+    for (int i = 0; i < LIGHT_EFFECT_COUNT; i++) {
+        if (strcmp(name, EFFECT_NAMES[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+LightStatePublisher::LightStatePublisher(unsigned long minInterval)
+    : minInterval(minInterval), hasPublished(false), lastPublish(0), updateCount(0), publishCount(0) {
+}
+
+void LightStatePublisher::update(const LightState& state) {
+    if (state == current) {
+        return;
+    }
+    current = state;
+    updateCount++;
+}
+
+bool LightStatePublisher::poll(unsigned long now, LightState& out) {
+    if (hasPublished && current == published) {
+        return false;
+    }
+    
+    if (hasPublished && now - lastPublish < minInterval) {
+        return false;
+    }
+    
+    published = current;
+    hasPublished = true;
+    lastPublish = now;
+    publishCount++;
+    
+    out = current;
+    return true;
+}
+
+void LightStatePublisher::invalidate() {
+    hasPublished = false;
+}
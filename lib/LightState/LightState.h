@@ -0,0 +1,78 @@
+#ifndef LIGHTSTATE_H
+#define LIGHTSTATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Home Assistant light state (JSON schema). No Arduino dependency so the
+// publish coalescing can be exercised in the native test environment.
+
+enum LightColorMode : uint8_t {
+    LIGHT_MODE_RGB = 0,
+    LIGHT_MODE_COLOR_TEMP = 1
+};
+
+enum LightEffect : uint8_t {
+    LIGHT_EFFECT_NONE = 0,
+    LIGHT_EFFECT_RAINBOW = 1,
+    LIGHT_EFFECT_PULSE = 2,
+    LIGHT_EFFECT_COUNT = 3
+};
+
+struct LightState {
+    static const uint16_t MIN_MIREDS = 153;  // ~6500K
+    static const uint16_t MAX_MIREDS = 500;  // 2000K
+    
+    bool on;
+    uint8_t brightness;
+    LightColorMode colorMode;
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint16_t colorTemp; // mireds
+    uint8_t effect;
+    
+    LightState();
+    
+    bool operator==(const LightState& other) const;
+    bool operator!=(const LightState& other) const { return !(*this == other); }
+    
+    // {"state":"ON","brightness":..,"color_mode":..,"color":{..},"color_temp":..,"effect":..}
+    // Returns the length written, or 0 if it didn't fit
+    size_t toJson(char* out, size_t capacity) const;
+    
+    static const char* effectName(uint8_t effect);
+    static int effectFromName(const char* name); // -1 if unknown
+};
+
+// Publishes the latest state at most once per interval, and only when it
+// differs from what the broker last saw. A slider drag in Home Assistant
+// sends a command every few tens of milliseconds; this collapses them into
+// a handful of state messages that always end on the final value.
+class LightStatePublisher {
+public:
+    explicit LightStatePublisher(unsigned long minInterval);
+    
+    // Cheap when unchanged, so it can be called every loop
+    void update(const LightState& state);
+    
+    // True if `out` should be published now; the caller must publish it
+    bool poll(unsigned long now, LightState& out);
+    
+    // Forget what was published, e.g. after a reconnect
+    void invalidate();
+    
+    unsigned long getUpdateCount() const { return updateCount; }
+    unsigned long getPublishCount() const { return publishCount; }
+
+private:
+    unsigned long minInterval;
+    LightState current;
+    LightState published;
+    bool hasPublished;
+    unsigned long lastPublish;
+    unsigned long updateCount;
+    unsigned long publishCount;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "Logger.h"
+#include "HeapTracker.h"
 
 String Logger::logEntries[MAX_LOG_ENTRIES];
 int Logger::logIndex = 0;
@@ -10,6 +11,7 @@ void Logger::init() {
 }
 
 void Logger::addEntry(String message) {
+    HeapScope heapScope(HEAP_MODULE_LOGGER);
     String timestamp = "[" + String(millis() / 1000) + "s]";
     String logEntry = timestamp + " " + message;
     
@@ -0,0 +1,67 @@
+#include "LzssDecoder.h"
+
+static const uint8_t LITERAL_BITS = 1 + 8;
+static const uint8_t COPY_BITS = 1 + LzssDecoder::WINDOW_BITS + LzssDecoder::LENGTH_BITS;
+
+LzssDecoder::LzssDecoder() {
+    reset();
+}
+
+void LzssDecoder::reset() {
+    bitBuffer = 0;
+    bitCount = 0;
+    copyDistance = 0;
+    copyRemaining = 0;
+    produced = 0;
+    error = false;
+}
+
+size_t LzssDecoder::decode(const uint8_t* in, size_t inLength, size_t& consumed, uint8_t* out, size_t outCapacity) {
+    consumed = 0;
+    size_t written = 0;
+    
+    while (!error && written < outCapacity) {
+        if (copyRemaining > 0) {
+            uint8_t value = window[(produced - copyDistance) & (WINDOW_SIZE - 1)];
+            window[produced & (WINDOW_SIZE - 1)] = value;
+            produced++;
+            out[written++] = value;
+            copyRemaining--;
+            continue;
+        }
+        
+        // Up to 24 bits buffered, enough for the longest token
+        while (bitCount <= 16 && consumed < inLength) {
+            bitBuffer = (bitBuffer << 8) | in[consumed++];
+            bitCount += 8;
+        }
+        if (bitCount < LITERAL_BITS) {
+            break;
+        }
+        
+        if ((bitBuffer >> (bitCount - 1)) & 1) {
+            uint8_t value = (bitBuffer >> (bitCount - LITERAL_BITS)) & 0xFF;
+            bitCount -= LITERAL_BITS;
+            window[produced & (WINDOW_SIZE - 1)] = value;
+            produced++;
+            out[written++] = value;
+            continue;
+        }
+        
+        if (bitCount < COPY_BITS) {
+            break;
+        }
+        uint16_t distance = ((bitBuffer >> (bitCount - 1 - WINDOW_BITS)) & (WINDOW_SIZE - 1)) + 1;
+        uint8_t length = ((bitBuffer >> (bitCount - COPY_BITS)) & ((1 << LENGTH_BITS) - 1)) + MIN_MATCH;
+        bitCount -= COPY_BITS;
+        
+        if (distance > produced) {
+            error = true;
+            break;
+        }
+        copyDistance = distance;
+        copyRemaining = length;
+    }
+    
+    return written;
+}
@@ -0,0 +1,45 @@
+#ifndef LZSSDECODER_H
+#define LZSSDECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Streaming LZSS decoder for compressed firmware payloads, written by
+// create_firmware_package.py --compress. The stream is a sequence of
+// tokens, most significant bit first:
+//
+//   1 [byte:8]                          literal
+//   0 [distance - 1:9] [length - 2:4]   copy 2-17 bytes from up to 512 back
+//
+// followed by fewer than 8 zero bits of padding; the caller knows the
+// decoded length. All state is in the object (about 530 bytes), no heap.
+class LzssDecoder {
+public:
+    static const uint8_t WINDOW_BITS = 9;
+    static const uint8_t LENGTH_BITS = 4;
+    static const size_t WINDOW_SIZE = 1 << WINDOW_BITS;
+    static const uint8_t MIN_MATCH = 2;
+    
+    LzssDecoder();
+    void reset();
+    
+    // Decodes until the input is used up or out is full, whichever comes
+    // first; consumed is set to the input bytes taken. Returns the bytes
+    // written. Call again with more input or more space to continue.
+    size_t decode(const uint8_t* in, size_t inLength, size_t& consumed, uint8_t* out, size_t outCapacity);
+    
+    // A copy reaching back before the start of the stream
+    bool failed() const { return error; }
+    uint32_t getOutputLength() const { return produced; }
+
+private:
+    uint8_t window[WINDOW_SIZE];
+    uint32_t bitBuffer;
+    uint8_t bitCount;
+    uint16_t copyDistance;
+    uint8_t copyRemaining;
+    uint32_t produced;
+    bool error;
+};
+
+#endif
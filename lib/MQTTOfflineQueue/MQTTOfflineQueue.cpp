@@ -0,0 +1,95 @@
+#include "MQTTOfflineQueue.h"
+#include <string.h>
+
+MQTTOfflineQueue::MQTTOfflineQueue()
+    : count(0), nextSequence(0), queuedCount(0), replacedCount(0), droppedCount(0), flushedCount(0) {
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        entries[i].used = false;
+    }
+}
+
+MQTTOfflineQueue::Result MQTTOfflineQueue::push(const char* topic, const char* payload, size_t length, uint8_t qos, bool retain) {
+    if (strlen(topic) >= MAX_TOPIC || length >= MAX_PAYLOAD) {
+        droppedCount++;
+        return TOO_LARGE;
+    }
+    
+    Result result = QUEUED;
+    int slot = find(topic);
+    
+    if (slot >= 0) {
+        // Newer value for a queued topic: overwrite in place, keep its position
+        result = REPLACED;
+        replacedCount++;
+    } else {
+        if (count == MAX_ENTRIES) {
+            slot = oldest();
+            entries[slot].used = false;
+            count--;
+            droppedCount++;
+            result = EVICTED;
+        } else {
+            for (slot = 0; entries[slot].used; slot++) {
+            }
+        }
+        
+        Entry& entry = entries[slot];
+        entry.used = true;
+        entry.sequence = nextSequence++;
+        strcpy(entry.topic, topic);
+        count++;
+    }
+    
+    Entry& entry = entries[slot];
+    entry.qos = qos;
+    entry.retain = retain;
+    entry.length = length;
+    memcpy(entry.payload, payload, length);
+    entry.payload[length] = '\0';
+    
+    queuedCount++;
+    return result;
+}
+
+const MQTTOfflineQueue::Entry* MQTTOfflineQueue::peek() const {
+    int slot = oldest();
+    return slot >= 0 ? &entries[slot] : nullptr;
+}
+
+void MQTTOfflineQueue::pop() {
+    int slot = oldest();
+    if (slot < 0) {
+        return;
+    }
+    
+    entries[slot].used = false;
+    count--;
+    flushedCount++;
+}
+
+void MQTTOfflineQueue::clear() {
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        entries[i].used = false;
+    }
+    count = 0;
+}
+
+int MQTTOfflineQueue::find(const char* topic) const {
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        if (entries[i].used && strcmp(entries[i].topic, topic) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int MQTTOfflineQueue::oldest() const {
+    int slot = -1;
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        // Sequence numbers are compared by difference so wraparound is harmless
+        if (entries[i].used && (slot < 0 || (int32_t)(entries[i].sequence - entries[slot].sequence) < 0)) {
+            slot = i;
+        }
+    }
+    return slot;
+}
@@ -0,0 +1,65 @@
+#ifndef MQTTOFFLINEQUEUE_H
+#define MQTTOFFLINEQUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Publishes held while the broker is unreachable. Only the latest value per
+// topic is kept, so a reconnect sends current state rather than replaying
+// history. When full, a new topic evicts the oldest entry. Fixed storage, no
+// heap, no Arduino dependency.
+class MQTTOfflineQueue {
+public:
+    static const int MAX_ENTRIES = 8;
+    static const size_t MAX_TOPIC = 128;     // Including terminator
+    static const size_t MAX_PAYLOAD = 512;   // Including terminator, fits a telemetry batch
+    
+    enum Result {
+        QUEUED,
+        REPLACED,
+        EVICTED,     // Queued, but the oldest entry was dropped to make room
+        TOO_LARGE
+    };
+    
+    struct Entry {
+        bool used;
+        bool retain;
+        uint8_t qos;
+        uint32_t sequence;
+        uint16_t length;
+        char topic[MAX_TOPIC];
+        char payload[MAX_PAYLOAD];
+    };
+    
+    MQTTOfflineQueue();
+    
+    Result push(const char* topic, const char* payload, size_t length, uint8_t qos, bool retain);
+    
+    // Oldest entry, or nullptr when empty. Call pop() once it has been sent.
+    const Entry* peek() const;
+    void pop();
+    void clear();
+    
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    
+    unsigned long getQueuedCount() const { return queuedCount; }
+    unsigned long getReplacedCount() const { return replacedCount; }
+    unsigned long getDroppedCount() const { return droppedCount; }
+    unsigned long getFlushedCount() const { return flushedCount; }
+
+private:
+    Entry entries[MAX_ENTRIES];
+    int count;
+    uint32_t nextSequence;
+    
+    unsigned long queuedCount;
+    unsigned long replacedCount;
+    unsigned long droppedCount;
+    unsigned long flushedCount;
+    
+    int find(const char* topic) const;
+    int oldest() const;
+};
+
+#endif
@@ -1,17 +1,42 @@
 #include "OLEDManager.h"
 #include "Logger.h"
+#include "I2CScanner.h"
 #include <WiFi.h>
 
 // Static member initialization
 Adafruit_SSD1306* OLEDManager::display = nullptr;
 bool OLEDManager::available = false;
 unsigned long OLEDManager::lastUpdate = 0;
+ScreenModel OLEDManager::screen;
+bool OLEDManager::defaultScreenActive = false;
+int OLEDManager::uptimeWidget = -1;
+int OLEDManager::wifiWidget = -1;
+int OLEDManager::ipWidget = -1;
+int OLEDManager::signalWidget = -1;
+bool OLEDManager::shadowValid = false;
+FrameSpan OLEDManager::spans[FrameDiff::MAX_SPANS];
+int OLEDManager::spanCount = 0;
+TaskHandle_t OLEDManager::flushTask = nullptr;
+volatile bool OLEDManager::flushBusy = false;
+bool OLEDManager::flushPending = false;
+unsigned long OLEDManager::lastHandoffMicros = 0;
+volatile unsigned long OLEDManager::lastFlushMicros = 0;
+volatile unsigned long OLEDManager::flushCount = 0;
+unsigned long OLEDManager::coalescedCount = 0;
 
 // OLED display settings
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define OLED_RESET -1
 #define SCREEN_ADDRESS 0x3C
+#define SCREEN_CLOCK 400000
+#define SCREEN_PAGES (SCREEN_HEIGHT / 8)
+#define LINE_HEIGHT 8
+#define DATA_CHUNK 64   // Data bytes per I2C write, well inside the Wire buffer
+#define FLUSH_TASK_STACK 3072
+
+uint8_t OLEDManager::front[SCREEN_WIDTH * SCREEN_PAGES];
+uint8_t OLEDManager::shadow[SCREEN_WIDTH * SCREEN_PAGES];
 
 bool OLEDManager::init() {
     if (available) {
@@ -21,10 +46,7 @@ bool OLEDManager::init() {
     Logger::addEntry("Initializing OLED display...");
     
     // Check if OLED is present at address 0x3C
-    Wire.beginTransmission(SCREEN_ADDRESS);
-    byte error = Wire.endTransmission();
-    
-    if (error != 0) {
+    if (I2CBus::probe(SCREEN_ADDRESS, 0, 0, I2C_PRIORITY_NORMAL) != I2C_PROBE_ACK) {
         Logger::addEntry("OLED not detected at address 0x3C");
         return false;
     }
@@ -32,22 +54,37 @@ bool OLEDManager::init() {
     Logger::addEntry("OLED detected at address 0x3C, initializing...");
     
     // Create display object
-    display = new Adafruit_SSD1306(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
-    
-    if (!display->begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
+    // The driver runs its transfers at SCREEN_CLOCK; I2CBus owns Wire, so
+    // begin() must not reinitialise the peripheral
+    display = new Adafruit_SSD1306(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET, SCREEN_CLOCK, I2CBus::DEFAULT_CLOCK);
+    I2CBus::setDeviceClock(SCREEN_ADDRESS, SCREEN_CLOCK);
+    
+    bool started;
+    {
+        I2CBusLock lock(SCREEN_ADDRESS);
+        started = lock.isLocked() && display->begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS, true, false);
+    }
+    if (!started) {
         Logger::addEntry("Failed to initialize OLED display");
         delete display;
         display = nullptr;
         return false;
     }
     
+    // Without the task, frames are streamed inline from flush()
+    if (flushTask == nullptr &&
+        xTaskCreate(flushTaskMain, "oled_flush", FLUSH_TASK_STACK, nullptr, 1, &flushTask) != pdPASS) {
+        flushTask = nullptr;
+        Logger::addEntry("OLED flush task not started, flushing on the main loop");
+    }
+    
     // Clear display and show startup message
     display->clearDisplay();
     display->setTextSize(1);
     display->setTextColor(SSD1306_WHITE);
     display->setCursor(0, 0);
     display->println("ESP32 Starting...");
-    display->display();
+    flush();
     
     available = true;
     lastUpdate = millis();
@@ -62,59 +99,76 @@ bool OLEDManager::isAvailable() {
 
 void OLEDManager::clear() {
     if (isAvailable()) {
+        defaultScreenActive = false;
         display->clearDisplay();
-        display->display();
+        flush();
     }
 }
 
 void OLEDManager::showStatus(const String& status) {
     if (!isAvailable()) return;
     
+    defaultScreenActive = false;
     display->clearDisplay();
     drawHeader();
     drawStatus(status);
-    display->display();
+    flush();
 }
 
 void OLEDManager::showSystemInfo() {
     if (!isAvailable()) return;
     
+    defaultScreenActive = false;
     display->clearDisplay();
     drawHeader();
     drawSystemInfo();
-    display->display();
+    flush();
 }
 
 void OLEDManager::showWiFiInfo() {
     if (!isAvailable()) return;
     
+    defaultScreenActive = false;
     display->clearDisplay();
     drawHeader();
     drawWiFiInfo();
-    display->display();
+    flush();
 }
 
 void OLEDManager::showI2CInfo() {
     if (!isAvailable()) return;
     
+    defaultScreenActive = false;
     display->clearDisplay();
     drawHeader();
     drawI2CInfo();
-    display->display();
+    flush();
 }
 
 void OLEDManager::showDefaultDisplay() {
     if (!isAvailable()) return;
     
-    display->clearDisplay();
-    drawHeader();
-    drawDefaultInfo();
-    display->display();
+    // Lay the screen out once, after that only widget values change
+    if (!defaultScreenActive) {
+        display->clearDisplay();
+        drawHeader();
+        buildDefaultScreen();
+        defaultScreenActive = true;
+    }
+    
+    updateDefaultWidgets();
+    drawWidgets();
+    flush();
 }
 
 void OLEDManager::updateDisplay() {
     if (!isAvailable()) return;
     
+    // Send the frame that was drawn while the last one was still streaming
+    if (flushPending && !flushBusy) {
+        flush();
+    }
+    
     // Only update every UPDATE_INTERVAL milliseconds
     if (millis() - lastUpdate < UPDATE_INTERVAL) {
         return;
@@ -126,6 +180,132 @@ void OLEDManager::updateDisplay() {
     showDefaultDisplay();
 }
 
+void OLEDManager::flush() {
+    // Still streaming the previous frame: the back buffer keeps the newest
+    // drawing and updateDisplay() hands it over once the task is done
+    if (flushBusy) {
+        if (!flushPending) {
+            coalescedCount++;
+        }
+        flushPending = true;
+        return;
+    }
+    flushPending = false;
+    
+    unsigned long started = micros();
+    memcpy(front, display->getBuffer(), sizeof(front));
+    
+    if (shadowValid) {
+        spanCount = FrameDiff::diff(front, shadow, SCREEN_WIDTH, SCREEN_PAGES, spans, FrameDiff::MAX_SPANS);
+    } else {
+        spanCount = -1;
+    }
+    
+    // Unknown panel contents, or changed all over: send every page whole
+    if (spanCount < 0) {
+        for (int page = 0; page < SCREEN_PAGES; page++) {
+            spans[page].page = page;
+            spans[page].firstColumn = 0;
+            spans[page].lastColumn = SCREEN_WIDTH - 1;
+        }
+        spanCount = SCREEN_PAGES;
+    }
+    
+    if (spanCount == 0) {
+        lastHandoffMicros = micros() - started;
+        return;
+    }
+    
+    flushBusy = true;
+    if (flushTask != nullptr) {
+        xTaskNotifyGive(flushTask);
+    } else {
+        streamFrame();
+    }
+    lastHandoffMicros = micros() - started;
+}
+
+void OLEDManager::streamFrame() {
+    unsigned long started = micros();
+    bool ok = true;
+    
+    for (int i = 0; i < spanCount && ok; i++) {
+        ok = sendSpan(front, spans[i]);
+        if (ok) {
+            int offset = spans[i].page * SCREEN_WIDTH + spans[i].firstColumn;
+            memcpy(shadow + offset, front + offset, spans[i].lastColumn - spans[i].firstColumn + 1);
+        }
+    }
+    
+    // Unknown what the panel holds after a failure, resend everything next time.
+    // Otherwise the shadow is valid once a whole-frame flush has gone through.
+    if (!ok) {
+        shadowValid = false;
+    } else if (spanCount == SCREEN_PAGES && spans[0].firstColumn == 0 && spans[0].lastColumn == SCREEN_WIDTH - 1) {
+        shadowValid = true;
+    }
+    
+    lastFlushMicros = micros() - started;
+    flushCount++;
+    flushBusy = false;
+}
+
+void OLEDManager::flushTaskMain(void* parameter) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        streamFrame();
+    }
+}
+
+bool OLEDManager::sendSpan(const uint8_t* frame, const FrameSpan& span) {
+    // Window the panel's RAM pointer onto the span, horizontal addressing
+    // mode then walks it column by column
+    const uint8_t commands[] = {
+        0x00,   // Control byte: command stream
+        SSD1306_COLUMNADDR, span.firstColumn, span.lastColumn,
+        SSD1306_PAGEADDR, span.page, span.page
+    };
+    if (I2CBus::write(SCREEN_ADDRESS, commands, sizeof(commands)) != 0) {
+        return false;
+    }
+    
+    const uint8_t* data = frame + span.page * SCREEN_WIDTH + span.firstColumn;
+    size_t remaining = span.lastColumn - span.firstColumn + 1;
+    uint8_t chunk[DATA_CHUNK + 1];
+    chunk[0] = 0x40;    // Control byte: data stream
+    
+    while (remaining > 0) {
+        size_t length = remaining;
+        if (length > DATA_CHUNK) {
+            length = DATA_CHUNK;
+        }
+        memcpy(chunk + 1, data, length);
+        if (I2CBus::write(SCREEN_ADDRESS, chunk, length + 1) != 0) {
+            return false;
+        }
+        data += length;
+        remaining -= length;
+    }
+    
+    return true;
+}
+
+unsigned long OLEDManager::getLastHandoffMicros() {
+    return lastHandoffMicros;
+}
+
+unsigned long OLEDManager::getLastFlushMicros() {
+    return lastFlushMicros;
+}
+
+unsigned long OLEDManager::getFlushCount() {
+    return flushCount;
+}
+
+unsigned long OLEDManager::getCoalescedCount() {
+    return coalescedCount;
+}
+
 void OLEDManager::drawHeader() {
     display->setTextSize(1);
     display->setTextColor(SSD1306_WHITE);
@@ -278,32 +458,25 @@ void OLEDManager::drawI2CInfo() {
     display->print("I2C Bus Status");
     yPos += 10;
     
-    // Scan for devices
-    int deviceCount = 0;
-    for (byte addr = 1; addr < 128; addr++) {
-        Wire.beginTransmission(addr);
-        byte error = Wire.endTransmission();
-        if (error == 0) {
-            deviceCount++;
-            
-            if (yPos < SCREEN_HEIGHT - 10) {
-                display->setCursor(0, yPos);
-                display->print("0x");
-                if (addr < 16) display->print("0");
-                display->print(addr, HEX);
-                
-                // Identify common devices
-                if (addr == 0x3C || addr == 0x3D) {
-                    display->print(" - OLED");
-                } else if (addr == 0x48) {
-                    display->print(" - ADC");
-                } else if (addr == 0x68) {
-                    display->print(" - RTC");
-                }
-                
-                yPos += 10;
-            }
+    // Devices from the scanner's registry, the bus isn't probed here
+    const I2CRegistry& registry = I2CScanner::getRegistry();
+    int deviceCount = registry.getDeviceCount();
+    for (int addr = registry.nextPresent(0); addr >= 0 && yPos < SCREEN_HEIGHT - 10; addr = registry.nextPresent(addr)) {
+        display->setCursor(0, yPos);
+        display->print("0x");
+        if (addr < 16) display->print("0");
+        display->print(addr, HEX);
+        
+        // Identify common devices
+        if (addr == 0x3C || addr == 0x3D) {
+            display->print(" - OLED");
+        } else if (addr == 0x48) {
+            display->print(" - ADC");
+        } else if (addr == 0x68) {
+            display->print(" - RTC");
         }
+        
+        yPos += 10;
     }
     
     // Total device count
@@ -315,11 +488,16 @@ void OLEDManager::drawI2CInfo() {
     }
 }
 
-void OLEDManager::drawDefaultInfo() {
-    display->setTextSize(1);
-    display->setTextColor(SSD1306_WHITE);
-    
-    int yPos = 15;
+void OLEDManager::buildDefaultScreen() {
+    screen.clear();
+    uptimeWidget = screen.add(0, 15, SCREEN_WIDTH);
+    wifiWidget = screen.add(0, 27, SCREEN_WIDTH);
+    ipWidget = screen.add(0, 39, SCREEN_WIDTH);
+    signalWidget = screen.add(0, 51, SCREEN_WIDTH);
+}
+
+void OLEDManager::updateDefaultWidgets() {
+    char text[ScreenModel::MAX_TEXT + 1];
     
     // Clean uptime display
     unsigned long uptime = millis();
@@ -329,39 +507,40 @@ void OLEDManager::drawDefaultInfo() {
     uptime %= 60000;
     unsigned long seconds = uptime / 1000;
     
-    display->setCursor(0, yPos);
-    display->print("Uptime: ");
     if (hours > 0) {
-        display->print(hours);
-        display->print("h ");
+        snprintf(text, sizeof(text), "Uptime: %luh %lum %lus", hours, minutes, seconds);
+    } else {
+        snprintf(text, sizeof(text), "Uptime: %lum %lus", minutes, seconds);
     }
-    display->print(minutes);
-    display->print("m ");
-    display->print(seconds);
-    display->print("s");
-    yPos += 12;
+    screen.set(uptimeWidget, text);
     
-    // WiFi status
-    display->setCursor(0, yPos);
-    display->print("WiFi: ");
-    if (WiFi.status() == WL_CONNECTED) {
-        display->print("Connected");
+    bool connected = WiFi.status() == WL_CONNECTED;
+    screen.set(wifiWidget, connected ? "WiFi: Connected" : "WiFi: Disconnected");
+    
+    // IP address and signal strength only while connected
+    if (connected) {
+        snprintf(text, sizeof(text), "IP: %s", WiFi.localIP().toString().c_str());
+        screen.set(ipWidget, text);
+        snprintf(text, sizeof(text), "Signal: %d dBm", (int)WiFi.RSSI());
+        screen.set(signalWidget, text);
     } else {
-        display->print("Disconnected");
+        screen.set(ipWidget, "");
+        screen.set(signalWidget, "");
     }
-    yPos += 12;
+}
+
+void OLEDManager::drawWidgets() {
+    display->setTextSize(1);
+    display->setTextColor(SSD1306_WHITE);
     
-    // IP Address (only if connected)
-    if (WiFi.status() == WL_CONNECTED) {
-        display->setCursor(0, yPos);
-        display->print("IP: ");
-        display->print(WiFi.localIP().toString());
-        yPos += 12;
+    for (int i = 0; i < screen.getCount(); i++) {
+        if (!screen.isDirty(i)) {
+            continue;
+        }
         
-        // Signal strength
-        display->setCursor(0, yPos);
-        display->print("Signal: ");
-        display->print(WiFi.RSSI());
-        display->print(" dBm");
+        display->fillRect(screen.getX(i), screen.getY(i), screen.getWidth(i), LINE_HEIGHT, SSD1306_BLACK);
+        display->setCursor(screen.getX(i), screen.getY(i));
+        display->print(screen.getText(i));
+        screen.markClean(i);
     }
 }
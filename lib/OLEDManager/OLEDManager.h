@@ -5,6 +5,11 @@
 #include <Wire.h>
 #include <Adafruit_SSD1306.h>
 #include <Adafruit_GFX.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "I2CBus.h"
+#include "FrameDiff.h"
+#include "ScreenModel.h"
 
 class OLEDManager {
 public:
@@ -18,18 +23,59 @@ public:
     static void showDefaultDisplay();
     static void updateDisplay();
     
+    // Flush timing: what the loop pays to hand a frame over, and how long
+    // the background task takes to stream it
+    static unsigned long getLastHandoffMicros();
+    static unsigned long getLastFlushMicros();
+    static unsigned long getFlushCount();
+    static unsigned long getCoalescedCount();
+    
 private:
     static Adafruit_SSD1306* display;
     static bool available;
     static unsigned long lastUpdate;
     static const unsigned long UPDATE_INTERVAL = 2000; // Update every 2 seconds
     
+    // Default screen: widgets hold the last text drawn, only changed ones
+    // are redrawn, and flush() only sends the bytes that differ from what
+    // the panel already shows
+    static ScreenModel screen;
+    static bool defaultScreenActive;
+    static int uptimeWidget;
+    static int wifiWidget;
+    static int ipWidget;
+    static int signalWidget;
+    
+    // Drawing goes into the driver's buffer (back). flush() copies it to
+    // the front buffer and the flush task streams the changed spans from
+    // there, so the loop never waits on I2C. shadow mirrors the panel's
+    // RAM and is only touched by whoever owns the flush.
+    static uint8_t front[];
+    static uint8_t shadow[];
+    static bool shadowValid;
+    static FrameSpan spans[FrameDiff::MAX_SPANS];
+    static int spanCount;
+    static TaskHandle_t flushTask;
+    static volatile bool flushBusy;
+    static bool flushPending;          // A frame was drawn while the task was busy
+    
+    static unsigned long lastHandoffMicros;
+    static volatile unsigned long lastFlushMicros;
+    static volatile unsigned long flushCount;
+    static unsigned long coalescedCount;
+    
+    static void flush();
+    static void streamFrame();
+    static void flushTaskMain(void* parameter);
+    static bool sendSpan(const uint8_t* frame, const FrameSpan& span);
+    static void buildDefaultScreen();
+    static void updateDefaultWidgets();
+    static void drawWidgets();
     static void drawHeader();
     static void drawStatus(const String& status);
     static void drawSystemInfo();
     static void drawWiFiInfo();
     static void drawI2CInfo();
-    static void drawDefaultInfo();
 };
 
 #endif
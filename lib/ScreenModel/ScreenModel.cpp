@@ -0,0 +1,48 @@
+#include "ScreenModel.h"
+#include <string.h>
+
+ScreenModel::ScreenModel() : count(0) {
+}
+
+int ScreenModel::add(int16_t x, int16_t y, int16_t width) {
+    if (count >= MAX_WIDGETS) {
+        return -1;
+    }
+    
+    Widget& widget = widgets[count];
+    widget.x = x;
+    widget.y = y;
+    widget.width = width;
+    widget.dirty = true;
+    widget.text[0] = '\0';
+    return count++;
+}
+
+void ScreenModel::clear() {
+    count = 0;
+}
+
+bool ScreenModel::set(int widget, const char* text) {
+    if (widget < 0 || widget >= count) {
+        return false;
+    }
+    
+    char truncated[MAX_TEXT + 1];
+    strncpy(truncated, text, MAX_TEXT);
+    truncated[MAX_TEXT] = '\0';
+    
+    Widget& target = widgets[widget];
+    if (strcmp(target.text, truncated) == 0) {
+        return false;
+    }
+    
+    memcpy(target.text, truncated, sizeof(target.text));
+    target.dirty = true;
+    return true;
+}
+
+void ScreenModel::invalidate() {
+    for (int i = 0; i < count; i++) {
+        widgets[i].dirty = true;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef SCREENMODEL_H
+#define SCREENMODEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Retained-mode screen: a fixed set of single-line text widgets. Setting a
+// widget to the text it already shows is a no-op, so the renderer only
+// redraws widgets whose value actually changed. No Arduino dependency.
+class ScreenModel {
+public:
+    static const int MAX_WIDGETS = 8;
+    static const size_t MAX_TEXT = 21;   // 6 px glyphs across 128 px
+    
+    ScreenModel();
+    
+    // Returns the widget id, or -1 if the screen is full
+    int add(int16_t x, int16_t y, int16_t width);
+    void clear();
+    
+    // True if the text changed; longer text is truncated to MAX_TEXT
+    bool set(int widget, const char* text);
+    // Force every widget to redraw, e.g. after the screen was wiped
+    void invalidate();
+    
+    int getCount() const { return count; }
+    bool isDirty(int widget) const { return widgets[widget].dirty; }
+    void markClean(int widget) { widgets[widget].dirty = false; }
+    const char* getText(int widget) const { return widgets[widget].text; }
+    int16_t getX(int widget) const { return widgets[widget].x; }
+    int16_t getY(int widget) const { return widgets[widget].y; }
+    int16_t getWidth(int widget) const { return widgets[widget].width; }
+
+private:
+    struct Widget {
+        int16_t x;
+        int16_t y;
+        int16_t width;
+        bool dirty;
+        char text[MAX_TEXT + 1];
+    };
+    
+    Widget widgets[MAX_WIDGETS];
+    int count;
+};
+
+#endif
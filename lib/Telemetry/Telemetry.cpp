@@ -0,0 +1,185 @@
+#include "Telemetry.h"
+#include <stdio.h>
+#include <math.h>
+
+Telemetry::Sensor Telemetry::sensors[MAX_SENSORS];
+int Telemetry::sensorCount = 0;
+unsigned long Telemetry::sampleInterval = DEFAULT_SAMPLE_INTERVAL;
+unsigned long Telemetry::publishInterval = DEFAULT_PUBLISH_INTERVAL;
+unsigned long Telemetry::lastSample = 0;
+unsigned long Telemetry::lastPublish = 0;
+bool Telemetry::started = false;
+unsigned long Telemetry::batchCount = 0;
+unsigned long Telemetry::suppressedCount = 0;
+
+int Telemetry::addSensor(const char* key, const char* name, const char* unit,
+                         TelemetrySampler sampler, float threshold, uint8_t decimals) {
+    if (sensorCount >= MAX_SENSORS) {
+        return -1;
+    }
+    
+    Sensor& sensor = sensors[sensorCount];
+    sensor.key = key;
+    sensor.name = name;
+    sensor.unit = unit;
+    sensor.sampler = sampler;
+    sensor.threshold = threshold;
+    sensor.decimals = decimals;
+    sensor.latest = 0;
+    sensor.published = false;
+    sensor.publishedAverage = 0;
+    sensor.suppressed = 0;
+    resetInterval(sensor);
+    
+    return sensorCount++;
+}
+
+void Telemetry::record(int sensor, float value) {
+    if (sensor < 0 || sensor >= sensorCount) {
+        return;
+    }
+    
+    Sensor& s = sensors[sensor];
+    if (s.count == 0 || value < s.min) s.min = value;
+    if (s.count == 0 || value > s.max) s.max = value;
+    s.sum += value;
+    s.latest = value;
+    if (s.count < UINT16_MAX) s.count++;
+}
+
+void Telemetry::setIntervals(unsigned long sample, unsigned long publish) {
+    sampleInterval = sample;
+    publishInterval = publish;
+}
+
+void Telemetry::clear() {
+    sensorCount = 0;
+    sampleInterval = DEFAULT_SAMPLE_INTERVAL;
+    publishInterval = DEFAULT_PUBLISH_INTERVAL;
+    started = false;
+    batchCount = 0;
+    suppressedCount = 0;
+}
+
+bool Telemetry::loop(unsigned long now) {
+    if (!started) {
+        // First call samples straight away and opens the first interval
+        started = true;
+        lastSample = now - sampleInterval;
+        lastPublish = now;
+    }
+    
+    if (now - lastSample >= sampleInterval) {
+        lastSample = now;
+        for (int i = 0; i < sensorCount; i++) {
+            if (sensors[i].sampler) {
+                record(i, sensors[i].sampler());
+            }
+        }
+    }
+    
+    if (now - lastPublish >= publishInterval) {
+        lastPublish = now;
+        return true;
+    }
+    return false;
+}
+
+size_t Telemetry::buildPayload(char* out, size_t capacity, unsigned long uptimeSeconds) {
+    size_t length = 0;
+    int written = snprintf(out, capacity, "{\"uptime\":%lu", uptimeSeconds);
+    if (written < 0 || (size_t)written >= capacity) {
+        return 0;
+    }
+    length = written;
+    
+    // Nothing is committed until the whole batch fits, so a batch that
+    // doesn't keeps every interval for the next attempt
+    bool included[MAX_SENSORS];
+    for (int i = 0; i < sensorCount; i++) {
+        Sensor& sensor = sensors[i];
+        included[i] = false;
+        if (sensor.count == 0) {
+            continue;
+        }
+        
+        float average = sensor.sum / sensor.count;
+        bool changed = !sensor.published || fabsf(average - sensor.publishedAverage) >= sensor.threshold;
+        if (!changed && sensor.suppressed < MAX_SUPPRESSED) {
+            continue;
+        }
+        
+        written = snprintf(out + length, capacity - length, ",\"%s\":[%.*f,%.*f,%.*f]", sensor.key,
+                           sensor.decimals, sensor.min, sensor.decimals, average, sensor.decimals, sensor.max);
+        if (written < 0 || (size_t)written >= capacity - length) {
+            return 0;
+        }
+        length += written;
+        included[i] = true;
+    }
+    
+    if (length + 2 > capacity) {
+        return 0;
+    }
+    out[length++] = '}';
+    out[length] = '\0';
+    
+    for (int i = 0; i < sensorCount; i++) {
+        Sensor& sensor = sensors[i];
+        if (sensor.count == 0) {
+            continue;
+        }
+        
+        if (included[i]) {
+            sensor.published = true;
+            sensor.publishedAverage = sensor.sum / sensor.count;
+            sensor.suppressed = 0;
+        } else {
+            sensor.suppressed++;
+            suppressedCount++;
+        }
+        resetInterval(sensor);
+    }
+    
+    batchCount++;
+    return length;
+}
+
+int Telemetry::getSensorCount() {
+    return sensorCount;
+}
+
+const char* Telemetry::getSensorKey(int sensor) {
+    return sensors[sensor].key;
+}
+
+const char* Telemetry::getSensorName(int sensor) {
+    return sensors[sensor].name;
+}
+
+const char* Telemetry::getSensorUnit(int sensor) {
+    return sensors[sensor].unit;
+}
+
+bool Telemetry::getLatest(int sensor, float& value) {
+    if (sensor < 0 || sensor >= sensorCount) {
+        return false;
+    }
+    value = sensors[sensor].latest;
+    return true;
+}
+
+unsigned long Telemetry::getBatchCount() {
+    return batchCount;
+}
+
+unsigned long Telemetry::getSuppressedCount() {
+    return suppressedCount;
+}
+
+void Telemetry::resetInterval(Sensor& sensor) {
+    sensor.min = 0;
+    sensor.max = 0;
+    sensor.sum = 0;
+    sensor.count = 0;
+}
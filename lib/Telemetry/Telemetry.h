@@ -0,0 +1,79 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef float (*TelemetrySampler)();
+
+// Sensors either register a sampler that loop() polls every sample interval,
+// or push values with record(). Each publish interval the samples collapse
+// into one batch: {"uptime":s,"key":[min,avg,max],...}. A sensor whose
+// average moved less than its threshold is left out, but never for more than
+// MAX_SUPPRESSED intervals in a row. Time is passed in so this stays free of
+// Arduino dependencies.
+class Telemetry {
+public:
+    static const int MAX_SENSORS = 12;
+    static const int MAX_SUPPRESSED = 10;
+    static const unsigned long DEFAULT_SAMPLE_INTERVAL = 1000;
+    static const unsigned long DEFAULT_PUBLISH_INTERVAL = 30000;
+    
+    // Returns the sensor id, or -1 if the table is full. Strings must outlive the sensor.
+    static int addSensor(const char* key, const char* name, const char* unit,
+                         TelemetrySampler sampler, float threshold, uint8_t decimals = 0);
+    static void record(int sensor, float value);
+    static void setIntervals(unsigned long sampleInterval, unsigned long publishInterval);
+    static void clear();
+    
+    // Samples when due; true once a batch should be built and published
+    static bool loop(unsigned long now);
+    
+    // Writes the batch and starts a new interval. Returns the length, 0 if it didn't fit.
+    static size_t buildPayload(char* out, size_t capacity, unsigned long uptimeSeconds);
+    
+    static int getSensorCount();
+    static const char* getSensorKey(int sensor);
+    static const char* getSensorName(int sensor);
+    static const char* getSensorUnit(int sensor);
+    static bool getLatest(int sensor, float& value);
+    
+    static unsigned long getBatchCount();
+    static unsigned long getSuppressedCount();
+
+private:
+    struct Sensor {
+        const char* key;
+        const char* name;
+        const char* unit;
+        TelemetrySampler sampler;
+        float threshold;
+        uint8_t decimals;
+        
+        // Current interval
+        float min;
+        float max;
+        float sum;
+        uint16_t count;
+        float latest;
+        
+        // Last value sent
+        bool published;
+        float publishedAverage;
+        uint8_t suppressed;
+    };
+    
+    static Sensor sensors[MAX_SENSORS];
+    static int sensorCount;
+    static unsigned long sampleInterval;
+    static unsigned long publishInterval;
+    static unsigned long lastSample;
+    static unsigned long lastPublish;
+    static bool started;
+    static unsigned long batchCount;
+    static unsigned long suppressedCount;
+    
+    static void resetInterval(Sensor& sensor);
+};
+
+#endif
@@ -29,6 +29,8 @@ void WebHandler::setupRoutes() {
     webServer->on("/i2c_scan", HTTP_GET, handleScanI2C);
     webServer->on("/i2c_quick_scan", HTTP_GET, handleI2CQuickScan);
     webServer->on("/i2c_test_common", HTTP_GET, handleI2CTestCommon);
+    webServer->on("/api/i2c/devices", HTTP_GET, handleI2CDevices);
+    webServer->on("/api/i2c/stats", HTTP_GET, handleI2CStats);
     webServer->on("/update_i2c_pins", HTTP_POST, handleUpdateI2CPins);
     webServer->on("/reinit_i2c", HTTP_GET, handleReinitI2C);
     webServer->on("/i2ccmd", HTTP_GET, handleI2CCommand);
@@ -39,6 +41,7 @@ void WebHandler::setupRoutes() {
     webServer->on("/oled/wifi", HTTP_GET, handleOLEDWiFi);
     webServer->on("/oled/i2c", HTTP_GET, handleOLEDI2C);
     webServer->on("/oled/clear", HTTP_GET, handleOLEDClear);
+    webServer->on("/api/oled/stats", HTTP_GET, handleOLEDStats);
     webServer->on("/versioncheck", HTTP_GET, handleVersionCheck);
     webServer->on("/firmwareupload", HTTP_POST, []() {
         // Handle the POST request completion
@@ -65,6 +68,12 @@ void WebHandler::setupRoutes() {
     webServer->on("/api/config", HTTP_GET, handleAPIConfig);
     webServer->on("/api/wifi", HTTP_GET, handleAPIWiFi);
     webServer->on("/api/wifi/scan", HTTP_GET, handleWiFiScan);
+    webServer->on("/api/config/stats", HTTP_GET, handleConfigStats);
+    webServer->on("/api/config/export", HTTP_GET, handleConfigExport);
+    webServer->on("/api/config/import", HTTP_POST, handleConfigImport);
+    webServer->on("/api/mqtt/stats", HTTP_GET, handleMQTTStats);
+    webServer->on("/api/boot", HTTP_GET, handleBootProfile);
+    webServer->on("/api/heap", HTTP_GET, handleHeapStats);
 }
 
 // Static file handlers
@@ -147,10 +156,90 @@ void WebHandler::handleClearLog() {
 }
 
 void WebHandler::handleScanI2C() {
-    String devices = I2CScanner::scan();
+    // Explicit full rescan; routine lookups go through the registry
+    bool details = webServer->hasArg("details") && webServer->arg("details") == "1";
+    String devices = details ? I2CScanner::scanWithDetails() : I2CScanner::scan();
     webServer->send(200, "text/plain", devices);
 }
 
+void WebHandler::handleI2CDevices() {
+    const I2CRegistry& registry = I2CScanner::getRegistry();
+    unsigned long now = millis();
+    
+    String json = "{\"devices\":[";
+    bool first = true;
+    for (int address = registry.nextPresent(0); address >= 0; address = registry.nextPresent(address)) {
+        if (!first) json += ",";
+        first = false;
+        json += "{\"address\":" + String(address);
+        json += ",\"type\":\"" + I2CScanner::getDeviceType(address) + "\"";
+        json += ",\"lastSeenMs\":" + String(now - registry.getLastSeen(address));
+        json += ",\"changedMs\":" + String(now - registry.getLastChange(address)) + "}";
+    }
+    json += "],\"count\":" + String(registry.getDeviceCount());
+    json += ",\"sweeps\":" + String(registry.getSweepCount());
+    json += ",\"changes\":" + String(registry.getChangeCount());
+    
+    const I2CProbeStats& stats = I2CScanner::getProbeStats();
+    json += ",\"fastProbe\":" + String(I2CScanner::isFastProbe() ? "true" : "false");
+    json += ",\"probes\":{";
+    for (int i = 0; i < I2C_PROBE_RESULT_COUNT; i++) {
+        json += "\"" + String(I2CProbe::resultToString((I2CProbeResult)i)) + "\":" + String(stats.counts[i]) + ",";
+    }
+    json += "\"recoveries\":" + String(stats.recoveries);
+    json += ",\"failedRecoveries\":" + String(stats.failedRecoveries) + "}}";
+    
+    webServer->send(200, "application/json", json);
+}
+
+void WebHandler::handleI2CStats() {
+    // Per-address health since boot; a rising error count or a latency
+    // histogram drifting right points at marginal wiring
+    const I2CBusStats& stats = I2CBus::getStats();
+    
+    String json = "{\"uptimeMs\":" + String(millis());
+    json += ",\"latencyBucketsUs\":[";
+    for (int b = 0; b < I2CBusStats::LATENCY_BUCKETS - 1; b++) {
+        if (b > 0) json += ",";
+        json += String(I2CBusStats::bucketLimit(b));
+    }
+    json += "],\"devices\":[";
+    for (int i = 0; i < stats.getDeviceCount(); i++) {
+        if (i > 0) json += ",";
+        json += i2cStatsEntryToJson(stats.getDevice(i));
+    }
+    json += "],\"other\":" + i2cStatsEntryToJson(stats.getOther());
+    json += ",\"transactions\":" + String(stats.getTransactions());
+    json += ",\"errors\":" + String(stats.getErrors());
+    json += ",\"contended\":" + String(I2CBus::getContendedCount());
+    json += ",\"maxWaitUs\":" + String(I2CBus::getMaxWaitMicros()) + "}";
+    
+    webServer->send(200, "application/json", json);
+}
+
+String WebHandler::i2cStatsEntryToJson(const I2CBusStats::Entry& entry) {
+    String json = "{\"address\":" + String(entry.address);
+    json += ",\"clock\":" + String(I2CBus::getDeviceClock(entry.address));
+    json += ",\"transactions\":" + String(entry.transactions);
+    json += ",\"errors\":" + String(entry.errors());
+    json += ",\"results\":{";
+    for (int r = 0; r < I2C_PROBE_RESULT_COUNT; r++) {
+        if (r > 0) json += ",";
+        json += "\"" + String(I2CProbe::resultToString((I2CProbeResult)r)) + "\":" + String(entry.results[r]);
+    }
+    json += "},\"bytesWritten\":" + String(entry.bytesWritten);
+    json += ",\"bytesRead\":" + String(entry.bytesRead);
+    json += ",\"busTimeMs\":" + String((unsigned long)(entry.busTimeMicros / 1000));
+    json += ",\"maxUs\":" + String(entry.maxMicros);
+    json += ",\"latency\":[";
+    for (int b = 0; b < I2CBusStats::LATENCY_BUCKETS; b++) {
+        if (b > 0) json += ",";
+        json += String(entry.latency[b]);
+    }
+    json += "]}";
+    return json;
+}
+
 void WebHandler::handleI2CCommand() {
     if (webServer->hasArg("cmd")) {
         int command = webServer->arg("cmd").toInt();
@@ -288,7 +377,16 @@ void WebHandler::handleFirmwareUpload() {
 void WebHandler::handleFirmwareUpdate() {
     Logger::addEntry("Starting ATtiny1616 firmware update...");
     
-    if (FirmwareUpdater::updateATtinyFirmware()) {
+    // ?full=1 rewrites every page, for an ATtiny flashed some other way since
+    if (webServer->arg("full") == "1") {
+        FirmwareUpdater::forgetFlashedImage();
+    }
+    
+    // ?package=<file.bin> flashes a stored package, compressed or not
+    bool success = webServer->hasArg("package")
+        ? FirmwareUpdater::updateATtinyFirmwareFromPackage(webServer->arg("package"))
+        : FirmwareUpdater::updateATtinyFirmware();
+    if (success) {
         webServer->send(200, "text/plain", "ATtiny1616 firmware update completed successfully!");
     } else {
         webServer->send(500, "text/plain", "Firmware update failed. Check logs for details.");
@@ -312,6 +410,7 @@ void WebHandler::handleConfigUpdate() {
         
         if (ConfigManager::updateMQTTConfig(brokerIP, brokerPort, username, password, deviceName, deviceId, mqttPrefix)) {
             Logger::addEntry("MQTT configuration updated, reconnecting...");
+            HomeAssistantMQTT::reconnect();
             webServer->send(200, "text/plain", "MQTT configuration updated successfully! Device will reconnect with new settings.");
         } else {
             webServer->send(500, "text/plain", "Failed to update MQTT configuration.");
@@ -332,6 +431,9 @@ void WebHandler::handleWiFiUpdate() {
         
         ConfigManager::setWiFiConfig(ssid, password);
         
+        // Don't leave the change waiting on the deferred commit, we're about to restart
+        ConfigManager::saveConfig();
+        
         webServer->send(200, "text/plain", "WiFi credentials updated! Device will restart to apply new settings.");
         
         // Restart the device after a short delay
@@ -375,7 +477,7 @@ void WebHandler::handleFirmwareDelete() {
 
 // API endpoints for configuration
 void WebHandler::handleAPIConfig() {
-    MQTTConfig config = ConfigManager::getMQTTConfig();
+    const MQTTConfig& config = ConfigManager::getMQTTConfig();
     
     String json = "{";
     json += "\"brokerIP\":\"" + config.brokerIP + "\",";
@@ -390,8 +492,117 @@ void WebHandler::handleAPIConfig() {
     webServer->send(200, "application/json", json);
 }
 
+void WebHandler::handleConfigStats() {
+    String json = "{";
+    json += "\"flashWrites\":" + String(ConfigManager::getFlashWrites()) + ",";
+    json += "\"writesSkipped\":" + String(ConfigManager::getWritesSkipped()) + ",";
+    json += "\"writesCoalesced\":" + String(ConfigManager::getWritesCoalesced()) + ",";
+    json += "\"dirty\":" + String(ConfigManager::isDirty() ? "true" : "false") + ",";
+    json += "\"schema\":" + String(ConfigManager::SCHEMA_VERSION) + ",";
+    json += "\"storedBytes\":" + String(ConfigManager::getStoredSize());
+    json += "}";
+    
+    webServer->send(200, "application/json", json);
+}
+
+void WebHandler::handleHeapStats() {
+    // Read everything first, building the response allocates
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t largestBlock = ESP.getMaxAllocHeap();
+    uint32_t minFreeHeap = ESP.getMinFreeHeap();
+    
+    webServer->send(200, "application/json", HeapReport::toJson(freeHeap, largestBlock, minFreeHeap));
+}
+
+void WebHandler::handleBootProfile() {
+    // This boot is first once it has finished, then the stored ones
+    const BootHistory& history = BootProfiler::getHistory();
+    
+    String json = "{\"finished\":" + String(BootProfiler::isFinished() ? "true" : "false");
+    json += ",\"boots\":[";
+    for (int i = 0; i < history.getCount(); i++) {
+        if (i > 0) json += ",";
+        json += bootProfileToJson(history.get(i));
+    }
+    json += "]}";
+    
+    webServer->send(200, "application/json", json);
+}
+
+String WebHandler::bootProfileToJson(const BootProfile& profile) {
+    String json = "{\"boot\":" + String(profile.getBootCount());
+    json += ",\"firmware\":\"" + String(profile.getFirmware()) + "\"";
+    json += ",\"resetReason\":\"" + String(BootProfiler::resetReasonToString(profile.getResetReason())) + "\"";
+    json += ",\"completedMs\":" + String(profile.getCompletedAt());
+    json += ",\"freeHeap\":" + String(profile.getFreeHeap());
+    json += ",\"minFreeHeap\":" + String(profile.getMinFreeHeap());
+    json += ",\"phases\":[";
+    for (int i = 0; i < profile.getPhaseCount(); i++) {
+        const BootPhaseRecord& phase = profile.getPhase(i);
+        if (i > 0) json += ",";
+        json += "{\"name\":\"" + String(phase.name) + "\"";
+        json += ",\"startMs\":" + String(phase.startedAt);
+        json += ",\"endMs\":" + String(phase.finishedAt);
+        json += ",\"heapDelta\":" + String(phase.heapDelta);
+        json += ",\"failed\":" + String(phase.status == BOOT_FAILED ? "true" : "false") + "}";
+    }
+    json += "]}";
+    return json;
+}
+
+void WebHandler::handleMQTTStats() {
+    const MQTTOfflineQueue& queue = HomeAssistantMQTT::getOfflineQueue();
+    const DiscoveryCache& discovery = HomeAssistantMQTT::getDiscoveryCache();
+    
+    String json = "{";
+    json += "\"state\":\"" + String(HomeAssistantMQTT::getConnectionStateName()) + "\",";
+    json += "\"connectedMs\":" + String(HomeAssistantMQTT::getConnectedDuration()) + ",";
+    json += "\"nextAttemptMs\":" + String(HomeAssistantMQTT::getNextAttemptIn()) + ",";
+    json += "\"attempts\":" + String(HomeAssistantMQTT::getConnectAttempts()) + ",";
+    json += "\"connects\":" + String(HomeAssistantMQTT::getConnectCount()) + ",";
+    json += "\"disconnects\":" + String(HomeAssistantMQTT::getDisconnectCount()) + ",";
+    json += "\"lastDisconnectReason\":" + String(HomeAssistantMQTT::getLastDisconnectReason()) + ",";
+    json += "\"droppedInbound\":" + String(HomeAssistantMQTT::getDroppedMessages()) + ",";
+    json += "\"queue\":{";
+    json += "\"depth\":" + String(queue.size()) + ",";
+    json += "\"capacity\":" + String((int)MQTTOfflineQueue::MAX_ENTRIES) + ",";
+    json += "\"queued\":" + String(queue.getQueuedCount()) + ",";
+    json += "\"replaced\":" + String(queue.getReplacedCount()) + ",";
+    json += "\"dropped\":" + String(queue.getDroppedCount()) + ",";
+    json += "\"flushed\":" + String(queue.getFlushedCount());
+    json += "},\"discovery\":{";
+    json += "\"entities\":" + String(discovery.size()) + ",";
+    json += "\"bytes\":" + String((unsigned long)discovery.getBytesUsed()) + ",";
+    json += "\"renders\":" + String(discovery.getRenderCount()) + ",";
+    json += "\"replays\":" + String(discovery.getReplayCount()) + ",";
+    json += "\"replaying\":" + String(discovery.isReplaying() ? "true" : "false");
+    json += "}}";
+    
+    webServer->send(200, "application/json", json);
+}
+
+void WebHandler::handleConfigExport() {
+    bool includeSecrets = webServer->hasArg("secrets") && webServer->arg("secrets") == "1";
+    webServer->sendHeader("Content-Disposition", "attachment; filename=config.json");
+    webServer->send(200, "application/json", ConfigManager::exportJson(includeSecrets));
+}
+
+void WebHandler::handleConfigImport() {
+    if (!webServer->hasArg("plain")) {
+        webServer->send(400, "text/plain", "Missing JSON body");
+        return;
+    }
+    
+    if (ConfigManager::importJson(webServer->arg("plain"))) {
+        Logger::addEntry("Configuration imported from JSON");
+        webServer->send(200, "text/plain", "Configuration imported");
+    } else {
+        webServer->send(400, "text/plain", "Failed to import configuration");
+    }
+}
+
 void WebHandler::handleAPIWiFi() {
-    WiFiConfig wifi = ConfigManager::getWiFiConfig();
+    const WiFiConfig& wifi = ConfigManager::getWiFiConfig();
     
     String json = "{";
     json += "\"ssid\":\"" + wifi.ssid + "\",";
@@ -402,23 +613,27 @@ void WebHandler::handleAPIWiFi() {
 }
 
 void WebHandler::handleWiFiScan() {
-    int numNetworks = WiFi.scanNetworks();
+    // Never block on the radio here - serve the cache and let a refresh run in the background
+    bool force = webServer->hasArg("refresh") && webServer->arg("refresh") == "1";
+    WiFiScanCache::requestRefresh(force);
     
-    if (numNetworks == -1) {
-        webServer->send(500, "application/json", "{\"error\":\"WiFi scan failed\"}");
-        return;
-    }
+    String json = "{";
+    json += "\"scanning\":" + String(WiFiScanCache::isScanning() ? "true" : "false") + ",";
+    json += "\"cached\":" + String(WiFiScanCache::hasResults() ? "true" : "false") + ",";
+    json += "\"age_ms\":" + String(WiFiScanCache::getAge()) + ",";
+    json += "\"networks\":[";
     
-    String json = "[";
+    int numNetworks = WiFiScanCache::getNetworkCount();
     for (int i = 0; i < numNetworks; i++) {
+        const WiFiNetwork& network = WiFiScanCache::getNetwork(i);
         if (i > 0) json += ",";
         json += "{";
-        json += "\"ssid\":\"" + WiFi.SSID(i) + "\",";
-        json += "\"rssi\":" + String(WiFi.RSSI(i)) + ",";
-        json += "\"encryption\":\"" + getEncryptionType(WiFi.encryptionType(i)) + "\"";
+        json += "\"ssid\":\"" + network.ssid + "\",";
+        json += "\"rssi\":" + String(network.rssi) + ",";
+        json += "\"encryption\":\"" + getEncryptionType(network.encryption) + "\"";
         json += "}";
     }
-    json += "]";
+    json += "]}";
     
     webServer->send(200, "application/json", json);
 }
@@ -518,44 +733,25 @@ void WebHandler::handleAllFirmware() {
 
 // New I2C testing handlers
 void WebHandler::handleI2CQuickScan() {
-    Logger::addEntry("Quick I2C scan requested");
-    String result = "Quick I2C Scan Results:\n";
-    
-    int deviceCount = 0;
-    for (byte addr = 1; addr < 10; addr++) {
-        Wire.beginTransmission(addr);
-        byte error = Wire.endTransmission();
-        if (error == 0) {
-            deviceCount++;
-            result += "Device found at 0x" + String(addr, HEX) + "\n";
-        }
-    }
-    
-    result += "\nQuick scan complete. Found " + String(deviceCount) + " device(s) in low address range";
-    webServer->send(200, "text/plain", result);
+    // Served from the background-maintained registry, no bus traffic
+    webServer->send(200, "text/plain", I2CScanner::getDeviceList());
 }
 
 void WebHandler::handleI2CTestCommon() {
-    Logger::addEntry("Common I2C address test requested");
     String result = "Common I2C Address Test Results:\n";
     
     byte commonAddresses[] = {0x3C, 0x3D, 0x27, 0x20, 0x48, 0x68, 0x76, 0x77};
     int deviceCount = 0;
     
     for (byte addr : commonAddresses) {
-        Wire.beginTransmission(addr);
-        byte error = Wire.endTransmission();
-        if (error == 0) {
+        if (I2CScanner::isPresent(addr)) {
             deviceCount++;
             result += "✓ Device found at 0x" + String(addr, HEX);
             
             // Identify device type
-            if (addr == 0x3C || addr == 0x3D) {
-                result += " - Likely OLED Display";
-            } else if (addr == 0x27) {
-                result += " - Likely LCD Display";
-            } else if (addr == 0x20) {
-                result += " - Likely I/O Expander";
+            String type = I2CScanner::getDeviceType(addr);
+            if (type.length() > 0) {
+                result += " - Likely " + type;
             }
             result += "\n";
         } else {
@@ -593,6 +789,17 @@ void WebHandler::handleReinitI2C() {
 }
 
 // OLED display handlers
+void WebHandler::handleOLEDStats() {
+    // handoffUs is what a refresh costs the loop, flushUs runs in the background
+    String json = "{\"available\":" + String(OLEDManager::isAvailable() ? "true" : "false");
+    json += ",\"flushes\":" + String(OLEDManager::getFlushCount());
+    json += ",\"coalesced\":" + String(OLEDManager::getCoalescedCount());
+    json += ",\"handoffUs\":" + String(OLEDManager::getLastHandoffMicros());
+    json += ",\"flushUs\":" + String(OLEDManager::getLastFlushMicros()) + "}";
+    
+    webServer->send(200, "application/json", json);
+}
+
 void WebHandler::handleOLEDStatus() {
     Logger::addEntry("OLED status display requested");
     
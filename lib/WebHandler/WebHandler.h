@@ -9,7 +9,13 @@
 #include "Logger.h"
 #include "LEDController.h"
 #include "I2CScanner.h"
+#include "I2CBus.h"
 #include "OLEDManager.h"
+#include "WiFiScanCache.h"
+#include "HomeAssistantMQTT.h"
+#include "BootProfiler.h"
+#include "HeapTracker.h"
+#include "HeapReport.h"
 
 class WebHandler {
 public:
@@ -54,6 +60,8 @@ public:
     // I2C testing handlers
     static void handleI2CQuickScan();
     static void handleI2CTestCommon();
+    static void handleI2CDevices();
+    static void handleI2CStats();
     static void handleUpdateI2CPins();
     static void handleReinitI2C();
     
@@ -63,10 +71,17 @@ public:
     static void handleOLEDWiFi();
     static void handleOLEDI2C();
     static void handleOLEDClear();
+    static void handleOLEDStats();
     
     // API endpoints for configuration
     static void handleAPIConfig();
     static void handleAPIWiFi();
+    static void handleConfigStats();
+    static void handleMQTTStats();
+    static void handleBootProfile();
+    static void handleHeapStats();
+    static void handleConfigExport();
+    static void handleConfigImport();
     static void handleWiFiScan();
 
 private:
@@ -76,6 +91,8 @@ private:
     static String getIPAddress();
     static int getWiFiRSSI();
     static String getEncryptionType(wifi_auth_mode_t encryptionType);
+    static String i2cStatsEntryToJson(const I2CBusStats::Entry& entry);
+    static String bootProfileToJson(const BootProfile& profile);
 };
 
 #endif
@@ -0,0 +1,154 @@
+#include "WiFiScanCache.h"
+#include "Logger.h"
+
+// Static member initialization
+WiFiNetwork WiFiScanCache::networks[MAX_NETWORKS];
+int WiFiScanCache::networkCount = 0;
+bool WiFiScanCache::scanning = false;
+bool WiFiScanCache::resultsValid = false;
+unsigned long WiFiScanCache::lastScanStart = 0;
+unsigned long WiFiScanCache::lastScanComplete = 0;
+unsigned long WiFiScanCache::scanCount = 0;
+unsigned long WiFiScanCache::coalescedCount = 0;
+
+void WiFiScanCache::init() {
+    networkCount = 0;
+    scanning = false;
+    resultsValid = false;
+    scanCount = 0;
+    coalescedCount = 0;
+}
+
+void WiFiScanCache::loop() {
+    if (!scanning) return;
+    
+    int16_t result = WiFi.scanComplete();
+    if (result == WIFI_SCAN_RUNNING) {
+        if (millis() - lastScanStart > SCAN_TIMEOUT) {
+            Logger::addEntry("WiFi scan timed out");
+            WiFi.scanDelete();
+            scanning = false;
+        }
+        return;
+    }
+    
+    scanning = false;
+    
+    if (result < 0) {
+        Logger::addEntry("WiFi scan failed");
+        WiFi.scanDelete();
+        return;
+    }
+    
+    collectResults(result);
+    
+    // Free the driver's copy, we keep our own
+    WiFi.scanDelete();
+}
+
+bool WiFiScanCache::requestRefresh(bool force) {
+    if (scanning) {
+        // Share the scan that's already running
+        coalescedCount++;
+        return true;
+    }
+    
+    unsigned long now = millis();
+    
+    // Fresh enough, nothing to do
+    if (!force && resultsValid && now - lastScanComplete < CACHE_TTL) {
+        return false;
+    }
+    
+    // Rate limit - every scan steals airtime from the station connection
+    if (scanCount > 0 && now - lastScanStart < MIN_SCAN_INTERVAL) {
+        coalescedCount++;
+        return false;
+    }
+    
+    return startScan();
+}
+
+bool WiFiScanCache::isScanning() {
+    return scanning;
+}
+
+bool WiFiScanCache::hasResults() {
+    return resultsValid;
+}
+
+unsigned long WiFiScanCache::getAge() {
+    if (!resultsValid) return 0;
+    return millis() - lastScanComplete;
+}
+
+int WiFiScanCache::getNetworkCount() {
+    return networkCount;
+}
+
+const WiFiNetwork& WiFiScanCache::getNetwork(int index) {
+    return networks[index];
+}
+
+unsigned long WiFiScanCache::getScanCount() {
+    return scanCount;
+}
+
+unsigned long WiFiScanCache::getCoalescedCount() {
+    return coalescedCount;
+}
+
+bool WiFiScanCache::startScan() {
+    // async = true, so this returns WIFI_SCAN_RUNNING immediately
+    int16_t result = WiFi.scanNetworks(true);
+    if (result == WIFI_SCAN_FAILED) {
+        Logger::addEntry("Failed to start WiFi scan");
+        return false;
+    }
+    
+    scanning = true;
+    lastScanStart = millis();
+    scanCount++;
+    return true;
+}
+
+void WiFiScanCache::collectResults(int found) {
+    networkCount = 0;
+    
+    for (int i = 0; i < found; i++) {
+        String ssid = WiFi.SSID(i);
+        if (ssid.length() == 0) continue; // Hidden network
+        
+        int32_t rssi = WiFi.RSSI(i);
+        
+        // Mesh and multi-AP setups report the same SSID several times,
+        // only keep the strongest one
+        int existing = -1;
+        for (int j = 0; j < networkCount; j++) {
+            if (networks[j].ssid == ssid) {
+                existing = j;
+                break;
+            }
+        }
+        
+        if (existing >= 0) {
+            if (rssi > networks[existing].rssi) {
+                networks[existing].rssi = rssi;
+                networks[existing].encryption = WiFi.encryptionType(i);
+            }
+            continue;
+        }
+        
+        if (networkCount >= MAX_NETWORKS) continue;
+        
+        networks[networkCount].ssid = ssid;
+        networks[networkCount].rssi = rssi;
+        networks[networkCount].encryption = WiFi.encryptionType(i);
+        networkCount++;
+    }
+    
+    resultsValid = true;
+    lastScanComplete = millis();
+    
+    Logger::addEntry("WiFi scan complete: " + String(networkCount) + " network(s) in " + String(lastScanComplete - lastScanStart) + "ms");
+}
@@ -0,0 +1,49 @@
+#ifndef WIFISCANCACHE_H
+#define WIFISCANCACHE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+struct WiFiNetwork {
+    String ssid;
+    int32_t rssi;
+    wifi_auth_mode_t encryption;
+};
+
+class WiFiScanCache {
+public:
+    static const int MAX_NETWORKS = 20;
+    static const unsigned long CACHE_TTL = 30000;          // Results older than this trigger a refresh
+    static const unsigned long MIN_SCAN_INTERVAL = 15000;  // Never start scans closer together than this
+    static const unsigned long SCAN_TIMEOUT = 10000;       // Give up on a scan that never completes
+
+    static void init();
+    static void loop();
+    
+    // Ask for fresh results; returns true if a scan is (now) in flight.
+    // Never blocks - callers always read whatever is cached.
+    static bool requestRefresh(bool force = false);
+    
+    static bool isScanning();
+    static bool hasResults();
+    static unsigned long getAge();
+    static int getNetworkCount();
+    static const WiFiNetwork& getNetwork(int index);
+    static unsigned long getScanCount();
+    static unsigned long getCoalescedCount();
+
+private:
+    static WiFiNetwork networks[MAX_NETWORKS];
+    static int networkCount;
+    static bool scanning;
+    static bool resultsValid;
+    static unsigned long lastScanStart;
+    static unsigned long lastScanComplete;
+    static unsigned long scanCount;
+    static unsigned long coalescedCount;
+    
+    static bool startScan();
+    static void collectResults(int found);
+};
+
+#endif
@@ -1,12 +1,12 @@
 #!/usr/bin/env python3
 """
 Post-build script for PlatformIO
-Generates firmware.meta JSON file and creates binary package with FLFW format
+Generates firmware.meta JSON file and creates binary package with FLFW format 2
 """
 
 import os
+import sys
 import json
-import struct
 import re
 from datetime import datetime
 from pathlib import Path
@@ -14,6 +14,10 @@ from pathlib import Path
 # Import PlatformIO environment
 Import("env")
 
+# The package layout and the LZSS packer live in create_firmware_package.py
+sys.path.insert(0, env["PROJECT_DIR"])
+import create_firmware_package
+
 def post_build(source, target, env):
     """
     Post-build hook that runs after successful compilation
@@ -244,34 +248,33 @@ def update_metadata_with_build_info(metadata, build_dir, firmware_file, firmware
 
 def create_binary_package(bin_path, metadata, firmware_hex):
     """
-    Create binary package with FLFW format:
-    [FLFW\0][MetadataLength][JSON Metadata][Intel HEX Firmware]
+    Create binary package with FLFW format 2:
+    [64 byte header: version, board, offsets, CRC32s][JSON Metadata][LZSS-packed HEX records]
     """
     try:
+        # Convert metadata to JSON string
+        json_metadata = json.dumps(metadata, separators=(',', ':'))
+        metadata_bytes = json_metadata.encode('utf-8')
+        metadata_length = len(metadata_bytes)
+        
+        # Intel HEX Firmware, compressed; the ESP32 decompresses it while flashing
+        with open(firmware_hex, 'rb') as hex_file:
+            firmware = hex_file.read()
+        
+        package_bytes = create_firmware_package.build_package_v2(metadata, metadata_bytes, firmware, compress=True)
+        package = create_firmware_package.read_package(package_bytes)
+        if create_firmware_package.hex_payload(package) != create_firmware_package.unpack_hex(create_firmware_package.pack_hex(firmware)):
+            raise ValueError("compressed payload does not decompress to the firmware")
+        
         with open(bin_path, 'wb') as bin_file:
-            # Magic Header: FLFW\0 (5 bytes)
-            bin_file.write(b'FLFW\0')
-            
-            # Convert metadata to JSON string
-            json_metadata = json.dumps(metadata, separators=(',', ':'))
-            metadata_bytes = json_metadata.encode('utf-8')
-            
-            # Metadata Length: 4-byte little-endian integer
-            metadata_length = len(metadata_bytes)
-            bin_file.write(struct.pack('<I', metadata_length))
-            
-            # JSON Metadata
-            bin_file.write(metadata_bytes)
-            
-            # Intel HEX Firmware
-            with open(firmware_hex, 'rb') as hex_file:
-                bin_file.write(hex_file.read())
+            bin_file.write(package_bytes)
                 
         print(f"📦 Created binary package:")
-        print(f"   Magic Header: FLFW\\0")
+        print(f"   Format: 2 ({package['board']}, version {package['version']})")
         print(f"   Metadata Length: {metadata_length} bytes")
         print(f"   JSON Metadata: {len(json_metadata)} characters")
-        print(f"   Firmware Size: {firmware_hex.stat().st_size} bytes")
+        print(f"   Firmware Size: {len(firmware)} bytes, {len(package['firmware'])} compressed "
+              f"({len(firmware) / len(package['firmware']):.2f}x)")
         print(f"   Total Package: {bin_path.stat().st_size} bytes")
             
     except Exception as e:
@@ -12,6 +12,12 @@
 #include "ConfigManager.h"
 #include "WebHandler.h"
 #include "OLEDManager.h"
+#include "WiFiScanCache.h"
+#include "Telemetry.h"
+#include "I2CBus.h"
+#include "BootSequencer.h"
+#include "BootProfiler.h"
+#include "HeapTracker.h"
 
 // Firmware version and board information
 #define FIRMWARE_VERSION "1.0.0"
@@ -22,34 +28,191 @@
 WebServer server(80);
 WiFiManager wifiManager;
 
+// How long to try the stored network before falling back to the config portal
+const unsigned long WIFI_CONNECT_TIMEOUT = 10000;
+// How long to try the cached access point before scanning for the network
+const unsigned long WIFI_DIRECT_TIMEOUT = 3000;
+
+// WiFi association state, see startWiFi()
+bool wifiDirected = false;           // Current attempt skips the channel scan
+unsigned long wifiScanStarted = 0;   // Phase time the full-scan attempt began
+unsigned long wifiConnectTime = 0;   // Time to a usable address, reported as telemetry
+
+// Startup phases, see setupBoot()
+BootSequencer boot(millis);
+
+// Telemetry sensors fed from loop() rather than sampled
+int loopLatencySensor = -1;
+int displayLatencySensor = -1;
+
 // Function prototypes
+void setupBoot();
 void setupWebServer();
+void setupTelemetry();
+void setupMQTTRoutes();
+bool startWiFi();
+void beginWiFi(bool directed);
+BootPhaseStatus pollWiFi(unsigned long elapsed);
+void onWiFiConnected(unsigned long elapsed);
+void logBootPhase(const BootSequencer& sequencer, int phase);
 
 void setup() {
     // Initialize serial for debugging
     Serial.begin(115200);
-    delay(1000);
+    BootProfiler::begin(FIRMWARE_VERSION);
+    
+    // Heap scopes opened on the loop task don't claim other tasks' allocations
+    HeapTracker::setThreadId([]() -> const void* {
+        return xTaskGetCurrentTaskHandle();
+    });
     
-    // Initialize all systems
     Logger::init();
-    ConfigManager::init();
-    LEDController::init();
-    I2CScanner::init();
-    FirmwareUpdater::init();
-    HomeAssistantMQTT::init();
+    Logger::addEntry("ESP32 C3 Mini 1 Starting...");
+    WiFiScanCache::init();
     
-    // Initialize OLED display if available
-    OLEDManager::init();
+    // Everything that doesn't wait on the network finishes here; WiFi
+    // association carries on from loop()
+    setupBoot();
+    boot.run();
     
-    // Startup sequence
-    Logger::addEntry("ESP32 C3 Mini 1 Starting...");
-    LEDController::startupSequence();
+    Logger::addEntry("Setup finished at " + String(millis()) + " ms");
+}
+
+void loop() {
+    unsigned long loopStart = micros();
+    
+    // Finish whatever boot phases are still running (WiFi association)
+    if (!boot.isComplete() && boot.run()) {
+        BootProfiler::finish(boot);
+    }
+    
+    // Allocations are counted per subsystem from here on, see /api/heap
+    {
+        HeapScope heapScope(HEAP_MODULE_WEB);
+        server.handleClient();
+    }
+    
+    // Collect background WiFi scan results
+    {
+        HeapScope heapScope(HEAP_MODULE_WIFI);
+        WiFiScanCache::loop();
+    }
+    
+    // Probe a few I2C addresses for the device registry
+    {
+        HeapScope heapScope(HEAP_MODULE_I2C);
+        I2CScanner::loop();
+    }
+    
+    // Commit any pending configuration changes
+    {
+        HeapScope heapScope(HEAP_MODULE_CONFIG);
+        ConfigManager::loop();
+    }
+    
+    // Animate light effects
+    LEDController::loop();
+    
+    // Dispatch MQTT commands received by the AsyncTCP task and publish
+    // the light state if it changed (rate limited)
+    {
+        HeapScope heapScope(HEAP_MODULE_MQTT);
+        HomeAssistantMQTT::publishLightState(LEDController::getLightState());
+        HomeAssistantMQTT::loop();
+    }
+    
+    // Update OLED display; the frame streams out from the flush task, so
+    // this is only the drawing and the hand-over
+    unsigned long displayStart = micros();
+    {
+        HeapScope heapScope(HEAP_MODULE_DISPLAY);
+        OLEDManager::updateDisplay();
+    }
+    Telemetry::record(displayLatencySensor, (micros() - displayStart) / 1000.0f);
     
-    // Initialize SPIFFS for storing WiFi credentials and serving HTML files
-    if (!SPIFFS.begin(true)) {
-        Logger::addEntry("SPIFFS initialization failed");
+    // Sample telemetry and publish one batch to Home Assistant every 30 seconds,
+    // held in the offline queue while disconnected
+    Telemetry::record(loopLatencySensor, (micros() - loopStart) / 1000.0f);
+    {
+        HeapScope heapScope(HEAP_MODULE_TELEMETRY);
+        if (Telemetry::loop(millis())) {
+            char payload[512];
+            unsigned long uptime = millis() / 1000;
+            
+            Logger::addEntry("Uptime: " + String(uptime) + "s, WiFi RSSI: " + String(WiFi.RSSI()) + " dBm");
+            
+            if (Telemetry::buildPayload(payload, sizeof(payload), uptime) > 0) {
+                HomeAssistantMQTT::publishTelemetry(payload);
+            }
+        }
     }
     
+    delay(10);
+}
+
+void setupBoot() {
+    boot.setListener(logBootPhase);
+    boot.setHeapProbe(BootProfiler::sampleHeap);
+    
+    // Status LED first, the light is back as soon as the LEDs are up
+    boot.add("leds", []() {
+        LEDController::init();
+        LEDController::startupSequence();
+        return true;
+    });
+    
+    // The config lives on SPIFFS, so mount it before reading anything
+    int spiffs = boot.add("spiffs", []() {
+        if (!SPIFFS.begin(true)) {
+            Logger::addEntry("SPIFFS initialization failed");
+            return false;
+        }
+        return true;
+    });
+    int config = boot.add("config", []() { return ConfigManager::init(); }, nullptr, BootSequencer::bit(spiffs));
+    
+    // Start associating early so it overlaps the I2C and display setup
+    int wifi = boot.add("wifi", startWiFi, nullptr, BootSequencer::bit(config));
+    int wifiConnect = boot.add("wifi_connect", nullptr, pollWiFi, BootSequencer::bit(wifi));
+    
+    int i2c = boot.add("i2c", []() {
+        I2CScanner::init();
+        return true;
+    });
+    boot.add("oled", []() { return OLEDManager::init(); }, nullptr, BootSequencer::bit(i2c));
+    boot.add("firmware", []() {
+        FirmwareUpdater::init();
+        return true;
+    }, nullptr, BootSequencer::bit(spiffs) | BootSequencer::bit(i2c));
+    
+    // The MQTT state machine waits for WiFi by itself. Sensors must be
+    // registered before the first connect renders discovery.
+    boot.add("mqtt", []() {
+        HomeAssistantMQTT::init();
+        setupMQTTRoutes();
+        setupTelemetry();
+        HomeAssistantMQTT::connect();
+        return true;
+    }, nullptr, BootSequencer::bit(config));
+    
+    // After the connection: the WiFiManager portal runs its own server on
+    // port 80 and blocks the loop that would serve this one
+    boot.add("web", []() {
+        setupWebServer();
+        server.begin();
+        Logger::addEntry("Web server started!");
+        return true;
+    }, nullptr, BootSequencer::bit(config) | BootSequencer::bit(wifiConnect));
+}
+
+void logBootPhase(const BootSequencer& sequencer, int phase) {
+    Logger::addEntry("Boot: " + String(sequencer.getName(phase)) +
+                     (sequencer.getStatus(phase) == BOOT_DONE ? " done" : " failed") +
+                     " at " + String(sequencer.getFinishedAt(phase)) + " ms (" +
+                     String(sequencer.getDuration(phase)) + " ms)");
+}
+
+bool startWiFi() {
     // Configure WiFi Manager
     wifiManager.setConfigPortalTimeout(180); // 3 minutes timeout
     wifiManager.setAPCallback([](WiFiManager *myWiFiManager) {
@@ -67,50 +230,83 @@ void setup() {
         ConfigManager::setWiFiConfig(ssid, password);
     });
     
-    // Try to connect to saved WiFi
-    Logger::addEntry("Attempting to connect to saved WiFi...");
+    WiFi.mode(WIFI_STA);
     
-    // Check if we have stored WiFi credentials
-    WiFiConfig storedWiFi = ConfigManager::getWiFiConfig();
+    // Association runs in the background, pollWiFi() picks up the result
+    const WiFiConfig& storedWiFi = ConfigManager::getWiFiConfig();
     if (storedWiFi.ssid.length() > 0) {
+        beginWiFi(storedWiFi.hasLink());
+    } else {
+        Logger::addEntry("No stored WiFi credentials");
+    }
+    return true;
+}
+
+void beginWiFi(bool directed) {
+    const WiFiConfig& storedWiFi = ConfigManager::getWiFiConfig();
+    wifiDirected = directed;
+    
+    // Only the scan is skipped; the address comes from DHCP unless a fixed one
+    // is configured. A cached lease can't be renewed without dropping it.
+    if (storedWiFi.staticIp) {
+        WiFi.config(IPAddress(storedWiFi.ip), IPAddress(storedWiFi.gateway),
+                    IPAddress(storedWiFi.subnet), IPAddress(storedWiFi.dns));
+    } else {
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+    
+    if (directed) {
+        Logger::addEntry("Attempting to connect to stored WiFi: " + storedWiFi.ssid +
+                         " (cached access point, channel " + String(storedWiFi.channel) + ")");
+        WiFi.begin(storedWiFi.ssid.c_str(), storedWiFi.password.c_str(), storedWiFi.channel, storedWiFi.bssid);
+    } else {
         Logger::addEntry("Attempting to connect to stored WiFi: " + storedWiFi.ssid);
         WiFi.begin(storedWiFi.ssid.c_str(), storedWiFi.password.c_str());
-        
-        // Wait for connection with timeout
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-            delay(500);
-            attempts++;
+    }
+}
+
+BootPhaseStatus pollWiFi(unsigned long elapsed) {
+    // Done once there's an address to use, not just an association
+    if (WiFi.status() == WL_CONNECTED && (uint32_t)WiFi.localIP() != 0) {
+        onWiFiConnected(elapsed);
+        return BOOT_DONE;
+    }
+    
+    if (ConfigManager::getWiFiConfig().ssid.length() > 0) {
+        // The access point was replaced or moved channel, scan for the network
+        if (wifiDirected && elapsed >= WIFI_DIRECT_TIMEOUT) {
+            Logger::addEntry("Cached access point not answering, scanning");
+            WiFi.disconnect();
+            wifiScanStarted = elapsed;
+            beginWiFi(false);
+            return BOOT_RUNNING;
         }
         
-        if (WiFi.status() == WL_CONNECTED) {
-            Logger::addEntry("Connected to stored WiFi successfully!");
-            // Ensure credentials are saved even when connecting to stored WiFi
-            String ssid = WiFi.SSID();
-            String password = WiFi.psk();
-            if (ssid.length() > 0) {
-                ConfigManager::setWiFiConfig(ssid, password);
-                Logger::addEntry("WiFi credentials confirmed and saved: " + ssid);
-            }
-        } else {
-            Logger::addEntry("Failed to connect to stored WiFi, entering setup mode");
-            if (!wifiManager.autoConnect("ESP32C3_Setup")) {
-                Logger::addEntry("Failed to connect and hit timeout");
-                LEDController::wifiFailed();
-                ESP.restart();
-            }
-        }
-    } else {
-        Logger::addEntry("No stored WiFi credentials, entering setup mode");
-        if (!wifiManager.autoConnect("ESP32C3_Setup")) {
-            Logger::addEntry("Failed to connect and hit timeout");
-            LEDController::wifiFailed();
-            ESP.restart();
+        if (elapsed - wifiScanStarted < WIFI_CONNECT_TIMEOUT) {
+            return BOOT_RUNNING;
         }
     }
     
-    // Connected to WiFi
-    Logger::addEntry("Connected to WiFi successfully!");
+    // The config portal blocks until it's done or times out
+    Logger::addEntry("Failed to connect to stored WiFi, entering setup mode");
+    if (!wifiManager.autoConnect("ESP32C3_Setup")) {
+        Logger::addEntry("Failed to connect and hit timeout");
+        LEDController::wifiFailed();
+        // Let the red flash show before restarting
+        delay(LEDController::STATUS_FLASH);
+        ESP.restart();
+        return BOOT_FAILED;
+    }
+    
+    onWiFiConnected(elapsed);
+    return BOOT_DONE;
+}
+
+void onWiFiConnected(unsigned long elapsed) {
+    wifiConnectTime = elapsed;
+    
+    Logger::addEntry("Connected to WiFi successfully in " + String(elapsed) + " ms" +
+                     (wifiDirected ? " (cached access point)" : ""));
     Logger::addEntry("IP Address: " + WiFi.localIP().toString());
     Logger::addEntry("MAC Address: " + WiFi.macAddress());
     Logger::addEntry("Signal Strength: " + String(WiFi.RSSI()) + " dBm");
@@ -121,69 +317,86 @@ void setup() {
     if (currentSSID.length() > 0) {
         ConfigManager::setWiFiConfig(currentSSID, currentPassword);
         Logger::addEntry("Current WiFi credentials saved: " + currentSSID);
+        
+        // Remember where the network was found for the next boot
+        ConfigManager::setWiFiLink(WiFi.BSSID(), WiFi.channel());
     }
     
     LEDController::wifiConnected();
-    
-    // Connect to Home Assistant via MQTT
-    HomeAssistantMQTT::connect();
-    
-    // Set up MQTT message callback to handle commands from Home Assistant
-    HomeAssistantMQTT::setMessageCallback([](const String& topic, const String& payload) {
-        // Handle LED control commands from Home Assistant
-        if (topic.endsWith("/led_control/set")) {
-            if (payload == "ON") {
-                LEDController::setColorByName("white"); // Default to white when turned on
-                HomeAssistantMQTT::publishLEDState("white");
-            } else if (payload == "OFF") {
-                LEDController::setColorByName("off");
-                HomeAssistantMQTT::publishLEDState("off");
-            }
+}
+
+void setupMQTTRoutes() {
+    // Handle LED control commands from Home Assistant
+    HomeAssistantMQTT::addRoute("led_control/set", [](const String& topic, const String& payload) {
+        if (payload == "ON") {
+            LEDController::setColorByName("white"); // Default to white when turned on
+            HomeAssistantMQTT::publishLEDState("white");
+        } else if (payload == "OFF") {
+            LEDController::setColorByName("off");
+            HomeAssistantMQTT::publishLEDState("off");
         }
     });
     
-    // Scan I2C bus
-    Logger::addEntry("Scanning I2C bus...");
-    I2CScanner::scan();
-    
-    // Setup web server
-    setupWebServer();
-    
-    // Start web server
-    server.begin();
-    Logger::addEntry("Web server started!");
-    
-    // Periodic tasks
-    Logger::addEntry("System initialization complete");
+    // Home Assistant JSON-schema light commands; state goes back out from loop()
+    HomeAssistantMQTT::addRoute(HomeAssistantMQTT::LIGHT_COMMAND_ROUTE, [](const String& topic, const String& payload) {
+        LightState state = LEDController::getLightState();
+        if (HomeAssistantMQTT::parseLightCommand(payload, state)) {
+            LEDController::applyLightState(state);
+        } else {
+            Logger::addEntry("Invalid light command: " + payload);
+        }
+    });
 }
 
-void loop() {
-    server.handleClient();
-    
-    // Handle MQTT operations
-    if (HomeAssistantMQTT::isConnected()) {
-        // MQTT client handles its own loop internally
-    }
-    
-    // Update OLED display
-    OLEDManager::updateDisplay();
-    
-    // Update uptime in log and publish to Home Assistant every 30 seconds
-    static unsigned long lastUptimeLog = 0;
-    if (millis() - lastUptimeLog > 30000) {
-        lastUptimeLog = millis();
-        String uptime = String(millis() / 1000);
-        int rssi = WiFi.RSSI();
-        
-        Logger::addEntry("Uptime: " + uptime + "s, WiFi RSSI: " + String(rssi) + " dBm");
-        
-        // Publish to Home Assistant if MQTT is connected
-        if (HomeAssistantMQTT::isConnected()) {
-            HomeAssistantMQTT::publishSystemStatus(uptime, rssi);
-        }
-    }
-    
-    delay(10);
+void setupTelemetry() {
+    Telemetry::addSensor("rssi", "WiFi Signal", "dBm", []() -> float {
+        return WiFi.RSSI();
+    }, 3);
+    Telemetry::addSensor("heap_free", "Free Heap", "B", []() -> float {
+        return ESP.getFreeHeap();
+    }, 2048);
+    Telemetry::addSensor("heap_min", "Heap Low-Water Mark", "B", []() -> float {
+        return ESP.getMinFreeHeap();
+    }, 512);
+    Telemetry::addSensor("heap_largest", "Largest Free Block", "B", []() -> float {
+        return ESP.getMaxAllocHeap();
+    }, 2048);
+    // Free heap that can't be handed out in one piece; String churn drives it up
+    Telemetry::addSensor("heap_frag", "Heap Fragmentation", "%", []() -> float {
+        return HeapTracker::fragmentation(ESP.getFreeHeap(), ESP.getMaxAllocHeap());
+    }, 2, 1);
+    Telemetry::addSensor("led_fps", "LED Frame Rate", "fps", []() -> float {
+        static unsigned long lastFrames = 0;
+        static unsigned long lastTime = 0;
+        unsigned long frames = LEDController::getFrameCount();
+        unsigned long now = millis();
+        float fps = lastTime == 0 ? 0 : (frames - lastFrames) * 1000.0f / (now - lastTime);
+        lastFrames = frames;
+        lastTime = now;
+        return fps;
+    }, 1, 1);
+    Telemetry::addSensor("flash_writes", "Config Flash Writes", "writes", []() -> float {
+        return ConfigManager::getFlashWrites();
+    }, 1);
+    Telemetry::addSensor("wifi_connect_ms", "WiFi Connect Time", "ms", []() -> float {
+        return wifiConnectTime;
+    }, 100);
+    loopLatencySensor = Telemetry::addSensor("loop_ms", "Loop Latency", "ms", nullptr, 1, 1);
+    displayLatencySensor = Telemetry::addSensor("oled_ms", "Display Loop Time", "ms", nullptr, 0.5, 2);
+    // Failed transactions to known devices, an early sign of marginal wiring
+    Telemetry::addSensor("i2c_error_rate", "I2C Error Rate", "%", []() -> float {
+        static unsigned long lastTransactions = 0;
+        static unsigned long lastErrors = 0;
+        const I2CBusStats& stats = I2CBus::getStats();
+        unsigned long transactions = stats.getTransactions() - lastTransactions;
+        unsigned long errors = stats.getErrors() - lastErrors;
+        lastTransactions += transactions;
+        lastErrors += errors;
+        return transactions == 0 ? 0 : errors * 100.0f / transactions;
+    }, 1, 1);
+    Telemetry::addSensor("i2c_errors", "I2C Errors", "errors", []() -> float {
+        return I2CBus::getStats().getErrors();
+    }, 1);
 }
 
 void setupWebServer() {
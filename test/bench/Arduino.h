@@ -0,0 +1,8 @@
+#ifndef BENCH_ARDUINO_H
+#define BENCH_ARDUINO_H
+
+// The bench environment compiles real libraries (Logger) for the host; they
+// include <Arduino.h> and get the test mocks instead
+#include "../mock_arduino.h"
+
+#endif // BENCH_ARDUINO_H
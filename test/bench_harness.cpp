@@ -0,0 +1,121 @@
+#include "bench_harness.h"
+#include "HeapTracker.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Outside run() so taking samples never allocates
+static double sampleNs[BenchHarness::MAX_SAMPLES];
+
+static uint64_t totalBytesAllocated() {
+    uint64_t total = 0;
+    for (int m = 0; m < HEAP_MODULE_COUNT; m++) {
+        total += HeapTracker::getCounters((HeapModule)m).bytesAllocated;
+    }
+    return total;
+}
+
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+BenchResult BenchHarness::run(const char* name, BenchFunction function, void* context,
+                              uint32_t samples, uint32_t warmup) {
+    if (samples == 0) {
+        samples = 1;
+    }
+    if (samples > MAX_SAMPLES) {
+        samples = MAX_SAMPLES;
+    }
+    if (warmup == 0) {
+        warmup = 1;
+    }
+    
+    // Warm caches and any lazily built state, and size the batch from it
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < warmup; i++) {
+        function(context);
+    }
+    double warmupNs = elapsedNs(start) / warmup;
+    
+    uint32_t batch = 1;
+    if (warmupNs > 0 && warmupNs < TARGET_SAMPLE_NS) {
+        batch = (uint32_t)(TARGET_SAMPLE_NS / warmupNs);
+        if (batch > MAX_BATCH) {
+            batch = MAX_BATCH;
+        }
+    }
+    
+    uint32_t allocationsBefore = HeapTracker::getAllocations();
+    uint64_t bytesBefore = totalBytesAllocated();
+    
+    double totalNs = 0;
+    for (uint32_t s = 0; s < samples; s++) {
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < batch; i++) {
+            function(context);
+        }
+        sampleNs[s] = elapsedNs(start) / batch;
+        totalNs += sampleNs[s];
+    }
+    
+    double calls = (double)samples * batch;
+    std::sort(sampleNs, sampleNs + samples);
+    
+    BenchResult result;
+    result.name = name;
+    result.samples = samples;
+    result.batch = batch;
+    result.medianNs = percentile(sampleNs, samples, 50);
+    result.p99Ns = percentile(sampleNs, samples, 99);
+    result.meanNs = totalNs / samples;
+    result.allocationsPerOp = (HeapTracker::getAllocations() - allocationsBefore) / calls;
+    result.bytesPerOp = (totalBytesAllocated() - bytesBefore) / calls;
+    return result;
+}
+
+double BenchHarness::percentile(const double* sorted, uint32_t count, double p) {
+    if (count == 0) {
+        return 0;
+    }
+    
+    // Nearest rank
+    uint32_t rank = (uint32_t)ceil(p / 100.0 * count);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > count) {
+        rank = count;
+    }
+    return sorted[rank - 1];
+}
+
+size_t BenchHarness::toJson(const BenchResult& result, char* out, size_t capacity) {
+    int written = snprintf(out, capacity,
+                           "{\"name\":\"%s\",\"samples\":%u,\"batch\":%u,\"median_ns\":%.1f,\"p99_ns\":%.1f,"
+                           "\"mean_ns\":%.1f,\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f}",
+                           result.name, (unsigned)result.samples, (unsigned)result.batch, result.medianNs,
+                           result.p99Ns, result.meanNs, result.allocationsPerOp, result.bytesPerOp);
+    if (written < 0 || (size_t)written >= capacity) {
+        return 0;
+    }
+    return written;
+}
+
+void BenchHarness::report(const BenchResult& result) {
+    char line[256];
+    if (toJson(result, line, sizeof(line)) == 0) {
+        return;
+    }
+    
+    printf("BENCH %s\n", line);
+    
+    const char* path = getenv("BENCH_OUTPUT");
+    FILE* file = fopen(path != nullptr ? path : "bench_output.txt", "a");
+    if (file != nullptr) {
+        fprintf(file, "%s\n", line);
+        fclose(file);
+    }
+}
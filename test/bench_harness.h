@@ -0,0 +1,44 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Timing harness for the benchmark target (pio test -e bench). Each sample
+// times a batch of calls so sub-microsecond operations stay well above the
+// clock resolution; times are per call. Allocations come from HeapTracker,
+// so they read zero in a build without HEAP_TRACKER_HOOK.
+struct BenchResult {
+    const char* name;
+    uint32_t samples;
+    uint32_t batch;             // Calls per sample
+    double medianNs;
+    double p99Ns;
+    double meanNs;
+    double allocationsPerOp;
+    double bytesPerOp;
+};
+
+typedef void (*BenchFunction)(void* context);
+
+class BenchHarness {
+public:
+    static const uint32_t DEFAULT_SAMPLES = 200;
+    static const uint32_t DEFAULT_WARMUP = 50;
+    static const uint32_t MAX_SAMPLES = 1000;
+    static const uint32_t TARGET_SAMPLE_NS = 20000;
+    static const uint32_t MAX_BATCH = 100000;
+    
+    static BenchResult run(const char* name, BenchFunction function, void* context,
+                           uint32_t samples = DEFAULT_SAMPLES, uint32_t warmup = DEFAULT_WARMUP);
+    
+    // One JSON object per line: printed as "BENCH {...}" and appended to
+    // $BENCH_OUTPUT (default bench_output.txt) for bench_compare.py
+    static void report(const BenchResult& result);
+    static size_t toJson(const BenchResult& result, char* out, size_t capacity);
+    
+    // Sorted samples; p from 0 to 100
+    static double percentile(const double* sorted, uint32_t count, double p);
+};
+
+#endif // BENCH_HARNESS_H
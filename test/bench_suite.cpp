@@ -0,0 +1,394 @@
+#ifdef BENCHMARK
+
+#include "bench_suite.h"
+#include "bench_harness.h"
+#include "Logger.h"
+#include "FirmwareFormat.h"
+#include "HexPayloadReader.h"
+#include "ConfigImage.h"
+#include "LightState.h"
+#include "Telemetry.h"
+#include "HeapTracker.h"
+#include "HeapReport.h"
+#include <string.h>
+#include <stdio.h>
+
+static const int HEX_DATA_LINES = 128;
+static const size_t HEX_LINE_SIZE = 44;     // ":10AAAA00" + 32 data digits + checksum + "\n"
+
+static volatile size_t sink;
+
+static void runAndReport(const char* name, BenchFunction function, void* context) {
+    BenchResult result = BenchHarness::run(name, function, context);
+    BenchHarness::report(result);
+    TEST_ASSERT_TRUE(result.medianNs > 0);
+}
+
+// Writes one 16-byte data record; returns the line length without the newline
+static size_t writeHexLine(char* out, uint16_t address, const uint8_t* data) {
+    uint8_t sum = 16 + (address >> 8) + (address & 0xFF);
+    int length = sprintf(out, ":10%04X00", address);
+    for (int i = 0; i < 16; i++) {
+        length += sprintf(out + length, "%02X", data[i]);
+        sum += data[i];
+    }
+    length += sprintf(out + length, "%02X", (uint8_t)(0x100 - sum));
+    return length;
+}
+
+// A firmware image the size of a small ATtiny build, with the version and
+// build date embedded as text part way through
+static size_t buildHexFile(char* out, size_t capacity) {
+    const char* banner = "FireLabs v1.0.2 2024-06-14 build";
+    size_t position = 0;
+    
+    for (int line = 0; line < HEX_DATA_LINES && position + HEX_LINE_SIZE < capacity; line++) {
+        uint8_t data[16];
+        for (int i = 0; i < 16; i++) {
+            data[i] = (uint8_t)(line * 31 + i * 7);
+        }
+        if (line == HEX_DATA_LINES / 2 || line == HEX_DATA_LINES / 2 + 1) {
+            memcpy(data, banner + (line - HEX_DATA_LINES / 2) * 16, 16);
+        }
+        position += writeHexLine(out + position, line * 16, data);
+        out[position++] = '\n';
+    }
+    
+    const char* eof = ":00000001FF\n";
+    memcpy(out + position, eof, strlen(eof));
+    position += strlen(eof);
+    out[position] = '\0';
+    return position;
+}
+
+// Logger
+
+static void addLogEntry(void*) {
+    Logger::addEntry("MQTT connected to 192.168.1.100:1883");
+}
+
+static void getLogEntries(void*) {
+    sink = Logger::getLogEntries().length();
+}
+
+void bench_logger_add_entry(void) {
+    Logger::init();
+    runAndReport("logger_add_entry", addLogEntry, nullptr);
+}
+
+void bench_logger_get_log_entries(void) {
+    // A full, wrapped buffer is what /api/logs sees after the first minutes of uptime
+    Logger::init();
+    for (int i = 0; i < Logger::MAX_LOG_ENTRIES + 10; i++) {
+        Logger::addEntry("Telemetry batch published (" + String(i) + " sensors)");
+    }
+    runAndReport("logger_get_log_entries", getLogEntries, nullptr);
+}
+
+// Intel HEX and the package container
+
+struct HexContext {
+    char file[HEX_DATA_LINES * HEX_LINE_SIZE + 32];
+    size_t length;
+    char line[64];
+    size_t lineLength;
+};
+
+static HexContext hex;
+
+static void prepareHex() {
+    hex.length = buildHexFile(hex.file, sizeof(hex.file));
+    const char* firstLine = hex.file + (HEX_DATA_LINES / 2) * HEX_LINE_SIZE;
+    hex.lineLength = HEX_LINE_SIZE - 1;
+    memcpy(hex.line, firstLine, hex.lineLength);
+    hex.line[hex.lineLength] = '\0';
+}
+
+static void validateHexLine(void* context) {
+    HexContext* h = (HexContext*)context;
+    sink = FirmwareFormat::isValidHexLine(h->line, h->lineLength) && FirmwareFormat::verifyChecksum(h->line, h->lineLength);
+}
+
+static void extractHexText(void* context) {
+    HexContext* h = (HexContext*)context;
+    char text[FirmwareFormat::MAX_HEX_DATA + 1];
+    sink = FirmwareFormat::extractText(h->line, h->lineLength, text, sizeof(text));
+}
+
+static void extractHexVersion(void* context) {
+    HexContext* h = (HexContext*)context;
+    char version[16];
+    char buildDate[16];
+    sink = FirmwareFormat::extractVersion(h->file, h->length, version, sizeof(version), buildDate, sizeof(buildDate));
+}
+
+void bench_hex_validate_line(void) {
+    prepareHex();
+    TEST_ASSERT_TRUE(FirmwareFormat::verifyChecksum(hex.line, hex.lineLength));
+    runAndReport("hex_validate_line", validateHexLine, &hex);
+}
+
+void bench_hex_extract_text(void) {
+    prepareHex();
+    runAndReport("hex_extract_text", extractHexText, &hex);
+}
+
+void bench_hex_extract_version(void) {
+    prepareHex();
+    char version[16];
+    char buildDate[16];
+    TEST_ASSERT_TRUE(FirmwareFormat::extractVersion(hex.file, hex.length, version, sizeof(version), buildDate, sizeof(buildDate)));
+    TEST_ASSERT_EQUAL_STRING("1.0.2", version);
+    TEST_ASSERT_EQUAL_STRING("2024-06-14", buildDate);
+    runAndReport("hex_extract_version", extractHexVersion, &hex);
+}
+
+struct PackageContext {
+    uint8_t data[1024];
+    size_t length;
+};
+
+static void parsePackageHeader(void* context) {
+    PackageContext* package = (PackageContext*)context;
+    FirmwarePackageLayout layout;
+    sink = FirmwareFormat::parsePackageHeader(package->data, package->length, package->length, layout);
+}
+
+void bench_package_parse_header(void) {
+    static PackageContext package;
+    const char* metadata = "{\"version\":\"1.0.2\",\"description\":\"LED controller\",\"build_date\":\"2024-06-14\","
+                           "\"board\":\"attiny1616\",\"features\":[\"rgb\",\"effects\"]}";
+    uint32_t metadataLength = strlen(metadata);
+    
+    memcpy(package.data, "FLFW\0", FirmwareFormat::PACKAGE_MAGIC_SIZE);
+    for (int i = 0; i < 4; i++) {
+        package.data[5 + i] = (metadataLength >> (8 * i)) & 0xFF;
+    }
+    memcpy(package.data + FirmwareFormat::PACKAGE_HEADER_SIZE, metadata, metadataLength);
+    package.length = FirmwareFormat::PACKAGE_HEADER_SIZE + metadataLength;
+    package.length += writeHexLine((char*)package.data + package.length, 0, (const uint8_t*)"0123456789abcdef");
+    
+    FirmwarePackageLayout layout;
+    TEST_ASSERT_EQUAL(PACKAGE_OK, FirmwareFormat::parsePackageHeader(package.data, package.length, package.length, layout));
+    runAndReport("package_parse_header", parsePackageHeader, &package);
+}
+
+// Firmware payloads, every line the way flashPayload reads them
+
+struct PayloadContext {
+    const uint8_t* data;
+    size_t length;
+    size_t position;
+    uint8_t payloadType;
+    uint32_t decodedLength;
+};
+
+static size_t readPayload(void* context, uint8_t* buffer, size_t capacity) {
+    PayloadContext* payload = (PayloadContext*)context;
+    size_t count = payload->length - payload->position;
+    if (count > capacity) {
+        count = capacity;
+    }
+    memcpy(buffer, payload->data + payload->position, count);
+    payload->position += count;
+    return count;
+}
+
+static void readPayloadLines(void* context) {
+    PayloadContext* payload = (PayloadContext*)context;
+    payload->position = 0;
+    HexPayloadReader reader(payload->payloadType, payload->length, payload->decodedLength, readPayload, payload);
+    char line[FirmwareFormat::MIN_HEX_LINE + 2 * FirmwareFormat::MAX_HEX_DATA + 1];
+    size_t length = 0;
+    while (reader.nextLine(line, sizeof(line), length)) {
+        sink = length;
+    }
+}
+
+// The records of a HEX file packed and stored as LZSS literals only, the
+// decoder's slowest case; returns the stream length
+static size_t packLiterals(const char* file, size_t fileLength, uint8_t* out, uint32_t& decodedLength) {
+    size_t bits = 0;
+    decodedLength = 0;
+    memset(out, 0, (HEX_DATA_LINES + 1) * (FirmwareFormat::PACKED_RECORD_HEADER + 16) * 9 / 8 + 1);
+    
+    const char* line = file;
+    while (line < file + fileLength) {
+        const char* newline = (const char*)memchr(line, '\n', file + fileLength - line);
+        size_t lineLength = newline != nullptr ? (size_t)(newline - line) : (size_t)(file + fileLength - line);
+        HexRecord record;
+        if (FirmwareFormat::decodeRecord(line, lineLength, record)) {
+            uint8_t packed[FirmwareFormat::PACKED_RECORD_HEADER + FirmwareFormat::MAX_HEX_DATA];
+            packed[0] = record.length;
+            packed[1] = record.address >> 8;
+            packed[2] = record.address & 0xFF;
+            packed[3] = record.type;
+            memcpy(packed + FirmwareFormat::PACKED_RECORD_HEADER, record.data, record.length);
+            
+            for (size_t i = 0; i < FirmwareFormat::PACKED_RECORD_HEADER + record.length; i++) {
+                uint16_t token = 0x100 | packed[i];
+                for (int bit = 8; bit >= 0; bit--, bits++) {
+                    if ((token >> bit) & 1) {
+                        out[bits / 8] |= 0x80 >> (bits % 8);
+                    }
+                }
+                decodedLength++;
+            }
+        }
+        line += lineLength + 1;
+    }
+    return (bits + 7) / 8;
+}
+
+void bench_payload_lines_hex(void) {
+    prepareHex();
+    static PayloadContext payload;
+    payload.data = (const uint8_t*)hex.file;
+    payload.length = hex.length;
+    payload.payloadType = PAYLOAD_INTEL_HEX;
+    payload.decodedLength = 0;
+    runAndReport("payload_lines_hex", readPayloadLines, &payload);
+}
+
+void bench_payload_lines_lzss(void) {
+    prepareHex();
+    static uint8_t stream[(HEX_DATA_LINES + 1) * (FirmwareFormat::PACKED_RECORD_HEADER + 16) * 9 / 8 + 1];
+    static PayloadContext payload;
+    payload.data = stream;
+    payload.length = packLiterals(hex.file, hex.length, stream, payload.decodedLength);
+    payload.payloadType = PAYLOAD_HEX_LZSS;
+    
+    // Same lines as the HEX text
+    payload.position = 0;
+    HexPayloadReader reader(PAYLOAD_HEX_LZSS, payload.length, payload.decodedLength, readPayload, &payload);
+    char line[64];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(reader.nextLine(line, sizeof(line), length));
+    TEST_ASSERT_EQUAL(0, strncmp(line, hex.file, length));
+    while (reader.nextLine(line, sizeof(line), length)) {
+    }
+    TEST_ASSERT_EQUAL(HEX_PAYLOAD_END, reader.getStatus());
+    TEST_ASSERT_EQUAL(HEX_DATA_LINES + 1, reader.getLineNumber());
+    runAndReport("payload_lines_lzss", readPayloadLines, &payload);
+}
+
+// Config image, through the encode and decode ConfigManager uses
+
+struct ConfigContext {
+    MQTTConfig mqtt;
+    WiFiConfig wifi;
+    uint8_t image[512];
+    size_t size;
+};
+
+static void fillConfig(ConfigContext* config) {
+    static const uint8_t bssid[6] = { 0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56 };
+    
+    config->mqtt.brokerIP = "192.168.1.100";
+    config->mqtt.brokerPort = 1883;
+    config->mqtt.username = "homeassistant";
+    config->mqtt.password = "supersecretpassword";
+    config->mqtt.deviceName = "Bookshelf Lights";
+    config->mqtt.deviceId = "bookshelf_lights_1";
+    config->mqtt.mqttPrefix = "homeassistant";
+    config->wifi.ssid = "FireLabs-IoT";
+    config->wifi.password = "another-long-passphrase";
+    memcpy(config->wifi.bssid, bssid, sizeof(bssid));
+    config->wifi.channel = 6;
+    
+    // A fixed address, so every field is in the image
+    config->wifi.staticIp = true;
+    config->wifi.ip = 0x6401A8C0;
+    config->wifi.gateway = 0x0101A8C0;
+    config->wifi.subnet = 0x00FFFFFF;
+    config->wifi.dns = 0x0101A8C0;
+}
+
+static void saveConfig(void* context) {
+    ConfigContext* config = (ConfigContext*)context;
+    config->size = ConfigImage::encode(config->mqtt, config->wifi, 1, config->image, sizeof(config->image));
+}
+
+static void loadConfig(void* context) {
+    ConfigContext* config = (ConfigContext*)context;
+    MQTTConfig mqtt;
+    WiFiConfig wifi;
+    uint16_t schema = 0;
+    sink = ConfigImage::decode(config->image, config->size, mqtt, wifi, schema);
+    sink = mqtt.deviceName.length() + wifi.ip;
+}
+
+void bench_config_save(void) {
+    static ConfigContext config;
+    fillConfig(&config);
+    saveConfig(&config);
+    TEST_ASSERT_TRUE(config.size > 0);
+    runAndReport("config_save", saveConfig, &config);
+}
+
+void bench_config_load(void) {
+    static ConfigContext config;
+    fillConfig(&config);
+    saveConfig(&config);
+    
+    MQTTConfig mqtt;
+    WiFiConfig wifi = {};
+    uint16_t schema = 0;
+    TEST_ASSERT_EQUAL(ConfigReader::OK, ConfigImage::decode(config.image, config.size, mqtt, wifi, schema));
+    TEST_ASSERT_TRUE(mqtt.deviceId == config.mqtt.deviceId);
+    TEST_ASSERT_EQUAL(config.wifi.dns, wifi.dns);
+    runAndReport("config_load", loadConfig, &config);
+}
+
+// JSON responses
+
+static void buildHeapStatsResponse(void*) {
+    // /api/heap, with fixed heap readings
+    sink = HeapReport::toJson(182344, 110580, 151208).length();
+}
+
+static void buildLightStateJson(void* context) {
+    const LightState* state = (const LightState*)context;
+    char json[256];
+    sink = state->toJson(json, sizeof(json));
+}
+
+static void buildTelemetryPayload(void*) {
+    // A value that moves past every threshold, so each sensor is in each batch
+    static unsigned long batch = 0;
+    batch++;
+    for (int i = 0; i < Telemetry::getSensorCount(); i++) {
+        Telemetry::record(i, (float)(batch % 100) + i);
+    }
+    
+    char payload[512];
+    sink = Telemetry::buildPayload(payload, sizeof(payload), 3600);
+}
+
+void bench_json_heap_stats_response(void) {
+    runAndReport("json_heap_stats_response", buildHeapStatsResponse, nullptr);
+}
+
+void bench_json_light_state(void) {
+    static LightState state;
+    state.on = true;
+    state.brightness = 180;
+    state.red = 255;
+    state.green = 120;
+    state.blue = 40;
+    state.effect = LIGHT_EFFECT_RAINBOW;
+    runAndReport("json_light_state", buildLightStateJson, &state);
+}
+
+void bench_json_telemetry_payload(void) {
+    // The sensors main.cpp registers
+    Telemetry::clear();
+    const char* keys[] = { "loop_ms", "heap", "heap_min", "heap_largest", "heap_frag", "rssi", "wifi_connect_ms", "temperature" };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        Telemetry::addSensor(keys[i], keys[i], "", nullptr, 0.5f, 1);
+    }
+    runAndReport("json_telemetry_payload", buildTelemetryPayload, nullptr);
+    Telemetry::clear();
+}
+
+#endif // BENCHMARK
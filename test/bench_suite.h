@@ -0,0 +1,22 @@
+#ifndef BENCH_SUITE_H
+#define BENCH_SUITE_H
+
+#include <unity.h>
+
+// Benchmarks - built into the bench environment only (-DBENCHMARK), where
+// the real Logger replaces mock_logger.cpp
+void bench_logger_add_entry(void);
+void bench_logger_get_log_entries(void);
+void bench_hex_validate_line(void);
+void bench_hex_extract_text(void);
+void bench_hex_extract_version(void);
+void bench_package_parse_header(void);
+void bench_payload_lines_hex(void);
+void bench_payload_lines_lzss(void);
+void bench_config_save(void);
+void bench_config_load(void);
+void bench_json_heap_stats_response(void);
+void bench_json_light_state(void);
+void bench_json_telemetry_payload(void);
+
+#endif // BENCH_SUITE_H
@@ -95,6 +95,10 @@ public:
     }
     
     size_t length() const { return data.length(); }
+    bool concat(const char* str, unsigned int length) {
+        data.append(str, length);
+        return true;
+    }
     
     // Fix method ambiguity by removing the default parameter version
     ArduinoString substring(size_t from, size_t to) const {
@@ -0,0 +1,74 @@
+#include "mock_i2c_bus.h"
+
+MockI2CBus* MockI2CBus::active = nullptr;
+
+MockI2CBus::MockI2CBus()
+    : releaseAfterPulses(3), clockHz(I2CProbe::NORMAL_CLOCK), timeoutMs(I2CProbe::NORMAL_TIMEOUT),
+      elapsedMicros(0), jammed(false), sclHigh(true), sdaDrivenLow(false), pulses(0) {
+    for (int i = 0; i < 128; i++) {
+        devices[i] = ABSENT;
+    }
+}
+
+void MockI2CBus::setDevice(uint8_t address, Device device) {
+    devices[address] = device;
+}
+
+void MockI2CBus::configure(uint32_t clock, uint16_t timeout) {
+    clockHz = clock;
+    timeoutMs = timeout;
+}
+
+uint8_t MockI2CBus::probe(uint8_t address) {
+    elapsedMicros += DRIVER_OVERHEAD_US;
+    
+    // Addressing the jammed device leaves it stuck mid-byte
+    if (devices[address] == JAMMED) {
+        jammed = true;
+        pulses = 0;
+    }
+    
+    if (jammed) {
+        // Can't even generate START, the driver waits out the timeout
+        elapsedMicros += timeoutMs * 1000UL;
+        return 5;
+    }
+    
+    if (devices[address] == STRETCHING) {
+        elapsedMicros += timeoutMs * 1000UL;
+        return 5;
+    }
+    
+    elapsedMicros += PROBE_BITS * 1000000UL / clockHz;
+    return devices[address] == PRESENT ? 0 : 2;
+}
+
+bool MockI2CBus::isSdaHigh() const {
+    return !jammed && !sdaDrivenLow;
+}
+
+I2CLines MockI2CBus::lines() {
+    active = this;
+    I2CLines lines = { setScl, setSda, readSda, delayMicros };
+    return lines;
+}
+
+void MockI2CBus::setScl(bool high) {
+    // Each rising edge shifts one bit out of the stuck device
+    if (high && !active->sclHigh && active->jammed && ++active->pulses >= active->releaseAfterPulses) {
+        active->jammed = false;
+    }
+    active->sclHigh = high;
+}
+
+void MockI2CBus::setSda(bool high) {
+    active->sdaDrivenLow = !high;
+}
+
+bool MockI2CBus::readSda() {
+    return active->isSdaHigh();
+}
+
+void MockI2CBus::delayMicros(uint32_t micros) {
+    active->elapsedMicros += micros;
+}
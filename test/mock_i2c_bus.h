@@ -0,0 +1,56 @@
+#ifndef MOCK_I2C_BUS_H
+#define MOCK_I2C_BUS_H
+
+#include <stdint.h>
+#include "I2CProbe.h"
+
+// Timing simulator for address probes on a shared I2C bus. Time is virtual:
+// each probe costs driver overhead plus the bit periods on the wire, or the
+// full timeout when a device holds SCL. One device can be made to jam SDA
+// low until the master clocks it out.
+class MockI2CBus {
+public:
+    enum Device {
+        ABSENT,
+        PRESENT,
+        STRETCHING,   // Busy, holds SCL low past any timeout
+        JAMMED        // Stuck mid-byte holding SDA low
+    };
+    
+    static const uint32_t DRIVER_OVERHEAD_US = 50;
+    static const int PROBE_BITS = 11;  // START, 7-bit address + R/W, ACK, STOP
+    
+    MockI2CBus();
+    
+    void setDevice(uint8_t address, Device device);
+    void configure(uint32_t clockHz, uint16_t timeoutMs);
+    
+    // Returns the ESP32 Wire endTransmission() code
+    uint8_t probe(uint8_t address);
+    
+    bool isSdaHigh() const;
+    unsigned long getElapsedMicros() const { return elapsedMicros; }
+    
+    // Line access for I2CProbe::recoverBus, bound to the active instance
+    I2CLines lines();
+    
+    int releaseAfterPulses;  // Clock pulses a jammed device needs
+
+private:
+    Device devices[128];
+    uint32_t clockHz;
+    uint16_t timeoutMs;
+    unsigned long elapsedMicros;
+    bool jammed;
+    bool sclHigh;
+    bool sdaDrivenLow;
+    int pulses;
+    
+    static MockI2CBus* active;
+    static void setScl(bool high);
+    static void setSda(bool high);
+    static bool readSda();
+    static void delayMicros(uint32_t micros);
+};
+
+#endif // MOCK_I2C_BUS_H
@@ -1,5 +1,8 @@
 #include "mock_logger.h"
 
+// The bench environment links the real Logger instead
+#ifndef BENCHMARK
+
 // Mock Logger implementation for testing
 String Logger::logEntries[MAX_LOG_ENTRIES];
 int Logger::logIndex = 0;
@@ -87,3 +90,5 @@ String Logger::getLogEntries() {
     
     return logText;
 }
+
+#endif // BENCHMARK
@@ -0,0 +1,57 @@
+#include "mock_mqtt_broker.h"
+
+static const std::string EMPTY;
+
+void MockMqttBroker::publish(const char* topic, const char* payload, bool retain, unsigned long now) {
+    Message message;
+    message.topic = topic;
+    message.payload = payload;
+    message.retain = retain;
+    message.timestamp = now;
+    messages.push_back(message);
+    
+    if (retain) {
+        retained[topic] = payload;
+    }
+}
+
+void MockMqttBroker::clear() {
+    messages.clear();
+    retained.clear();
+}
+
+size_t MockMqttBroker::messageCount(const std::string& topic) const {
+    size_t count = 0;
+    for (size_t i = 0; i < messages.size(); i++) {
+        if (messages[i].topic == topic) count++;
+    }
+    return count;
+}
+
+size_t MockMqttBroker::peakMessagesPerSecond(const std::string& topic) const {
+    std::vector<unsigned long> times;
+    for (size_t i = 0; i < messages.size(); i++) {
+        if (messages[i].topic == topic) times.push_back(messages[i].timestamp);
+    }
+    
+    // Messages are recorded in time order, so slide a window over them
+    size_t peak = 0;
+    size_t start = 0;
+    for (size_t end = 0; end < times.size(); end++) {
+        while (times[end] - times[start] >= 1000) start++;
+        if (end - start + 1 > peak) peak = end - start + 1;
+    }
+    return peak;
+}
+
+const std::string& MockMqttBroker::lastPayload(const std::string& topic) const {
+    for (size_t i = messages.size(); i > 0; i--) {
+        if (messages[i - 1].topic == topic) return messages[i - 1].payload;
+    }
+    return EMPTY;
+}
+
+const std::string& MockMqttBroker::retainedPayload(const std::string& topic) const {
+    std::map<std::string, std::string>::const_iterator it = retained.find(topic);
+    return it == retained.end() ? EMPTY : it->second;
+}
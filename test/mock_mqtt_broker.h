@@ -0,0 +1,35 @@
+#ifndef MOCK_MQTT_BROKER_H
+#define MOCK_MQTT_BROKER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// In-process stand-in for a broker: records every publish with its
+// timestamp so tests can measure message rates and retained state
+class MockMqttBroker {
+public:
+    struct Message {
+        std::string topic;
+        std::string payload;
+        bool retain;
+        unsigned long timestamp;
+    };
+    
+    void publish(const char* topic, const char* payload, bool retain, unsigned long now);
+    void clear();
+    
+    size_t messageCount(const std::string& topic) const;
+    
+    // Highest number of messages on a topic inside any 1000 ms window
+    size_t peakMessagesPerSecond(const std::string& topic) const;
+    
+    const std::string& lastPayload(const std::string& topic) const;
+    const std::string& retainedPayload(const std::string& topic) const;
+
+private:
+    std::vector<Message> messages;
+    std::map<std::string, std::string> retained;
+};
+
+#endif // MOCK_MQTT_BROKER_H
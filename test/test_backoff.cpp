@@ -0,0 +1,44 @@
+#include "test_backoff.h"
+#include "Backoff.h"
+
+void test_backoff_doubles_to_cap(void) {
+    Backoff backoff(1000, 60000, 0);
+    
+    const unsigned long expected[] = {1000, 2000, 4000, 8000, 16000, 32000, 60000, 60000};
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_UINT32(expected[i], backoff.next(12345));
+    }
+    TEST_ASSERT_EQUAL(8, backoff.getAttempts());
+}
+
+void test_backoff_jitter_range(void) {
+    // 50% jitter: every delay lands in [base / 2, base]
+    Backoff backoff(1000, 60000, 50);
+    uint32_t seed = 1;
+    
+    for (int attempt = 0; attempt < 10; attempt++) {
+        unsigned long base = backoff.getBaseDelay();
+        seed = seed * 1103515245 + 12345;
+        unsigned long delay = backoff.next(seed);
+        TEST_ASSERT_TRUE(delay >= base / 2);
+        TEST_ASSERT_TRUE(delay <= base);
+    }
+    
+    // Different random draws give different delays for the same base
+    Backoff first(8000, 60000, 50);
+    Backoff second(8000, 60000, 50);
+    TEST_ASSERT_TRUE(first.next(17) != second.next(2901));
+}
+
+void test_backoff_reset(void) {
+    Backoff backoff(500, 10000, 25);
+    backoff.next(0);
+    backoff.next(0);
+    backoff.next(0);
+    TEST_ASSERT_EQUAL_UINT32(4000, backoff.getBaseDelay());
+    
+    backoff.reset();
+    TEST_ASSERT_EQUAL_UINT32(500, backoff.getBaseDelay());
+    TEST_ASSERT_EQUAL(0, backoff.getAttempts());
+    TEST_ASSERT_EQUAL_UINT32(500, backoff.next(0));
+}
@@ -0,0 +1,11 @@
+#ifndef TEST_BACKOFF_H
+#define TEST_BACKOFF_H
+
+#include <unity.h>
+
+// Backoff Tests
+void test_backoff_doubles_to_cap(void);
+void test_backoff_jitter_range(void);
+void test_backoff_reset(void);
+
+#endif // TEST_BACKOFF_H
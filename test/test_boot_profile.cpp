@@ -0,0 +1,118 @@
+#include "test_boot_profile.h"
+#include "BootProfile.h"
+#include <string.h>
+
+static unsigned long fakeNow = 0;
+static unsigned long fakeClock() { return fakeNow; }
+
+static uint32_t fakeHeap = 0;
+static uint32_t fakeHeapProbe() { return fakeHeap; }
+
+static bool startConfig() { fakeNow += 12; fakeHeap -= 300; return true; }
+static bool startDisplay() { fakeNow += 40; fakeHeap -= 1100; return true; }
+static bool startBroken() { return false; }
+
+static BootProfile makeProfile(uint32_t bootCount, const char* firmware, uint32_t completedAt) {
+    BootProfile profile;
+    profile.setFirmware(firmware);
+    profile.setBootCount(bootCount);
+    profile.setResetReason(1);
+    profile.add("core", 0, 210, -42000, BOOT_DONE);
+    profile.add("wifi_connect", 300, completedAt, -9000, BOOT_DONE);
+    profile.finish(completedAt, 180000, 171000);
+    return profile;
+}
+
+void test_boot_profile_captures_sequencer(void) {
+    fakeNow = 100;
+    fakeHeap = 200000;
+    
+    BootSequencer boot(fakeClock);
+    boot.setHeapProbe(fakeHeapProbe);
+    int config = boot.add("config", startConfig);
+    boot.add("oled", startDisplay, nullptr, BootSequencer::bit(config));
+    boot.add("broken", startBroken);
+    TEST_ASSERT_TRUE(boot.run());
+    
+    BootProfile profile;
+    profile.add("core", 0, 100, -40000, BOOT_DONE);
+    profile.capture(boot);
+    TEST_ASSERT_EQUAL(4, profile.getPhaseCount());
+    
+    int oled = profile.findPhase("oled");
+    TEST_ASSERT_EQUAL(2, oled);
+    TEST_ASSERT_EQUAL(112, profile.getPhase(oled).startedAt);
+    TEST_ASSERT_EQUAL(40, profile.getPhase(oled).duration());
+    TEST_ASSERT_EQUAL(-1100, profile.getPhase(oled).heapDelta);
+    TEST_ASSERT_EQUAL(-300, profile.getPhase(profile.findPhase("config")).heapDelta);
+    TEST_ASSERT_EQUAL(BOOT_FAILED, profile.getPhase(profile.findPhase("broken")).status);
+    
+    // "core" is the longest at 100 ms
+    TEST_ASSERT_EQUAL(0, profile.getLongestPhase());
+    TEST_ASSERT_EQUAL(-1, profile.findPhase("mqtt"));
+}
+
+void test_boot_history_round_trip(void) {
+    BootHistory history;
+    for (uint32_t boot = 1; boot <= BootHistory::MAX_BOOTS + 2; boot++) {
+        history.push(makeProfile(boot, boot <= 3 ? "1.0.0" : "1.1.0", 2000 + boot * 100));
+    }
+    
+    // The oldest boots dropped off, newest first
+    TEST_ASSERT_EQUAL(BootHistory::MAX_BOOTS, history.getCount());
+    TEST_ASSERT_EQUAL(BootHistory::MAX_BOOTS + 2, history.get(0).getBootCount());
+    TEST_ASSERT_EQUAL(3, history.get(BootHistory::MAX_BOOTS - 1).getBootCount());
+    
+    static uint8_t image[BootHistory::MAX_SIZE];
+    size_t size = history.serialize(image, sizeof(image));
+    TEST_ASSERT_TRUE(size > BootHistory::HEADER_SIZE);
+    
+    BootHistory loaded;
+    TEST_ASSERT_TRUE(loaded.deserialize(image, size));
+    TEST_ASSERT_EQUAL(history.getCount(), loaded.getCount());
+    for (int i = 0; i < loaded.getCount(); i++) {
+        const BootProfile& expected = history.get(i);
+        const BootProfile& actual = loaded.get(i);
+        TEST_ASSERT_EQUAL(expected.getBootCount(), actual.getBootCount());
+        TEST_ASSERT_EQUAL_STRING(expected.getFirmware(), actual.getFirmware());
+        TEST_ASSERT_EQUAL(expected.getCompletedAt(), actual.getCompletedAt());
+        TEST_ASSERT_EQUAL(expected.getMinFreeHeap(), actual.getMinFreeHeap());
+        TEST_ASSERT_EQUAL(expected.getPhaseCount(), actual.getPhaseCount());
+        TEST_ASSERT_EQUAL_STRING("wifi_connect", actual.getPhase(1).name);
+        TEST_ASSERT_EQUAL(-42000, actual.getPhase(0).heapDelta);
+    }
+    
+    // Pushing onto a loaded history keeps the order
+    loaded.push(makeProfile(99, "1.2.0", 1500));
+    TEST_ASSERT_EQUAL(99, loaded.get(0).getBootCount());
+    TEST_ASSERT_EQUAL(BootHistory::MAX_BOOTS + 2, loaded.get(1).getBootCount());
+    
+    // Too small a buffer fails rather than truncating
+    TEST_ASSERT_EQUAL(0, history.serialize(image, size - 1));
+}
+
+void test_boot_history_rejects_corruption(void) {
+    BootHistory history;
+    history.push(makeProfile(7, "1.0.0", 2500));
+    
+    uint8_t image[BootHistory::MAX_SIZE];
+    size_t size = history.serialize(image, sizeof(image));
+    
+    BootHistory loaded;
+    image[size - 3] ^= 0x01;
+    TEST_ASSERT_FALSE(loaded.deserialize(image, size));
+    TEST_ASSERT_EQUAL(0, loaded.getCount());
+    image[size - 3] ^= 0x01;
+    
+    TEST_ASSERT_FALSE(loaded.deserialize(image, size - 1));
+    TEST_ASSERT_FALSE(loaded.deserialize(image, 4));
+    
+    // A future format is dropped rather than misread
+    image[4] = BootHistory::FORMAT_VERSION + 1;
+    TEST_ASSERT_FALSE(loaded.deserialize(image, size));
+    image[4] = BootHistory::FORMAT_VERSION;
+    
+    TEST_ASSERT_TRUE(loaded.deserialize(image, size));
+    TEST_ASSERT_EQUAL(1, loaded.getCount());
+    TEST_ASSERT_EQUAL(7, loaded.get(0).getBootCount());
+}
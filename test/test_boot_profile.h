@@ -0,0 +1,11 @@
+#ifndef TEST_BOOT_PROFILE_H
+#define TEST_BOOT_PROFILE_H
+
+#include <unity.h>
+
+// BootProfile Tests
+void test_boot_profile_captures_sequencer(void);
+void test_boot_history_round_trip(void);
+void test_boot_history_rejects_corruption(void);
+
+#endif // TEST_BOOT_PROFILE_H
@@ -0,0 +1,107 @@
+#include "test_boot_sequencer.h"
+#include "BootSequencer.h"
+#include <string.h>
+
+static unsigned long fakeNow = 0;
+static unsigned long fakeClock() { return fakeNow; }
+
+// Start order, as phase names joined by spaces
+static char order[128];
+static void note(const char* name) {
+    strcat(order, name);
+    strcat(order, " ");
+}
+
+static bool startA() { note("a"); fakeNow += 5; return true; }
+static bool startB() { note("b"); fakeNow += 20; return true; }
+static bool startC() { note("c"); return true; }
+static bool startFail() { note("fail"); return false; }
+
+static bool wifiConnected = false;
+static BootPhaseStatus pollWiFi(unsigned long elapsed) {
+    return wifiConnected ? BOOT_DONE : BOOT_RUNNING;
+}
+
+static int finishedPhases = 0;
+static void countFinished(const BootSequencer& sequencer, int phase) {
+    finishedPhases++;
+}
+
+void test_boot_sequencer_dependency_order(void) {
+    fakeNow = 0;
+    order[0] = '\0';
+    finishedPhases = 0;
+    
+    // Registered backwards: c needs a and b, b needs a
+    BootSequencer boot(fakeClock);
+    boot.setListener(countFinished);
+    int c = boot.add("c", startC, nullptr, BootSequencer::bit(2) | BootSequencer::bit(1));
+    int b = boot.add("b", startB, nullptr, BootSequencer::bit(2));
+    int a = boot.add("a", startA);
+    TEST_ASSERT_EQUAL(2, a);
+    
+    TEST_ASSERT_TRUE(boot.run());
+    TEST_ASSERT_EQUAL_STRING("a b c ", order);
+    TEST_ASSERT_EQUAL(3, finishedPhases);
+    
+    // Each phase is timed from its own start
+    TEST_ASSERT_EQUAL_UINT32(0, boot.getStartedAt(a));
+    TEST_ASSERT_EQUAL_UINT32(5, boot.getDuration(a));
+    TEST_ASSERT_EQUAL_UINT32(5, boot.getStartedAt(b));
+    TEST_ASSERT_EQUAL_UINT32(20, boot.getDuration(b));
+    TEST_ASSERT_EQUAL_UINT32(25, boot.getStartedAt(c));
+    TEST_ASSERT_EQUAL_UINT32(25, boot.getCompletedAt());
+    TEST_ASSERT_EQUAL(BOOT_DONE, boot.getStatus(c));
+}
+
+void test_boot_sequencer_overlaps_running_phase(void) {
+    fakeNow = 0;
+    order[0] = '\0';
+    wifiConnected = false;
+    
+    BootSequencer boot(fakeClock);
+    int config = boot.add("a", startA);
+    int wifi = boot.add("wifi", nullptr, pollWiFi, BootSequencer::bit(config));
+    int i2c = boot.add("b", startB);
+    int mqtt = boot.add("c", startC, nullptr, BootSequencer::bit(wifi));
+    
+    // WiFi keeps running, independent phases don't wait for it
+    TEST_ASSERT_FALSE(boot.run());
+    TEST_ASSERT_EQUAL_STRING("a b ", order);
+    TEST_ASSERT_EQUAL(BOOT_RUNNING, boot.getStatus(wifi));
+    TEST_ASSERT_TRUE(boot.isFinished(i2c));
+    TEST_ASSERT_EQUAL(BOOT_WAITING, boot.getStatus(mqtt));
+    
+    fakeNow = 1000;
+    TEST_ASSERT_FALSE(boot.run());
+    
+    wifiConnected = true;
+    fakeNow = 2000;
+    TEST_ASSERT_TRUE(boot.run());
+    TEST_ASSERT_EQUAL_STRING("a b c ", order);
+    TEST_ASSERT_EQUAL_UINT32(2000, boot.getFinishedAt(wifi));
+    TEST_ASSERT_EQUAL_UINT32(2000 - 5, boot.getDuration(wifi));
+    TEST_ASSERT_EQUAL_UINT32(2000, boot.getCompletedAt());
+}
+
+void test_boot_sequencer_failed_dependency(void) {
+    fakeNow = 0;
+    order[0] = '\0';
+    
+    BootSequencer boot(fakeClock);
+    int spiffs = boot.add("fail", startFail);
+    int config = boot.add("c", startC, nullptr, BootSequencer::bit(spiffs));
+    
+    // A failed phase still counts as finished, the dependent decides what to do
+    TEST_ASSERT_TRUE(boot.run());
+    TEST_ASSERT_EQUAL_STRING("fail c ", order);
+    TEST_ASSERT_EQUAL(BOOT_FAILED, boot.getStatus(spiffs));
+    TEST_ASSERT_EQUAL(BOOT_DONE, boot.getStatus(config));
+    
+    // Table limit
+    BootSequencer full(fakeClock);
+    for (int i = 0; i < BootSequencer::MAX_PHASES; i++) {
+        TEST_ASSERT_EQUAL(i, full.add("c", startC));
+    }
+    TEST_ASSERT_EQUAL(-1, full.add("c", startC));
+}
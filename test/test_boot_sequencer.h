@@ -0,0 +1,11 @@
+#ifndef TEST_BOOT_SEQUENCER_H
+#define TEST_BOOT_SEQUENCER_H
+
+#include <unity.h>
+
+// BootSequencer Tests
+void test_boot_sequencer_dependency_order(void);
+void test_boot_sequencer_overlaps_running_phase(void);
+void test_boot_sequencer_failed_dependency(void);
+
+#endif // TEST_BOOT_SEQUENCER_H
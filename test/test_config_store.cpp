@@ -0,0 +1,164 @@
+#include "test_config_store.h"
+#include "ConfigStore.h"
+#include <string.h>
+#include <stdio.h>
+#include <chrono>
+
+// Same field ids ConfigManager uses
+enum {
+    FIELD_MQTT_BROKER_IP = 1,
+    FIELD_MQTT_BROKER_PORT = 2,
+    FIELD_MQTT_USERNAME = 3,
+    FIELD_MQTT_PASSWORD = 4,
+    FIELD_MQTT_DEVICE_NAME = 5,
+    FIELD_MQTT_DEVICE_ID = 6,
+    FIELD_MQTT_PREFIX = 7,
+    FIELD_WIFI_SSID = 16,
+    FIELD_WIFI_PASSWORD = 17
+};
+
+// The equivalent document as the old /config.json stored it
+static const char* LEGACY_JSON =
+    "{\"mqtt\":{\"brokerIP\":\"192.168.1.100\",\"brokerPort\":1883,\"username\":\"homeassistant\","
+    "\"password\":\"supersecretpassword\",\"deviceName\":\"Bookshelf Lights\",\"deviceId\":\"bookshelf_lights_1\","
+    "\"mqttPrefix\":\"homeassistant\"},\"wifi\":{\"ssid\":\"FireLabs-IoT\",\"password\":\"another-long-passphrase\"}}";
+
+static void writeString(ConfigWriter& writer, uint8_t id, const char* value) {
+    writer.writeString(id, value, strlen(value));
+}
+
+static size_t buildSampleImage(uint8_t* buffer, size_t capacity) {
+    ConfigWriter writer(buffer, capacity);
+    writeString(writer, FIELD_MQTT_BROKER_IP, "192.168.1.100");
+    writer.writeU16(FIELD_MQTT_BROKER_PORT, 1883);
+    writeString(writer, FIELD_MQTT_USERNAME, "homeassistant");
+    writeString(writer, FIELD_MQTT_PASSWORD, "supersecretpassword");
+    writeString(writer, FIELD_MQTT_DEVICE_NAME, "Bookshelf Lights");
+    writeString(writer, FIELD_MQTT_DEVICE_ID, "bookshelf_lights_1");
+    writeString(writer, FIELD_MQTT_PREFIX, "homeassistant");
+    writeString(writer, FIELD_WIFI_SSID, "FireLabs-IoT");
+    writeString(writer, FIELD_WIFI_PASSWORD, "another-long-passphrase");
+    return writer.finish(1);
+}
+
+static bool fieldEquals(const ConfigField& field, const char* expected) {
+    return field.length == strlen(expected) && memcmp(field.value, expected, field.length) == 0;
+}
+
+void test_config_store_round_trip(void) {
+    uint8_t buffer[256];
+    size_t size = buildSampleImage(buffer, sizeof(buffer));
+    TEST_ASSERT_GREATER_THAN(0, size);
+    
+    ConfigReader reader;
+    TEST_ASSERT_EQUAL(ConfigReader::OK, reader.open(buffer, size));
+    TEST_ASSERT_EQUAL(1, reader.getSchemaVersion());
+    TEST_ASSERT_EQUAL(9, reader.getFieldCount());
+    
+    ConfigField field;
+    int seen = 0;
+    while (reader.next(field)) {
+        seen++;
+        if (field.id == FIELD_MQTT_BROKER_PORT) {
+            TEST_ASSERT_EQUAL(CONFIG_TYPE_U16, field.type);
+            TEST_ASSERT_EQUAL(1883, field.asU32());
+        } else if (field.id == FIELD_MQTT_DEVICE_ID) {
+            TEST_ASSERT_EQUAL(CONFIG_TYPE_STRING, field.type);
+            TEST_ASSERT_TRUE(fieldEquals(field, "bookshelf_lights_1"));
+        } else if (field.id == FIELD_WIFI_SSID) {
+            TEST_ASSERT_TRUE(fieldEquals(field, "FireLabs-IoT"));
+        }
+    }
+    TEST_ASSERT_EQUAL(9, seen);
+}
+
+void test_config_store_rejects_corruption(void) {
+    uint8_t buffer[256];
+    size_t size = buildSampleImage(buffer, sizeof(buffer));
+    ConfigReader reader;
+    
+    // Flipped payload bit
+    buffer[ConfigStore::HEADER_SIZE + 5] ^= 0x01;
+    TEST_ASSERT_EQUAL(ConfigReader::BAD_CRC, reader.open(buffer, size));
+    buffer[ConfigStore::HEADER_SIZE + 5] ^= 0x01;
+    
+    // Truncated write
+    TEST_ASSERT_EQUAL(ConfigReader::BAD_LENGTH, reader.open(buffer, size - 3));
+    TEST_ASSERT_EQUAL(ConfigReader::TOO_SHORT, reader.open(buffer, 10));
+    
+    // Not a config image at all
+    TEST_ASSERT_EQUAL(ConfigReader::BAD_MAGIC, reader.open((const uint8_t*)LEGACY_JSON, strlen(LEGACY_JSON)));
+    
+    // A failed open must not leave fields to iterate
+    ConfigField field;
+    TEST_ASSERT_FALSE(reader.next(field));
+}
+
+void test_config_store_skips_unknown_fields(void) {
+    // Image from a "newer" firmware with a field this one doesn't know
+    uint8_t buffer[128];
+    ConfigWriter writer(buffer, sizeof(buffer));
+    writer.writeU16(FIELD_MQTT_BROKER_PORT, 8883);
+    uint8_t future[] = {1, 2, 3, 4, 5, 6};
+    writer.writeBlob(200, future, sizeof(future));
+    writer.writeBool(201, true);
+    writeString(writer, FIELD_WIFI_SSID, "shelf");
+    size_t size = writer.finish(7);
+    
+    ConfigReader reader;
+    TEST_ASSERT_EQUAL(ConfigReader::OK, reader.open(buffer, size));
+    TEST_ASSERT_EQUAL(7, reader.getSchemaVersion());
+    
+    ConfigField field;
+    int port = 0;
+    bool ssidFound = false;
+    while (reader.next(field)) {
+        if (field.id == FIELD_MQTT_BROKER_PORT) port = field.asU32();
+        if (field.id == FIELD_WIFI_SSID) ssidFound = fieldEquals(field, "shelf");
+        if (field.id == 201) TEST_ASSERT_TRUE(field.asBool());
+    }
+    TEST_ASSERT_EQUAL(8883, port);
+    TEST_ASSERT_TRUE(ssidFound);
+}
+
+void test_config_store_overflow(void) {
+    uint8_t buffer[32];
+    ConfigWriter writer(buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(writer.writeU32(1, 42));
+    TEST_ASSERT_FALSE(writer.writeString(2, "this string does not fit in the buffer", 38));
+    TEST_ASSERT_TRUE(writer.overflowed());
+    TEST_ASSERT_EQUAL(0, writer.finish(1));
+}
+
+void bench_config_store_load(void) {
+    uint8_t buffer[256];
+    size_t size = buildSampleImage(buffer, sizeof(buffer));
+    
+    const int iterations = 20000;
+    volatile uint32_t sink = 0;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        ConfigReader reader;
+        if (reader.open(buffer, size) != ConfigReader::OK) {
+            TEST_ASSERT_TRUE(false);
+            return;
+        }
+        ConfigField field;
+        while (reader.next(field)) {
+            sink += field.length;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double nsPerLoad = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    
+    char message[160];
+    snprintf(message, sizeof(message), "config load: %.0f ns/op, image %u bytes (JSON %u bytes, JSON doc capacity 1024), reader state %u bytes",
+             nsPerLoad, (unsigned)size, (unsigned)strlen(LEGACY_JSON), (unsigned)sizeof(ConfigReader));
+    TEST_MESSAGE(message);
+    
+    // The binary image must stay smaller than the JSON it replaces, and
+    // decoding needs no heap beyond the file buffer
+    TEST_ASSERT_LESS_THAN(strlen(LEGACY_JSON), size);
+    TEST_ASSERT_LESS_OR_EQUAL(64, sizeof(ConfigReader));
+}
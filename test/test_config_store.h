@@ -0,0 +1,15 @@
+#ifndef TEST_CONFIG_STORE_H
+#define TEST_CONFIG_STORE_H
+
+#include <unity.h>
+
+// ConfigStore Tests
+void test_config_store_round_trip(void);
+void test_config_store_rejects_corruption(void);
+void test_config_store_skips_unknown_fields(void);
+void test_config_store_overflow(void);
+
+// ConfigStore Benchmarks
+void bench_config_store_load(void);
+
+#endif // TEST_CONFIG_STORE_H
@@ -0,0 +1,41 @@
+#include "test_crc32.h"
+#include "Crc32.h"
+#include <string.h>
+
+void test_crc32_known_vectors(void) {
+    // Reference values from zlib.crc32, which the packaging scripts use
+    const char* check = "123456789";
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, Crc32::compute((const uint8_t*)check, strlen(check)));
+    TEST_ASSERT_EQUAL_HEX32(0x00000000, Crc32::compute((const uint8_t*)"", 0));
+    
+    const char* config = "{\"wifi\":{\"ssid\":\"\",\"password\":\"\"}}";
+    TEST_ASSERT_EQUAL_HEX32(0x914AB58E, Crc32::compute((const uint8_t*)config, strlen(config)));
+}
+
+void test_crc32_incremental_update(void) {
+    const char* data = "FireLabs bookshelf light controller";
+    size_t length = strlen(data);
+    uint32_t whole = Crc32::compute((const uint8_t*)data, length);
+    
+    // Any split point must give the same result as one pass
+    for (size_t split = 0; split <= length; split++) {
+        uint32_t crc = Crc32::update(0, (const uint8_t*)data, split);
+        crc = Crc32::update(crc, (const uint8_t*)data + split, length - split);
+        TEST_ASSERT_EQUAL_HEX32(whole, crc);
+    }
+}
+
+void test_crc32_detects_corruption(void) {
+    uint8_t buffer[64];
+    for (int i = 0; i < 64; i++) {
+        buffer[i] = (uint8_t)(i * 7);
+    }
+    uint32_t original = Crc32::compute(buffer, sizeof(buffer));
+    
+    // Every single-bit flip must change the CRC
+    for (int bit = 0; bit < 64 * 8; bit++) {
+        buffer[bit / 8] ^= (1 << (bit % 8));
+        TEST_ASSERT_NOT_EQUAL(original, Crc32::compute(buffer, sizeof(buffer)));
+        buffer[bit / 8] ^= (1 << (bit % 8));
+    }
+}
@@ -0,0 +1,11 @@
+#ifndef TEST_CRC32_H
+#define TEST_CRC32_H
+
+#include <unity.h>
+
+// Crc32 Tests
+void test_crc32_known_vectors(void);
+void test_crc32_incremental_update(void);
+void test_crc32_detects_corruption(void);
+
+#endif // TEST_CRC32_H
@@ -0,0 +1,118 @@
+#include "test_discovery_cache.h"
+#include "DiscoveryCache.h"
+#include "mock_mqtt_broker.h"
+#include <string.h>
+#include <stdio.h>
+
+static const unsigned long PACE = 50;
+static const unsigned long LOOP_PERIOD = 10;
+
+static void render(DiscoveryCache& cache, uint32_t generation, int entities) {
+    cache.begin(generation);
+    
+    char topic[64];
+    char payload[128];
+    for (int i = 0; i < entities; i++) {
+        snprintf(topic, sizeof(topic), "homeassistant/sensor/dev/entity_%d/config", i);
+        snprintf(payload, sizeof(payload), "{\"name\":\"Entity %d\",\"unique_id\":\"dev_%d\",\"generation\":%u}", i, i, (unsigned)generation);
+        TEST_ASSERT_TRUE(cache.add(topic, payload, strlen(payload), true));
+    }
+}
+
+// Loop until the replay finishes, publishing whatever is due
+static unsigned long replay(DiscoveryCache& cache, MockMqttBroker& broker, unsigned long now) {
+    cache.startReplay();
+    while (cache.isReplaying()) {
+        int index = cache.nextDue(now);
+        if (index >= 0) {
+            broker.publish(cache.getTopic(index), cache.getPayload(index), cache.getRetain(index), now);
+            cache.markSent(now);
+        }
+        now += LOOP_PERIOD;
+    }
+    return now;
+}
+
+void test_discovery_cache_render_once(void) {
+    DiscoveryCache cache(PACE);
+    MockMqttBroker broker;
+    
+    TEST_ASSERT_FALSE(cache.isCurrent(1));
+    render(cache, 1, 5);
+    TEST_ASSERT_TRUE(cache.isCurrent(1));
+    TEST_ASSERT_FALSE(cache.isReplaying());
+    
+    // A reconnect storm replays the same bytes without re-rendering
+    unsigned long now = 0;
+    for (int reconnect = 0; reconnect < 10; reconnect++) {
+        now = replay(cache, broker, now);
+    }
+    TEST_ASSERT_EQUAL(1, cache.getRenderCount());
+    TEST_ASSERT_EQUAL(10, cache.getReplayCount());
+    TEST_ASSERT_EQUAL(10, broker.messageCount("homeassistant/sensor/dev/entity_4/config"));
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"Entity 4\",\"unique_id\":\"dev_4\",\"generation\":1}",
+                             broker.retainedPayload("homeassistant/sensor/dev/entity_4/config").c_str());
+    
+    // A new config generation is rendered fresh
+    TEST_ASSERT_FALSE(cache.isCurrent(2));
+    render(cache, 2, 3);
+    TEST_ASSERT_EQUAL(3, cache.size());
+    TEST_ASSERT_EQUAL(2, cache.getRenderCount());
+}
+
+void test_discovery_cache_paced_replay(void) {
+    DiscoveryCache cache(PACE);
+    MockMqttBroker broker;
+    render(cache, 1, DiscoveryCache::MAX_ENTRIES);
+    
+    cache.startReplay();
+    unsigned long now = 1000;
+    unsigned long last = 0;
+    int sent = 0;
+    while (cache.isReplaying()) {
+        int index = cache.nextDue(now);
+        if (index >= 0) {
+            if (sent > 0) {
+                TEST_ASSERT_TRUE(now - last >= PACE);
+            }
+            TEST_ASSERT_EQUAL(sent, index);
+            cache.markSent(now);
+            last = now;
+            sent++;
+        }
+        now += LOOP_PERIOD;
+    }
+    
+    TEST_ASSERT_EQUAL(DiscoveryCache::MAX_ENTRIES, sent);
+    TEST_ASSERT_EQUAL(-1, cache.nextDue(now + PACE));
+}
+
+void test_discovery_cache_retries_refused_publish(void) {
+    DiscoveryCache cache(PACE);
+    render(cache, 1, 2);
+    
+    cache.startReplay();
+    TEST_ASSERT_EQUAL(0, cache.nextDue(0));
+    
+    // Client refused (send buffer full): nothing marked, same entry next loop
+    TEST_ASSERT_EQUAL(0, cache.nextDue(10));
+    cache.markSent(10);
+    TEST_ASSERT_EQUAL(-1, cache.nextDue(20));
+    TEST_ASSERT_EQUAL(1, cache.nextDue(60));
+}
+
+void test_discovery_cache_overflow(void) {
+    DiscoveryCache cache(PACE);
+    cache.begin(1);
+    
+    static char payload[DiscoveryCache::ARENA_SIZE];
+    memset(payload, 'x', sizeof(payload));
+    
+    TEST_ASSERT_FALSE(cache.add("too/big", payload, sizeof(payload), true));
+    TEST_ASSERT_TRUE(cache.add("fits", payload, DiscoveryCache::ARENA_SIZE - 16, true));
+    TEST_ASSERT_FALSE(cache.add("no/room", payload, 16, true));
+    TEST_ASSERT_EQUAL(1, cache.size());
+    TEST_ASSERT_EQUAL(2, cache.getOverflowCount());
+    TEST_ASSERT_EQUAL(DiscoveryCache::ARENA_SIZE - 16, cache.getPayloadLength(0));
+    TEST_ASSERT_EQUAL('\0', cache.getPayload(0)[DiscoveryCache::ARENA_SIZE - 16]);
+}
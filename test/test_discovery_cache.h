@@ -0,0 +1,12 @@
+#ifndef TEST_DISCOVERY_CACHE_H
+#define TEST_DISCOVERY_CACHE_H
+
+#include <unity.h>
+
+// DiscoveryCache Tests
+void test_discovery_cache_render_once(void);
+void test_discovery_cache_paced_replay(void);
+void test_discovery_cache_retries_refused_publish(void);
+void test_discovery_cache_overflow(void);
+
+#endif // TEST_DISCOVERY_CACHE_H
@@ -0,0 +1,171 @@
+#include "test_firmware_format.h"
+#include "FirmwareFormat.h"
+#include <string.h>
+
+static bool validLine(const char* line) {
+    return FirmwareFormat::isValidHexLine(line, strlen(line));
+}
+
+static bool checksumOk(const char* line) {
+    return FirmwareFormat::verifyChecksum(line, strlen(line));
+}
+
+void test_firmware_format_hex_lines(void) {
+    // "Hello World" at 0x0000 and the end-of-file record
+    const char* data = ":0B00000048656C6C6F20576F726C64D9";
+    TEST_ASSERT_TRUE(validLine(data));
+    TEST_ASSERT_TRUE(checksumOk(data));
+    TEST_ASSERT_TRUE(checksumOk(":00000001FF"));
+    
+    TEST_ASSERT_FALSE(checksumOk(":0B00000048656C6C6F20576F726C64DA"));
+    TEST_ASSERT_FALSE(checksumOk(":00000001F"));         // Half a byte
+    TEST_ASSERT_FALSE(validLine("0B0000004865"));        // No start code
+    TEST_ASSERT_FALSE(validLine(":0000000"));            // Too short
+    TEST_ASSERT_FALSE(validLine(":0B00000048656C6C6G")); // Not hex
+    TEST_ASSERT_FALSE(FirmwareFormat::isValidHexLine(nullptr, 20));
+    
+    char text[16];
+    TEST_ASSERT_EQUAL(11, FirmwareFormat::extractText(data, strlen(data), text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("Hello World", text);
+    
+    // Truncated to the buffer, still terminated
+    TEST_ASSERT_EQUAL(4, FirmwareFormat::extractText(data, strlen(data), text, 5));
+    TEST_ASSERT_EQUAL_STRING("Hell", text);
+    
+    TEST_ASSERT_TRUE(FirmwareFormat::isValidDate("2024-06-14", 10, '-'));
+    TEST_ASSERT_FALSE(FirmwareFormat::isValidDate("2024/06/14", 10, '-'));
+    TEST_ASSERT_FALSE(FirmwareFormat::isValidDate("2024-13-01", 10, '-'));
+    TEST_ASSERT_FALSE(FirmwareFormat::isValidDate("2031-01-01", 10, '-'));
+}
+
+void test_firmware_format_decode_record(void) {
+    HexRecord record;
+    const char* data = ":02100000AABB89";
+    TEST_ASSERT_TRUE(FirmwareFormat::decodeRecord(data, strlen(data), record));
+    TEST_ASSERT_EQUAL(2, record.length);
+    TEST_ASSERT_EQUAL(0x1000, record.address);
+    TEST_ASSERT_EQUAL(HEX_RECORD_DATA, record.type);
+    TEST_ASSERT_EQUAL(0xAA, record.data[0]);
+    TEST_ASSERT_EQUAL(0xBB, record.data[1]);
+    
+    TEST_ASSERT_TRUE(FirmwareFormat::decodeRecord(":00000001FF", 11, record));
+    TEST_ASSERT_EQUAL(HEX_RECORD_EOF, record.type);
+    TEST_ASSERT_EQUAL(0, record.length);
+    
+    // Checksum fine, but the byte count says 1 and the line carries 2
+    TEST_ASSERT_FALSE(FirmwareFormat::decodeRecord(":01000000486552", 15, record));
+    TEST_ASSERT_FALSE(FirmwareFormat::decodeRecord(":00000006FA", 11, record)); // Unknown type
+    TEST_ASSERT_FALSE(FirmwareFormat::decodeRecord(":02100000AABB88", 15, record));
+    TEST_ASSERT_FALSE(FirmwareFormat::decodeRecord(nullptr, 15, record));
+}
+
+void test_firmware_format_extract_version(void) {
+    // "FW 1.0.1", a line with no date, then "2024/03/09", CRLF line endings and no final newline
+    const char* hex =
+        ":08000000465720312E302E314D\r\n"
+        ":0A000800323032340730330730394C\r\n"
+        ":0A001200323032342F30332F3039F2";
+    char version[16];
+    char buildDate[16];
+    
+    TEST_ASSERT_TRUE(FirmwareFormat::extractVersion(hex, strlen(hex), version, sizeof(version), buildDate, sizeof(buildDate)));
+    TEST_ASSERT_EQUAL_STRING("1.0.1", version);
+    TEST_ASSERT_EQUAL_STRING("2024/03/09", buildDate);
+    
+    const char* plain = ":0B00000048656C6C6F20576F726C64D9\n:00000001FF\n";
+    TEST_ASSERT_FALSE(FirmwareFormat::extractVersion(plain, strlen(plain), version, sizeof(version), buildDate, sizeof(buildDate)));
+    TEST_ASSERT_EQUAL_STRING("Unknown", version);
+    TEST_ASSERT_EQUAL_STRING("Unknown", buildDate);
+}
+
+void test_firmware_format_package_header(void) {
+    uint8_t package[64];
+    memset(package, 0, sizeof(package));
+    memcpy(package, "FLFW\0", 5);
+    package[5] = 20; // Metadata length, little-endian
+    FirmwarePackageLayout layout;
+    
+    TEST_ASSERT_EQUAL(PACKAGE_OK, FirmwareFormat::parsePackageHeader(package, sizeof(package), sizeof(package), layout));
+    TEST_ASSERT_EQUAL(9, layout.metadataOffset);
+    TEST_ASSERT_EQUAL(20, layout.metadataLength);
+    TEST_ASSERT_EQUAL(29, layout.firmwareOffset);
+    TEST_ASSERT_EQUAL(35, layout.firmwareLength);
+    
+    // Ends right after the metadata: valid header, no firmware
+    TEST_ASSERT_EQUAL(PACKAGE_OK, FirmwareFormat::parsePackageHeader(package, sizeof(package), 29, layout));
+    TEST_ASSERT_EQUAL(0, layout.firmwareLength);
+    
+    TEST_ASSERT_EQUAL(PACKAGE_TRUNCATED, FirmwareFormat::parsePackageHeader(package, sizeof(package), 28, layout));
+    TEST_ASSERT_EQUAL(PACKAGE_TOO_SHORT, FirmwareFormat::parsePackageHeader(package, 8, sizeof(package), layout));
+    TEST_ASSERT_EQUAL(PACKAGE_TOO_SHORT, FirmwareFormat::parsePackageHeader(package, sizeof(package), 9, layout));
+    TEST_ASSERT_EQUAL(PACKAGE_TOO_LARGE, FirmwareFormat::parsePackageHeader(package, sizeof(package), FirmwareFormat::MAX_PACKAGE_SIZE + 1, layout));
+    
+    package[7] = 1; // 64 KiB of metadata
+    TEST_ASSERT_EQUAL(PACKAGE_BAD_METADATA_LENGTH, FirmwareFormat::parsePackageHeader(package, sizeof(package), sizeof(package), layout));
+    package[5] = 0;
+    package[7] = 0;
+    TEST_ASSERT_EQUAL(PACKAGE_BAD_METADATA_LENGTH, FirmwareFormat::parsePackageHeader(package, sizeof(package), sizeof(package), layout));
+    
+    package[0] = 'X';
+    TEST_ASSERT_EQUAL(PACKAGE_BAD_MAGIC, FirmwareFormat::parsePackageHeader(package, sizeof(package), sizeof(package), layout));
+    TEST_ASSERT_EQUAL_STRING("Invalid package magic header", FirmwareFormat::packageStatusToString(PACKAGE_BAD_MAGIC));
+}
+
+// Written by create_firmware_package.py for version 1.0.6 on FL-LC01
+static const uint8_t PACKAGE_V2_HEADER[64] = {
+    0x46, 0x4C, 0x46, 0x57, 0x02, 0x00, 0x40, 0x00, 0x01, 0x00, 0x01, 0x00, 0x06, 0x00, 0x00, 0x00,
+    0xA3, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, 0xD3, 0x37, 0xE0, 0x19, 0x40, 0x00, 0x00, 0x00,
+    0x63, 0x00, 0x00, 0x00, 0x57, 0xF6, 0x92, 0xDC, 0x54, 0x2C, 0xB3, 0x68, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xD6, 0x3A, 0x67, 0xBB
+};
+static const char PACKAGE_V2_METADATA[] =
+    "{\"firmware\":{\"version\":\"1.0.6\",\"board\":\"FL-LC01\"},\"build_info\":{\"timestamp\":\"2025-08-30T16:52:36\"}}";
+static const char PACKAGE_V2_FIRMWARE[] = ":00000001FF\n";
+
+void test_firmware_format_package_header_v2(void) {
+    uint8_t package[175];
+    memcpy(package, PACKAGE_V2_HEADER, 64);
+    memcpy(package + 64, PACKAGE_V2_METADATA, 99);
+    memcpy(package + 163, PACKAGE_V2_FIRMWARE, 12);
+    FirmwarePackageLayout layout;
+    
+    TEST_ASSERT_EQUAL(PACKAGE_OK, FirmwareFormat::parsePackageHeader(package, sizeof(package), sizeof(package), layout));
+    TEST_ASSERT_EQUAL(2, layout.formatVersion);
+    TEST_ASSERT_EQUAL(PAYLOAD_INTEL_HEX, layout.payloadType);
+    TEST_ASSERT_EQUAL_STRING("FL-LC01", FirmwareFormat::boardName(layout.boardId));
+    TEST_ASSERT_EQUAL(1, layout.versionMajor);
+    TEST_ASSERT_EQUAL(0, layout.versionMinor);
+    TEST_ASSERT_EQUAL(6, layout.versionPatch);
+    TEST_ASSERT_EQUAL(64, layout.metadataOffset);
+    TEST_ASSERT_EQUAL(99, layout.metadataLength);
+    TEST_ASSERT_EQUAL(163, layout.firmwareOffset);
+    TEST_ASSERT_EQUAL(12, layout.firmwareLength);
+    TEST_ASSERT_EQUAL(PACKAGE_OK, FirmwareFormat::verifyPackage(package, sizeof(package), layout));
+    
+    char date[11];
+    TEST_ASSERT_TRUE(FirmwareFormat::formatBuildDate(layout.buildTime, date, sizeof(date)));
+    TEST_ASSERT_EQUAL_STRING("2025-08-30", date);
+    TEST_ASSERT_TRUE(FirmwareFormat::formatBuildDate(951782400, date, sizeof(date)));
+    TEST_ASSERT_EQUAL_STRING("2000-02-29", date);
+    TEST_ASSERT_FALSE(FirmwareFormat::formatBuildDate(0, date, sizeof(date)));
+    TEST_ASSERT_EQUAL_STRING("Unknown", date);
+    
+    // The header alone is enough to list a stored package
+    TEST_ASSERT_EQUAL(PACKAGE_OK, FirmwareFormat::parsePackageHeader(package, 64, sizeof(package), layout));
+    TEST_ASSERT_EQUAL(PACKAGE_TOO_SHORT, FirmwareFormat::parsePackageHeader(package, 10, sizeof(package), layout));
+    TEST_ASSERT_EQUAL(PACKAGE_TRUNCATED, FirmwareFormat::parsePackageHeader(package, sizeof(package), 174, layout));
+    
+    package[170] ^= 0x01;
+    TEST_ASSERT_EQUAL(PACKAGE_OK, FirmwareFormat::parsePackageHeader(package, sizeof(package), sizeof(package), layout));
+    TEST_ASSERT_EQUAL(PACKAGE_BAD_CHECKSUM, FirmwareFormat::verifyPackage(package, sizeof(package), layout));
+    package[170] ^= 0x01;
+    
+    package[12] = 7;  // Patch version, without fixing the header CRC
+    TEST_ASSERT_EQUAL(PACKAGE_BAD_HEADER_CRC, FirmwareFormat::parsePackageHeader(package, sizeof(package), sizeof(package), layout));
+    package[4] = 3;
+    TEST_ASSERT_EQUAL(PACKAGE_UNSUPPORTED_FORMAT, FirmwareFormat::parsePackageHeader(package, sizeof(package), sizeof(package), layout));
+    
+    TEST_ASSERT_EQUAL(1, FirmwareFormat::boardId("FL-LC01"));
+    TEST_ASSERT_EQUAL(FirmwareFormat::BOARD_UNKNOWN, FirmwareFormat::boardId("FL-XX99"));
+    TEST_ASSERT_NULL(FirmwareFormat::boardName(FirmwareFormat::BOARD_UNKNOWN));
+}
@@ -0,0 +1,13 @@
+#ifndef TEST_FIRMWARE_FORMAT_H
+#define TEST_FIRMWARE_FORMAT_H
+
+#include <unity.h>
+
+// FirmwareFormat Tests
+void test_firmware_format_hex_lines(void);
+void test_firmware_format_decode_record(void);
+void test_firmware_format_extract_version(void);
+void test_firmware_format_package_header(void);
+void test_firmware_format_package_header_v2(void);
+
+#endif // TEST_FIRMWARE_FORMAT_H
@@ -0,0 +1,155 @@
+#include "test_flash_pages.h"
+#include "FlashPages.h"
+#include "Crc32.h"
+#include <string.h>
+
+static HexRecord dataRecord(uint16_t address, uint8_t length, uint8_t fill) {
+    HexRecord record;
+    record.type = HEX_RECORD_DATA;
+    record.address = address;
+    record.length = length;
+    memset(record.data, fill, length);
+    return record;
+}
+
+struct PageLog {
+    int calls;
+    uint16_t lastPage;
+    bool inOrder;
+    uint8_t page1[FlashPages::PAGE_SIZE];
+};
+
+static void logPage(void* context, uint16_t page, const uint8_t* data, uint32_t hash) {
+    PageLog* log = (PageLog*)context;
+    if (page != log->calls || hash != Crc32::compute(data, FlashPages::PAGE_SIZE)) {
+        log->inOrder = false;
+    }
+    if (page == 1) {
+        memcpy(log->page1, data, FlashPages::PAGE_SIZE);
+    }
+    log->lastPage = page;
+    log->calls++;
+}
+
+void test_flash_pages_builds_pages(void) {
+    static FlashPages pages;
+    PageLog log = { 0, 0, true, {} };
+    pages.reset(logPage, &log);
+    
+    // A record straddling pages 0 and 1, then one in page 4; pages 2 and 3 are a gap
+    TEST_ASSERT_TRUE(pages.addRecord(dataRecord(0x0038, 16, 0xAA)));
+    TEST_ASSERT_TRUE(pages.addRecord(dataRecord(0x0100, 16, 0x55)));
+    HexRecord eof = dataRecord(0, 0, 0);
+    eof.type = HEX_RECORD_EOF;
+    TEST_ASSERT_TRUE(pages.addRecord(eof));
+    TEST_ASSERT_TRUE(pages.finish());
+    
+    TEST_ASSERT_TRUE(log.inOrder);
+    TEST_ASSERT_EQUAL(FlashPages::MAX_PAGES, log.calls);
+    TEST_ASSERT_EQUAL(FlashPages::MAX_PAGES - 1, log.lastPage);
+    TEST_ASSERT_EQUAL(5, pages.getPageCount());
+    
+    // Page 1 holds the last 8 bytes of the first record, the rest erased
+    uint8_t expected[FlashPages::PAGE_SIZE];
+    memset(expected, 0xFF, sizeof(expected));
+    memset(expected, 0xAA, 8);
+    TEST_ASSERT_EQUAL_MEMORY(expected, log.page1, sizeof(expected));
+    
+    memset(expected, 0xFF, sizeof(expected));
+    uint32_t erased = Crc32::compute(expected, sizeof(expected));
+    TEST_ASSERT_TRUE(pages.getPageHash(0) != erased);
+    TEST_ASSERT_EQUAL_UINT32(erased, pages.getPageHash(2));
+    TEST_ASSERT_EQUAL_UINT32(erased, pages.getPageHash(3));
+    TEST_ASSERT_TRUE(pages.getPageHash(4) != erased);
+}
+
+void test_flash_pages_image_crc(void) {
+    static FlashPages pages;
+    pages.reset();
+    pages.addRecord(dataRecord(0x0038, 16, 0xAA));
+    pages.addRecord(dataRecord(0x0100, 16, 0x55));
+    pages.finish();
+    
+    // Pages 0-4 in one run, gaps and unset bytes erased; nothing after page 4
+    uint8_t image[5 * FlashPages::PAGE_SIZE];
+    memset(image, 0xFF, sizeof(image));
+    memset(image + 0x38, 0xAA, 16);
+    memset(image + 0x100, 0x55, 16);
+    TEST_ASSERT_EQUAL_UINT32(Crc32::compute(image, sizeof(image)), pages.getImageCrc());
+    
+    // An empty image covers no pages
+    pages.reset();
+    pages.finish();
+    TEST_ASSERT_EQUAL(0, pages.getPageCount());
+    TEST_ASSERT_EQUAL_UINT32(0, pages.getImageCrc());
+}
+
+void test_flash_pages_rejects_bad_records(void) {
+    static FlashPages pages;
+    
+    // Going backwards
+    pages.reset();
+    TEST_ASSERT_TRUE(pages.addRecord(dataRecord(0x0100, 16, 0x11)));
+    TEST_ASSERT_FALSE(pages.addRecord(dataRecord(0x0000, 16, 0x22)));
+    TEST_ASSERT_TRUE(pages.failed());
+    TEST_ASSERT_FALSE(pages.finish());
+    
+    // Past the end of the ATtiny's flash
+    pages.reset();
+    TEST_ASSERT_FALSE(pages.addRecord(dataRecord(FlashPages::MAX_PAGES * FlashPages::PAGE_SIZE - 8, 16, 0x33)));
+    
+    // An extended address moves everything out of range
+    pages.reset();
+    HexRecord extended = dataRecord(0, 2, 0);
+    extended.type = HEX_RECORD_EXTENDED_LINEAR;
+    extended.data[1] = 0x01;
+    TEST_ASSERT_TRUE(pages.addRecord(extended));
+    TEST_ASSERT_FALSE(pages.addRecord(dataRecord(0x0000, 16, 0x44)));
+}
+
+void test_flash_pages_count_changed(void) {
+    static FlashPages before;
+    static FlashPages after;
+    
+    before.reset();
+    after.reset();
+    for (uint16_t address = 0; address < 0x200; address += 16) {
+        before.addRecord(dataRecord(address, 16, address >> 4));
+        // One byte different in page 3, and the new image is one page shorter
+        uint8_t fill = address == 0x00C0 ? 0xEE : address >> 4;
+        if (address < 0x1C0) {
+            after.addRecord(dataRecord(address, 16, fill));
+        }
+    }
+    TEST_ASSERT_TRUE(before.finish());
+    TEST_ASSERT_TRUE(after.finish());
+    
+    TEST_ASSERT_EQUAL(8, before.getPageCount());
+    TEST_ASSERT_EQUAL(7, after.getPageCount());
+    TEST_ASSERT_EQUAL(2, after.countChanged(before));
+    TEST_ASSERT_EQUAL(0, after.countChanged(after));
+}
+
+void test_flash_pages_serialize_round_trip(void) {
+    static FlashPages pages;
+    static FlashPages loaded;
+    static uint8_t buffer[FlashPages::SERIALIZED_SIZE];
+    
+    pages.reset();
+    pages.addRecord(dataRecord(0x0040, 16, 0x5A));
+    pages.finish();
+    
+    TEST_ASSERT_EQUAL(0, pages.serialize(buffer, sizeof(buffer) - 1));
+    TEST_ASSERT_EQUAL(FlashPages::SERIALIZED_SIZE, pages.serialize(buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_MEMORY("FLPG", buffer, 4);
+    TEST_ASSERT_TRUE(loaded.deserialize(buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL(2, loaded.getPageCount());
+    TEST_ASSERT_EQUAL_UINT32(pages.getImageCrc(), loaded.getImageCrc());
+    TEST_ASSERT_EQUAL(0, loaded.countChanged(pages));
+    
+    // Any damage throws the hashes away
+    buffer[FlashPages::HEADER_SIZE + 5] ^= 0x01;
+    TEST_ASSERT_FALSE(loaded.deserialize(buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL(0, loaded.getPageCount());
+    TEST_ASSERT_FALSE(loaded.deserialize(buffer, sizeof(buffer) - 4));
+}
@@ -0,0 +1,13 @@
+#ifndef TEST_FLASH_PAGES_H
+#define TEST_FLASH_PAGES_H
+
+#include <unity.h>
+
+// FlashPages Tests
+void test_flash_pages_builds_pages(void);
+void test_flash_pages_image_crc(void);
+void test_flash_pages_rejects_bad_records(void);
+void test_flash_pages_count_changed(void);
+void test_flash_pages_serialize_round_trip(void);
+
+#endif // TEST_FLASH_PAGES_H
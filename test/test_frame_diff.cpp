@@ -0,0 +1,111 @@
+#include "test_frame_diff.h"
+#include "FrameDiff.h"
+#include <stdio.h>
+#include <string.h>
+
+static const int WIDTH = 128;
+static const int PAGES = 8;
+
+static uint8_t frame[WIDTH * PAGES];
+static uint8_t shadow[WIDTH * PAGES];
+
+void test_frame_diff_identical_frames(void) {
+    FrameSpan spans[FrameDiff::MAX_SPANS];
+    memset(frame, 0x5A, sizeof(frame));
+    memcpy(shadow, frame, sizeof(frame));
+    
+    TEST_ASSERT_EQUAL(0, FrameDiff::diff(frame, shadow, WIDTH, PAGES, spans, FrameDiff::MAX_SPANS));
+    TEST_ASSERT_EQUAL_UINT32(0, FrameDiff::transferSize(spans, 0));
+}
+
+void test_frame_diff_spans_and_merging(void) {
+    FrameSpan spans[FrameDiff::MAX_SPANS];
+    memset(frame, 0, sizeof(frame));
+    memset(shadow, 0, sizeof(shadow));
+    
+    // Page 1: two changes a few columns apart merge into one span
+    frame[1 * WIDTH + 10] = 0xFF;
+    frame[1 * WIDTH + 14] = 0xFF;
+    // Page 3: changes far apart stay separate
+    frame[3 * WIDTH + 0] = 0x01;
+    frame[3 * WIDTH + 100] = 0x01;
+    // Last column of the last page
+    frame[7 * WIDTH + 127] = 0x80;
+    
+    int count = FrameDiff::diff(frame, shadow, WIDTH, PAGES, spans, FrameDiff::MAX_SPANS);
+    TEST_ASSERT_EQUAL(4, count);
+    
+    TEST_ASSERT_EQUAL_UINT8(1, spans[0].page);
+    TEST_ASSERT_EQUAL_UINT8(10, spans[0].firstColumn);
+    TEST_ASSERT_EQUAL_UINT8(14, spans[0].lastColumn);
+    
+    TEST_ASSERT_EQUAL_UINT8(3, spans[1].page);
+    TEST_ASSERT_EQUAL_UINT8(0, spans[1].firstColumn);
+    TEST_ASSERT_EQUAL_UINT8(0, spans[1].lastColumn);
+    TEST_ASSERT_EQUAL_UINT8(3, spans[2].page);
+    TEST_ASSERT_EQUAL_UINT8(100, spans[2].firstColumn);
+    TEST_ASSERT_EQUAL_UINT8(100, spans[2].lastColumn);
+    
+    TEST_ASSERT_EQUAL_UINT8(7, spans[3].page);
+    TEST_ASSERT_EQUAL_UINT8(127, spans[3].firstColumn);
+    TEST_ASSERT_EQUAL_UINT8(127, spans[3].lastColumn);
+    
+    TEST_ASSERT_EQUAL_UINT32(4 * FrameDiff::SPAN_OVERHEAD + 5 + 1 + 1 + 1,
+                             FrameDiff::transferSize(spans, count));
+}
+
+void test_frame_diff_too_many_spans(void) {
+    FrameSpan spans[FrameDiff::MAX_SPANS];
+    memset(shadow, 0, sizeof(shadow));
+    memset(frame, 0, sizeof(frame));
+    
+    // Every 16th column on every page: 64 isolated changes
+    for (int i = 0; i < WIDTH * PAGES; i += 16) {
+        frame[i] = 1;
+    }
+    TEST_ASSERT_EQUAL(-1, FrameDiff::diff(frame, shadow, WIDTH, PAGES, spans, FrameDiff::MAX_SPANS));
+    
+    // A completely new frame comes back as one span per page
+    memset(frame, 0xFF, sizeof(frame));
+    TEST_ASSERT_EQUAL(PAGES, FrameDiff::diff(frame, shadow, WIDTH, PAGES, spans, FrameDiff::MAX_SPANS));
+}
+
+// Renders "Uptime: 0m Ns" as 6x8 cells on page 2 of an otherwise static frame
+static void renderUptime(uint8_t* target, int seconds) {
+    char text[22];
+    snprintf(text, sizeof(text), "Uptime: 0m %ds", seconds);
+    memset(target + 2 * WIDTH, 0, WIDTH);
+    for (int i = 0; text[i] != '\0'; i++) {
+        for (int column = 0; column < 5; column++) {
+            // Stand-in glyph: distinct per character and column
+            target[2 * WIDTH + i * 6 + column] = (uint8_t)(text[i] * 7 + column * 13);
+        }
+    }
+}
+
+void bench_frame_diff_uptime_refresh(void) {
+    FrameSpan spans[FrameDiff::MAX_SPANS];
+    memset(frame, 0x11, sizeof(frame));
+    
+    renderUptime(shadow, 0);
+    memcpy(frame, shadow, sizeof(frame));
+    
+    size_t total = 0;
+    int refreshes = 0;
+    for (int seconds = 2; seconds < 60; seconds += 2) {
+        renderUptime(frame, seconds);
+        int count = FrameDiff::diff(frame, shadow, WIDTH, PAGES, spans, FrameDiff::MAX_SPANS);
+        TEST_ASSERT_TRUE(count > 0);
+        total += FrameDiff::transferSize(spans, count);
+        memcpy(shadow, frame, sizeof(frame));
+        refreshes++;
+    }
+    
+    size_t full = FrameDiff::fullTransferSize(WIDTH, PAGES);
+    size_t average = total / refreshes;
+    printf("Uptime refresh: %u bytes average vs %u for a full frame\n",
+           (unsigned)average, (unsigned)full);
+    
+    // At least an order of magnitude less than pushing the whole frame
+    TEST_ASSERT_TRUE(average * 10 <= full);
+}
@@ -0,0 +1,12 @@
+#ifndef TEST_FRAME_DIFF_H
+#define TEST_FRAME_DIFF_H
+
+#include <unity.h>
+
+// FrameDiff Tests
+void test_frame_diff_identical_frames(void);
+void test_frame_diff_spans_and_merging(void);
+void test_frame_diff_too_many_spans(void);
+void bench_frame_diff_uptime_refresh(void);
+
+#endif // TEST_FRAME_DIFF_H
@@ -0,0 +1,123 @@
+#include "test_heap_tracker.h"
+#include "HeapTracker.h"
+#include "ConfigStore.h"
+#include <string.h>
+#include <stdio.h>
+#include <string>
+
+static int threadA = 0;
+static int threadB = 0;
+static const void* runningThread = &threadA;
+static const void* fakeThreadId() { return runningThread; }
+
+// Keeps the optimiser from dropping an allocation
+static volatile char sink;
+
+static void allocate(size_t size) {
+    char* block = new char[size];
+    block[0] = 1;
+    sink = block[0];
+    delete[] block;
+}
+
+void test_heap_tracker_scopes(void) {
+    if (!HeapTracker::isHooked()) {
+        TEST_IGNORE_MESSAGE("Built without HEAP_TRACKER_HOOK");
+    }
+    
+    HeapTracker::reset();
+    {
+        HeapScope web(HEAP_MODULE_WEB);
+        allocate(32);
+        {
+            HeapScope mqtt(HEAP_MODULE_MQTT);
+            allocate(100);
+            allocate(20);
+        }
+        TEST_ASSERT_EQUAL(HEAP_MODULE_WEB, HeapTracker::getCurrentModule());
+        allocate(8);
+    }
+    TEST_ASSERT_EQUAL(HEAP_MODULE_OTHER, HeapTracker::getCurrentModule());
+    
+    const HeapTracker::Counters& web = HeapTracker::getCounters(HEAP_MODULE_WEB);
+    TEST_ASSERT_EQUAL(2, web.allocations);
+    TEST_ASSERT_EQUAL(2, web.frees);
+    TEST_ASSERT_EQUAL(40, (int)web.bytesAllocated);
+    
+    const HeapTracker::Counters& mqtt = HeapTracker::getCounters(HEAP_MODULE_MQTT);
+    TEST_ASSERT_EQUAL(2, mqtt.allocations);
+    TEST_ASSERT_EQUAL(120, (int)mqtt.bytesAllocated);
+    TEST_ASSERT_EQUAL(0, HeapTracker::getCounters(HEAP_MODULE_LOGGER).allocations);
+}
+
+void test_heap_tracker_other_threads(void) {
+    if (!HeapTracker::isHooked()) {
+        TEST_IGNORE_MESSAGE("Built without HEAP_TRACKER_HOOK");
+    }
+    
+    HeapTracker::reset();
+    HeapTracker::setThreadId(fakeThreadId);
+    runningThread = &threadA;
+    {
+        HeapScope display(HEAP_MODULE_DISPLAY);
+        allocate(16);
+        
+        // Another task allocating meanwhile isn't the display's doing
+        runningThread = &threadB;
+        allocate(64);
+        runningThread = &threadA;
+    }
+    HeapTracker::setThreadId(nullptr);
+    
+    TEST_ASSERT_EQUAL(1, HeapTracker::getCounters(HEAP_MODULE_DISPLAY).allocations);
+    TEST_ASSERT_EQUAL(16, (int)HeapTracker::getCounters(HEAP_MODULE_DISPLAY).bytesAllocated);
+    TEST_ASSERT_TRUE(HeapTracker::getCounters(HEAP_MODULE_OTHER).allocations >= 1);
+}
+
+void test_heap_tracker_fragmentation(void) {
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, HeapTracker::fragmentation(100000, 100000));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, HeapTracker::fragmentation(100000, 75000));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, HeapTracker::fragmentation(0, 0));
+    TEST_ASSERT_EQUAL_STRING("firmware", HeapTracker::moduleName(HEAP_MODULE_FIRMWARE));
+    TEST_ASSERT_EQUAL_STRING("unknown", HeapTracker::moduleName(HEAP_MODULE_COUNT));
+}
+
+void bench_heap_tracker_allocations_per_operation(void) {
+    if (!HeapTracker::isHooked()) {
+        TEST_IGNORE_MESSAGE("Built without HEAP_TRACKER_HOOK");
+    }
+    
+    const int iterations = 100;
+    uint8_t image[256];
+    
+    // The binary config path is meant to load without touching the heap
+    HeapTracker::reset();
+    for (int i = 0; i < iterations; i++) {
+        ConfigWriter writer(image, sizeof(image));
+        writer.writeString(1, "192.168.1.100", 13);
+        writer.writeU16(2, 1883);
+        size_t size = writer.finish(1);
+        
+        ConfigReader reader;
+        TEST_ASSERT_EQUAL(ConfigReader::OK, reader.open(image, size));
+        ConfigField field;
+        while (reader.next(field)) {
+        }
+    }
+    uint32_t configAllocations = HeapTracker::getAllocations();
+    
+    // String building the way the handlers do it, for comparison
+    HeapTracker::reset();
+    for (int i = 0; i < iterations; i++) {
+        std::string json = "{\"brokerIP\":\"192.168.1.100\"";
+        json += ",\"brokerPort\":" + std::to_string(1883 + i) + "}";
+        sink = json[0];
+    }
+    uint32_t stringAllocations = HeapTracker::getAllocations();
+    
+    printf("Allocations per operation: config image %.2f, string JSON %.2f\n",
+           configAllocations / (float)iterations, stringAllocations / (float)iterations);
+    
+    TEST_ASSERT_EQUAL(0, configAllocations);
+    TEST_ASSERT_TRUE(stringAllocations >= (uint32_t)iterations);
+}
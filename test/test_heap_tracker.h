@@ -0,0 +1,12 @@
+#ifndef TEST_HEAP_TRACKER_H
+#define TEST_HEAP_TRACKER_H
+
+#include <unity.h>
+
+// HeapTracker Tests
+void test_heap_tracker_scopes(void);
+void test_heap_tracker_other_threads(void);
+void test_heap_tracker_fragmentation(void);
+void bench_heap_tracker_allocations_per_operation(void);
+
+#endif // TEST_HEAP_TRACKER_H
@@ -0,0 +1,196 @@
+#include "test_hex_payload_reader.h"
+#include "HexPayloadReader.h"
+#include <string.h>
+
+// The first six records and the end record of firmware-v1.0.6.bin
+static const char* const LINES[] = {
+    ":100000000C943F000C9468000C9468000C946800F9",
+    ":100010000C9468000C9468000C9468000C946800C0",
+    ":100020000C9468000C9468000C9468000C946800B0",
+    ":100030000C9468000C9468000C9468000C942508DB",
+    ":100040000C9468000C9468000C9468000C94680090",
+    ":100050000C9468000C9468000C9468000C94680080",
+    ":00000001FF"
+};
+static const size_t LINE_COUNT = sizeof(LINES) / sizeof(LINES[0]);
+
+// The same records packed and compressed by create_firmware_package.py --compress
+static const uint8_t PACKED[] = {
+    0x88, 0x40, 0x00, 0x00, 0x86, 0x65, 0x27, 0xE0, 0x18, 0xDA, 0x00, 0x37, 0x04, 0xC0, 0x01, 0x00,
+    0x3E, 0x81, 0x34, 0x90, 0x02, 0x7E, 0x09, 0x84, 0xC0, 0x13, 0xD9, 0x2C, 0x20, 0x13, 0x0A, 0x00,
+    0x4F, 0xE0, 0x98, 0x54, 0x01, 0x3F, 0x00, 0x06, 0x02
+};
+static const uint32_t PACKED_DECODED_LENGTH = 124;
+
+struct MemorySource {
+    const uint8_t* data;
+    size_t length;
+    size_t position;
+    size_t chunk;       // Most bytes handed out per read, like a short File read
+};
+
+static size_t readMemory(void* context, uint8_t* buffer, size_t capacity) {
+    MemorySource* source = (MemorySource*)context;
+    size_t count = source->length - source->position;
+    if (count > capacity) {
+        count = capacity;
+    }
+    if (count > source->chunk) {
+        count = source->chunk;
+    }
+    memcpy(buffer, source->data + source->position, count);
+    source->position += count;
+    return count;
+}
+
+void test_hex_payload_reader_plain_text(void) {
+    const char* text =
+        ":100000000C943F000C9468000C9468000C946800F9\r\n"
+        "\r\n"
+        "  ; comment\n"
+        "\t:00000001FF  ";
+    MemorySource source = { (const uint8_t*)text, strlen(text), 0, 7 };
+    HexPayloadReader reader(PAYLOAD_INTEL_HEX, strlen(text), 0, readMemory, &source);
+    char line[128];
+    size_t length = 0;
+    
+    TEST_ASSERT_TRUE(reader.nextLine(line, sizeof(line), length));
+    TEST_ASSERT_EQUAL_STRING(LINES[0], line);
+    TEST_ASSERT_EQUAL(strlen(LINES[0]), length);
+    TEST_ASSERT_TRUE(reader.nextLine(line, sizeof(line), length));
+    TEST_ASSERT_EQUAL_STRING(":00000001FF", line);
+    TEST_ASSERT_EQUAL(4, reader.getLineNumber());
+    TEST_ASSERT_FALSE(reader.nextLine(line, sizeof(line), length));
+    TEST_ASSERT_EQUAL(HEX_PAYLOAD_END, reader.getStatus());
+    
+    // A line that doesn't fit stops the reader rather than being cut
+    source.position = 0;
+    HexPayloadReader shortReader(PAYLOAD_INTEL_HEX, strlen(text), 0, readMemory, &source);
+    TEST_ASSERT_FALSE(shortReader.nextLine(line, 20, length));
+    TEST_ASSERT_EQUAL(HEX_PAYLOAD_LINE_TOO_LONG, shortReader.getStatus());
+}
+
+void test_hex_payload_reader_packed(void) {
+    // One byte per read, so every token crosses a refill
+    const size_t chunks[] = { 1, 64 };
+    for (size_t c = 0; c < 2; c++) {
+        MemorySource source = { PACKED, sizeof(PACKED), 0, chunks[c] };
+        HexPayloadReader reader(PAYLOAD_HEX_LZSS, sizeof(PACKED), PACKED_DECODED_LENGTH, readMemory, &source);
+        char line[128];
+        size_t length = 0;
+        
+        for (size_t i = 0; i < LINE_COUNT; i++) {
+            TEST_ASSERT_TRUE(reader.nextLine(line, sizeof(line), length));
+            TEST_ASSERT_EQUAL_STRING(LINES[i], line);
+            TEST_ASSERT_EQUAL(strlen(LINES[i]), length);
+        }
+        TEST_ASSERT_FALSE(reader.nextLine(line, sizeof(line), length));
+        TEST_ASSERT_EQUAL(HEX_PAYLOAD_END, reader.getStatus());
+        TEST_ASSERT_EQUAL(LINE_COUNT, reader.getLineNumber());
+    }
+}
+
+// LzssDecoder's token format, most significant bit first
+struct BitWriter {
+    uint8_t* out;
+    size_t bits;
+    
+    void put(uint32_t value, int count) {
+        for (int bit = count - 1; bit >= 0; bit--, bits++) {
+            if ((value >> bit) & 1) {
+                out[bits / 8] |= 0x80 >> (bits % 8);
+            }
+        }
+    }
+};
+
+// Literals, and distance-1 copies for runs, so a stream can end on either
+static size_t compressRuns(const uint8_t* data, size_t length, uint8_t* out) {
+    BitWriter writer = { out, 0 };
+    size_t i = 0;
+    while (i < length) {
+        size_t run = 0;
+        while (i > 0 && i + run < length && data[i + run] == data[i - 1] && run < 17) {
+            run++;
+        }
+        if (run >= LzssDecoder::MIN_MATCH) {
+            writer.put(0, 1);
+            writer.put(0, LzssDecoder::WINDOW_BITS);
+            writer.put(run - LzssDecoder::MIN_MATCH, LzssDecoder::LENGTH_BITS);
+            i += run;
+        } else {
+            writer.put(0x100 | data[i], 9);
+            i++;
+        }
+    }
+    return (writer.bits + 7) / 8;
+}
+
+void test_hex_payload_reader_chunk_boundaries(void) {
+    // One data record of every length, then the end record: the stored and
+    // decoded lengths sweep across the 64-byte input and output chunks
+    static uint8_t packed[FirmwareFormat::PACKED_RECORD_HEADER * 2 + FirmwareFormat::MAX_HEX_DATA];
+    static uint8_t stream[sizeof(packed) * 2];
+    char line[FirmwareFormat::MIN_HEX_LINE + 2 * FirmwareFormat::MAX_HEX_DATA + 1];
+    size_t length = 0;
+    
+    for (size_t count = 1; count <= FirmwareFormat::MAX_HEX_DATA; count++) {
+        memset(packed, 0, sizeof(packed));
+        packed[0] = count;
+        for (size_t i = 0; i < count; i++) {
+            packed[FirmwareFormat::PACKED_RECORD_HEADER + i] = (i / 5) * 7;
+        }
+        size_t decodedLength = FirmwareFormat::PACKED_RECORD_HEADER * 2 + count;
+        packed[decodedLength - 1] = HEX_RECORD_EOF;
+        
+        memset(stream, 0, sizeof(stream));
+        size_t streamLength = compressRuns(packed, decodedLength, stream);
+        MemorySource source = { stream, streamLength, 0, 64 };
+        HexPayloadReader reader(PAYLOAD_HEX_LZSS, streamLength, decodedLength, readMemory, &source);
+        
+        TEST_ASSERT_TRUE(reader.nextLine(line, sizeof(line), length));
+        TEST_ASSERT_EQUAL(FirmwareFormat::MIN_HEX_LINE + 2 * count, length);
+        TEST_ASSERT_TRUE(reader.nextLine(line, sizeof(line), length));
+        TEST_ASSERT_EQUAL_STRING(":00000001FF", line);
+        TEST_ASSERT_FALSE(reader.nextLine(line, sizeof(line), length));
+        TEST_ASSERT_EQUAL(HEX_PAYLOAD_END, reader.getStatus());
+    }
+}
+
+void test_hex_payload_reader_corrupt_packed(void) {
+    char line[128];
+    size_t length = 0;
+    
+    // Cut short: runs out of input before the decoded length
+    MemorySource truncated = { PACKED, 30, 0, 64 };
+    HexPayloadReader shortReader(PAYLOAD_HEX_LZSS, 30, PACKED_DECODED_LENGTH, readMemory, &truncated);
+    while (shortReader.nextLine(line, sizeof(line), length)) {
+    }
+    TEST_ASSERT_EQUAL(HEX_PAYLOAD_CORRUPT, shortReader.getStatus());
+    
+    // Decoded length ending inside a record
+    MemorySource source = { PACKED, sizeof(PACKED), 0, 64 };
+    HexPayloadReader midRecord(PAYLOAD_HEX_LZSS, sizeof(PACKED), PACKED_DECODED_LENGTH - 1, readMemory, &source);
+    while (midRecord.nextLine(line, sizeof(line), length)) {
+    }
+    TEST_ASSERT_EQUAL(HEX_PAYLOAD_CORRUPT, midRecord.getStatus());
+    TEST_ASSERT_EQUAL(LINE_COUNT - 1, midRecord.getLineNumber());
+    
+    // A copy before the start of the stream
+    const uint8_t bad[] = { 0x00, 0x00, 0x00 };
+    MemorySource badSource = { bad, sizeof(bad), 0, 64 };
+    HexPayloadReader badReader(PAYLOAD_HEX_LZSS, sizeof(bad), 10, readMemory, &badSource);
+    TEST_ASSERT_FALSE(badReader.nextLine(line, sizeof(line), length));
+    TEST_ASSERT_EQUAL(HEX_PAYLOAD_CORRUPT, badReader.getStatus());
+    
+    // A record type Intel HEX doesn't have (9)
+    const uint8_t badType[] = { 0x80, 0x00, 0x01, 0x09 };
+    MemorySource badTypeSource = { badType, sizeof(badType), 0, 64 };
+    HexPayloadReader badTypeReader(PAYLOAD_HEX_LZSS, sizeof(badType), 4, readMemory, &badTypeSource);
+    TEST_ASSERT_FALSE(badTypeReader.nextLine(line, sizeof(line), length));
+    TEST_ASSERT_EQUAL(HEX_PAYLOAD_CORRUPT, badTypeReader.getStatus());
+    
+    HexPayloadReader unknown(7, sizeof(PACKED), 0, readMemory, &source);
+    TEST_ASSERT_FALSE(unknown.nextLine(line, sizeof(line), length));
+    TEST_ASSERT_EQUAL(HEX_PAYLOAD_UNSUPPORTED, unknown.getStatus());
+}
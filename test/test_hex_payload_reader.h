@@ -0,0 +1,12 @@
+#ifndef TEST_HEX_PAYLOAD_READER_H
+#define TEST_HEX_PAYLOAD_READER_H
+
+#include <unity.h>
+
+// HexPayloadReader Tests
+void test_hex_payload_reader_plain_text(void);
+void test_hex_payload_reader_packed(void);
+void test_hex_payload_reader_chunk_boundaries(void);
+void test_hex_payload_reader_corrupt_packed(void);
+
+#endif // TEST_HEX_PAYLOAD_READER_H
@@ -0,0 +1,119 @@
+#include "test_i2c_arbiter.h"
+#include "I2CArbiter.h"
+
+static int owners[8];
+
+void test_i2c_arbiter_priority_order(void) {
+    I2CArbiter arbiter;
+    TEST_ASSERT_EQUAL(-1, arbiter.pickNext(0));
+    
+    arbiter.enqueue(0, &owners[0], 0);
+    arbiter.enqueue(2, &owners[2], 0);
+    arbiter.enqueue(1, &owners[1], 0);
+    TEST_ASSERT_EQUAL(3, arbiter.size());
+    
+    int expected[] = {2, 1, 0};
+    for (int i = 0; i < 3; i++) {
+        int slot = arbiter.pickNext(0);
+        TEST_ASSERT_EQUAL_PTR(&owners[expected[i]], arbiter.getOwner(slot));
+        arbiter.remove(slot);
+    }
+    TEST_ASSERT_TRUE(arbiter.isEmpty());
+}
+
+void test_i2c_arbiter_fifo_within_priority(void) {
+    I2CArbiter arbiter;
+    
+    for (int i = 0; i < I2CArbiter::MAX_WAITERS; i++) {
+        TEST_ASSERT_EQUAL(i, arbiter.enqueue(1, &owners[i], 0));
+    }
+    TEST_ASSERT_EQUAL(-1, arbiter.enqueue(1, &owners[0], 0));
+    
+    // Free a slot in the middle and refill it: the newcomer still goes last
+    arbiter.remove(0);
+    TEST_ASSERT_EQUAL(0, arbiter.enqueue(1, &owners[0], 0));
+    
+    int expected[] = {1, 2, 3, 4, 5, 6, 7, 0};
+    for (int i = 0; i < I2CArbiter::MAX_WAITERS; i++) {
+        int slot = arbiter.pickNext(0);
+        TEST_ASSERT_EQUAL_PTR(&owners[expected[i]], arbiter.getOwner(slot));
+        arbiter.remove(slot);
+    }
+}
+
+void test_i2c_arbiter_aging_prevents_starvation(void) {
+    I2CArbiter arbiter;
+    
+    // A low priority waiter against an endless stream of high priority ones
+    arbiter.enqueue(0, &owners[0], 0);
+    unsigned long now = 0;
+    unsigned long grantedAt = 0;
+    for (int round = 0; round < 100; round++) {
+        arbiter.enqueue(2, &owners[2], now);
+        int slot = arbiter.pickNext(now);
+        arbiter.remove(slot);
+        if (arbiter.getOwner(slot) == &owners[0]) {
+            grantedAt = now;
+            break;
+        }
+        now += 10;
+    }
+    
+    // Two levels behind: gets the bus once it has waited past two aging intervals
+    TEST_ASSERT_TRUE(grantedAt > 0);
+    TEST_ASSERT_TRUE(grantedAt <= 3 * I2CArbiter::AGING_INTERVAL);
+}
+
+void test_i2c_arbiter_flash_and_display_share_bus(void) {
+    // Simulated bus, times in ms: firmware flashing keeps a low priority
+    // line write queued at all times, the display wants a 25 ms push every
+    // 50 ms. Without arbitration the display would wait the whole flash out.
+    const unsigned long FLASH_LINE = 2;
+    const unsigned long DISPLAY_PUSH = 25;
+    const unsigned long DISPLAY_PERIOD = 50;
+    const unsigned long DURATION = 5000;
+    
+    I2CArbiter arbiter;
+    void* flash = &owners[0];
+    void* display = &owners[1];
+    
+    arbiter.enqueue(0, flash, 0);
+    unsigned long now = 0;
+    unsigned long nextFrame = 0;
+    bool displayWaiting = false;
+    unsigned long displayQueuedAt = 0;
+    unsigned long maxDisplayWait = 0;
+    unsigned long frames = 0;
+    unsigned long flashLines = 0;
+    
+    while (now < DURATION) {
+        if (!displayWaiting && now >= nextFrame) {
+            arbiter.enqueue(1, display, now);
+            displayWaiting = true;
+            displayQueuedAt = now;
+            nextFrame += DISPLAY_PERIOD;
+        }
+        
+        int slot = arbiter.pickNext(now);
+        void* owner = arbiter.getOwner(slot);
+        arbiter.remove(slot);
+        
+        if (owner == display) {
+            if (now - displayQueuedAt > maxDisplayWait) {
+                maxDisplayWait = now - displayQueuedAt;
+            }
+            displayWaiting = false;
+            frames++;
+            now += DISPLAY_PUSH;
+        } else {
+            flashLines++;
+            now += FLASH_LINE;
+            arbiter.enqueue(0, flash, now);
+        }
+    }
+    
+    // The display waits at most one flash line, and flashing keeps half the bus
+    TEST_ASSERT_TRUE(maxDisplayWait <= FLASH_LINE);
+    TEST_ASSERT_TRUE(frames >= DURATION / DISPLAY_PERIOD - 1);
+    TEST_ASSERT_TRUE(flashLines * FLASH_LINE >= DURATION * 4 / 10);
+}
@@ -0,0 +1,12 @@
+#ifndef TEST_I2C_ARBITER_H
+#define TEST_I2C_ARBITER_H
+
+#include <unity.h>
+
+// I2CArbiter Tests
+void test_i2c_arbiter_priority_order(void);
+void test_i2c_arbiter_fifo_within_priority(void);
+void test_i2c_arbiter_aging_prevents_starvation(void);
+void test_i2c_arbiter_flash_and_display_share_bus(void);
+
+#endif // TEST_I2C_ARBITER_H
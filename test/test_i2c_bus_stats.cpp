@@ -0,0 +1,85 @@
+#include "test_i2c_bus_stats.h"
+#include "I2CBusStats.h"
+
+void test_i2c_bus_stats_per_address(void) {
+    I2CBusStats stats;
+    
+    // Scan NACKs to empty addresses don't create entries
+    stats.record(0x21, I2C_PROBE_NACK, 0, 0, 30);
+    stats.record(0x22, I2C_PROBE_NACK, 0, 0, 30);
+    TEST_ASSERT_EQUAL(0, stats.getDeviceCount());
+    TEST_ASSERT_EQUAL_UINT32(2, stats.getOther().transactions);
+    
+    // Once a device has answered, its failures are its own
+    stats.record(0x50, I2C_PROBE_ACK, 44, 0, 1200);
+    stats.record(0x50, I2C_PROBE_ACK, 0, 1, 150);
+    stats.record(0x50, I2C_PROBE_NACK, 0, 0, 90);
+    stats.record(0x50, I2C_PROBE_TIMEOUT, 0, 0, 5000);
+    TEST_ASSERT_EQUAL(1, stats.getDeviceCount());
+    
+    const I2CBusStats::Entry& attiny = stats.getDevice(0);
+    TEST_ASSERT_EQUAL_UINT8(0x50, attiny.address);
+    TEST_ASSERT_EQUAL_UINT32(4, attiny.transactions);
+    TEST_ASSERT_EQUAL_UINT32(2, attiny.errors());
+    TEST_ASSERT_EQUAL_UINT32(1, attiny.results[I2C_PROBE_NACK]);
+    TEST_ASSERT_EQUAL_UINT32(1, attiny.results[I2C_PROBE_TIMEOUT]);
+    TEST_ASSERT_EQUAL_UINT32(44, attiny.bytesWritten);
+    TEST_ASSERT_EQUAL_UINT32(1, attiny.bytesRead);
+    TEST_ASSERT_EQUAL_UINT32(6440, (uint32_t)attiny.busTimeMicros);
+    TEST_ASSERT_EQUAL_UINT32(5000, attiny.maxMicros);
+    
+    TEST_ASSERT_EQUAL_UINT32(4, stats.getTransactions());
+    TEST_ASSERT_EQUAL_UINT32(2, stats.getErrors());
+    
+    // A configured clock creates the entry ahead of the first answer
+    TEST_ASSERT_EQUAL_UINT32(0, stats.getClock(0x3C));
+    stats.setClock(0x3C, 400000);
+    TEST_ASSERT_EQUAL_UINT32(400000, stats.getClock(0x3C));
+    stats.record(0x3C, I2C_PROBE_NACK, 0, 0, 25);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.getDevice(1).errors());
+    TEST_ASSERT_EQUAL_UINT32(2, stats.getOther().transactions);
+}
+
+void test_i2c_bus_stats_latency_histogram(void) {
+    I2CBusStats stats;
+    
+    TEST_ASSERT_EQUAL(0, I2CBusStats::bucketFor(0));
+    TEST_ASSERT_EQUAL(0, I2CBusStats::bucketFor(49));
+    TEST_ASSERT_EQUAL(1, I2CBusStats::bucketFor(50));
+    TEST_ASSERT_EQUAL(I2CBusStats::LATENCY_BUCKETS - 1, I2CBusStats::bucketFor(1000000));
+    TEST_ASSERT_EQUAL_UINT32(0, I2CBusStats::bucketLimit(I2CBusStats::LATENCY_BUCKETS - 1));
+    
+    // Bucket limits strictly increase
+    for (int b = 1; b < I2CBusStats::LATENCY_BUCKETS - 1; b++) {
+        TEST_ASSERT_TRUE(I2CBusStats::bucketLimit(b) > I2CBusStats::bucketLimit(b - 1));
+        TEST_ASSERT_EQUAL(b, I2CBusStats::bucketFor(I2CBusStats::bucketLimit(b - 1)));
+    }
+    
+    stats.record(0x3C, I2C_PROBE_ACK, 1024, 0, 24000);
+    stats.record(0x3C, I2C_PROBE_ACK, 1024, 0, 26000);
+    stats.record(0x3C, I2C_PROBE_ACK, 0, 0, 20);
+    
+    const I2CBusStats::Entry& oled = stats.getDevice(0);
+    unsigned long total = 0;
+    for (int b = 0; b < I2CBusStats::LATENCY_BUCKETS; b++) {
+        total += oled.latency[b];
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, total);
+    TEST_ASSERT_EQUAL_UINT32(1, oled.latency[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, oled.latency[I2CBusStats::bucketFor(24000)]);
+    TEST_ASSERT_EQUAL_UINT32(1, oled.latency[I2CBusStats::LATENCY_BUCKETS - 1]);
+}
+
+void test_i2c_bus_stats_table_full(void) {
+    I2CBusStats stats;
+    
+    for (int i = 0; i < I2CBusStats::MAX_DEVICES + 2; i++) {
+        stats.record(0x10 + i, I2C_PROBE_ACK, 1, 0, 100);
+    }
+    TEST_ASSERT_EQUAL(I2CBusStats::MAX_DEVICES, stats.getDeviceCount());
+    TEST_ASSERT_EQUAL_UINT32(2, stats.getOther().transactions);
+    
+    stats.clear();
+    TEST_ASSERT_EQUAL(0, stats.getDeviceCount());
+    TEST_ASSERT_EQUAL_UINT32(0, stats.getOther().transactions);
+}
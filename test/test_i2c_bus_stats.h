@@ -0,0 +1,11 @@
+#ifndef TEST_I2C_BUS_STATS_H
+#define TEST_I2C_BUS_STATS_H
+
+#include <unity.h>
+
+// I2CBusStats Tests
+void test_i2c_bus_stats_per_address(void);
+void test_i2c_bus_stats_latency_histogram(void);
+void test_i2c_bus_stats_table_full(void);
+
+#endif // TEST_I2C_BUS_STATS_H
@@ -0,0 +1,120 @@
+#include "test_i2c_probe.h"
+#include "I2CProbe.h"
+#include "mock_i2c_bus.h"
+#include <stdio.h>
+
+// Same per-address logic as I2CScanner::testAddress
+static I2CProbeResult probeAddress(MockI2CBus& bus, uint8_t address, I2CProbeStats& stats) {
+    uint8_t code = bus.probe(address);
+    I2CProbeResult result = I2CProbe::classify(code, bus.isSdaHigh());
+    stats.record(result);
+    
+    if (result == I2C_PROBE_BUS_STUCK) {
+        if (I2CProbe::recoverBus(bus.lines())) {
+            stats.recoveries++;
+        } else {
+            stats.failedRecoveries++;
+        }
+    }
+    return result;
+}
+
+static unsigned long sweep(MockI2CBus& bus, I2CProbeStats& stats) {
+    unsigned long start = bus.getElapsedMicros();
+    for (int address = 1; address < 128; address++) {
+        probeAddress(bus, address, stats);
+    }
+    return bus.getElapsedMicros() - start;
+}
+
+// The bookshelf bus: OLED, a sensor and the ATtiny, busy flashing so it stretches SCL
+static void populate(MockI2CBus& bus) {
+    bus.setDevice(0x3C, MockI2CBus::PRESENT);
+    bus.setDevice(0x50, MockI2CBus::STRETCHING);
+    bus.setDevice(0x76, MockI2CBus::PRESENT);
+}
+
+void test_i2c_probe_classify(void) {
+    TEST_ASSERT_EQUAL(I2C_PROBE_ACK, I2CProbe::classify(0));
+    TEST_ASSERT_EQUAL(I2C_PROBE_BUS_ERROR, I2CProbe::classify(1));
+    TEST_ASSERT_EQUAL(I2C_PROBE_NACK, I2CProbe::classify(2));
+    TEST_ASSERT_EQUAL(I2C_PROBE_NACK, I2CProbe::classify(3));
+    TEST_ASSERT_EQUAL(I2C_PROBE_BUS_ERROR, I2CProbe::classify(4));
+    TEST_ASSERT_EQUAL(I2C_PROBE_TIMEOUT, I2CProbe::classify(5));
+    
+    // SDA only matters once the transfer failed
+    TEST_ASSERT_EQUAL(I2C_PROBE_BUS_STUCK, I2CProbe::classify(5, false));
+    TEST_ASSERT_EQUAL(I2C_PROBE_BUS_STUCK, I2CProbe::classify(4, false));
+    TEST_ASSERT_EQUAL(I2C_PROBE_TIMEOUT, I2CProbe::classify(5, true));
+    TEST_ASSERT_EQUAL(I2C_PROBE_NACK, I2CProbe::classify(2, false));
+    TEST_ASSERT_EQUAL(I2C_PROBE_ACK, I2CProbe::classify(0, false));
+    TEST_ASSERT_EQUAL_STRING("bus_stuck", I2CProbe::resultToString(I2C_PROBE_BUS_STUCK));
+}
+
+void test_i2c_probe_recovers_jammed_bus(void) {
+    MockI2CBus bus;
+    populate(bus);
+    bus.setDevice(0x48, MockI2CBus::JAMMED);
+    bus.releaseAfterPulses = 5;
+    
+    I2CProbeStats stats;
+    sweep(bus, stats);
+    
+    // Jammed once, clocked free, and the rest of the sweep is clean
+    TEST_ASSERT_EQUAL(1, stats.counts[I2C_PROBE_BUS_STUCK]);
+    TEST_ASSERT_EQUAL(1, stats.recoveries);
+    TEST_ASSERT_EQUAL(0, stats.failedRecoveries);
+    TEST_ASSERT_EQUAL(1, stats.counts[I2C_PROBE_TIMEOUT]);   // The stretching ATtiny
+    TEST_ASSERT_EQUAL(2, stats.counts[I2C_PROBE_ACK]);
+    TEST_ASSERT_EQUAL(123, stats.counts[I2C_PROBE_NACK]);
+    TEST_ASSERT_TRUE(bus.isSdaHigh());
+}
+
+void test_i2c_probe_recovery_gives_up(void) {
+    MockI2CBus bus;
+    bus.setDevice(0x10, MockI2CBus::JAMMED);
+    bus.releaseAfterPulses = I2CProbe::RECOVERY_PULSES + 5;
+    
+    I2CProbeStats stats;
+    probeAddress(bus, 0x10, stats);
+    TEST_ASSERT_EQUAL(1, stats.failedRecoveries);
+    TEST_ASSERT_FALSE(bus.isSdaHigh());
+}
+
+void bench_i2c_probe_sweep(void) {
+    unsigned long times[2];
+    
+    for (int mode = 0; mode < 2; mode++) {
+        MockI2CBus bus;
+        populate(bus);
+        bus.setDevice(0x48, MockI2CBus::JAMMED);  // Jams SDA the first time it is addressed
+        if (mode == 0) {
+            bus.configure(I2CProbe::NORMAL_CLOCK, I2CProbe::NORMAL_TIMEOUT);
+        } else {
+            bus.configure(I2CProbe::SCAN_CLOCK, I2CProbe::SCAN_TIMEOUT);
+        }
+        
+        I2CProbeStats stats;
+        times[mode] = sweep(bus, stats);
+    }
+    
+    // A quiet bus, where only the bit rate matters
+    unsigned long quiet[2];
+    for (int mode = 0; mode < 2; mode++) {
+        MockI2CBus bus;
+        bus.setDevice(0x3C, MockI2CBus::PRESENT);
+        bus.configure(mode == 0 ? I2CProbe::NORMAL_CLOCK : I2CProbe::SCAN_CLOCK,
+                      mode == 0 ? I2CProbe::NORMAL_TIMEOUT : I2CProbe::SCAN_TIMEOUT);
+        I2CProbeStats stats;
+        quiet[mode] = sweep(bus, stats);
+    }
+    
+    char message[200];
+    snprintf(message, sizeof(message),
+             "i2c sweep (simulated): busy bus %.1f ms -> %.1f ms, quiet bus %.1f ms -> %.1f ms (100 kHz/50 ms vs 400 kHz/5 ms)",
+             times[0] / 1000.0, times[1] / 1000.0, quiet[0] / 1000.0, quiet[1] / 1000.0);
+    TEST_MESSAGE(message);
+    
+    TEST_ASSERT_TRUE(times[1] * 4 < times[0]);
+    TEST_ASSERT_TRUE(quiet[1] < quiet[0]);
+}
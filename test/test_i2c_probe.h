@@ -0,0 +1,12 @@
+#ifndef TEST_I2C_PROBE_H
+#define TEST_I2C_PROBE_H
+
+#include <unity.h>
+
+// I2CProbe Tests
+void test_i2c_probe_classify(void);
+void test_i2c_probe_recovers_jammed_bus(void);
+void test_i2c_probe_recovery_gives_up(void);
+void bench_i2c_probe_sweep(void);
+
+#endif // TEST_I2C_PROBE_H
@@ -0,0 +1,73 @@
+#include "test_i2c_registry.h"
+#include "I2CRegistry.h"
+
+void test_i2c_registry_presence_changes(void) {
+    I2CRegistry registry;
+    
+    TEST_ASSERT_EQUAL(I2CRegistry::APPEARED, registry.record(0x3C, true, 100));
+    TEST_ASSERT_EQUAL(I2CRegistry::UNCHANGED, registry.record(0x3C, true, 200));
+    TEST_ASSERT_TRUE(registry.isPresent(0x3C));
+    TEST_ASSERT_EQUAL_UINT32(200, registry.getLastSeen(0x3C));
+    TEST_ASSERT_EQUAL_UINT32(100, registry.getLastChange(0x3C));
+    TEST_ASSERT_EQUAL(1, registry.getDeviceCount());
+    
+    // Gone: still remembers when it was last seen
+    TEST_ASSERT_EQUAL(I2CRegistry::DISAPPEARED, registry.record(0x3C, false, 300));
+    TEST_ASSERT_FALSE(registry.isPresent(0x3C));
+    TEST_ASSERT_EQUAL_UINT32(200, registry.getLastSeen(0x3C));
+    TEST_ASSERT_EQUAL_UINT32(300, registry.getLastChange(0x3C));
+    TEST_ASSERT_EQUAL(0, registry.getDeviceCount());
+    TEST_ASSERT_EQUAL(2, registry.getChangeCount());
+    
+    // Absent addresses and out of range ones are no-ops
+    TEST_ASSERT_EQUAL(I2CRegistry::UNCHANGED, registry.record(0x50, false, 400));
+    TEST_ASSERT_EQUAL(I2CRegistry::UNCHANGED, registry.record(0, true, 400));
+    TEST_ASSERT_EQUAL(I2CRegistry::UNCHANGED, registry.record(200, true, 400));
+    TEST_ASSERT_EQUAL_UINT32(0, registry.getLastSeen(0x50));
+    TEST_ASSERT_EQUAL(2, registry.getChangeCount());
+}
+
+void test_i2c_registry_iteration(void) {
+    I2CRegistry registry;
+    const int addresses[] = {0x01, 0x1F, 0x20, 0x3C, 0x60, 0x7F};
+    for (int i = 0; i < 6; i++) {
+        registry.record(addresses[i], true, 1);
+    }
+    
+    int found = 0;
+    for (int address = registry.nextPresent(0); address >= 0; address = registry.nextPresent(address)) {
+        TEST_ASSERT_EQUAL(addresses[found], address);
+        found++;
+    }
+    TEST_ASSERT_EQUAL(6, found);
+    TEST_ASSERT_EQUAL(6, registry.getDeviceCount());
+    
+    registry.clear();
+    TEST_ASSERT_EQUAL(-1, registry.nextPresent(0));
+    TEST_ASSERT_EQUAL(0, registry.getDeviceCount());
+}
+
+void test_i2c_registry_incremental_sweep(void) {
+    I2CRegistry registry;
+    
+    // Four probes per tick, as the scanner does: 127 addresses in 32 ticks
+    int ticks = 0;
+    int probes = 0;
+    bool wrapped = false;
+    while (!wrapped) {
+        ticks++;
+        for (int i = 0; i < 4 && !wrapped; i++) {
+            uint8_t address = registry.getCursor();
+            TEST_ASSERT_EQUAL(I2CRegistry::FIRST_ADDRESS + probes, address);
+            registry.record(address, address == 0x3C || address == 0x48, ticks * 10);
+            probes++;
+            wrapped = registry.advance();
+        }
+    }
+    
+    TEST_ASSERT_EQUAL(127, probes);
+    TEST_ASSERT_EQUAL(32, ticks);
+    TEST_ASSERT_EQUAL(1, registry.getSweepCount());
+    TEST_ASSERT_EQUAL(I2CRegistry::FIRST_ADDRESS, registry.getCursor());
+    TEST_ASSERT_EQUAL(2, registry.getDeviceCount());
+}
@@ -0,0 +1,11 @@
+#ifndef TEST_I2C_REGISTRY_H
+#define TEST_I2C_REGISTRY_H
+
+#include <unity.h>
+
+// I2CRegistry Tests
+void test_i2c_registry_presence_changes(void);
+void test_i2c_registry_iteration(void);
+void test_i2c_registry_incremental_sweep(void);
+
+#endif // TEST_I2C_REGISTRY_H
@@ -0,0 +1,132 @@
+#include "test_light_state.h"
+#include "LightState.h"
+#include "mock_mqtt_broker.h"
+#include <stdio.h>
+
+static const char* STATE_TOPIC = "homeassistant/sensor/bookshelf_lights_1/state/light";
+static const unsigned long INTERVAL = 250;
+static const unsigned long LOOP_PERIOD = 10;
+
+// One pass of the firmware's loop(): hand the current state to the
+// publisher and forward anything it releases to the broker
+static void runLoop(LightStatePublisher& publisher, const LightState& state, MockMqttBroker& broker, unsigned long now) {
+    publisher.update(state);
+    
+    LightState out;
+    if (publisher.poll(now, out)) {
+        char payload[192];
+        TEST_ASSERT_TRUE(out.toJson(payload, sizeof(payload)) > 0);
+        broker.publish(STATE_TOPIC, payload, true, now);
+    }
+}
+
+void test_light_state_json(void) {
+    LightState state;
+    state.on = true;
+    state.brightness = 128;
+    state.red = 255;
+    state.green = 64;
+    state.blue = 0;
+    
+    char payload[192];
+    TEST_ASSERT_TRUE(state.toJson(payload, sizeof(payload)) > 0);
+    TEST_ASSERT_EQUAL_STRING("{\"state\":\"ON\",\"brightness\":128,\"color_mode\":\"rgb\",\"color\":{\"r\":255,\"g\":64,\"b\":0},\"effect\":\"none\"}", payload);
+    
+    state.colorMode = LIGHT_MODE_COLOR_TEMP;
+    state.colorTemp = 370;
+    state.effect = LIGHT_EFFECT_PULSE;
+    TEST_ASSERT_TRUE(state.toJson(payload, sizeof(payload)) > 0);
+    TEST_ASSERT_EQUAL_STRING("{\"state\":\"ON\",\"brightness\":128,\"color_mode\":\"color_temp\",\"color_temp\":370,\"effect\":\"pulse\"}", payload);
+    
+    // Truncation is reported rather than sending half a document
+    char small[16];
+    TEST_ASSERT_EQUAL(0, state.toJson(small, sizeof(small)));
+}
+
+void test_light_state_effect_names(void) {
+    for (int i = 0; i < LIGHT_EFFECT_COUNT; i++) {
+        TEST_ASSERT_EQUAL(i, LightState::effectFromName(LightState::effectName(i)));
+    }
+    TEST_ASSERT_EQUAL(-1, LightState::effectFromName("strobe"));
+    TEST_ASSERT_EQUAL_STRING("none", LightState::effectName(200));
+}
+
+void test_light_state_publishes_only_changes(void) {
+    LightStatePublisher publisher(INTERVAL);
+    MockMqttBroker broker;
+    LightState state;
+    
+    // First loop publishes the initial state, then nothing while idle
+    for (unsigned long now = 0; now < 5000; now += LOOP_PERIOD) {
+        runLoop(publisher, state, broker, now);
+    }
+    TEST_ASSERT_EQUAL(1, broker.messageCount(STATE_TOPIC));
+    
+    // Setting the same value again is not a change
+    state.brightness = 255;
+    runLoop(publisher, state, broker, 5000);
+    TEST_ASSERT_EQUAL(1, broker.messageCount(STATE_TOPIC));
+    
+    // A real change goes out straight away once the interval has passed
+    state.on = true;
+    runLoop(publisher, state, broker, 5010);
+    TEST_ASSERT_EQUAL(2, broker.messageCount(STATE_TOPIC));
+}
+
+void test_light_state_brightness_drag_rate(void) {
+    LightStatePublisher publisher(INTERVAL);
+    MockMqttBroker broker;
+    LightState state;
+    state.on = true;
+    
+    unsigned long now = 0;
+    runLoop(publisher, state, broker, now);
+    broker.clear();
+    
+    // HA slider drag: 100 brightness commands 20 ms apart
+    const int steps = 100;
+    const unsigned long commandInterval = 20;
+    for (int step = 1; step <= steps; step++) {
+        state.brightness = 255 - step * 2;
+        for (unsigned long t = 0; t < commandInterval; t += LOOP_PERIOD) {
+            now += LOOP_PERIOD;
+            runLoop(publisher, state, broker, now);
+        }
+    }
+    
+    // Then let it settle
+    for (int i = 0; i < 100; i++) {
+        now += LOOP_PERIOD;
+        runLoop(publisher, state, broker, now);
+    }
+    
+    size_t messages = broker.messageCount(STATE_TOPIC);
+    size_t peak = broker.peakMessagesPerSecond(STATE_TOPIC);
+    
+    char message[128];
+    snprintf(message, sizeof(message), "brightness drag: %d commands -> %u state messages, peak %u msg/s",
+             steps, (unsigned)messages, (unsigned)peak);
+    TEST_MESSAGE(message);
+    
+    TEST_ASSERT_TRUE(peak <= 1000 / INTERVAL);
+    TEST_ASSERT_TRUE(messages < (size_t)steps / 4);
+    
+    // Whatever was skipped, the broker ends up with the final value
+    char expected[192];
+    state.toJson(expected, sizeof(expected));
+    TEST_ASSERT_EQUAL_STRING(expected, broker.retainedPayload(STATE_TOPIC).c_str());
+}
+
+void test_light_state_resync_after_reconnect(void) {
+    LightStatePublisher publisher(INTERVAL);
+    MockMqttBroker broker;
+    LightState state;
+    
+    runLoop(publisher, state, broker, 0);
+    runLoop(publisher, state, broker, 1000);
+    TEST_ASSERT_EQUAL(1, broker.messageCount(STATE_TOPIC));
+    
+    publisher.invalidate();
+    runLoop(publisher, state, broker, 1010);
+    TEST_ASSERT_EQUAL(2, broker.messageCount(STATE_TOPIC));
+}
@@ -0,0 +1,13 @@
+#ifndef TEST_LIGHT_STATE_H
+#define TEST_LIGHT_STATE_H
+
+#include <unity.h>
+
+// LightState Tests
+void test_light_state_json(void);
+void test_light_state_effect_names(void);
+void test_light_state_publishes_only_changes(void);
+void test_light_state_brightness_drag_rate(void);
+void test_light_state_resync_after_reconnect(void);
+
+#endif // TEST_LIGHT_STATE_H
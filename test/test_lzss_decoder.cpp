@@ -0,0 +1,62 @@
+#include "test_lzss_decoder.h"
+#include "LzssDecoder.h"
+#include <string.h>
+
+// "abcabcabcabcabcabcabcabcXYZXYZ" from create_firmware_package.py: three
+// literals, a copy overlapping itself, three literals and a short copy
+static const uint8_t STREAM[] = { 0xB0, 0xD8, 0xAC, 0x60, 0x17, 0x80, 0x45, 0x58, 0xAC, 0xD6, 0x80, 0x21 };
+static const char* const EXPECTED = "abcabcabcabcabcabcabcabcXYZXYZ";
+
+void test_lzss_decoder_known_stream(void) {
+    LzssDecoder decoder;
+    uint8_t out[64];
+    size_t consumed = 0;
+    
+    size_t written = decoder.decode(STREAM, sizeof(STREAM), consumed, out, sizeof(out));
+    TEST_ASSERT_EQUAL(strlen(EXPECTED), written);
+    TEST_ASSERT_EQUAL_MEMORY(EXPECTED, out, written);
+    TEST_ASSERT_EQUAL(sizeof(STREAM), consumed);
+    TEST_ASSERT_FALSE(decoder.failed());
+    
+    // The padding bits at the end never make a token
+    TEST_ASSERT_EQUAL(0, decoder.decode(STREAM, 0, consumed, out, sizeof(out)));
+    TEST_ASSERT_EQUAL(strlen(EXPECTED), decoder.getOutputLength());
+}
+
+void test_lzss_decoder_byte_at_a_time(void) {
+    LzssDecoder decoder;
+    char out[64];
+    size_t total = 0;
+    size_t input = 0;
+    
+    // One input byte and at most two output bytes per call, so copies and
+    // tokens are split across calls
+    while (input < sizeof(STREAM) || total < strlen(EXPECTED)) {
+        size_t consumed = 0;
+        size_t available = input < sizeof(STREAM) ? 1 : 0;
+        size_t written = decoder.decode(STREAM + input, available, consumed, (uint8_t*)out + total, 2);
+        input += consumed;
+        total += written;
+        if (available == 0 && written == 0) {
+            break;
+        }
+    }
+    
+    TEST_ASSERT_EQUAL(strlen(EXPECTED), total);
+    TEST_ASSERT_EQUAL_MEMORY(EXPECTED, out, total);
+    
+    decoder.reset();
+    TEST_ASSERT_EQUAL(0, decoder.getOutputLength());
+}
+
+void test_lzss_decoder_rejects_bad_copy(void) {
+    LzssDecoder decoder;
+    uint8_t out[16];
+    size_t consumed = 0;
+    
+    // A copy as the very first token has nothing to copy from
+    const uint8_t bad[] = { 0x00, 0x00 };
+    TEST_ASSERT_EQUAL(0, decoder.decode(bad, sizeof(bad), consumed, out, sizeof(out)));
+    TEST_ASSERT_TRUE(decoder.failed());
+    TEST_ASSERT_EQUAL(0, decoder.decode(STREAM, sizeof(STREAM), consumed, out, sizeof(out)));
+}
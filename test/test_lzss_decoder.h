@@ -0,0 +1,11 @@
+#ifndef TEST_LZSS_DECODER_H
+#define TEST_LZSS_DECODER_H
+
+#include <unity.h>
+
+// LzssDecoder Tests
+void test_lzss_decoder_known_stream(void);
+void test_lzss_decoder_byte_at_a_time(void);
+void test_lzss_decoder_rejects_bad_copy(void);
+
+#endif // TEST_LZSS_DECODER_H
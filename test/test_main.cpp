@@ -4,6 +4,27 @@
 #include "test_logger_library.h"
 #include "test_firmware_updater_library.h"
 #include "test_oled_manager.h"
+#include "test_crc32.h"
+#include "test_config_store.h"
+#include "test_light_state.h"
+#include "test_backoff.h"
+#include "test_mqtt_offline_queue.h"
+#include "test_discovery_cache.h"
+#include "test_telemetry.h"
+#include "test_i2c_registry.h"
+#include "test_i2c_probe.h"
+#include "test_i2c_arbiter.h"
+#include "test_i2c_bus_stats.h"
+#include "test_frame_diff.h"
+#include "test_screen_model.h"
+#include "test_boot_sequencer.h"
+#include "test_boot_profile.h"
+#include "test_heap_tracker.h"
+#include "test_firmware_format.h"
+#include "test_lzss_decoder.h"
+#include "test_hex_payload_reader.h"
+#include "test_flash_pages.h"
+#include "bench_suite.h"
 
 void setUp(void) {
     // Setup code that runs before each test
@@ -16,6 +37,22 @@ void tearDown(void) {
 int main(int argc, char **argv) {
     UNITY_BEGIN();
     
+#ifdef BENCHMARK
+    // Benchmarks - Real library code, results in bench_output.txt (pio test -e bench)
+    RUN_TEST(bench_logger_add_entry);
+    RUN_TEST(bench_logger_get_log_entries);
+    RUN_TEST(bench_hex_validate_line);
+    RUN_TEST(bench_hex_extract_text);
+    RUN_TEST(bench_hex_extract_version);
+    RUN_TEST(bench_package_parse_header);
+    RUN_TEST(bench_payload_lines_hex);
+    RUN_TEST(bench_payload_lines_lzss);
+    RUN_TEST(bench_config_save);
+    RUN_TEST(bench_config_load);
+    RUN_TEST(bench_json_heap_stats_response);
+    RUN_TEST(bench_json_light_state);
+    RUN_TEST(bench_json_telemetry_payload);
+#else
     // Simple Tests - No library dependencies
     RUN_TEST(test_basic_math);
     RUN_TEST(test_string_operations);
@@ -74,11 +111,129 @@ int main(int argc, char **argv) {
     RUN_TEST(test_text_wrapping_logic);
     RUN_TEST(test_display_update_timing);
     
+    // Crc32 Tests - Pure library, no Arduino dependencies
+    RUN_TEST(test_crc32_known_vectors);
+    RUN_TEST(test_crc32_incremental_update);
+    RUN_TEST(test_crc32_detects_corruption);
+    
+    // ConfigStore Tests - Binary config format
+    RUN_TEST(test_config_store_round_trip);
+    RUN_TEST(test_config_store_rejects_corruption);
+    RUN_TEST(test_config_store_skips_unknown_fields);
+    RUN_TEST(test_config_store_overflow);
+    RUN_TEST(bench_config_store_load);
+    
+    // LightState Tests - Home Assistant light state and publish coalescing
+    RUN_TEST(test_light_state_json);
+    RUN_TEST(test_light_state_effect_names);
+    RUN_TEST(test_light_state_publishes_only_changes);
+    RUN_TEST(test_light_state_brightness_drag_rate);
+    RUN_TEST(test_light_state_resync_after_reconnect);
+    
+    // Backoff Tests - Reconnect scheduling
+    RUN_TEST(test_backoff_doubles_to_cap);
+    RUN_TEST(test_backoff_jitter_range);
+    RUN_TEST(test_backoff_reset);
+    
+    // MQTTOfflineQueue Tests - Latest value per topic while disconnected
+    RUN_TEST(test_offline_queue_latest_per_topic);
+    RUN_TEST(test_offline_queue_evicts_oldest);
+    RUN_TEST(test_offline_queue_rejects_oversize);
+    RUN_TEST(test_offline_queue_converges_on_reconnect);
+    
+    // DiscoveryCache Tests - Pre-rendered discovery with paced replay
+    RUN_TEST(test_discovery_cache_render_once);
+    RUN_TEST(test_discovery_cache_paced_replay);
+    RUN_TEST(test_discovery_cache_retries_refused_publish);
+    RUN_TEST(test_discovery_cache_overflow);
+    
+    // Telemetry Tests - Aggregation and batched payloads
+    RUN_TEST(test_telemetry_aggregates_min_avg_max);
+    RUN_TEST(test_telemetry_suppresses_unchanged);
+    RUN_TEST(test_telemetry_suppression_is_bounded);
+    RUN_TEST(test_telemetry_sensor_table_full);
+    RUN_TEST(test_telemetry_payload_too_small);
+    RUN_TEST(test_telemetry_overflow_keeps_interval);
+    
+    // I2CRegistry Tests - Device registry behind the background scanner
+    RUN_TEST(test_i2c_registry_presence_changes);
+    RUN_TEST(test_i2c_registry_iteration);
+    RUN_TEST(test_i2c_registry_incremental_sweep);
+    
+    // I2CProbe Tests - Error classification, recovery and simulated sweep timing
+    RUN_TEST(test_i2c_probe_classify);
+    RUN_TEST(test_i2c_probe_recovers_jammed_bus);
+    RUN_TEST(test_i2c_probe_recovery_gives_up);
+    RUN_TEST(bench_i2c_probe_sweep);
+    
+    // I2CArbiter Tests - Bus grant order, aging and flash/display fairness
+    RUN_TEST(test_i2c_arbiter_priority_order);
+    RUN_TEST(test_i2c_arbiter_fifo_within_priority);
+    RUN_TEST(test_i2c_arbiter_aging_prevents_starvation);
+    RUN_TEST(test_i2c_arbiter_flash_and_display_share_bus);
+    
+    // I2CBusStats Tests - Per-address errors, bytes and latency histogram
+    RUN_TEST(test_i2c_bus_stats_per_address);
+    RUN_TEST(test_i2c_bus_stats_latency_histogram);
+    RUN_TEST(test_i2c_bus_stats_table_full);
+    
+    // FrameDiff Tests - Changed page/column spans and partial flush size
+    RUN_TEST(test_frame_diff_identical_frames);
+    RUN_TEST(test_frame_diff_spans_and_merging);
+    RUN_TEST(test_frame_diff_too_many_spans);
+    RUN_TEST(bench_frame_diff_uptime_refresh);
+    
+    // ScreenModel Tests - Retained widgets redraw only on change
+    RUN_TEST(test_screen_model_dirty_tracking);
+    RUN_TEST(test_screen_model_limits);
+    
+    // BootSequencer Tests - Phase dependencies, overlap and timestamps
+    RUN_TEST(test_boot_sequencer_dependency_order);
+    RUN_TEST(test_boot_sequencer_overlaps_running_phase);
+    RUN_TEST(test_boot_sequencer_failed_dependency);
+    
+    // BootProfile Tests - Phase table and stored boot history
+    RUN_TEST(test_boot_profile_captures_sequencer);
+    RUN_TEST(test_boot_history_round_trip);
+    RUN_TEST(test_boot_history_rejects_corruption);
+    
+    // HeapTracker Tests - Per-module allocation counts through the allocator hook
+    RUN_TEST(test_heap_tracker_scopes);
+    RUN_TEST(test_heap_tracker_other_threads);
+    RUN_TEST(test_heap_tracker_fragmentation);
+    RUN_TEST(bench_heap_tracker_allocations_per_operation);
+    
+    // FirmwareFormat Tests - HEX lines and package headers on plain buffers
+    RUN_TEST(test_firmware_format_hex_lines);
+    RUN_TEST(test_firmware_format_decode_record);
+    RUN_TEST(test_firmware_format_extract_version);
+    RUN_TEST(test_firmware_format_package_header);
+    RUN_TEST(test_firmware_format_package_header_v2);
+    
+    // LzssDecoder Tests - Streaming decompression in a fixed window
+    RUN_TEST(test_lzss_decoder_known_stream);
+    RUN_TEST(test_lzss_decoder_byte_at_a_time);
+    RUN_TEST(test_lzss_decoder_rejects_bad_copy);
+    
+    // HexPayloadReader Tests - HEX lines from plain and compressed payloads
+    RUN_TEST(test_hex_payload_reader_plain_text);
+    RUN_TEST(test_hex_payload_reader_packed);
+    RUN_TEST(test_hex_payload_reader_chunk_boundaries);
+    RUN_TEST(test_hex_payload_reader_corrupt_packed);
+    
+    // FlashPages Tests - Page hashes for delta ATtiny updates
+    RUN_TEST(test_flash_pages_builds_pages);
+    RUN_TEST(test_flash_pages_image_crc);
+    RUN_TEST(test_flash_pages_rejects_bad_records);
+    RUN_TEST(test_flash_pages_count_changed);
+    RUN_TEST(test_flash_pages_serialize_round_trip);
+    
     // TODO: Add more library tests
     // ConfigManager Tests
     // WebHandler Tests
     // I2CScanner Tests
     // LEDController Tests
+#endif
     
     return UNITY_END();
 }
@@ -0,0 +1,95 @@
+#include "test_mqtt_offline_queue.h"
+#include "MQTTOfflineQueue.h"
+#include "mock_mqtt_broker.h"
+#include <string.h>
+#include <stdio.h>
+
+static MQTTOfflineQueue::Result push(MQTTOfflineQueue& queue, const char* topic, const char* payload, bool retain = true) {
+    return queue.push(topic, payload, strlen(payload), 0, retain);
+}
+
+void test_offline_queue_latest_per_topic(void) {
+    MQTTOfflineQueue queue;
+    
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::QUEUED, push(queue, "a", "1"));
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::QUEUED, push(queue, "b", "1"));
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::REPLACED, push(queue, "a", "2"));
+    TEST_ASSERT_EQUAL(2, queue.size());
+    
+    // "a" keeps its place in line but carries the newest value
+    const MQTTOfflineQueue::Entry* entry = queue.peek();
+    TEST_ASSERT_EQUAL_STRING("a", entry->topic);
+    TEST_ASSERT_EQUAL_STRING("2", entry->payload);
+    queue.pop();
+    TEST_ASSERT_EQUAL_STRING("b", queue.peek()->topic);
+    queue.pop();
+    
+    TEST_ASSERT_TRUE(queue.isEmpty());
+    TEST_ASSERT_NULL(queue.peek());
+    TEST_ASSERT_EQUAL(3, queue.getQueuedCount());
+    TEST_ASSERT_EQUAL(1, queue.getReplacedCount());
+    TEST_ASSERT_EQUAL(2, queue.getFlushedCount());
+}
+
+void test_offline_queue_evicts_oldest(void) {
+    MQTTOfflineQueue queue;
+    char topic[16];
+    
+    for (int i = 0; i < MQTTOfflineQueue::MAX_ENTRIES; i++) {
+        snprintf(topic, sizeof(topic), "topic/%d", i);
+        push(queue, topic, "x");
+    }
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::MAX_ENTRIES, queue.size());
+    
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::EVICTED, push(queue, "topic/new", "y"));
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::MAX_ENTRIES, queue.size());
+    TEST_ASSERT_EQUAL(1, queue.getDroppedCount());
+    TEST_ASSERT_EQUAL_STRING("topic/1", queue.peek()->topic);
+    
+    // Updating a queued topic never evicts
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::REPLACED, push(queue, "topic/3", "z"));
+    TEST_ASSERT_EQUAL(1, queue.getDroppedCount());
+}
+
+void test_offline_queue_rejects_oversize(void) {
+    MQTTOfflineQueue queue;
+    
+    static char payload[MQTTOfflineQueue::MAX_PAYLOAD + 1];
+    memset(payload, 'p', sizeof(payload) - 1);
+    payload[sizeof(payload) - 1] = '\0';
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::TOO_LARGE, push(queue, "big", payload));
+    
+    payload[MQTTOfflineQueue::MAX_PAYLOAD - 1] = '\0';
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::QUEUED, push(queue, "big", payload));
+    TEST_ASSERT_EQUAL(MQTTOfflineQueue::MAX_PAYLOAD - 1, queue.peek()->length);
+    TEST_ASSERT_EQUAL(1, queue.getDroppedCount());
+}
+
+void test_offline_queue_converges_on_reconnect(void) {
+    MQTTOfflineQueue queue;
+    MockMqttBroker broker;
+    
+    // Ten minutes offline, status every 30 s and a few LED changes
+    char payload[32];
+    for (int i = 0; i < 20; i++) {
+        snprintf(payload, sizeof(payload), "{\"uptime\":%d}", i * 30);
+        push(queue, "state/system", payload, false);
+        if (i % 7 == 0) {
+            snprintf(payload, sizeof(payload), "led-%d", i);
+            push(queue, "state/led", payload);
+        }
+    }
+    
+    unsigned long now = 600000;
+    while (!queue.isEmpty()) {
+        const MQTTOfflineQueue::Entry* entry = queue.peek();
+        broker.publish(entry->topic, entry->payload, entry->retain, now);
+        queue.pop();
+    }
+    
+    // One message per topic, each the latest value
+    TEST_ASSERT_EQUAL(1, broker.messageCount("state/system"));
+    TEST_ASSERT_EQUAL(1, broker.messageCount("state/led"));
+    TEST_ASSERT_EQUAL_STRING("{\"uptime\":570}", broker.lastPayload("state/system").c_str());
+    TEST_ASSERT_EQUAL_STRING("led-14", broker.retainedPayload("state/led").c_str());
+}
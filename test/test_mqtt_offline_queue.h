@@ -0,0 +1,12 @@
+#ifndef TEST_MQTT_OFFLINE_QUEUE_H
+#define TEST_MQTT_OFFLINE_QUEUE_H
+
+#include <unity.h>
+
+// MQTTOfflineQueue Tests
+void test_offline_queue_latest_per_topic(void);
+void test_offline_queue_evicts_oldest(void);
+void test_offline_queue_rejects_oversize(void);
+void test_offline_queue_converges_on_reconnect(void);
+
+#endif // TEST_MQTT_OFFLINE_QUEUE_H
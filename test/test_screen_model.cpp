@@ -0,0 +1,48 @@
+#include "test_screen_model.h"
+#include "ScreenModel.h"
+#include <string.h>
+
+void test_screen_model_dirty_tracking(void) {
+    ScreenModel screen;
+    int uptime = screen.add(0, 15, 128);
+    int wifi = screen.add(0, 27, 128);
+    TEST_ASSERT_EQUAL(0, uptime);
+    TEST_ASSERT_EQUAL(1, wifi);
+    
+    // New widgets start dirty so the first render draws them
+    TEST_ASSERT_TRUE(screen.isDirty(uptime));
+    screen.markClean(uptime);
+    screen.markClean(wifi);
+    
+    TEST_ASSERT_TRUE(screen.set(uptime, "Uptime: 0m 2s"));
+    TEST_ASSERT_TRUE(screen.isDirty(uptime));
+    TEST_ASSERT_FALSE(screen.isDirty(wifi));
+    screen.markClean(uptime);
+    
+    // Same value again: nothing to redraw
+    TEST_ASSERT_FALSE(screen.set(uptime, "Uptime: 0m 2s"));
+    TEST_ASSERT_FALSE(screen.isDirty(uptime));
+    TEST_ASSERT_EQUAL_STRING("Uptime: 0m 2s", screen.getText(uptime));
+    
+    screen.invalidate();
+    TEST_ASSERT_TRUE(screen.isDirty(uptime));
+    TEST_ASSERT_TRUE(screen.isDirty(wifi));
+}
+
+void test_screen_model_limits(void) {
+    ScreenModel screen;
+    for (int i = 0; i < ScreenModel::MAX_WIDGETS; i++) {
+        TEST_ASSERT_EQUAL(i, screen.add(0, i * 8, 128));
+    }
+    TEST_ASSERT_EQUAL(-1, screen.add(0, 0, 128));
+    TEST_ASSERT_FALSE(screen.set(-1, "x"));
+    TEST_ASSERT_FALSE(screen.set(ScreenModel::MAX_WIDGETS, "x"));
+    
+    // Long text is cut to what fits on a line
+    TEST_ASSERT_TRUE(screen.set(0, "0123456789012345678901234567890"));
+    TEST_ASSERT_EQUAL(ScreenModel::MAX_TEXT, strlen(screen.getText(0)));
+    TEST_ASSERT_FALSE(screen.set(0, "0123456789012345678901234"));
+    
+    screen.clear();
+    TEST_ASSERT_EQUAL(0, screen.getCount());
+}
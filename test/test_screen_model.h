@@ -0,0 +1,10 @@
+#ifndef TEST_SCREEN_MODEL_H
+#define TEST_SCREEN_MODEL_H
+
+#include <unity.h>
+
+// ScreenModel Tests
+void test_screen_model_dirty_tracking(void);
+void test_screen_model_limits(void);
+
+#endif // TEST_SCREEN_MODEL_H
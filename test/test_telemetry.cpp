@@ -0,0 +1,134 @@
+#include "test_telemetry.h"
+#include "Telemetry.h"
+#include <string.h>
+
+static float sampledValue = 0;
+
+static float sampleValue() {
+    return sampledValue;
+}
+
+// Runs the loop in 10 ms steps until a batch is due
+static unsigned long runUntilBatch(unsigned long now) {
+    do {
+        now += 10;
+    } while (!Telemetry::loop(now));
+    return now;
+}
+
+void test_telemetry_aggregates_min_avg_max(void) {
+    Telemetry::clear();
+    Telemetry::setIntervals(1000, 5000);
+    int pushed = Telemetry::addSensor("loop_ms", "Loop Latency", "ms", nullptr, 0.5f, 1);
+    Telemetry::addSensor("heap", "Free Heap", "B", sampleValue, 100);
+    
+    sampledValue = 1000;
+    Telemetry::loop(0);
+    sampledValue = 3000;
+    
+    Telemetry::record(pushed, 2.0f);
+    Telemetry::record(pushed, 4.0f);
+    Telemetry::record(pushed, 9.0f);
+    
+    unsigned long now = runUntilBatch(0);
+    TEST_ASSERT_EQUAL_UINT32(5000, now);
+    
+    // Sampled at 0 ms and then once a second: 1000 + 5 x 3000
+    char payload[256];
+    TEST_ASSERT_TRUE(Telemetry::buildPayload(payload, sizeof(payload), 5) > 0);
+    TEST_ASSERT_EQUAL_STRING("{\"uptime\":5,\"loop_ms\":[2.0,5.0,9.0],\"heap\":[1000,2667,3000]}", payload);
+    TEST_ASSERT_EQUAL(1, Telemetry::getBatchCount());
+    
+    float latest;
+    TEST_ASSERT_TRUE(Telemetry::getLatest(pushed, latest));
+    TEST_ASSERT_EQUAL_FLOAT(9.0f, latest);
+}
+
+void test_telemetry_suppresses_unchanged(void) {
+    Telemetry::clear();
+    Telemetry::setIntervals(1000, 5000);
+    Telemetry::addSensor("rssi", "WiFi Signal", "dBm", sampleValue, 3);
+    
+    char payload[128];
+    unsigned long now = 0;
+    
+    sampledValue = -60;
+    now = runUntilBatch(now);
+    Telemetry::buildPayload(payload, sizeof(payload), 5);
+    TEST_ASSERT_EQUAL_STRING("{\"uptime\":5,\"rssi\":[-60,-60,-60]}", payload);
+    
+    // Inside the threshold: left out of the batch
+    sampledValue = -62;
+    now = runUntilBatch(now);
+    Telemetry::buildPayload(payload, sizeof(payload), 10);
+    TEST_ASSERT_EQUAL_STRING("{\"uptime\":10}", payload);
+    TEST_ASSERT_EQUAL(1, Telemetry::getSuppressedCount());
+    
+    // Compared against the last published value, not the last interval
+    sampledValue = -63;
+    now = runUntilBatch(now);
+    Telemetry::buildPayload(payload, sizeof(payload), 15);
+    TEST_ASSERT_EQUAL_STRING("{\"uptime\":15,\"rssi\":[-63,-63,-63]}", payload);
+}
+
+void test_telemetry_suppression_is_bounded(void) {
+    Telemetry::clear();
+    Telemetry::setIntervals(1000, 2000);
+    Telemetry::addSensor("flash_writes", "Config Flash Writes", "writes", sampleValue, 1);
+    sampledValue = 7;
+    
+    char payload[128];
+    unsigned long now = 0;
+    int published = 0;
+    int batches = 2 * (Telemetry::MAX_SUPPRESSED + 1);
+    for (int i = 0; i < batches; i++) {
+        now = runUntilBatch(now);
+        Telemetry::buildPayload(payload, sizeof(payload), now / 1000);
+        if (strstr(payload, "flash_writes")) published++;
+    }
+    
+    // First batch, then a refresh after every MAX_SUPPRESSED quiet intervals
+    TEST_ASSERT_EQUAL(2, published);
+}
+
+void test_telemetry_sensor_table_full(void) {
+    Telemetry::clear();
+    for (int i = 0; i < Telemetry::MAX_SENSORS; i++) {
+        TEST_ASSERT_EQUAL(i, Telemetry::addSensor("s", "Sensor", "", sampleValue, 1));
+    }
+    TEST_ASSERT_EQUAL(-1, Telemetry::addSensor("extra", "Extra", "", sampleValue, 1));
+    TEST_ASSERT_EQUAL(Telemetry::MAX_SENSORS, Telemetry::getSensorCount());
+    
+    // Recording against an unknown id is ignored
+    Telemetry::record(-1, 5);
+    Telemetry::record(Telemetry::MAX_SENSORS, 5);
+}
+
+void test_telemetry_payload_too_small(void) {
+    Telemetry::clear();
+    Telemetry::addSensor("heap", "Free Heap", "B", sampleValue, 1);
+    sampledValue = 123456;
+    Telemetry::loop(0);
+    
+    char payload[20];
+    TEST_ASSERT_EQUAL(0, Telemetry::buildPayload(payload, sizeof(payload), 1));
+    TEST_ASSERT_EQUAL(0, Telemetry::getBatchCount());
+}
+
+void test_telemetry_overflow_keeps_interval(void) {
+    Telemetry::clear();
+    int first = Telemetry::addSensor("a", "First", "", nullptr, 1);
+    int second = Telemetry::addSensor("b", "Second", "", nullptr, 1);
+    Telemetry::record(first, 1);
+    Telemetry::record(second, 2);
+    
+    // "a" fits, "b" doesn't
+    char payload[128];
+    TEST_ASSERT_EQUAL(0, Telemetry::buildPayload(payload, 30, 1));
+    
+    // Neither interval was used up by the failed batch
+    TEST_ASSERT_TRUE(Telemetry::buildPayload(payload, sizeof(payload), 2) > 0);
+    TEST_ASSERT_EQUAL_STRING("{\"uptime\":2,\"a\":[1,1,1],\"b\":[2,2,2]}", payload);
+    TEST_ASSERT_EQUAL(1, Telemetry::getBatchCount());
+    TEST_ASSERT_EQUAL(0, Telemetry::getSuppressedCount());
+}
@@ -0,0 +1,14 @@
+#ifndef TEST_TELEMETRY_H
+#define TEST_TELEMETRY_H
+
+#include <unity.h>
+
+// Telemetry Tests
+void test_telemetry_aggregates_min_avg_max(void);
+void test_telemetry_suppresses_unchanged(void);
+void test_telemetry_suppression_is_bounded(void);
+void test_telemetry_sensor_table_full(void);
+void test_telemetry_payload_too_small(void);
+void test_telemetry_overflow_keeps_interval(void);
+
+#endif // TEST_TELEMETRY_H